@@ -0,0 +1,690 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+#include "../src/AstPrinter.hpp"
+#include "../src/astCache.h"
+#include "../src/interpreter.h"
+#include "../src/jit.h"
+#include "../src/lexer.h"
+#include "../src/logger.h"
+#include "../src/parser.h"
+#include "../src/perfCounters.h"
+#include "../src/preparedExpression.h"
+#include "../src/profiler.h"
+#include "../src/session.h"
+#include "../src/staticVisitor.h"
+#include "../src/workStealingPool.h"
+#include "../src/tracer.h"
+#include "corpus.h"
+
+#include <array>
+#include <benchmark/benchmark.h>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <ostream>
+#include <random>
+#include <string>
+
+using namespace lox;
+
+namespace
+{
+
+class NodeCounter : public ExpressionVisitor
+{
+public:
+    std::size_t count(const Expression& expr)
+    {
+        m_nodes = 0;
+        expr.accept(*this);
+        return m_nodes;
+    }
+
+    LiteralValues visit(const BinaryExpression& expr) override
+    {
+        m_nodes++;
+        expr.left->accept(*this);
+        return expr.right->accept(*this);
+    }
+    LiteralValues visit(const LiteralExpression& /*expr*/) override
+    {
+        m_nodes++;
+        return NullLiteral{};
+    }
+    LiteralValues visit(const UnaryExpression& expr) override
+    {
+        m_nodes++;
+        return expr.right->accept(*this);
+    }
+    LiteralValues visit(const GroupingExpression& expr) override
+    {
+        m_nodes++;
+        return expr.expression->accept(*this);
+    }
+    LiteralValues visit(const LogicalExpression& expr) override
+    {
+        m_nodes++;
+        expr.left->accept(*this);
+        return expr.right->accept(*this);
+    }
+    LiteralValues visit(const ConditionalExpression& expr) override
+    {
+        m_nodes++;
+        expr.condition->accept(*this);
+        expr.thenBranch->accept(*this);
+        return expr.elseBranch->accept(*this);
+    }
+    LiteralValues visit(const ArrayExpression& expr) override
+    {
+        m_nodes++;
+        for (const auto& element : expr.elements)
+        {
+            element->accept(*this);
+        }
+        return NullLiteral{};
+    }
+    LiteralValues visit(const CallExpression& expr) override
+    {
+        m_nodes++;
+        return expr.argument->accept(*this);
+    }
+    LiteralValues visit(const VariableExpression& /*expr*/) override
+    {
+        m_nodes++;
+        return NullLiteral{};
+    }
+
+private:
+    std::size_t m_nodes = 0;
+};
+
+// NodeCounter without virtual calls, for BM_Dispatch
+class StaticNodeCounter : public StaticVisitor<StaticNodeCounter, std::size_t>
+{
+public:
+    std::size_t count(const Expression& expr) { return dispatch(expr); }
+
+    std::size_t visit(const BinaryExpression& expr) { return 1 + dispatch(*expr.left) + dispatch(*expr.right); }
+    std::size_t visit(const LiteralExpression& /*expr*/) { return 1; }
+    std::size_t visit(const UnaryExpression& expr) { return 1 + dispatch(*expr.right); }
+    std::size_t visit(const GroupingExpression& expr) { return 1 + dispatch(*expr.expression); }
+    std::size_t visit(const VariableExpression& /*expr*/) { return 1; }
+    std::size_t visit(const LogicalExpression& expr) { return 1 + dispatch(*expr.left) + dispatch(*expr.right); }
+    std::size_t visit(const ConditionalExpression& expr)
+    {
+        return 1 + dispatch(*expr.condition) + dispatch(*expr.thenBranch) + dispatch(*expr.elseBranch);
+    }
+    std::size_t visit(const ArrayExpression& expr)
+    {
+        std::size_t nodes = 1;
+        for (const auto& element : expr.elements)
+        {
+            nodes += dispatch(*element);
+        }
+        return nodes;
+    }
+    std::size_t visit(const CallExpression& expr) { return 1 + dispatch(*expr.argument); }
+};
+
+// The nodes an evaluation reached, from the visits a Profiler counted
+class VisitedNodes : public StaticVisitor<VisitedNodes, std::size_t>
+{
+public:
+    explicit VisitedNodes(const Profiler& profiler)
+        : m_profiler(profiler)
+    {
+    }
+
+    std::size_t count(const Expression& expr) { return dispatch(expr); }
+
+    std::size_t visit(const BinaryExpression& expr)
+    {
+        return self(expr) + dispatch(*expr.left) + dispatch(*expr.right);
+    }
+    std::size_t visit(const LiteralExpression& expr) { return self(expr); }
+    std::size_t visit(const UnaryExpression& expr) { return self(expr) + dispatch(*expr.right); }
+    std::size_t visit(const GroupingExpression& expr) { return self(expr) + dispatch(*expr.expression); }
+    std::size_t visit(const VariableExpression& expr) { return self(expr); }
+    std::size_t visit(const LogicalExpression& expr)
+    {
+        return self(expr) + dispatch(*expr.left) + dispatch(*expr.right);
+    }
+    std::size_t visit(const ConditionalExpression& expr)
+    {
+        return self(expr) + dispatch(*expr.condition) + dispatch(*expr.thenBranch) + dispatch(*expr.elseBranch);
+    }
+    std::size_t visit(const ArrayExpression& expr)
+    {
+        std::size_t visits = self(expr);
+        for (const auto& element : expr.elements)
+        {
+            visits += dispatch(*element);
+        }
+        return visits;
+    }
+    std::size_t visit(const CallExpression& expr) { return self(expr) + dispatch(*expr.argument); }
+
+private:
+    std::size_t self(const Expression& expr)
+    {
+        const auto* profile = m_profiler.node(expr);
+        return profile ? profile->visits : 0;
+    }
+
+    const Profiler& m_profiler;
+};
+
+CorpusOptions corpusOptions(std::string_view mix, std::int64_t nodes)
+{
+    CorpusOptions options{};
+    options.nodes = static_cast<std::size_t>(nodes);
+    if (mix == "numeric")
+    {
+        options.strings = false;
+        options.nil = false;
+    }
+    else if (mix == "strings")
+    {
+        options.numbers = false;
+        options.booleans = false;
+        options.nil = false;
+    }
+    return options;
+}
+
+ExpressionUPTR parse(const std::string& source)
+{
+    auto expr = Parser{ Lexer{ source }.tokenize() }.parse();
+    if (!expr)
+    {
+        throw std::logic_error("The corpus generator produced an invalid expression.");
+    }
+    return std::move(expr.value());
+}
+
+void setRates(benchmark::State& state, std::size_t bytes, std::size_t tokens, std::size_t nodes)
+{
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * bytes));
+    using benchmark::Counter;
+    state.counters["tokens"] = Counter(static_cast<double>(tokens), Counter::kIsIterationInvariantRate);
+    state.counters["nodes"] = Counter(static_cast<double>(nodes), Counter::kIsIterationInvariantRate);
+}
+
+// Reading the counters costs two system calls per phase, so they are only read when asked for
+constexpr std::string_view PerfCountersFlag = "--lox_perf_counters";
+
+using PerfSnapshot = std::array<PerfCounts, PhaseCount>;
+
+PerfSnapshot perfSnapshot()
+{
+    PerfSnapshot snapshot{};
+    for (std::size_t i = 0; i < PhaseCount; ++i)
+    {
+        snapshot[i] = PerfCounters::phase(static_cast<Phase>(i));
+    }
+    return snapshot;
+}
+
+// Adds the hardware counters of every phase that ran since `before`
+void setPerfCounters(benchmark::State& state, const PerfSnapshot& before)
+{
+    if (!PerfCounters::enabled())
+    {
+        return;
+    }
+    auto after = perfSnapshot();
+    for (std::size_t i = 0; i < PhaseCount; ++i)
+    {
+        auto delta = after[i] - before[i];
+        if (!delta.cycles)
+        {
+            continue;
+        }
+        auto name = std::string{ phaseName(static_cast<Phase>(i)) };
+        state.counters[name + "_IPC"] = delta.instructionsPerCycle();
+        state.counters[name + "_branch_miss%"] = delta.branchMissRate() * 100;
+        state.counters[name + "_cache_miss%"] = delta.cacheMissRate() * 100;
+    }
+}
+
+void BM_Lexer(benchmark::State& state, std::string_view mix)
+{
+    auto source = CorpusGenerator{ corpusOptions(mix, state.range(0)) }.generate();
+    auto nodes = NodeCounter{}.count(*parse(source));
+    std::size_t tokens = 0;
+    auto perf = perfSnapshot();
+    for (auto _ : state)
+    {
+        PhaseScope phase{ Phase::Lex };
+        auto output = Lexer{ source }.tokenize();
+        tokens = output.size();
+        benchmark::DoNotOptimize(output.data());
+    }
+    setRates(state, source.size(), tokens, nodes);
+    setPerfCounters(state, perf);
+}
+
+void BM_Parser(benchmark::State& state, std::string_view mix)
+{
+    auto source = CorpusGenerator{ corpusOptions(mix, state.range(0)) }.generate();
+    auto tokens = Lexer{ source }.tokenize();
+    auto nodes = NodeCounter{}.count(*parse(source));
+    auto perf = perfSnapshot();
+    for (auto _ : state)
+    {
+        PhaseScope phase{ Phase::Parse };
+        auto expr = Parser{ tokens }.parse();
+        benchmark::DoNotOptimize(expr->get());
+    }
+    setRates(state, source.size(), tokens.size(), nodes);
+    setPerfCounters(state, perf);
+}
+
+void BM_Evaluate(benchmark::State& state, std::string_view mix)
+{
+    auto source = CorpusGenerator{ corpusOptions(mix, state.range(0)) }.generate();
+    auto tokens = Lexer{ source }.tokenize().size();
+    auto expr = parse(source);
+    auto nodes = NodeCounter{}.count(*expr);
+    Interpreter interpreter{};
+    auto perf = perfSnapshot();
+    for (auto _ : state)
+    {
+        PhaseScope phase{ Phase::Evaluate };
+        auto value = interpreter.evaluateTree(*expr);
+        benchmark::DoNotOptimize(value);
+    }
+    setRates(state, source.size(), tokens, nodes);
+    setPerfCounters(state, perf);
+}
+
+// The same trees as BM_Evaluate on the numeric mix, evaluated with NumericOnly values
+void BM_EvaluateNumericOnly(benchmark::State& state)
+{
+    auto source = CorpusGenerator{ corpusOptions("numeric", state.range(0)) }.generate();
+    auto tokens = Lexer{ source }.tokenize().size();
+    auto expr = parse(source);
+    auto nodes = NodeCounter{}.count(*expr);
+    Interpreter interpreter{};
+    auto perf = perfSnapshot();
+    for (auto _ : state)
+    {
+        PhaseScope phase{ Phase::Evaluate };
+        auto value = interpreter.evaluateNumeric(*expr);
+        benchmark::DoNotOptimize(value);
+    }
+    setRates(state, source.size(), tokens, nodes);
+    setPerfCounters(state, perf);
+}
+
+// The same trees again, prepared once and evaluated without touching the heap
+void BM_EvaluatePrepared(benchmark::State& state)
+{
+    auto source = CorpusGenerator{ corpusOptions("numeric", state.range(0)) }.generate();
+    auto tokens = Lexer{ source }.tokenize().size();
+    auto expr = parse(source);
+    auto nodes = NodeCounter{}.count(*expr);
+    auto prepared = PreparedExpression::prepare(*expr);
+    if (!prepared)
+    {
+        state.SkipWithError("The tree has values on the heap.");
+        return;
+    }
+    Globals globals{};
+    EvaluationError error{};
+    auto perf = perfSnapshot();
+    for (auto _ : state)
+    {
+        PhaseScope phase{ Phase::Evaluate };
+        auto value = prepared->evaluate(globals, error);
+        benchmark::DoNotOptimize(value);
+    }
+    setRates(state, source.size(), tokens, nodes);
+    setPerfCounters(state, perf);
+}
+
+// BM_Evaluate/mixed with fork-join, on a pool of state.range(1) threads
+void BM_ForkJoin(benchmark::State& state)
+{
+    auto source = CorpusGenerator{ corpusOptions("mixed", state.range(0)) }.generate();
+    auto tokens = Lexer{ source }.tokenize().size();
+    auto expr = parse(source);
+    auto nodes = NodeCounter{}.count(*expr);
+    WorkStealingPool pool{ static_cast<unsigned int>(state.range(1)) };
+    Interpreter interpreter{};
+    interpreter.setPool(&pool);
+    auto perf = perfSnapshot();
+    for (auto _ : state)
+    {
+        PhaseScope phase{ Phase::Evaluate };
+        auto value = interpreter.evaluateForked(*expr);
+        benchmark::DoNotOptimize(value);
+    }
+    setRates(state, source.size(), tokens, nodes);
+    setPerfCounters(state, perf);
+}
+
+// A table of state.range(0) rules, "x below i gives (x * i + y) / (i + 1)", of which the one in the middle applies.
+// The "eager" form computes every rule, the way they had to be written before there were conditionals, while the
+// "conditional" form, a chain of `?:`, and the "logical" form, `and` inside `or`, stop at the first rule that applies.
+// The nodes counter is the size of the tree, and visited the nodes one evaluation reaches.
+void BM_Rules(benchmark::State& state, std::string_view form)
+{
+    const auto rules = state.range(0);
+    std::string source{};
+    for (std::int64_t i = 1; i <= rules; ++i)
+    {
+        auto predicate = std::format("x < {}", i);
+        auto value = std::format("(x * {} + y) / ({} + 1)", i, i);
+        if (form == "eager")
+        {
+            source += std::format("{}, {}, ", predicate, value);
+        }
+        else if (form == "conditional")
+        {
+            source += std::format("{} ? {} : ", predicate, value);
+        }
+        else
+        {
+            source += std::format("{} and {} or ", predicate, value);
+        }
+    }
+    source += "0";
+    auto tokens = Lexer{ source }.tokenize().size();
+    auto expr = parse(source);
+    auto nodes = NodeCounter{}.count(*expr);
+    Interpreter interpreter{};
+    interpreter.setGlobal("x", static_cast<double>(rules / 2)); // Interned in the order of the source
+    interpreter.setGlobal("y", 0.5);
+    Profiler profiler{};
+    interpreter.profile(*expr, profiler);
+    auto visited = VisitedNodes{ profiler }.count(*expr);
+    auto perf = perfSnapshot();
+    for (auto _ : state)
+    {
+        PhaseScope phase{ Phase::Evaluate };
+        auto value = interpreter.evaluateTree(*expr);
+        benchmark::DoNotOptimize(value);
+    }
+    setRates(state, source.size(), tokens, nodes);
+    state.counters["visited"] = static_cast<double>(visited);
+    setPerfCounters(state, perf);
+}
+
+// The same arithmetic on state.range(0) numbers, `(e * 3 + 1) / 2` summed over them. The "scalar" form writes it out
+// for every number, the "array" form as `sum(([e, ...] * 3 + 1) / 2)`, which runs each operator as one SIMD loop.
+void BM_Arrays(benchmark::State& state, std::string_view form)
+{
+    const auto elements = state.range(0);
+    std::string source = form == "array" ? "sum(([" : "";
+    for (std::int64_t i = 0; i < elements; ++i)
+    {
+        auto separator = i == 0 ? "" : form == "array" ? ", " : " + ";
+        source += form == "array" ? std::format("{}{}", separator, i) : std::format("{}({} * 3 + 1) / 2", separator, i);
+    }
+    source += form == "array" ? "] * 3 + 1) / 2)" : "";
+    auto tokens = Lexer{ source }.tokenize().size();
+    auto expr = parse(source);
+    auto nodes = NodeCounter{}.count(*expr);
+    Interpreter interpreter{};
+    auto perf = perfSnapshot();
+    for (auto _ : state)
+    {
+        PhaseScope phase{ Phase::Evaluate };
+        auto value = interpreter.evaluateTree(*expr);
+        benchmark::DoNotOptimize(value);
+    }
+    setRates(state, source.size(), tokens, nodes);
+    state.counters["elements"] =
+        benchmark::Counter(static_cast<double>(elements), benchmark::Counter::kIsIterationInvariantRate);
+    setPerfCounters(state, perf);
+}
+
+// The same trees as BM_Evaluate on the numeric mix, run as machine code
+void BM_Jit(benchmark::State& state)
+{
+    auto source = CorpusGenerator{ corpusOptions("numeric", state.range(0)) }.generate();
+    auto tokens = Lexer{ source }.tokenize().size();
+    auto expr = parse(source);
+    auto nodes = NodeCounter{}.count(*expr);
+    auto function = JitFunction::compile(*expr);
+    if (!function)
+    {
+        state.SkipWithError("The JIT does not support this machine or tree.");
+        return;
+    }
+    Interpreter interpreter{};
+    auto perf = perfSnapshot();
+    for (auto _ : state)
+    {
+        PhaseScope phase{ Phase::Evaluate };
+        auto value = interpreter.evaluateCompiled(*function, *expr);
+        benchmark::DoNotOptimize(value);
+    }
+    setRates(state, source.size(), tokens, nodes);
+    setPerfCounters(state, perf);
+}
+
+// The cost of visiting every node and nothing else, through ExpressionVisitor or StaticVisitor
+template <typename Counter> void BM_Dispatch(benchmark::State& state)
+{
+    auto source = CorpusGenerator{ corpusOptions("mixed", state.range(0)) }.generate();
+    auto tokens = Lexer{ source }.tokenize().size();
+    auto expr = parse(source);
+    auto nodes = NodeCounter{}.count(*expr);
+    Counter counter{};
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(counter.count(*expr));
+    }
+    setRates(state, source.size(), tokens, nodes);
+}
+
+void BM_AstPrinter(benchmark::State& state, std::string_view mix)
+{
+    auto source = CorpusGenerator{ corpusOptions(mix, state.range(0)) }.generate();
+    auto tokens = Lexer{ source }.tokenize().size();
+    auto expr = parse(source);
+    auto nodes = NodeCounter{}.count(*expr);
+    std::ostream sink{ nullptr }; // Discards everything, the formatting still happens
+    AstPrinter printer{ sink };
+    auto perf = perfSnapshot();
+    for (auto _ : state)
+    {
+        PhaseScope phase{ Phase::Print };
+        printer.print(*expr);
+    }
+    setRates(state, source.size(), tokens, nodes);
+    setPerfCounters(state, perf);
+}
+
+void BM_Pipeline(benchmark::State& state, std::string_view mix)
+{
+    auto source = CorpusGenerator{ corpusOptions(mix, state.range(0)) }.generate();
+    auto tokens = Lexer{ source }.tokenize().size();
+    auto nodes = NodeCounter{}.count(*parse(source));
+    Interpreter interpreter{};
+    auto perf = perfSnapshot();
+    for (auto _ : state)
+    {
+        std::vector<Token> output{};
+        {
+            PhaseScope phase{ Phase::Lex };
+            output = Lexer{ source }.tokenize();
+        }
+        std::optional<ExpressionUPTR> expr{};
+        {
+            PhaseScope phase{ Phase::Parse };
+            expr = Parser{ std::move(output) }.parse();
+        }
+        PhaseScope phase{ Phase::Evaluate };
+        auto value = interpreter.evaluateTree(*expr.value());
+        benchmark::DoNotOptimize(value);
+    }
+    setRates(state, source.size(), tokens, nodes);
+    setPerfCounters(state, perf);
+}
+
+// "..." + "..." + ... with n terms, every Plus used to copy all of the left side
+void BM_ConcatChain(benchmark::State& state)
+{
+    const auto terms = state.range(0);
+    constexpr std::string_view Term = "\"some characters\"";
+    std::string source{ Term };
+    for (std::int64_t i = 1; i < terms; ++i)
+    {
+        source.append(" + ").append(Term);
+    }
+    auto expr = parse(source);
+    Interpreter interpreter{};
+    for (auto _ : state)
+    {
+        auto value = interpreter.evaluateTree(*expr);
+        benchmark::DoNotOptimize(std::get<LoxString>(value).view().data()); // Flattens it
+    }
+    state.SetComplexityN(terms);
+    state.SetBytesProcessed(state.iterations() * terms * static_cast<std::int64_t>(Term.size() - 2));
+}
+
+// A sum of n number literals: short integers like most of our data, short decimals, or literals too long to be built
+// while scanning
+void BM_NumberLiterals(benchmark::State& state, std::string_view kind)
+{
+    const auto terms = state.range(0);
+    std::mt19937 rng{ 42 };
+    std::string source{};
+    for (std::int64_t i = 0; i < terms; ++i)
+    {
+        if (i)
+        {
+            source += " + ";
+        }
+        source += std::to_string(rng() % 10000);
+        if (kind == "decimals")
+        {
+            source += "." + std::to_string(rng() % 1000);
+        }
+        else if (kind == "long")
+        {
+            source += std::to_string(rng()) + "." + std::to_string(rng());
+        }
+    }
+    std::size_t tokens = 0;
+    for (auto _ : state)
+    {
+        PhaseScope phase{ Phase::Lex };
+        auto output = Lexer{ source }.tokenize();
+        tokens = output.size();
+        benchmark::DoNotOptimize(output.data());
+    }
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * source.size()));
+    using benchmark::Counter;
+    state.counters["tokens"] = Counter(static_cast<double>(tokens), Counter::kIsIterationInvariantRate);
+}
+
+// Getting the tree of an unchanged script: lexing and parsing it when cold, loading it from the AstCache when warm
+void BM_Startup(benchmark::State& state, std::string_view start)
+{
+    auto source = CorpusGenerator{ corpusOptions("mixed", state.range(0)) }.generate();
+    auto tokens = Lexer{ source }.tokenize().size();
+    auto nodes = NodeCounter{}.count(*parse(source));
+    AstCache cache{ std::filesystem::temp_directory_path() / "lox_bench_ast_cache" };
+    Session session{};
+    session.lex(source);
+    cache.store(source, *session.parse(), session.symbols());
+    for (auto _ : state)
+    {
+        const Expression* tree = nullptr;
+        if (start == "warm")
+        {
+            PhaseScope phase{ Phase::Parse };
+            tree = cache.load(source, session);
+        }
+        else
+        {
+            {
+                PhaseScope phase{ Phase::Lex };
+                session.lex(source);
+            }
+            PhaseScope phase{ Phase::Parse };
+            tree = session.parse();
+        }
+        benchmark::DoNotOptimize(tree);
+    }
+    std::filesystem::remove_all(cache.directory());
+    setRates(state, source.size(), tokens, nodes);
+}
+
+constexpr std::int64_t MinNodes = 1 << 6;
+constexpr std::int64_t MaxNodes = 1 << 15;
+
+} // namespace
+
+BENCHMARK_CAPTURE(BM_Lexer, numeric, "numeric")->RangeMultiplier(8)->Range(MinNodes, MaxNodes);
+BENCHMARK_CAPTURE(BM_Lexer, strings, "strings")->RangeMultiplier(8)->Range(MinNodes, MaxNodes);
+BENCHMARK_CAPTURE(BM_Lexer, mixed, "mixed")->RangeMultiplier(8)->Range(MinNodes, MaxNodes);
+BENCHMARK_CAPTURE(BM_Parser, numeric, "numeric")->RangeMultiplier(8)->Range(MinNodes, MaxNodes);
+BENCHMARK_CAPTURE(BM_Parser, mixed, "mixed")->RangeMultiplier(8)->Range(MinNodes, MaxNodes);
+BENCHMARK_CAPTURE(BM_Evaluate, numeric, "numeric")->RangeMultiplier(8)->Range(MinNodes, MaxNodes);
+BENCHMARK_CAPTURE(BM_Evaluate, strings, "strings")->RangeMultiplier(8)->Range(MinNodes, MaxNodes);
+BENCHMARK_CAPTURE(BM_Evaluate, mixed, "mixed")->RangeMultiplier(8)->Range(MinNodes, MaxNodes);
+BENCHMARK(BM_EvaluateNumericOnly)->RangeMultiplier(8)->Range(MinNodes, MaxNodes);
+BENCHMARK(BM_EvaluatePrepared)->RangeMultiplier(8)->Range(MinNodes, MaxNodes);
+BENCHMARK(BM_ForkJoin)->ArgsProduct({ { MaxNodes, 1 << 18 }, { 2, 4, 8 } })->UseRealTime();
+BENCHMARK_CAPTURE(BM_Rules, eager, "eager")->RangeMultiplier(8)->Range(8, 1 << 9);
+BENCHMARK_CAPTURE(BM_Rules, conditional, "conditional")->RangeMultiplier(8)->Range(8, 1 << 9);
+BENCHMARK_CAPTURE(BM_Rules, logical, "logical")->RangeMultiplier(8)->Range(8, 1 << 9);
+BENCHMARK_CAPTURE(BM_Arrays, scalar, "scalar")->RangeMultiplier(8)->Range(8, 1 << 12);
+BENCHMARK_CAPTURE(BM_Arrays, array, "array")->RangeMultiplier(8)->Range(8, 1 << 12);
+BENCHMARK(BM_Jit)->RangeMultiplier(8)->Range(MinNodes, MaxNodes);
+BENCHMARK_TEMPLATE(BM_Dispatch, NodeCounter)->RangeMultiplier(8)->Range(MinNodes, MaxNodes);
+BENCHMARK_TEMPLATE(BM_Dispatch, StaticNodeCounter)->RangeMultiplier(8)->Range(MinNodes, MaxNodes);
+BENCHMARK_CAPTURE(BM_AstPrinter, mixed, "mixed")->RangeMultiplier(8)->Range(MinNodes, MaxNodes);
+BENCHMARK_CAPTURE(BM_Pipeline, mixed, "mixed")->RangeMultiplier(8)->Range(MinNodes, MaxNodes);
+BENCHMARK_CAPTURE(BM_NumberLiterals, integers, "integers")->RangeMultiplier(8)->Range(MinNodes, MaxNodes);
+BENCHMARK_CAPTURE(BM_NumberLiterals, decimals, "decimals")->RangeMultiplier(8)->Range(MinNodes, MaxNodes);
+BENCHMARK_CAPTURE(BM_NumberLiterals, long, "long")->RangeMultiplier(8)->Range(MinNodes, MaxNodes);
+BENCHMARK_CAPTURE(BM_Startup, cold, "cold")->RangeMultiplier(8)->Range(MinNodes, MaxNodes);
+BENCHMARK_CAPTURE(BM_Startup, warm, "warm")->RangeMultiplier(8)->Range(MinNodes, MaxNodes);
+BENCHMARK(BM_ConcatChain)->RangeMultiplier(4)->Range(1 << 6, 1 << 14)->Complexity(benchmark::oN);
+
+int main(int argc, char** argv)
+{
+    // The pipeline logs every token and parser step at debug level, which would bury the results
+    Logger::setLevel(Logger::Error);
+    for (int i = 1; i < argc; ++i)
+    {
+        if (argv[i] == PerfCountersFlag)
+        {
+            if (!PerfCounters::enable())
+            {
+                Logger::error("Hardware counters are not available, check /proc/sys/kernel/perf_event_paranoid.");
+            }
+            std::memmove(argv + i, argv + i + 1, (argc - i) * sizeof(char*)); // Google Benchmark rejects it
+            argc--;
+            break;
+        }
+    }
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+    {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,234 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+#include "corpus.h"
+
+#include <array>
+#include <stdexcept>
+#include <vector>
+
+namespace lox
+{
+
+namespace
+{
+
+constexpr std::array<std::string_view, 4> ArithmeticOperators{ "+", "-", "*", "/" };
+constexpr std::array<std::string_view, 4> ComparisonOperators{ "<", "<=", ">", ">=" };
+constexpr std::array<std::string_view, 2> EqualityOperators{ "==", "!=" };
+
+} // namespace
+
+CorpusGenerator::CorpusGenerator(CorpusOptions options)
+    : m_options(options)
+    , m_state(options.seed)
+{
+    if (!m_options.numbers && !m_options.strings && !m_options.booleans && !m_options.nil)
+    {
+        throw std::invalid_argument("A corpus needs at least one type.");
+    }
+}
+
+std::string CorpusGenerator::generate()
+{
+    m_state = m_options.seed;
+    return expression(anyType(), std::max<std::size_t>(m_options.nodes, 1), 0).text;
+}
+
+auto CorpusGenerator::expression(Type type, std::size_t budget, unsigned int depth) -> Generated
+{
+    if (budget <= 1 || depth >= m_options.maxDepth)
+    {
+        return literal(type);
+    }
+
+    enum class Kind
+    {
+        Arithmetic,
+        Comparison,
+        Equality,
+        Unary,
+        Grouping
+    };
+    std::vector<std::pair<Kind, unsigned int>> kinds{};
+    const bool binaryFits = budget >= 3;
+    switch (type)
+    {
+    case Type::Number:
+        if (binaryFits)
+        {
+            kinds.emplace_back(Kind::Arithmetic, m_options.arithmetic);
+        }
+        kinds.emplace_back(Kind::Unary, m_options.unary);
+        break;
+    case Type::String:
+        if (binaryFits)
+        {
+            kinds.emplace_back(Kind::Arithmetic, m_options.arithmetic);
+        }
+        break;
+    case Type::Boolean:
+        if (binaryFits && m_options.numbers)
+        {
+            kinds.emplace_back(Kind::Comparison, m_options.comparison);
+        }
+        if (binaryFits)
+        {
+            kinds.emplace_back(Kind::Equality, m_options.equality);
+        }
+        kinds.emplace_back(Kind::Unary, m_options.unary);
+        break;
+    case Type::Nil:
+        break;
+    }
+    kinds.emplace_back(Kind::Grouping, m_options.grouping);
+
+    unsigned int totalWeight = 0;
+    for (const auto& [kind, weight] : kinds)
+    {
+        totalWeight += weight;
+    }
+    if (!totalWeight)
+    {
+        return literal(type);
+    }
+
+    auto pick = below(totalWeight);
+    auto chosen = kinds.front().first;
+    for (const auto& [kind, weight] : kinds)
+    {
+        if (pick < weight)
+        {
+            chosen = kind;
+            break;
+        }
+        pick -= weight;
+    }
+
+    switch (chosen)
+    {
+    case Kind::Arithmetic:
+    {
+        auto op = type == Type::String ? ArithmeticOperators[0] : ArithmeticOperators[below(ArithmeticOperators.size())];
+        auto precedence = op == "+" || op == "-" ? Term : Factor;
+        return binary(type, type, op, precedence, budget, depth);
+    }
+    case Kind::Comparison:
+        return binary(
+            Type::Number,
+            Type::Number,
+            ComparisonOperators[below(ComparisonOperators.size())],
+            Precedence::Comparison,
+            budget,
+            depth);
+    case Kind::Equality:
+        return binary(
+            anyType(), anyType(), EqualityOperators[below(EqualityOperators.size())], Precedence::Equality, budget, depth);
+    case Kind::Unary:
+        if (type == Type::Number)
+        {
+            return { "-" + operand(Type::Number, Precedence::Unary, budget - 1, depth), Precedence::Unary };
+        }
+        return { "!" + operand(anyType(), Precedence::Unary, budget - 1, depth), Precedence::Unary };
+    case Kind::Grouping:
+        break;
+    }
+    return { "(" + expression(type, budget - 1, depth + 1).text + ")", Primary };
+}
+
+auto CorpusGenerator::binary(
+    Type left, Type right, std::string_view op, Precedence precedence, std::size_t budget, unsigned int depth)
+    -> Generated
+{
+    auto leftBudget = 1 + below(budget - 2);
+    auto rightBudget = budget - 1 - leftBudget;
+    // Binary operators are left associative, so only the right operand needs parentheses at the same precedence
+    auto text = operand(left, precedence, leftBudget, depth);
+    text.append(" ").append(op).append(" ");
+    text.append(operand(right, static_cast<Precedence>(precedence + 1), rightBudget, depth));
+    return { std::move(text), precedence };
+}
+
+std::string CorpusGenerator::operand(Type type, Precedence atLeast, std::size_t budget, unsigned int depth)
+{
+    auto generated = expression(type, budget, depth + 1);
+    if (generated.precedence < atLeast)
+    {
+        return "(" + generated.text + ")";
+    }
+    return generated.text;
+}
+
+auto CorpusGenerator::literal(Type type) -> Generated
+{
+    switch (type)
+    {
+    case Type::Number:
+        if (below(4) == 0)
+        {
+            return { std::to_string(below(1000)) + "." + std::to_string(1 + below(99)), Primary };
+        }
+        return { std::to_string(below(1000)), Primary };
+    case Type::String:
+    {
+        std::string text = "\"";
+        for (auto length = 1 + below(8); length; --length)
+        {
+            text.push_back(static_cast<char>('a' + below(26)));
+        }
+        text.push_back('"');
+        return { std::move(text), Primary };
+    }
+    case Type::Boolean:
+        return { below(2) ? "true" : "false", Primary };
+    case Type::Nil:
+        break;
+    }
+    return { "nil", Primary };
+}
+
+auto CorpusGenerator::anyType() -> Type
+{
+    std::vector<Type> types{};
+    if (m_options.numbers)
+    {
+        types.emplace_back(Type::Number);
+    }
+    if (m_options.strings)
+    {
+        types.emplace_back(Type::String);
+    }
+    if (m_options.booleans)
+    {
+        types.emplace_back(Type::Boolean);
+    }
+    if (m_options.nil)
+    {
+        types.emplace_back(Type::Nil);
+    }
+    return types[below(types.size())];
+}
+
+// splitmix64, unlike the standard distributions it gives the same numbers with every standard library
+std::uint64_t CorpusGenerator::next()
+{
+    auto z = (m_state += 0x9e3779b97f4a7c15);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+    return z ^ (z >> 31);
+}
+
+} // namespace lox
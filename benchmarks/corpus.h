@@ -0,0 +1,96 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace lox
+{
+
+struct CorpusOptions
+{
+    std::size_t nodes = 1024; // Roughly how many nodes the expression has
+    unsigned int maxDepth = 32;
+    std::uint64_t seed = 42;
+
+    // Relative weight of every kind of node with children
+    unsigned int arithmetic = 4;
+    unsigned int comparison = 1;
+    unsigned int equality = 1;
+    unsigned int unary = 1;
+    unsigned int grouping = 1;
+
+    // Types of the values the expression (and every part of it) may produce
+    bool numbers = true;
+    bool strings = true;
+    bool booleans = true;
+    bool nil = true;
+};
+
+// Generates random expressions that parse and evaluate without errors. The same options always give the same
+// expression, on every platform.
+class CorpusGenerator
+{
+public:
+    explicit CorpusGenerator(CorpusOptions options);
+
+    std::string generate();
+
+private:
+    enum class Type
+    {
+        Number,
+        String,
+        Boolean,
+        Nil
+    };
+
+    // Precedence of the text of a generated expression, as in the grammar
+    enum Precedence
+    {
+        Equality = 1,
+        Comparison,
+        Term,
+        Factor,
+        Unary,
+        Primary
+    };
+
+    struct Generated
+    {
+        std::string text;
+        Precedence precedence;
+    };
+
+    Generated expression(Type type, std::size_t budget, unsigned int depth);
+    Generated binary(
+        Type left, Type right, std::string_view op, Precedence precedence, std::size_t budget, unsigned int depth);
+    std::string operand(Type type, Precedence atLeast, std::size_t budget, unsigned int depth);
+    Generated literal(Type type);
+    Type anyType();
+
+    std::uint64_t next();
+    std::uint64_t below(std::uint64_t bound) { return next() % bound; }
+
+    CorpusOptions m_options;
+    std::uint64_t m_state;
+};
+
+} // namespace lox
@@ -22,4 +22,13 @@ namespace lox
 
 void run();
 
+// Runs the script given in the arguments, or reads from stdin when there is none.
+// `--trace=<file>`, or the LOX_TRACE environment variable, writes a Chrome trace of every phase to <file>.
+// `--alloc-stats` prints the heap allocations made in every phase, when the binary links LoxAllocHooks.
+// `--perf-stats` prints the hardware counters of every phase, when the kernel allows reading them.
+// `--profile[=<N>]` prints the cycles spent in every node and operator, timing one visit in N.
+// `--result-cache[=<bytes>]` answers repeated inputs from memory, keeping up to <bytes> of results (16 MiB by default).
+// `--ast-cache=<dir>` keeps the parsed tree of the script in <dir>, and loads it rather than parse an unchanged script.
+int run(int argc, char** argv);
+
 } // namespace lox
\ No newline at end of file
@@ -18,7 +18,7 @@
 
 #include "lox.h"
 
-int main()
+int main(int argc, char** argv)
 {
-    lox::run();
+    return lox::run(argc, argv);
 }
\ No newline at end of file
@@ -17,54 +17,128 @@
 #pragma once
 
 #include "BaseExpression.h"
+#include "staticVisitor.h"
 
+#include <functional>
 #include <iostream>
+#include <string>
 
 namespace lox
 {
 
-class AstPrinter : public ExpressionVisitor
+class AstPrinter : public StaticVisitor<AstPrinter>
 {
 public:
-    void print(Expression& expr)
+    // Text printed in braces after every node
+    using Annotation = std::function<std::string(const Expression&)>;
+
+    explicit AstPrinter(std::ostream& out = std::cout, Annotation annotation = {})
+        : m_out(out)
+        , m_annotation(std::move(annotation))
+    {
+    }
+
+    void print(const Expression& expr)
+    {
+        dispatch(expr);
+        m_out << std::endl;
+    }
+
+    void visit(const BinaryExpression& expr)
+    {
+        m_out << "Binary(";
+        m_out << "OP: " << expr.op;
+        m_out << ", Left: ";
+        dispatch(*expr.left);
+        m_out << ", Right: ";
+        dispatch(*expr.right);
+        m_out << ")";
+        annotate(expr);
+    }
+
+    void visit(const LiteralExpression& expr)
     {
-        expr.accept(*this);
-        std::cout << std::endl;
+        std::visit([this](auto&& value) { m_out << value; }, expr.value);
+        annotate(expr);
     }
 
-    LiteralValues visit(const BinaryExpression& expr) override
+    void visit(const UnaryExpression& expr)
     {
-        std::cout << "Binary(";
-        std::cout << "OP: " << expr.op;
-        std::cout << ", Left: ";
-        expr.left->accept(*this);
-        std::cout << ", Right: ";
-        expr.right->accept(*this);
-        std::cout << ")";
-        return NullLiteral{};
+        m_out << "Unary( " << expr.op << " ";
+        dispatch(*expr.right);
+        m_out << ")";
+        annotate(expr);
     }
 
-    LiteralValues visit(const LiteralExpression& expr) override
+    void visit(const GroupingExpression& expr)
     {
-        std::visit([](auto&& value) { std::cout << value; }, expr.value);
-        return NullLiteral{};
+        m_out << "Grouping(";
+        dispatch(*expr.expression);
+        m_out << ")";
+        annotate(expr);
     }
 
-    LiteralValues visit(const UnaryExpression& expr) override
+    void visit(const VariableExpression& expr)
     {
-        std::cout << "Unary( " << expr.op << " ";
-        expr.right->accept(*this);
-        std::cout << ")";
-        return NullLiteral{};
+        m_out << "Variable(#" << expr.symbol.id << ")";
+        annotate(expr);
     }
 
-    LiteralValues visit(const GroupingExpression& expr) override
+    void visit(const LogicalExpression& expr)
     {
-        std::cout << "Grouping(";
-        expr.expression->accept(*this);
-        std::cout << ")";
-        return NullLiteral{};
+        m_out << "Logical(";
+        m_out << "OP: " << expr.op;
+        m_out << ", Left: ";
+        dispatch(*expr.left);
+        m_out << ", Right: ";
+        dispatch(*expr.right);
+        m_out << ")";
+        annotate(expr);
     }
+
+    void visit(const ConditionalExpression& expr)
+    {
+        m_out << "Conditional(Condition: ";
+        dispatch(*expr.condition);
+        m_out << ", Then: ";
+        dispatch(*expr.thenBranch);
+        m_out << ", Else: ";
+        dispatch(*expr.elseBranch);
+        m_out << ")";
+        annotate(expr);
+    }
+
+    void visit(const ArrayExpression& expr)
+    {
+        m_out << "Array(";
+        for (std::size_t i = 0; i < expr.elements.size(); ++i)
+        {
+            m_out << (i ? ", " : "");
+            dispatch(*expr.elements[i]);
+        }
+        m_out << ")";
+        annotate(expr);
+    }
+
+    void visit(const CallExpression& expr)
+    {
+        m_out << "Call(" << CallExpression::nameOf(expr.builtin) << ", ";
+        dispatch(*expr.argument);
+        m_out << ")";
+        annotate(expr);
+    }
+
+private:
+    void annotate(const Expression& expr)
+    {
+        if (m_annotation)
+        {
+            m_out << " {" << m_annotation(expr) << "}";
+        }
+    }
+
+    std::ostream& m_out;
+    Annotation m_annotation;
 };
 
 } // namespace lox
\ No newline at end of file
@@ -16,6 +16,12 @@
 
 #include "BaseExpression.h"
 
+#include "arena.h"
+
+#include <bit>
+#include <new>
+#include <sstream>
+
 namespace lox
 {
 
@@ -24,6 +30,107 @@ std::ostream& operator<<(std::ostream& os, NullLiteral /*nl*/)
     return os << "null";
 }
 
+namespace
+{
+
+// In front of every node, telling where its memory came from
+struct alignas(std::max_align_t) NodeHeader
+{
+    Arena* arena;
+};
+
+// splitmix64's finalizer, every bit of the input flips about half of the output
+std::uint64_t mix(std::uint64_t value)
+{
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+    return value ^ (value >> 31);
+}
+
+// Unlinks the left operands one by one, so that none of them is destroyed with a chain still hanging from it
+void freeChain(std::unique_ptr<Expression> link)
+{
+    while (link)
+    {
+        if (link->kind() == Expression::Kind::Binary)
+        {
+            link = std::move(static_cast<BinaryExpression&>(*link).left);
+        }
+        else if (link->kind() == Expression::Kind::Logical)
+        {
+            link = std::move(static_cast<LogicalExpression&>(*link).left);
+        }
+        else
+        {
+            break;
+        }
+    }
+}
+
+} // namespace
+
+BinaryExpression::~BinaryExpression()
+{
+    freeChain(std::move(left));
+}
+
+LogicalExpression::~LogicalExpression()
+{
+    freeChain(std::move(left));
+}
+
+void* Expression::operator new(std::size_t size)
+{
+    auto* arena = Arena::current();
+    void* memory = arena ? arena->allocate(sizeof(NodeHeader) + size) : ::operator new(sizeof(NodeHeader) + size);
+    return new (memory) NodeHeader{ arena } + 1;
+}
+
+void Expression::operator delete(void* memory)
+{
+    if (!memory)
+    {
+        return;
+    }
+    auto* header = static_cast<NodeHeader*>(memory) - 1;
+    if (!header->arena)
+    {
+        ::operator delete(header);
+    }
+}
+
+std::uint64_t hashNode(std::initializer_list<std::uint64_t> parts)
+{
+    std::uint64_t hash = 0;
+    for (auto part : parts)
+    {
+        hash = mix(hash ^ mix(part + 0x9e3779b97f4a7c15ull));
+    }
+    return hash;
+}
+
+std::uint64_t hashValue(const LiteralValues& value)
+{
+    std::uint64_t bits = 0;
+    if (auto* number = std::get_if<double>(&value))
+    {
+        bits = std::bit_cast<std::uint64_t>(*number); // Keeps 0 and -0 apart, 1 / 0 and 1 / -0 differ
+    }
+    else if (auto* string = std::get_if<LoxString>(&value))
+    {
+        bits = string->hash();
+    }
+    else if (auto* boolean = std::get_if<bool>(&value))
+    {
+        bits = *boolean;
+    }
+    else if (auto* array = std::get_if<NumberArray>(&value))
+    {
+        bits = array->hash();
+    }
+    return hashNode({ value.index(), bits });
+}
+
 std::string print(const LiteralValues& values)
 {
     if (std::holds_alternative<double>(values))
@@ -34,9 +141,15 @@ std::string print(const LiteralValues& values)
     {
         return std::get<bool>(values) ? "true" : "false";
     }
-    if (std::holds_alternative<std::string>(values))
+    if (std::holds_alternative<LoxString>(values))
+    {
+        return std::string{ std::get<LoxString>(values).view() };
+    }
+    if (const auto* array = std::get_if<NumberArray>(&values))
     {
-        return std::get<std::string>(values);
+        std::ostringstream out{};
+        out << *array;
+        return out.str();
     }
     return "null";
 }
@@ -16,12 +16,19 @@
 
 #pragma once
 
+#include "loxString.h"
+#include "numberArray.h"
 #include "token.h"
 
+#include <cstdint>
+#include <initializer_list>
 #include <iostream>
 #include <memory>
+#include <optional>
+#include <string_view>
 #include <type_traits>
 #include <variant>
+#include <vector>
 
 namespace lox
 {
@@ -30,12 +37,22 @@ class BinaryExpression;
 class LiteralExpression;
 struct NullLiteral
 {
+    bool operator==(const NullLiteral&) const = default;
 };
 std::ostream& operator<<(std::ostream& os, NullLiteral /*nl*/);
-using LiteralValues = std::variant<std::string, double, bool, NullLiteral>;
+using LiteralValues = std::variant<LoxString, double, bool, NullLiteral, NumberArray>;
 std::string print(const LiteralValues& values);
+
+// Mixes the parts of a node into its structural hash
+std::uint64_t hashNode(std::initializer_list<std::uint64_t> parts);
+std::uint64_t hashValue(const LiteralValues& value);
 class UnaryExpression;
 class GroupingExpression;
+class VariableExpression;
+class LogicalExpression;
+class ConditionalExpression;
+class ArrayExpression;
+class CallExpression;
 
 class ExpressionVisitor
 {
@@ -46,27 +63,86 @@ public:
     virtual LiteralValues visit(const LiteralExpression& expr) = 0;
     virtual LiteralValues visit(const UnaryExpression& expr) = 0;
     virtual LiteralValues visit(const GroupingExpression& expr) = 0;
+    virtual LiteralValues visit(const VariableExpression& expr) = 0;
+    virtual LiteralValues visit(const LogicalExpression& expr) = 0;
+    virtual LiteralValues visit(const ConditionalExpression& expr) = 0;
+    virtual LiteralValues visit(const ArrayExpression& expr) = 0;
+    virtual LiteralValues visit(const CallExpression& expr) = 0;
 };
 
 class Expression
 {
 public:
+    // The concrete class of a node, for StaticVisitor to dispatch on. The values are mixed into the hashes, so the
+    // ones in use never change.
+    enum class Kind : std::uint8_t
+    {
+        Binary = 1,
+        Literal,
+        Unary,
+        Variable,
+        Grouping,
+        Logical,
+        Conditional,
+        Array,
+        Call
+    };
+
     virtual ~Expression() = default;
     // Accept method for the Visitor pattern
     virtual LiteralValues accept(ExpressionVisitor& visitor) const = 0;
+
+    // Equal for trees that evaluate the same way: built from the same values, operators and variables in the same
+    // shape, ignoring parentheses and lines. Computed when the node is made, from the hashes of its children.
+    std::uint64_t hash() const { return m_hash; }
+    // Recomputes the hash and the size after a child was replaced
+    virtual void rehash() = 0;
+    // The nodes of the tree rooted here, this one included. Computed with the hash, when the tree is parsed.
+    std::uint32_t treeSize() const { return m_treeSize; }
+
+    // Nodes are made in the Arena of the innermost Arena::Scope of the thread, or on the heap outside of one. Deleting
+    // a node made in an arena only runs its destructor, its memory comes back when the arena is rewound.
+    static void* operator new(std::size_t size);
+    static void operator delete(void* memory);
+
+    Kind kind() const { return m_kind; }
+
+protected:
+    explicit Expression(Kind kind)
+        : m_kind(kind)
+    {
+    }
+
+    std::uint64_t m_hash = 0;
+    std::uint32_t m_treeSize = 1;
+
+private:
+    Kind m_kind;
 };
 
 class BinaryExpression : public Expression
 {
 public:
     BinaryExpression(std::unique_ptr<Expression> left, Token op, std::unique_ptr<Expression> right)
-        : left(std::move(left))
+        : Expression(Kind::Binary)
+        , left(std::move(left))
         , op(std::move(op))
         , right(std::move(right))
     {
+        rehash();
     }
+    // Frees a chain of left operands in a loop, long chains nest deeper than the stack would allow recursing
+    ~BinaryExpression() override;
 
     LiteralValues accept(ExpressionVisitor& visitor) const override { return visitor.visit(*this); }
+    void rehash() override
+    {
+        m_hash = hashNode({ static_cast<std::uint64_t>(Kind::Binary),
+                            static_cast<std::uint64_t>(op.type),
+                            left->hash(),
+                            right->hash() });
+        m_treeSize = 1 + left->treeSize() + right->treeSize();
+    }
 
     std::unique_ptr<Expression> left;
     Token op;
@@ -78,11 +154,14 @@ class LiteralExpression : public Expression
 
 public:
     LiteralExpression(LiteralValues value)
-        : value(std::move(value))
+        : Expression(Kind::Literal)
+        , value(std::move(value))
     {
+        rehash();
     }
 
     LiteralValues accept(ExpressionVisitor& visitor) const override { return visitor.visit(*this); }
+    void rehash() override { m_hash = hashNode({ static_cast<std::uint64_t>(Kind::Literal), hashValue(value) }); }
 
     LiteralValues value;
 };
@@ -91,12 +170,20 @@ class UnaryExpression : public Expression
 {
 public:
     UnaryExpression(Token op, std::unique_ptr<Expression> right)
-        : op(std::move(op))
+        : Expression(Kind::Unary)
+        , op(std::move(op))
         , right(std::move(right))
     {
+        rehash();
     }
 
     LiteralValues accept(ExpressionVisitor& visitor) const override { return visitor.visit(*this); }
+    void rehash() override
+    {
+        m_hash = hashNode(
+            { static_cast<std::uint64_t>(Kind::Unary), static_cast<std::uint64_t>(op.type), right->hash() });
+        m_treeSize = 1 + right->treeSize();
+    }
 
     Token op;
     std::unique_ptr<Expression> right;
@@ -106,13 +193,194 @@ class GroupingExpression : public Expression
 {
 public:
     GroupingExpression(std::unique_ptr<Expression> expression)
-        : expression(std::move(expression))
+        : Expression(Kind::Grouping)
+        , expression(std::move(expression))
     {
+        rehash();
     }
 
     LiteralValues accept(ExpressionVisitor& visitor) const override { return visitor.visit(*this); }
+    // Parentheses only shape the tree, which the hash already covers
+    void rehash() override
+    {
+        m_hash = expression->hash();
+        m_treeSize = 1 + expression->treeSize();
+    }
 
     std::unique_ptr<Expression> expression;
 };
 
+// Names are resolved by the lexer, so a variable is looked up by its Symbol and never by its text
+class VariableExpression : public Expression
+{
+public:
+    VariableExpression(Symbol symbol, unsigned int line)
+        : Expression(Kind::Variable)
+        , symbol(symbol)
+        , line(line)
+    {
+        rehash();
+    }
+
+    LiteralValues accept(ExpressionVisitor& visitor) const override { return visitor.visit(*this); }
+    void rehash() override { m_hash = hashNode({ static_cast<std::uint64_t>(Kind::Variable), symbol.id }); }
+
+    Symbol symbol;
+    unsigned int line;
+};
+
+// `and` and `or`, which evaluate their right operand only when the left one does not decide the value
+class LogicalExpression : public Expression
+{
+public:
+    LogicalExpression(std::unique_ptr<Expression> left, Token op, std::unique_ptr<Expression> right)
+        : Expression(Kind::Logical)
+        , left(std::move(left))
+        , op(std::move(op))
+        , right(std::move(right))
+    {
+        rehash();
+    }
+    // Frees a chain of left operands in a loop, long chains nest deeper than the stack would allow recursing
+    ~LogicalExpression() override;
+
+    LiteralValues accept(ExpressionVisitor& visitor) const override { return visitor.visit(*this); }
+    void rehash() override
+    {
+        m_hash = hashNode({ static_cast<std::uint64_t>(Kind::Logical),
+                            static_cast<std::uint64_t>(op.type),
+                            left->hash(),
+                            right->hash() });
+        m_treeSize = 1 + left->treeSize() + right->treeSize();
+    }
+
+    std::unique_ptr<Expression> left;
+    Token op;
+    std::unique_ptr<Expression> right;
+};
+
+// `condition ? thenBranch : elseBranch`, which evaluates only the branch the condition selects
+class ConditionalExpression : public Expression
+{
+public:
+    ConditionalExpression(std::unique_ptr<Expression> condition,
+                          std::unique_ptr<Expression> thenBranch,
+                          std::unique_ptr<Expression> elseBranch)
+        : Expression(Kind::Conditional)
+        , condition(std::move(condition))
+        , thenBranch(std::move(thenBranch))
+        , elseBranch(std::move(elseBranch))
+    {
+        rehash();
+    }
+
+    LiteralValues accept(ExpressionVisitor& visitor) const override { return visitor.visit(*this); }
+    void rehash() override
+    {
+        m_hash = hashNode({ static_cast<std::uint64_t>(Kind::Conditional),
+                            condition->hash(),
+                            thenBranch->hash(),
+                            elseBranch->hash() });
+        m_treeSize = 1 + condition->treeSize() + thenBranch->treeSize() + elseBranch->treeSize();
+    }
+
+    std::unique_ptr<Expression> condition;
+    std::unique_ptr<Expression> thenBranch;
+    std::unique_ptr<Expression> elseBranch;
+};
+
+// `[a, b, c]`, whose elements are evaluated in order into a NumberArray, and must all be numbers
+class ArrayExpression : public Expression
+{
+public:
+    ArrayExpression(std::vector<std::unique_ptr<Expression>> elements, Token bracket)
+        : Expression(Kind::Array)
+        , elements(std::move(elements))
+        , bracket(std::move(bracket))
+    {
+        rehash();
+    }
+
+    LiteralValues accept(ExpressionVisitor& visitor) const override { return visitor.visit(*this); }
+    void rehash() override
+    {
+        m_hash = hashNode({ static_cast<std::uint64_t>(Kind::Array), elements.size() });
+        m_treeSize = 1;
+        for (const auto& element : elements)
+        {
+            m_hash = hashNode({ m_hash, element->hash() });
+            m_treeSize += element->treeSize();
+        }
+    }
+
+    std::vector<std::unique_ptr<Expression>> elements;
+    Token bracket; // The opening one, where errors are reported
+};
+
+// A call of one of the built-in reductions of arrays, `sum(array)`, `min(array)` or `max(array)`. Their names are
+// resolved by the parser, there are no functions of the user.
+class CallExpression : public Expression
+{
+public:
+    enum class Builtin : std::uint8_t
+    {
+        Sum,
+        Min,
+        Max
+    };
+
+    static constexpr std::optional<Builtin> builtinNamed(std::string_view name)
+    {
+        if (name == "sum")
+        {
+            return Builtin::Sum;
+        }
+        if (name == "min")
+        {
+            return Builtin::Min;
+        }
+        if (name == "max")
+        {
+            return Builtin::Max;
+        }
+        return std::nullopt;
+    }
+
+    static constexpr std::string_view nameOf(Builtin builtin)
+    {
+        switch (builtin)
+        {
+        case Builtin::Sum:
+            return "sum";
+        case Builtin::Min:
+            return "min";
+        case Builtin::Max:
+            return "max";
+        }
+        return "";
+    }
+
+    CallExpression(Builtin builtin, Token name, std::unique_ptr<Expression> argument)
+        : Expression(Kind::Call)
+        , builtin(builtin)
+        , name(std::move(name))
+        , argument(std::move(argument))
+    {
+        this->name.location = nameOf(builtin);
+        rehash();
+    }
+
+    LiteralValues accept(ExpressionVisitor& visitor) const override { return visitor.visit(*this); }
+    void rehash() override
+    {
+        m_hash = hashNode(
+            { static_cast<std::uint64_t>(Kind::Call), static_cast<std::uint64_t>(builtin), argument->hash() });
+        m_treeSize = 1 + argument->treeSize();
+    }
+
+    Builtin builtin;
+    Token name; // Its location views nameOf(builtin) rather than the source, which the tree may outlive
+    std::unique_ptr<Expression> argument;
+};
+
 } // namespace lox
@@ -0,0 +1,170 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+// Replaces the global operator new and delete with ones that count every allocation in AllocStats, and fail the ones
+// made inside a FailingAllocations scope. Linking this file into a binary is what turns the counting on.
+
+#include "allocStats.h"
+
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+
+void* allocate(std::size_t size)
+{
+    if (lox::AllocStats::refuseAllocation()) [[unlikely]]
+    {
+        return nullptr;
+    }
+    lox::AllocStats::recordAllocation(size);
+    return std::malloc(size ? size : 1);
+}
+
+void* allocate(std::size_t size, std::align_val_t alignment)
+{
+    if (lox::AllocStats::refuseAllocation()) [[unlikely]]
+    {
+        return nullptr;
+    }
+    lox::AllocStats::recordAllocation(size);
+    auto align = static_cast<std::size_t>(alignment);
+    // aligned_alloc wants a size that is a multiple of the alignment
+    auto rounded = (size + align - 1) / align * align;
+    return std::aligned_alloc(align, rounded ? rounded : align);
+}
+
+void deallocate(void* ptr)
+{
+    if (ptr)
+    {
+        lox::AllocStats::recordDeallocation();
+        std::free(ptr);
+    }
+}
+
+[[maybe_unused]] const bool s_registered = (lox::AllocStats::markAvailable(), true);
+
+} // namespace
+
+void* operator new(std::size_t size)
+{
+    if (auto* ptr = allocate(size))
+    {
+        return ptr;
+    }
+    throw std::bad_alloc{};
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    return allocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return allocate(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    if (auto* ptr = allocate(size, alignment))
+    {
+        return ptr;
+    }
+    throw std::bad_alloc{};
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+    return operator new(size, alignment);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return allocate(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return allocate(size, alignment);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    deallocate(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    deallocate(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    deallocate(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+    deallocate(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept
+{
+    deallocate(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept
+{
+    deallocate(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept
+{
+    deallocate(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept
+{
+    deallocate(ptr);
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept
+{
+    deallocate(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept
+{
+    deallocate(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept
+{
+    deallocate(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept
+{
+    deallocate(ptr);
+}
@@ -0,0 +1,147 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+#include "allocStats.h"
+
+#include <array>
+#include <format>
+
+namespace lox
+{
+
+namespace
+{
+
+struct Counters
+{
+    std::atomic<std::uint64_t> allocations = 0;
+    std::atomic<std::uint64_t> bytes = 0;
+    std::atomic<std::uint64_t> deallocations = 0;
+};
+
+// One slot per phase, and a last one for allocations outside of any phase. Constant initialized, so allocations made
+// before main() are counted too.
+std::array<Counters, PhaseCount + 1> s_counters{};
+
+// Plain values, constant initialized, so the hooks can read them on any thread without running an initializer
+thread_local unsigned int t_failingScopes = 0;
+thread_local std::uint64_t t_failedAllocations = 0;
+
+Counters& countersFor(std::optional<Phase> phase)
+{
+    return s_counters[phase ? static_cast<std::size_t>(phase.value()) : PhaseCount];
+}
+
+AllocationCounts load(const Counters& counters)
+{
+    return { counters.allocations.load(std::memory_order_relaxed),
+             counters.bytes.load(std::memory_order_relaxed),
+             counters.deallocations.load(std::memory_order_relaxed) };
+}
+
+} // namespace
+
+void AllocStats::recordAllocation(std::size_t size)
+{
+    auto& counters = countersFor(PhaseScope::current());
+    counters.allocations.fetch_add(1, std::memory_order_relaxed);
+    counters.bytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+void AllocStats::recordDeallocation()
+{
+    countersFor(PhaseScope::current()).deallocations.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool AllocStats::refuseAllocation()
+{
+    if (t_failingScopes == 0) [[likely]]
+    {
+        return false;
+    }
+    ++t_failedAllocations;
+    return true;
+}
+
+AllocationCounts AllocStats::phase(Phase phase)
+{
+    return load(countersFor(phase));
+}
+
+AllocationCounts AllocStats::unattributed()
+{
+    return load(countersFor(std::nullopt));
+}
+
+AllocationCounts AllocStats::total()
+{
+    AllocationCounts sum{};
+    for (const auto& counters : s_counters)
+    {
+        auto counts = load(counters);
+        sum.allocations += counts.allocations;
+        sum.bytes += counts.bytes;
+        sum.deallocations += counts.deallocations;
+    }
+    return sum;
+}
+
+void AllocStats::reset()
+{
+    for (auto& counters : s_counters)
+    {
+        counters.allocations.store(0, std::memory_order_relaxed);
+        counters.bytes.store(0, std::memory_order_relaxed);
+        counters.deallocations.store(0, std::memory_order_relaxed);
+    }
+}
+
+std::string AllocStats::report()
+{
+    if (!available())
+    {
+        return "Allocation stats are not available, link LoxAllocHooks to collect them.\n";
+    }
+    std::string out = std::format("{:<12}{:>14}{:>16}{:>14}\n", "phase", "allocations", "bytes", "frees");
+    auto line = [&out](std::string_view name, const AllocationCounts& counts)
+    { out += std::format("{:<12}{:>14}{:>16}{:>14}\n", name, counts.allocations, counts.bytes, counts.deallocations); };
+    for (std::size_t i = 0; i < PhaseCount; ++i)
+    {
+        auto phase = static_cast<Phase>(i);
+        line(phaseName(phase), AllocStats::phase(phase));
+    }
+    line("(other)", unattributed());
+    line("total", total());
+    return out;
+}
+
+FailingAllocations::FailingAllocations()
+    : m_failedBefore(t_failedAllocations)
+{
+    ++t_failingScopes;
+}
+
+FailingAllocations::~FailingAllocations()
+{
+    --t_failingScopes;
+}
+
+std::uint64_t FailingAllocations::failed() const
+{
+    return t_failedAllocations - m_failedBefore;
+}
+
+} // namespace lox
@@ -0,0 +1,88 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include "tracer.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace lox
+{
+
+struct AllocationCounts
+{
+    std::uint64_t allocations = 0;
+    std::uint64_t bytes = 0;
+    std::uint64_t deallocations = 0;
+
+    AllocationCounts operator-(const AllocationCounts& other) const
+    {
+        return { allocations - other.allocations, bytes - other.bytes, deallocations - other.deallocations };
+    }
+};
+
+// Counts the heap allocations made during every phase, as marked by PhaseScope.
+//
+// The counting itself happens in the global operator new and delete of the LoxAllocHooks library. Without it linked in
+// nothing is counted and available() is false.
+class AllocStats
+{
+public:
+    static bool available() { return s_available.load(std::memory_order_relaxed); }
+
+    static AllocationCounts phase(Phase phase);
+    // Allocations made outside of any phase
+    static AllocationCounts unattributed();
+    static AllocationCounts total();
+    static void reset();
+
+    // One line per phase, for humans
+    static std::string report();
+
+    // Called by the hooks, must not allocate
+    static void markAvailable() { s_available.store(true, std::memory_order_relaxed); }
+    static void recordAllocation(std::size_t size);
+    static void recordDeallocation();
+    // Called by the hooks, true when the allocation must fail, which is then counted as failed
+    static bool refuseAllocation();
+
+private:
+    static inline std::atomic<bool> s_available = false;
+};
+
+// Makes the hooks fail every allocation the calling thread makes while it is alive, as if the heap were exhausted:
+// operator new throws std::bad_alloc and its nothrow form returns nullptr. For tests of code that must not allocate at
+// all. Scopes nest, and do nothing without LoxAllocHooks.
+class FailingAllocations
+{
+public:
+    FailingAllocations();
+    ~FailingAllocations();
+    FailingAllocations(const FailingAllocations&) = delete;
+    FailingAllocations& operator=(const FailingAllocations&) = delete;
+
+    // The allocations that failed on this thread since the scope began
+    std::uint64_t failed() const;
+
+private:
+    std::uint64_t m_failedBefore;
+};
+
+} // namespace lox
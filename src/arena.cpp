@@ -0,0 +1,80 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+#include "arena.h"
+
+#include <algorithm>
+
+namespace lox
+{
+
+namespace
+{
+
+constexpr std::size_t Alignment = alignof(std::max_align_t);
+
+std::size_t alignUp(std::size_t size)
+{
+    return (size + Alignment - 1) / Alignment * Alignment;
+}
+
+} // namespace
+
+Arena::Arena(std::size_t blockSize)
+    : m_blockSize(alignUp(std::max<std::size_t>(blockSize, Alignment)))
+{
+}
+
+void* Arena::allocate(std::size_t size)
+{
+    size = alignUp(std::max<std::size_t>(size, 1));
+    // Blocks kept from before the last rewind are reused before new ones are made
+    while (m_block < m_blocks.size() && m_offset + size > m_blocks[m_block].size)
+    {
+        m_block++;
+        m_offset = 0;
+    }
+    if (m_block == m_blocks.size())
+    {
+        auto blockSize = std::max(m_blockSize, size);
+        // operator new[] aligns to max_align_t, and so do the offsets
+        m_blocks.emplace_back(Block{ std::make_unique_for_overwrite<std::byte[]>(blockSize), blockSize });
+        m_offset = 0;
+    }
+    auto* memory = m_blocks[m_block].memory.get() + m_offset;
+    m_offset += size;
+    m_used += size;
+    return memory;
+}
+
+void Arena::rewind()
+{
+    m_block = 0;
+    m_offset = 0;
+    m_used = 0;
+}
+
+std::size_t Arena::capacity() const
+{
+    std::size_t capacity = 0;
+    for (const auto& block : m_blocks)
+    {
+        capacity += block.size;
+    }
+    return capacity;
+}
+
+} // namespace lox
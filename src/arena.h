@@ -0,0 +1,85 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace lox
+{
+
+// Hands out memory by bumping a pointer through blocks that it keeps until it is destroyed. Nothing is freed one
+// object at a time: rewinding makes all of it available again, so a workload that repeats itself stops allocating
+// once the blocks are big enough.
+//
+// Trees are built in the arena of the innermost Arena::Scope of their thread, see Expression::operator new.
+class Arena
+{
+public:
+    static constexpr std::size_t DefaultBlockSize = 16 * 1024;
+
+    explicit Arena(std::size_t blockSize = DefaultBlockSize);
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    // Aligned to alignof(std::max_align_t)
+    void* allocate(std::size_t size);
+    // Every object allocated so far must have been destroyed
+    void rewind();
+
+    std::size_t used() const { return m_used; }
+    std::size_t capacity() const;
+
+    // Makes `arena` the arena of the calling thread for as long as it lives
+    class Scope
+    {
+    public:
+        explicit Scope(Arena& arena)
+            : m_previous(s_current)
+        {
+            s_current = &arena;
+        }
+        ~Scope() { s_current = m_previous; }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        Arena* m_previous;
+    };
+
+    static Arena* current() { return s_current; }
+
+private:
+    struct Block
+    {
+        std::unique_ptr<std::byte[]> memory;
+        std::size_t size = 0;
+    };
+
+    std::size_t m_blockSize;
+    std::vector<Block> m_blocks;
+    std::size_t m_block = 0;  // The block being bumped through
+    std::size_t m_offset = 0; // Into that block
+    std::size_t m_used = 0;
+
+    static inline thread_local Arena* s_current = nullptr;
+};
+
+} // namespace lox
@@ -0,0 +1,229 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+
+#include "arrayKernels.h"
+
+#include <cstring>
+#include <limits>
+
+#if defined(__x86_64__) && defined(__linux__)
+#define LOX_KERNEL __attribute__((target_clones("avx2", "default")))
+#else
+#define LOX_KERNEL
+#endif
+
+// Lanes are only returned by helpers that are always inlined, so no call ever passes them through the ABI
+#pragma GCC diagnostic ignored "-Wpsabi"
+
+namespace lox::kernels
+{
+
+namespace
+{
+
+// Four doubles, one AVX register or two SSE ones
+using Lanes = double __attribute__((vector_size(32)));
+using LaneMask = decltype(Lanes{} < Lanes{});
+constexpr std::size_t Width = sizeof(Lanes) / sizeof(double);
+
+// Arrays are not aligned to the width of the lanes, so they are read and written with unaligned accesses
+[[gnu::always_inline]] inline Lanes load(const double* a, std::size_t index)
+{
+    Lanes lanes;
+    std::memcpy(&lanes, a + index, sizeof(lanes));
+    return lanes;
+}
+
+[[gnu::always_inline]] inline Lanes load(double a, std::size_t /*index*/)
+{
+    return Lanes{} + a;
+}
+
+[[gnu::always_inline]] inline double at(const double* a, std::size_t index)
+{
+    return a[index];
+}
+
+[[gnu::always_inline]] inline double at(double a, std::size_t /*index*/)
+{
+    return a;
+}
+
+[[gnu::always_inline]] inline void store(double* out, std::size_t index, const Lanes& lanes)
+{
+    std::memcpy(out + index, &lanes, sizeof(lanes));
+}
+
+// A comparison as numbers, 1 where it holds
+[[gnu::always_inline]] inline Lanes asNumbers(const LaneMask& mask)
+{
+    return __builtin_convertvector(-mask, Lanes);
+}
+
+[[gnu::always_inline]] inline double asNumbers(bool holds)
+{
+    return holds ? 1.0 : 0.0;
+}
+
+// The operators, on lanes and on single elements. Always inlined, even unoptimized, as the AVX2 build of a kernel
+// cannot pass lanes to a baseline function.
+#define LOX_ELEMENT_WISE(Name, expression)                                                                             \
+    struct Name                                                                                                        \
+    {                                                                                                                  \
+        template <typename T> [[gnu::always_inline]] auto operator()(const T& x, const T& y) const                    \
+        {                                                                                                              \
+            return expression;                                                                                         \
+        }                                                                                                              \
+    };
+LOX_ELEMENT_WISE(Add, x + y)
+LOX_ELEMENT_WISE(Subtract, x - y)
+LOX_ELEMENT_WISE(Multiply, x * y)
+LOX_ELEMENT_WISE(Divide, x / y)
+LOX_ELEMENT_WISE(Greater, asNumbers(x > y))
+LOX_ELEMENT_WISE(GreaterEqual, asNumbers(x >= y))
+LOX_ELEMENT_WISE(Less, asNumbers(x < y))
+LOX_ELEMENT_WISE(LessEqual, asNumbers(x <= y))
+LOX_ELEMENT_WISE(Negate, (static_cast<void>(y), -x))
+LOX_ELEMENT_WISE(IsZero, asNumbers(x == y))
+#undef LOX_ELEMENT_WISE
+
+// out[i] = fn(a[i], b[i]), where a number operand is the same in every lane
+template <typename Fn, typename Left, typename Right>
+[[gnu::always_inline]] inline void each(Left a, Right b, double* out, std::size_t size)
+{
+    std::size_t i = 0;
+    for (; i + Width <= size; i += Width)
+    {
+        store(out, i, Fn{}(load(a, i), load(b, i)));
+    }
+    for (; i < size; ++i)
+    {
+        out[i] = Fn{}(at(a, i), at(b, i));
+    }
+}
+
+template <typename Left, typename Right>
+[[gnu::always_inline]] inline void dispatch(Op op, Left a, Right b, double* out, std::size_t size)
+{
+    switch (op)
+    {
+    case Op::Add:
+        return each<Add>(a, b, out, size);
+    case Op::Subtract:
+        return each<Subtract>(a, b, out, size);
+    case Op::Multiply:
+        return each<Multiply>(a, b, out, size);
+    case Op::Divide:
+        return each<Divide>(a, b, out, size);
+    case Op::Greater:
+        return each<Greater>(a, b, out, size);
+    case Op::GreaterEqual:
+        return each<GreaterEqual>(a, b, out, size);
+    case Op::Less:
+        return each<Less>(a, b, out, size);
+    case Op::LessEqual:
+        return each<LessEqual>(a, b, out, size);
+    }
+}
+
+// The smallest element, or the largest, or NaN when there is one. Lanes keep their own best element, and remember
+// whether they saw a NaN, which compares false with everything.
+template <bool Smallest> [[gnu::always_inline]] inline double pick(const double* a, std::size_t size)
+{
+    Lanes best = load(a[0], 0);
+    LaneMask nan{};
+    std::size_t i = 0;
+    for (; i + Width <= size; i += Width)
+    {
+        auto lanes = load(a, i);
+        nan |= lanes != lanes;
+        best = (Smallest ? lanes < best : lanes > best) ? lanes : best;
+    }
+    double result = best[0];
+    for (std::size_t lane = 0; lane < Width; ++lane)
+    {
+        if (nan[lane])
+        {
+            return std::numeric_limits<double>::quiet_NaN();
+        }
+        result = (Smallest ? best[lane] < result : best[lane] > result) ? best[lane] : result;
+    }
+    for (; i < size; ++i)
+    {
+        if (a[i] != a[i])
+        {
+            return std::numeric_limits<double>::quiet_NaN();
+        }
+        result = (Smallest ? a[i] < result : a[i] > result) ? a[i] : result;
+    }
+    return result;
+}
+
+} // namespace
+
+LOX_KERNEL void apply(Op op, const double* a, const double* b, double* out, std::size_t size)
+{
+    dispatch(op, a, b, out, size);
+}
+
+LOX_KERNEL void apply(Op op, const double* a, double b, double* out, std::size_t size)
+{
+    dispatch(op, a, b, out, size);
+}
+
+LOX_KERNEL void apply(Op op, double a, const double* b, double* out, std::size_t size)
+{
+    dispatch(op, a, b, out, size);
+}
+
+LOX_KERNEL void negate(const double* a, double* out, std::size_t size)
+{
+    each<Negate>(a, 0.0, out, size);
+}
+
+LOX_KERNEL void logicalNot(const double* a, double* out, std::size_t size)
+{
+    each<IsZero>(a, 0.0, out, size);
+}
+
+LOX_KERNEL double sum(const double* a, std::size_t size)
+{
+    Lanes total{};
+    std::size_t i = 0;
+    for (; i + Width <= size; i += Width)
+    {
+        total += load(a, i);
+    }
+    double result = (total[0] + total[1]) + (total[2] + total[3]);
+    for (; i < size; ++i)
+    {
+        result += a[i];
+    }
+    return result;
+}
+
+LOX_KERNEL double min(const double* a, std::size_t size)
+{
+    return pick<true>(a, size);
+}
+
+LOX_KERNEL double max(const double* a, std::size_t size)
+{
+    return pick<false>(a, size);
+}
+
+} // namespace lox::kernels
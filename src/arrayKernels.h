@@ -0,0 +1,59 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Loops over arrays of doubles, a few elements at a time in SIMD registers. On x86-64 Linux every kernel is built
+// twice, for AVX2 and for the baseline, and the loader picks the one the machine runs.
+namespace lox::kernels
+{
+
+// The binary operators of arrays. Comparisons give 1 where they hold and 0 where they do not.
+enum class Op : std::uint8_t
+{
+    Add,
+    Subtract,
+    Multiply,
+    Divide,
+    Greater,
+    GreaterEqual,
+    Less,
+    LessEqual
+};
+
+// out[i] = a[i] op b[i]
+void apply(Op op, const double* a, const double* b, double* out, std::size_t size);
+// out[i] = a[i] op b
+void apply(Op op, const double* a, double b, double* out, std::size_t size);
+// out[i] = a op b[i]
+void apply(Op op, double a, const double* b, double* out, std::size_t size);
+
+// out[i] = -a[i]
+void negate(const double* a, double* out, std::size_t size);
+// out[i] = 1 where a[i] is 0, and 0 elsewhere
+void logicalNot(const double* a, double* out, std::size_t size);
+
+// Adds the elements in several lanes at once, so the rounding may differ from adding them one after the other
+double sum(const double* a, std::size_t size);
+// NaN when an element is NaN. `size` must not be 0.
+double min(const double* a, std::size_t size);
+double max(const double* a, std::size_t size);
+
+} // namespace lox::kernels
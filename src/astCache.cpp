@@ -0,0 +1,227 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+#include "astCache.h"
+
+#include "astSerializer.h"
+#include "logger.h"
+
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <span>
+#include <string>
+#include <system_error>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <iterator>
+#endif
+
+#ifndef LOX_VERSION
+#define LOX_VERSION "unknown"
+#endif
+
+namespace lox
+{
+
+namespace
+{
+
+constexpr std::string_view Magic{ "LOXAST\0\0", 8 };
+constexpr std::string_view Version{ LOX_VERSION };
+
+// The fixed part of a file, followed by the version and then the tree
+struct Header
+{
+    char magic[8];
+    std::uint32_t format;
+    std::uint32_t versionSize;
+    std::uint64_t sourceSize;
+    std::uint64_t sourceHash;
+};
+
+// Stable across runs and platforms of the same endianness, unlike std::hash
+std::uint64_t contentHash(std::string_view text)
+{
+    std::uint64_t hash = text.size();
+    std::size_t i = 0;
+    for (; i + sizeof(std::uint64_t) <= text.size(); i += sizeof(std::uint64_t))
+    {
+        std::uint64_t chunk = 0;
+        std::memcpy(&chunk, text.data() + i, sizeof(chunk));
+        hash = hashNode({ hash, chunk });
+    }
+    std::uint64_t tail = 0;
+    std::memcpy(&tail, text.data() + i, text.size() - i);
+    return hashNode({ hash, tail });
+}
+
+// A read-only view of a whole file, empty when it cannot be read
+class MappedFile
+{
+public:
+    explicit MappedFile(const std::filesystem::path& path)
+    {
+#ifdef __linux__
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            return;
+        }
+        struct stat info{};
+        if (::fstat(fd, &info) == 0 && info.st_size > 0)
+        {
+            auto size = static_cast<std::size_t>(info.st_size);
+            void* data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data != MAP_FAILED)
+            {
+                m_data = data;
+                m_size = size;
+            }
+        }
+        ::close(fd);
+#else
+        std::ifstream file{ path, std::ios::binary };
+        m_contents.assign(std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{});
+#endif
+    }
+
+    ~MappedFile()
+    {
+#ifdef __linux__
+        if (m_data)
+        {
+            ::munmap(m_data, m_size);
+        }
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    std::span<const char> bytes() const
+    {
+#ifdef __linux__
+        return { static_cast<const char*>(m_data), m_size };
+#else
+        return { m_contents.data(), m_contents.size() };
+#endif
+    }
+
+private:
+#ifdef __linux__
+    void* m_data = nullptr;
+    std::size_t m_size = 0;
+#else
+    std::string m_contents;
+#endif
+};
+
+} // namespace
+
+AstCache::AstCache(std::filesystem::path directory)
+    : m_directory(std::move(directory))
+{
+}
+
+const Expression* AstCache::load(std::string_view source, Session& session)
+{
+    auto hash = contentHash(source);
+    MappedFile file{ pathOf(hash) };
+    auto bytes = file.bytes();
+
+    Header header{};
+    if (bytes.size() >= sizeof(header))
+    {
+        std::memcpy(&header, bytes.data(), sizeof(header));
+    }
+    bool valid = bytes.size() >= sizeof(header) && std::string_view{ header.magic, sizeof(header.magic) } == Magic &&
+                 header.format == FormatVersion && header.versionSize == Version.size() &&
+                 bytes.size() - sizeof(header) >= header.versionSize &&
+                 std::string_view{ bytes.data() + sizeof(header), header.versionSize } == Version &&
+                 header.sourceSize == source.size() && header.sourceHash == hash;
+    auto* tree = valid ? session.restore(bytes.subspan(sizeof(header) + header.versionSize), source) : nullptr;
+    if (tree)
+    {
+        m_stats.hits++;
+    }
+    else
+    {
+        m_stats.misses++;
+    }
+    return tree;
+}
+
+bool AstCache::store(std::string_view source, const Expression& tree, const SymbolTable& symbols)
+{
+    if (source.size() > std::numeric_limits<std::uint32_t>::max())
+    {
+        return false; // Token offsets are 32 bits
+    }
+    auto hash = contentHash(source);
+    Header header{ {}, FormatVersion, static_cast<std::uint32_t>(Version.size()), source.size(), hash };
+    std::memcpy(header.magic, Magic.data(), Magic.size());
+    std::string bytes(reinterpret_cast<const char*>(&header), sizeof(header));
+    bytes += Version;
+    serializeTree(tree, source, symbols, bytes);
+
+    // Written aside and renamed over the old file, so a concurrent run never maps half of one
+    std::error_code error{};
+    std::filesystem::create_directories(m_directory, error);
+    auto path = pathOf(hash);
+    auto temporary = path;
+    temporary += std::format(".{:x}.tmp", std::random_device{}());
+    {
+        std::ofstream file{ temporary, std::ios::binary | std::ios::trunc };
+        file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+        if (!file)
+        {
+            file.close();
+            std::filesystem::remove(temporary, error);
+            Logger::warn(std::format("Failed to write the cached tree to {}.", temporary.string()));
+            return false;
+        }
+    }
+    std::filesystem::rename(temporary, path, error);
+    if (error)
+    {
+        std::filesystem::remove(temporary, error);
+        Logger::warn(std::format("Failed to write the cached tree to {}.", path.string()));
+        return false;
+    }
+    m_stats.stores++;
+    return true;
+}
+
+std::filesystem::path AstCache::pathOf(std::string_view source) const
+{
+    return pathOf(contentHash(source));
+}
+
+std::filesystem::path AstCache::pathOf(std::uint64_t sourceHash) const
+{
+    auto key = hashNode({ sourceHash, contentHash(Version), FormatVersion });
+    return m_directory / std::format("{:016x}.ast", key);
+}
+
+} // namespace lox
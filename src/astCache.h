@@ -0,0 +1,68 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include "BaseExpression.h"
+#include "session.h"
+#include "symbolTable.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+
+namespace lox
+{
+
+// Keeps the parsed trees of scripts in a directory, so running an unchanged script again skips lexing and parsing.
+//
+// A tree is stored in one file named after a hash of the source and of the interpreter version, so editing the script
+// or upgrading the interpreter looks for another file. The file repeats the version, the source size and its hash,
+// which are checked before the tree is read. Files are memory-mapped and read in one pass, straight into the arena of
+// the Session. Unusable files are ignored and overwritten by the next store.
+class AstCache
+{
+public:
+    // Bumped whenever the layout of the files, or the nodes they hold, change
+    static constexpr std::uint32_t FormatVersion = 3;
+
+    explicit AstCache(std::filesystem::path directory);
+
+    // The tree cached for `source`, made in `session` as if it was just parsed, or nullptr. `source` must outlive it.
+    const Expression* load(std::string_view source, Session& session);
+    // Saves `tree`, parsed from `source`, creating the directory when needed. False when it could not be written.
+    bool store(std::string_view source, const Expression& tree, const SymbolTable& symbols);
+
+    // Where the tree of `source` goes
+    std::filesystem::path pathOf(std::string_view source) const;
+    const std::filesystem::path& directory() const { return m_directory; }
+
+    struct Stats
+    {
+        std::uint64_t hits = 0;
+        std::uint64_t misses = 0;
+        std::uint64_t stores = 0;
+    };
+    const Stats& stats() const { return m_stats; }
+
+private:
+    std::filesystem::path pathOf(std::uint64_t sourceHash) const;
+
+    std::filesystem::path m_directory;
+    Stats m_stats;
+};
+
+} // namespace lox
@@ -0,0 +1,447 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+#include "astSerializer.h"
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <type_traits>
+#include <vector>
+
+namespace lox
+{
+
+namespace
+{
+
+enum class Tag : std::uint8_t
+{
+    Binary,
+    Literal,
+    Unary,
+    Grouping,
+    Variable,
+    Logical,
+    Conditional,
+    Array,
+    Call
+};
+
+bool isBinaryOperator(TokenType type)
+{
+    using enum TokenType;
+    switch (type)
+    {
+    case Comma:
+    case Plus:
+    case Minus:
+    case Star:
+    case Slash:
+    case Greater:
+    case GreaterEqual:
+    case Less:
+    case LessEqual:
+    case EqualEqual:
+    case BangEqual:
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool isUnaryOperator(TokenType type)
+{
+    return type == TokenType::Minus || type == TokenType::Bang;
+}
+
+bool isLogicalOperator(TokenType type)
+{
+    return type == TokenType::And || type == TokenType::Or;
+}
+
+class TreeWriter : public ExpressionVisitor
+{
+public:
+    TreeWriter(std::string_view source, const SymbolTable& symbols, std::string& out)
+        : m_source(source)
+        , m_symbols(symbols)
+        , m_out(out)
+    {
+    }
+
+    LiteralValues visit(const BinaryExpression& expr) override
+    {
+        put(Tag::Binary);
+        putToken(expr.op);
+        expr.left->accept(*this);
+        return expr.right->accept(*this);
+    }
+
+    LiteralValues visit(const LiteralExpression& expr) override
+    {
+        put(Tag::Literal);
+        put(static_cast<std::uint8_t>(expr.value.index()));
+        if (auto* number = std::get_if<double>(&expr.value))
+        {
+            put(*number);
+        }
+        else if (auto* string = std::get_if<LoxString>(&expr.value))
+        {
+            putText(string->view());
+        }
+        else if (auto* boolean = std::get_if<bool>(&expr.value))
+        {
+            put(static_cast<std::uint8_t>(*boolean));
+        }
+        else if (auto* array = std::get_if<NumberArray>(&expr.value))
+        {
+            put(static_cast<std::uint32_t>(array->size()));
+            for (auto element : array->elements())
+            {
+                put(element);
+            }
+        }
+        return NullLiteral{};
+    }
+
+    LiteralValues visit(const UnaryExpression& expr) override
+    {
+        put(Tag::Unary);
+        putToken(expr.op);
+        return expr.right->accept(*this);
+    }
+
+    LiteralValues visit(const GroupingExpression& expr) override
+    {
+        put(Tag::Grouping);
+        return expr.expression->accept(*this);
+    }
+
+    LiteralValues visit(const VariableExpression& expr) override
+    {
+        put(Tag::Variable);
+        put(static_cast<std::uint32_t>(expr.line));
+        putText(m_symbols.name(expr.symbol));
+        return NullLiteral{};
+    }
+
+    LiteralValues visit(const LogicalExpression& expr) override
+    {
+        put(Tag::Logical);
+        putToken(expr.op);
+        expr.left->accept(*this);
+        return expr.right->accept(*this);
+    }
+
+    LiteralValues visit(const ConditionalExpression& expr) override
+    {
+        put(Tag::Conditional);
+        expr.condition->accept(*this);
+        expr.thenBranch->accept(*this);
+        return expr.elseBranch->accept(*this);
+    }
+
+    LiteralValues visit(const ArrayExpression& expr) override
+    {
+        put(Tag::Array);
+        putToken(expr.bracket);
+        put(static_cast<std::uint32_t>(expr.elements.size()));
+        for (const auto& element : expr.elements)
+        {
+            element->accept(*this);
+        }
+        return NullLiteral{};
+    }
+
+    LiteralValues visit(const CallExpression& expr) override
+    {
+        put(Tag::Call);
+        put(expr.builtin);
+        putToken(expr.name);
+        return expr.argument->accept(*this);
+    }
+
+private:
+    template <typename Value>
+    void put(Value value)
+    {
+        static_assert(std::is_trivially_copyable_v<Value>);
+        m_out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    void putText(std::string_view text)
+    {
+        put(static_cast<std::uint32_t>(text.size()));
+        m_out.append(text);
+    }
+
+    // Operators carry no literal, only their type, line and where they are in the source
+    void putToken(const Token& token)
+    {
+        put(static_cast<std::uint8_t>(token.type));
+        put(static_cast<std::uint32_t>(token.lineNo));
+        std::uint32_t offset = 0;
+        std::uint32_t length = 0;
+        auto begin = m_source.data();
+        auto end = m_source.data() + m_source.size();
+        if (std::less_equal<>{}(begin, token.location.data()) &&
+            std::less_equal<>{}(token.location.data() + token.location.size(), end))
+        {
+            offset = static_cast<std::uint32_t>(token.location.data() - begin);
+            length = static_cast<std::uint32_t>(token.location.size());
+        }
+        put(offset);
+        put(length);
+    }
+
+    std::string_view m_source;
+    const SymbolTable& m_symbols;
+    std::string& m_out;
+};
+
+class TreeReader
+{
+public:
+    TreeReader(std::span<const char> bytes, std::string_view source, SymbolTable& symbols, StringInterner& strings)
+        : m_bytes(bytes)
+        , m_source(source)
+        , m_symbols(symbols)
+        , m_strings(strings)
+    {
+    }
+
+    ExpressionUPTR read()
+    {
+        auto tree = node();
+        return m_position == m_bytes.size() ? std::move(tree) : nullptr;
+    }
+
+private:
+    ExpressionUPTR node()
+    {
+        Tag tag{};
+        if (!get(tag))
+        {
+            return nullptr;
+        }
+        switch (tag)
+        {
+        case Tag::Binary:
+        {
+            Token op{ TokenType::Eof, std::monostate{}, "", 0 };
+            if (!getToken(op) || !isBinaryOperator(op.type))
+            {
+                return nullptr;
+            }
+            auto left = node();
+            auto right = left ? node() : nullptr;
+            return right ? std::make_unique<BinaryExpression>(std::move(left), op, std::move(right)) : nullptr;
+        }
+        case Tag::Literal:
+            return literal();
+        case Tag::Unary:
+        {
+            Token op{ TokenType::Eof, std::monostate{}, "", 0 };
+            if (!getToken(op) || !isUnaryOperator(op.type))
+            {
+                return nullptr;
+            }
+            auto right = node();
+            return right ? std::make_unique<UnaryExpression>(op, std::move(right)) : nullptr;
+        }
+        case Tag::Grouping:
+        {
+            auto expression = node();
+            return expression ? std::make_unique<GroupingExpression>(std::move(expression)) : nullptr;
+        }
+        case Tag::Variable:
+        {
+            std::uint32_t line = 0;
+            std::string_view name{};
+            if (!get(line) || !getText(name) || name.empty())
+            {
+                return nullptr;
+            }
+            return std::make_unique<VariableExpression>(m_symbols.intern(name), line);
+        }
+        case Tag::Logical:
+        {
+            Token op{ TokenType::Eof, std::monostate{}, "", 0 };
+            if (!getToken(op) || !isLogicalOperator(op.type))
+            {
+                return nullptr;
+            }
+            auto left = node();
+            auto right = left ? node() : nullptr;
+            return right ? std::make_unique<LogicalExpression>(std::move(left), op, std::move(right)) : nullptr;
+        }
+        case Tag::Conditional:
+        {
+            auto condition = node();
+            auto thenBranch = condition ? node() : nullptr;
+            auto elseBranch = thenBranch ? node() : nullptr;
+            return elseBranch ? std::make_unique<ConditionalExpression>(
+                                    std::move(condition), std::move(thenBranch), std::move(elseBranch))
+                              : nullptr;
+        }
+        case Tag::Array:
+        {
+            Token bracket{ TokenType::Eof, std::monostate{}, "", 0 };
+            std::uint32_t size = 0;
+            if (!getToken(bracket) || bracket.type != TokenType::LeftBracket || !get(size))
+            {
+                return nullptr;
+            }
+            std::vector<ExpressionUPTR> elements{};
+            for (std::uint32_t i = 0; i < size; ++i)
+            {
+                auto element = node();
+                if (!element)
+                {
+                    return nullptr;
+                }
+                elements.push_back(std::move(element));
+            }
+            return std::make_unique<ArrayExpression>(std::move(elements), bracket);
+        }
+        case Tag::Call:
+        {
+            CallExpression::Builtin builtin{};
+            Token name{ TokenType::Eof, std::monostate{}, "", 0 };
+            if (!get(builtin) || builtin > CallExpression::Builtin::Max || !getToken(name) ||
+                name.type != TokenType::Identifier)
+            {
+                return nullptr;
+            }
+            // The Lexer interns the name like any identifier, so names get the ids a fresh parse gives them
+            name.literal = m_symbols.intern(CallExpression::nameOf(builtin));
+            auto argument = node();
+            return argument ? std::make_unique<CallExpression>(builtin, name, std::move(argument)) : nullptr;
+        }
+        }
+        return nullptr;
+    }
+
+    ExpressionUPTR literal()
+    {
+        std::uint8_t index = 0;
+        if (!get(index))
+        {
+            return nullptr;
+        }
+        switch (index)
+        {
+        case 0:
+        {
+            std::string_view text{};
+            // Interned, as the Parser does with string literals
+            return getText(text) ? std::make_unique<LiteralExpression>(m_strings.intern(text)) : nullptr;
+        }
+        case 1:
+        {
+            double number = 0;
+            return get(number) ? std::make_unique<LiteralExpression>(number) : nullptr;
+        }
+        case 2:
+        {
+            std::uint8_t boolean = 0;
+            return get(boolean) && boolean <= 1 ? std::make_unique<LiteralExpression>(boolean == 1) : nullptr;
+        }
+        case 3:
+            return std::make_unique<LiteralExpression>(NullLiteral{});
+        case 4:
+        {
+            std::uint32_t size = 0;
+            if (!get(size) || (m_bytes.size() - m_position) / sizeof(double) < size)
+            {
+                return nullptr;
+            }
+            auto bytes = m_bytes.subspan(m_position, size * sizeof(double));
+            m_position += bytes.size();
+            auto copy = [bytes](double* elements) { std::memcpy(elements, bytes.data(), bytes.size()); };
+            return std::make_unique<LiteralExpression>(NumberArray::make(size, copy));
+        }
+        default:
+            return nullptr;
+        }
+    }
+
+    template <typename Value>
+    bool get(Value& value)
+    {
+        static_assert(std::is_trivially_copyable_v<Value>);
+        if (m_bytes.size() - m_position < sizeof(value))
+        {
+            return false;
+        }
+        std::memcpy(&value, m_bytes.data() + m_position, sizeof(value));
+        m_position += sizeof(value);
+        return true;
+    }
+
+    // Views the bytes, which must outlive it
+    bool getText(std::string_view& text)
+    {
+        std::uint32_t size = 0;
+        if (!get(size) || m_bytes.size() - m_position < size)
+        {
+            return false;
+        }
+        text = std::string_view{ m_bytes.data() + m_position, size };
+        m_position += size;
+        return true;
+    }
+
+    bool getToken(Token& token)
+    {
+        std::uint8_t type = 0;
+        std::uint32_t line = 0;
+        std::uint32_t offset = 0;
+        std::uint32_t length = 0;
+        if (!get(type) || type > TokenType::Error || !get(line) || !get(offset) || !get(length) ||
+            offset > m_source.size() || length > m_source.size() - offset)
+        {
+            return false;
+        }
+        token = Token{ static_cast<TokenType>(type), std::monostate{}, m_source.substr(offset, length), line };
+        return true;
+    }
+
+    std::span<const char> m_bytes;
+    std::size_t m_position = 0;
+    std::string_view m_source;
+    SymbolTable& m_symbols;
+    StringInterner& m_strings;
+};
+
+} // namespace
+
+void serializeTree(const Expression& tree, std::string_view source, const SymbolTable& symbols, std::string& out)
+{
+    TreeWriter writer{ source, symbols, out };
+    tree.accept(writer);
+}
+
+ExpressionUPTR deserializeTree(std::span<const char> bytes,
+                               std::string_view source,
+                               SymbolTable& symbols,
+                               StringInterner& strings)
+{
+    return TreeReader{ bytes, source, symbols, strings }.read();
+}
+
+} // namespace lox
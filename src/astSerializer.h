@@ -0,0 +1,43 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include "BaseExpression.h"
+#include "loxString.h"
+#include "parser.h"
+#include "symbolTable.h"
+
+#include <span>
+#include <string>
+#include <string_view>
+
+namespace lox
+{
+
+// Appends a compact binary form of `tree`, parsed from `source`, to `out`. The nodes are written in preorder. Token
+// locations are kept as offsets into `source`, and names and string literals as text, so the tree can be read back
+// into tables other than the ones it was parsed with.
+void serializeTree(const Expression& tree, std::string_view source, const SymbolTable& symbols, std::string& out);
+
+// Reads back a tree written by serializeTree from the same `source`, interning its names into `symbols` and its
+// strings into `strings`. nullptr when the bytes are not exactly one valid tree.
+ExpressionUPTR deserializeTree(std::span<const char> bytes,
+                               std::string_view source,
+                               SymbolTable& symbols,
+                               StringInterner& strings);
+
+} // namespace lox
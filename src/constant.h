@@ -0,0 +1,665 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include "BaseExpression.h"
+#include "lexical.h"
+#include "token.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string_view>
+
+namespace lox
+{
+
+// A string literal usable as a template argument
+template <std::size_t Size> struct FixedString
+{
+    char text[Size]{};
+
+    consteval FixedString(const char (&literal)[Size]) { std::copy_n(literal, Size, text); }
+
+    constexpr std::string_view view() const { return { text, Size - 1 }; }
+};
+
+// The value of a constant expression: the numbers, booleans and nil of LiteralValues, without strings or arrays
+struct ConstantValue
+{
+    enum class Type
+    {
+        Number,
+        Boolean,
+        Nil
+    };
+
+    Type type = Type::Nil;
+    double number = 0;
+    bool boolean = false;
+};
+
+// Reached only when a constant does not evaluate. Not constexpr, so the compiler stops at the call and quotes `reason`.
+inline void constantError(const char* reason)
+{
+    (void)reason;
+}
+
+// Lexes, parses and evaluates a Lox expression during compilation, in one pass and without building a tree.
+//
+// Follows the grammar of the Parser, scans tokens with the same rules as the Lexer, which it shares through
+// lexical.h, and computes what Interpreter::evaluateTree would. Anything the interpreter would reject, and strings,
+// arrays and variables, which are not constants, stop the compilation instead. Operands that the interpreter would
+// skip, past a deciding `and` or `or` or in the branch a conditional does not select, are parsed without being
+// evaluated.
+class ConstantEvaluator
+{
+public:
+    consteval explicit ConstantEvaluator(std::string_view source)
+        : m_source(source)
+    {
+        advance();
+    }
+
+    consteval ConstantValue evaluate()
+    {
+        auto value = comma();
+        if (m_token.type != TokenType::Eof)
+        {
+            constantError("Expected the end of the expression.");
+        }
+        return value;
+    }
+
+private:
+    struct Scanned
+    {
+        TokenType type = TokenType::Eof;
+        double number = 0;
+    };
+
+    // expression → conditional ( "," conditional )*, which the interpreter evaluates to nil
+    consteval ConstantValue comma()
+    {
+        auto value = conditional();
+        while (match(TokenType::Comma))
+        {
+            conditional();
+            value = ConstantValue{};
+        }
+        return value;
+    }
+
+    // conditional → logic_or ( "?" expression ":" conditional )?
+    consteval ConstantValue conditional()
+    {
+        auto condition = logicOr();
+        if (!match(TokenType::Question))
+        {
+            return condition;
+        }
+        bool selected = isTruthy(condition);
+        auto thenValue = skipping(!selected, &ConstantEvaluator::comma);
+        if (!match(TokenType::Colon))
+        {
+            constantError("Expected ':' after the then branch of a conditional.");
+        }
+        auto elseValue = skipping(selected, &ConstantEvaluator::conditional);
+        return selected ? thenValue : elseValue;
+    }
+
+    consteval ConstantValue logicOr()
+    {
+        auto left = logicAnd();
+        while (match(TokenType::Or))
+        {
+            bool decided = isTruthy(left);
+            auto right = skipping(decided, &ConstantEvaluator::logicAnd);
+            left = decided ? left : right;
+        }
+        return left;
+    }
+
+    consteval ConstantValue logicAnd()
+    {
+        auto left = equality();
+        while (match(TokenType::And))
+        {
+            bool decided = !isTruthy(left);
+            auto right = skipping(decided, &ConstantEvaluator::equality);
+            left = decided ? left : right;
+        }
+        return left;
+    }
+
+    // Parses with `parse`, evaluating nothing when `skip` is set
+    consteval ConstantValue skipping(bool skip, ConstantValue (ConstantEvaluator::*parse)())
+    {
+        bool outer = m_skipping;
+        m_skipping = outer || skip;
+        auto value = (this->*parse)();
+        m_skipping = outer;
+        return value;
+    }
+
+    consteval ConstantValue equality()
+    {
+        auto left = comparison();
+        while (m_token.type == TokenType::BangEqual || m_token.type == TokenType::EqualEqual)
+        {
+            auto op = take();
+            auto right = comparison();
+            bool equal = isEqual(left, right);
+            left = boolean(op == TokenType::EqualEqual ? equal : !equal);
+        }
+        return left;
+    }
+
+    consteval ConstantValue comparison()
+    {
+        using enum TokenType;
+        auto left = term();
+        while (m_token.type == Greater || m_token.type == GreaterEqual || m_token.type == Less ||
+               m_token.type == LessEqual)
+        {
+            auto op = take();
+            auto right = term();
+            double a = numberOf(left);
+            double b = numberOf(right);
+            left = boolean(op == Greater ? a > b : op == GreaterEqual ? a >= b : op == Less ? a < b : a <= b);
+        }
+        return left;
+    }
+
+    consteval ConstantValue term()
+    {
+        auto left = factor();
+        while (m_token.type == TokenType::Plus || m_token.type == TokenType::Minus)
+        {
+            auto op = take();
+            auto right = factor();
+            double a = numberOf(left);
+            double b = numberOf(right);
+            left = number(sum(a, op == TokenType::Plus ? b : -b));
+        }
+        return left;
+    }
+
+    consteval ConstantValue factor()
+    {
+        auto left = unary();
+        while (m_token.type == TokenType::Slash || m_token.type == TokenType::Star)
+        {
+            auto op = take();
+            auto right = unary();
+            double a = numberOf(left);
+            double b = numberOf(right);
+            left = number(op == TokenType::Star ? product(a, b) : quotient(a, b));
+        }
+        return left;
+    }
+
+    consteval ConstantValue unary()
+    {
+        if (match(TokenType::Bang))
+        {
+            return boolean(!isTruthy(unary()));
+        }
+        if (match(TokenType::Minus))
+        {
+            return number(-numberOf(unary()));
+        }
+        return primary();
+    }
+
+    consteval ConstantValue primary()
+    {
+        using enum TokenType;
+        auto token = m_token;
+        switch (take())
+        {
+        case False:
+            return boolean(false);
+        case True:
+            return boolean(true);
+        case Nil:
+            return ConstantValue{};
+        case Number:
+            return number(token.number);
+        case LeftParen:
+        {
+            auto value = comma();
+            if (!match(RightParen))
+            {
+                constantError("Expected ')' after expression.");
+            }
+            return value;
+        }
+        default:
+            constantError("Expected expression.");
+            return ConstantValue{};
+        }
+    }
+
+    static consteval ConstantValue number(double value)
+    {
+        return ConstantValue{ ConstantValue::Type::Number, value, false };
+    }
+
+    static consteval ConstantValue boolean(bool value)
+    {
+        return ConstantValue{ ConstantValue::Type::Boolean, 0, value };
+    }
+
+    // Anything goes in operands that are skipped, their values are never used
+    consteval double numberOf(const ConstantValue& value) const
+    {
+        if (value.type != ConstantValue::Type::Number && !m_skipping)
+        {
+            constantError("Operands must be numbers.");
+        }
+        return value.number;
+    }
+
+    static consteval bool isTruthy(const ConstantValue& value)
+    {
+        return value.type == ConstantValue::Type::Boolean ? value.boolean : value.type != ConstantValue::Type::Nil;
+    }
+
+    static consteval bool isEqual(const ConstantValue& a, const ConstantValue& b)
+    {
+        if (a.type != b.type)
+        {
+            return false;
+        }
+        return a.type == ConstantValue::Type::Number    ? a.number == b.number
+               : a.type == ConstantValue::Type::Boolean ? a.boolean == b.boolean
+                                                        : true;
+    }
+
+    // IEEE arithmetic, as the interpreter does it. Constant expressions refuse to overflow to an infinity, or to make a
+    // NaN out of numbers, so those results are worked out beforehand. Scaling by a power of two is exact in the ranges
+    // it is used, and commutes with the rounding, so a scaled sum overflows exactly when the real one would. Products
+    // and quotients of finite numbers are rounded by hand from the integer significands and exponents of the operands,
+    // which no intermediate can overflow.
+    static constexpr double Infinity = std::numeric_limits<double>::infinity();
+    static constexpr double NaN = std::numeric_limits<double>::quiet_NaN();
+
+    __extension__ using Wide = unsigned __int128;
+
+    // A finite double as significand * 2^exponent
+    struct Decomposed
+    {
+        std::uint64_t significand;
+        int exponent;
+    };
+
+    static consteval double magnitude(double value) { return value < 0 ? -value : value; }
+
+    static consteval bool isFinite(double value) { return magnitude(value) <= std::numeric_limits<double>::max(); }
+
+    static consteval bool signOf(double value) { return std::bit_cast<std::uint64_t>(value) >> 63; }
+
+    static consteval Decomposed decompose(double value)
+    {
+        auto bits = std::bit_cast<std::uint64_t>(value);
+        auto exponent = static_cast<int>((bits >> 52) & 0x7ff);
+        auto fraction = bits & ((std::uint64_t{ 1 } << 52) - 1);
+        if (exponent == 0)
+        {
+            return { fraction, -1074 }; // Subnormal
+        }
+        return { fraction | (std::uint64_t{ 1 } << 52), exponent - 1075 };
+    }
+
+    // The same number with its top bit where a normal double has it, for subnormals
+    static consteval Decomposed normalized(Decomposed value)
+    {
+        while (value.significand < (std::uint64_t{ 1 } << 52))
+        {
+            value.significand <<= 1;
+            --value.exponent;
+        }
+        return value;
+    }
+
+    // The double nearest to (value + a little when `inexact`) * 2^exponent, ties to even, as IEEE rounds. `inexact`
+    // stands for nonzero bits below those of `value`, which must have more bits than a double keeps when it is set.
+    static consteval double round(Wide value, bool inexact, int exponent, bool negative)
+    {
+        int bits = 0;
+        for (auto rest = value; rest; rest >>= 1)
+        {
+            ++bits;
+        }
+        // The exponent of the last bit kept, no lower than that of the subnormals
+        int last = std::max(bits + exponent - 53, -1074);
+        int shift = last - exponent;
+        Wide significand = 0;
+        if (shift <= 0)
+        {
+            significand = value << -shift;
+        }
+        else if (shift <= bits)
+        {
+            significand = value >> shift;
+            Wide dropped = value & ((Wide{ 1 } << shift) - 1);
+            Wide half = Wide{ 1 } << (shift - 1);
+            if (dropped > half || (dropped == half && (inexact || (significand & 1))))
+            {
+                ++significand;
+            }
+        }
+        // Otherwise less than half the smallest subnormal, which rounds to zero
+        if (significand == (Wide{ 1 } << 53))
+        {
+            significand >>= 1;
+            ++last;
+        }
+        std::uint64_t result = static_cast<std::uint64_t>(significand);
+        if (significand >= (Wide{ 1 } << 52))
+        {
+            auto biased = last + 1075;
+            if (biased >= 0x7ff)
+            {
+                return negative ? -Infinity : Infinity;
+            }
+            result = (static_cast<std::uint64_t>(biased) << 52) | (result & ((std::uint64_t{ 1 } << 52) - 1));
+        }
+        return std::bit_cast<double>(result | (std::uint64_t{ negative } << 63));
+    }
+
+    static consteval double sum(double a, double b)
+    {
+        if (a == -b && !isFinite(a))
+        {
+            return NaN; // Infinities of opposite signs
+        }
+        if (!isFinite(a) || !isFinite(b) || magnitude(a) < 1 || magnitude(b) < 1 ||
+            (magnitude(a) < 0x1p1022 && magnitude(b) < 0x1p1022))
+        {
+            return a + b;
+        }
+        double half = a * 0.5 + b * 0.5;
+        if (magnitude(half) >= 0x1p1023)
+        {
+            return half < 0 ? -Infinity : Infinity;
+        }
+        return half * 2;
+    }
+
+    static consteval double product(double a, double b)
+    {
+        if ((a == 0 && magnitude(b) == Infinity) || (b == 0 && magnitude(a) == Infinity))
+        {
+            return NaN;
+        }
+        if (!isFinite(a) || !isFinite(b) || a == 0 || b == 0)
+        {
+            return a * b;
+        }
+        // Both significands have at most 53 bits, so their product is exact in 106
+        auto left = decompose(a);
+        auto right = decompose(b);
+        return round(Wide{ left.significand } * right.significand, false, left.exponent + right.exponent,
+                     signOf(a) != signOf(b));
+    }
+
+    static consteval double quotient(double a, double b)
+    {
+        if (b == 0)
+        {
+            if (a != a || a == 0)
+            {
+                return NaN;
+            }
+            return signOf(a) != signOf(b) ? -Infinity : Infinity;
+        }
+        if (magnitude(a) == Infinity && magnitude(b) == Infinity)
+        {
+            return NaN;
+        }
+        if (!isFinite(a) || !isFinite(b) || a == 0)
+        {
+            return a / b;
+        }
+        // With both significands of 53 bits, the integer quotient has 74 or 75, more than enough to round, and the
+        // remainder tells whether it is exact
+        auto left = normalized(decompose(a));
+        auto right = normalized(decompose(b));
+        Wide dividend = Wide{ left.significand } << 74;
+        return round(dividend / right.significand, dividend % right.significand != 0,
+                     left.exponent - right.exponent - 74, signOf(a) != signOf(b));
+    }
+
+    consteval bool match(TokenType type)
+    {
+        if (m_token.type != type)
+        {
+            return false;
+        }
+        advance();
+        return true;
+    }
+
+    consteval TokenType take()
+    {
+        auto type = m_token.type;
+        advance();
+        return type;
+    }
+
+    // Scans the next token into m_token
+    consteval void advance()
+    {
+        using enum TokenType;
+        skipBlanks();
+        if (m_current >= m_source.size())
+        {
+            m_token = Scanned{ Eof, 0 };
+            return;
+        }
+        char c = m_source[m_current++];
+        auto next = [this](char expected)
+        {
+            bool matches = m_current < m_source.size() && m_source[m_current] == expected;
+            m_current += matches;
+            return matches;
+        };
+        switch (c)
+        {
+        case '(':
+            m_token = Scanned{ LeftParen, 0 };
+            return;
+        case ')':
+            m_token = Scanned{ RightParen, 0 };
+            return;
+        case ',':
+            m_token = Scanned{ Comma, 0 };
+            return;
+        case '-':
+            m_token = Scanned{ Minus, 0 };
+            return;
+        case '+':
+            m_token = Scanned{ Plus, 0 };
+            return;
+        case '*':
+            m_token = Scanned{ Star, 0 };
+            return;
+        case '?':
+            m_token = Scanned{ Question, 0 };
+            return;
+        case ':':
+            m_token = Scanned{ Colon, 0 };
+            return;
+        case '/':
+            m_token = Scanned{ Slash, 0 };
+            return;
+        case '!':
+            m_token = Scanned{ next('=') ? BangEqual : Bang, 0 };
+            return;
+        case '=':
+            m_token = Scanned{ next('=') ? EqualEqual : Equal, 0 };
+            return;
+        case '<':
+            m_token = Scanned{ next('=') ? LessEqual : Less, 0 };
+            return;
+        case '>':
+            m_token = Scanned{ next('=') ? GreaterEqual : Greater, 0 };
+            return;
+        case '"':
+            constantError("Strings are not constants.");
+            return;
+        case '[':
+        case ']':
+            constantError("Arrays are not constants.");
+            return;
+        default:
+            break;
+        }
+        if (lexical::isDigit(c))
+        {
+            m_token = Scanned{ Number, scanNumber(c) };
+            return;
+        }
+        if (lexical::isAlpha(c))
+        {
+            auto start = m_current - 1;
+            while (m_current < m_source.size() && lexical::isAlphaNumeric(m_source[m_current]))
+            {
+                m_current++;
+            }
+            auto name = m_source.substr(start, m_current - start);
+            auto type = lexical::keyword(name);
+            if (CallExpression::builtinNamed(name))
+            {
+                constantError("Arrays are not constants.");
+            }
+            else if (!type)
+            {
+                constantError("Variables are not constants.");
+            }
+            m_token = Scanned{ type.value_or(Identifier), 0 };
+            return;
+        }
+        constantError("Unexpected character.");
+    }
+
+    consteval double scanNumber(char first)
+    {
+        std::uint64_t mantissa = static_cast<unsigned int>(first - '0');
+        unsigned int digits = 1;
+        unsigned int fractionDigits = 0;
+        auto scanDigits = [&]()
+        {
+            while (m_current < m_source.size() && lexical::isDigit(m_source[m_current]))
+            {
+                mantissa = mantissa * 10 + static_cast<unsigned int>(m_source[m_current++] - '0');
+                digits++;
+            }
+        };
+        scanDigits();
+        if (m_current + 1 < m_source.size() && m_source[m_current] == '.' && lexical::isDigit(m_source[m_current + 1]))
+        {
+            m_current++;
+            auto integerDigits = digits;
+            scanDigits();
+            fractionDigits = digits - integerDigits;
+        }
+        auto value = lexical::shortNumber(mantissa, digits, fractionDigits);
+        if (!value)
+        {
+            // The Lexer rounds those with std::from_chars, which is not constexpr
+            constantError("Number literal too long to be rounded at compile time.");
+        }
+        return value.value_or(0);
+    }
+
+    // Whitespace and comments, as the Lexer skips them
+    consteval void skipBlanks()
+    {
+        while (m_current < m_source.size())
+        {
+            char c = m_source[m_current];
+            if (c == ' ' || c == '\r' || c == '\t' || c == '\n')
+            {
+                m_current++;
+            }
+            else if (m_source.substr(m_current, 2) == "//")
+            {
+                while (m_current < m_source.size() && m_source[m_current] != '\n')
+                {
+                    m_current++;
+                }
+            }
+            else if (m_source.substr(m_current, 2) == "/*")
+            {
+                auto end = m_source.find("*/", m_current + 2);
+                m_current = end == std::string_view::npos ? m_source.size() : end + 2;
+            }
+            else
+            {
+                return;
+            }
+        }
+    }
+
+    std::string_view m_source;
+    std::size_t m_current = 0;
+    Scanned m_token{};
+    bool m_skipping = false;
+};
+
+consteval ConstantValue evaluateConstant(std::string_view source)
+{
+    return ConstantEvaluator{ source }.evaluate();
+}
+
+template <ConstantValue Value> constexpr auto constantAs()
+{
+    if constexpr (Value.type == ConstantValue::Type::Number)
+    {
+        return Value.number;
+    }
+    else if constexpr (Value.type == ConstantValue::Type::Boolean)
+    {
+        return Value.boolean;
+    }
+    else
+    {
+        return NullLiteral{};
+    }
+}
+
+// The value of a constant Lox expression, computed by the compiler: a double, a bool or a NullLiteral, depending on
+// the expression. `lox::constant<"1 + 2 * 3">` is 7.0, and `lox::constant<"1 + true">` does not compile.
+template <FixedString Source> inline constexpr auto constant = constantAs<evaluateConstant(Source.view())>();
+
+namespace literals
+{
+
+// `"1 + 2 * 3"_lox` is lox::constant<"1 + 2 * 3">
+template <FixedString Source> consteval auto operator""_lox()
+{
+    return constant<Source>;
+}
+
+} // namespace literals
+
+} // namespace lox
@@ -0,0 +1,479 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+#include "cppTranspiler.h"
+
+#include "interpreter.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <format>
+#include <fstream>
+#include <stdexcept>
+#include <system_error>
+#include <typeinfo>
+
+namespace lox
+{
+
+namespace
+{
+
+// C++20 keywords, and the names the generated code defines itself
+constexpr std::string_view ReservedNames[] = {
+    "alignas", "alignof", "and", "and_eq", "asm", "auto", "bitand", "bitor", "bool", "break", "case", "catch", "char",
+    "char8_t", "char16_t", "char32_t", "class", "compl", "concept", "const", "consteval", "constexpr", "constinit",
+    "const_cast", "continue", "co_await", "co_return", "co_yield", "decltype", "default", "delete", "do", "double",
+    "dynamic_cast", "else", "enum", "explicit", "export", "extern", "false", "float", "for", "friend", "goto", "if",
+    "inline", "int", "long", "mutable", "namespace", "new", "noexcept", "not", "not_eq", "nullptr", "operator", "or",
+    "or_eq", "private", "protected", "public", "register", "reinterpret_cast", "requires", "return", "short", "signed",
+    "sizeof", "static", "static_assert", "static_cast", "struct", "switch", "template", "this", "thread_local", "throw",
+    "true", "try", "typedef", "typeid", "typename", "union", "unsigned", "using", "virtual", "void", "volatile",
+    "wchar_t", "while", "xor", "xor_eq", "std", "Value", "Nil", "Lookup", "RuntimeError", "isTruthy", "number",
+    "add", "variable",
+};
+
+bool isIdentifier(std::string_view name)
+{
+    auto isAlpha = [](char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_'; };
+    auto isAlphaNumeric = [&isAlpha](char c) { return isAlpha(c) || (c >= '0' && c <= '9'); };
+    if (name.empty() || !isAlpha(name[0]) || !std::ranges::all_of(name, isAlphaNumeric))
+    {
+        return false;
+    }
+    // Names starting with an underscore and a capital, or holding two underscores, are the implementation's
+    bool implementation = (name.size() > 1 && name[0] == '_' && name[1] >= 'A' && name[1] <= 'Z') ||
+                          name.find("__") != std::string_view::npos;
+    return !implementation && std::ranges::find(ReservedNames, name) == std::end(ReservedNames);
+}
+
+// A C++ string literal holding `text`. Octal escapes always have three digits, so a digit after one is not taken in.
+std::string quote(std::string_view text)
+{
+    std::string literal = "\"";
+    for (char c : text)
+    {
+        auto byte = static_cast<unsigned char>(c);
+        if (c == '"' || c == '\\')
+        {
+            literal += '\\';
+            literal += c;
+        }
+        else if (byte < 0x20 || byte >= 0x7F || c == '?') // '?' would start a trigraph
+        {
+            literal += std::format("\\{:03o}", byte);
+        }
+        else
+        {
+            literal += c;
+        }
+    }
+    return literal + "\"";
+}
+
+// The message of the InterpreterException thrown for `token`
+std::string errorOf(const Token& token, const std::string& message)
+{
+    return quote(Interpreter::InterpreterException{ token, message }.what());
+}
+
+std::string typeError(const Token& token)
+{
+    return errorOf(token, "variables do not hold the same type " + std::string{ typeid(double).name() });
+}
+
+// Writes the body of a function, one constant per node in the order the interpreter visits them. Evaluating into
+// named constants, rather than one nested expression, keeps the order of the operands and the depth of the source flat.
+// Operands that are only evaluated on some paths go in an `if` block that assigns the value of their node.
+class BodyGenerator : public ExpressionVisitor
+{
+public:
+    explicit BodyGenerator(const SymbolTable& symbols)
+        : m_symbols(symbols)
+    {
+    }
+
+    std::string generate(const Expression& tree)
+    {
+        tree.accept(*this);
+        line(std::format("return {};", m_result));
+        return std::move(m_body);
+    }
+
+    LiteralValues visit(const BinaryExpression& expr) override
+    {
+        expr.left->accept(*this);
+        auto left = m_result;
+        expr.right->accept(*this);
+        auto right = m_result;
+
+        using enum TokenType;
+        switch (expr.op.type)
+        {
+        case Plus:
+            define(std::format("add({}, {}, {})", left, right,
+                               errorOf(expr.op, "Addition on something other than two doubles or two strings not "
+                                                "allowed.")));
+            break;
+        case Minus:
+            arithmetic("-", expr.op, left, right);
+            break;
+        case Star:
+            arithmetic("*", expr.op, left, right);
+            break;
+        case Slash:
+            arithmetic("/", expr.op, left, right);
+            break;
+        case Greater:
+            arithmetic(">", expr.op, left, right);
+            break;
+        case GreaterEqual:
+            arithmetic(">=", expr.op, left, right);
+            break;
+        case Less:
+            arithmetic("<", expr.op, left, right);
+            break;
+        case LessEqual:
+            arithmetic("<=", expr.op, left, right);
+            break;
+        // std::variant compares the alternatives first, then the values, just like the interpreter
+        case EqualEqual:
+            define(std::format("Value{{ {} == {} }}", left, right));
+            break;
+        case BangEqual:
+            define(std::format("Value{{ !({} == {}) }}", left, right));
+            break;
+        default:
+            define("Value{ Nil{} }");
+            break;
+        }
+        return NullLiteral{};
+    }
+
+    LiteralValues visit(const LiteralExpression& expr) override
+    {
+        std::visit(
+            [this](const auto& value)
+            {
+                using Type = std::decay_t<decltype(value)>;
+                if constexpr (std::is_same_v<Type, double>)
+                {
+                    define(std::format("Value{{ {} }}", number(value)));
+                }
+                else if constexpr (std::is_same_v<Type, bool>)
+                {
+                    define(value ? "Value{ true }" : "Value{ false }");
+                }
+                else if constexpr (std::is_same_v<Type, LoxString>)
+                {
+                    define(std::format("Value{{ std::string{{ {}, {} }} }}", quote(value.view()), value.size()));
+                }
+                else if constexpr (std::is_same_v<Type, NumberArray>)
+                {
+                    throw std::invalid_argument("Arrays cannot be translated to C++.");
+                }
+                else
+                {
+                    define("Value{ Nil{} }");
+                }
+            },
+            expr.value);
+        return NullLiteral{};
+    }
+
+    LiteralValues visit(const UnaryExpression& expr) override
+    {
+        expr.right->accept(*this);
+        if (expr.op.type == TokenType::Minus)
+        {
+            // The interpreter asserts instead, this is the error it would throw if it checked
+            define(std::format("Value{{ -number({}, {}) }}", m_result, errorOf(expr.op, "operand is not a number")));
+        }
+        else
+        {
+            define(std::format("Value{{ !isTruthy({}) }}", m_result));
+        }
+        return NullLiteral{};
+    }
+
+    LiteralValues visit(const GroupingExpression& expr) override
+    {
+        expr.expression->accept(*this);
+        return NullLiteral{};
+    }
+
+    LiteralValues visit(const VariableExpression& expr) override
+    {
+        auto name = m_symbols.name(expr.symbol);
+        Token token{ TokenType::Identifier, expr.symbol, name, expr.line };
+        define(std::format("variable(lookup, {}, {})", quote(name),
+                           errorOf(token, "undefined variable " + std::string{ name })));
+        return NullLiteral{};
+    }
+
+    // The operands that may be skipped are evaluated in a block of their own, which assigns the value
+    LiteralValues visit(const LogicalExpression& expr) override
+    {
+        expr.left->accept(*this);
+        auto left = m_result;
+        auto result = declare(left);
+        line(std::format("if ({}isTruthy({}))", expr.op.type == TokenType::Or ? "!" : "", left));
+        branch(*expr.right, result);
+        m_result = result;
+        return NullLiteral{};
+    }
+
+    LiteralValues visit(const ConditionalExpression& expr) override
+    {
+        expr.condition->accept(*this);
+        auto condition = m_result;
+        auto result = declare("Value{ Nil{} }");
+        line(std::format("if (isTruthy({}))", condition));
+        branch(*expr.thenBranch, result);
+        line("else");
+        branch(*expr.elseBranch, result);
+        m_result = result;
+        return NullLiteral{};
+    }
+
+    // The generated Value has no arrays, which would need the kernels of the interpreter
+    LiteralValues visit(const ArrayExpression& /*expr*/) override
+    {
+        throw std::invalid_argument("Arrays cannot be translated to C++.");
+    }
+    LiteralValues visit(const CallExpression& expr) override
+    {
+        throw std::invalid_argument(
+            std::format("{}() cannot be translated to C++.", CallExpression::nameOf(expr.builtin)));
+    }
+
+private:
+    void arithmetic(std::string_view op, const Token& token, const std::string& left, const std::string& right)
+    {
+        auto error = typeError(token);
+        define(std::format("Value{{ number({}, {}) {} number({}, {}) }}", left, error, op, right, error));
+    }
+
+    // A literal that reads back as `value`, and is a double even when `value` is whole
+    static std::string number(double value)
+    {
+        if (!std::isfinite(value))
+        {
+            auto bits = std::bit_cast<std::uint64_t>(value);
+            return std::format("std::bit_cast<double>(std::uint64_t{{ 0x{:016x} }})", bits);
+        }
+        auto text = std::format("{}", value);
+        if (text.find_first_of(".e") == std::string::npos)
+        {
+            text += ".0";
+        }
+        return text;
+    }
+
+    void define(const std::string& value)
+    {
+        m_result = std::format("v{}", m_count++);
+        line(std::format("const Value {} = {};", m_result, value));
+    }
+
+    // A variable that is assigned later, starting as `value`
+    std::string declare(const std::string& value)
+    {
+        auto name = std::format("v{}", m_count++);
+        line(std::format("Value {} = {};", name, value));
+        return name;
+    }
+
+    // Evaluates `tree` in a block, into `result`
+    void branch(const Expression& tree, const std::string& result)
+    {
+        line("{");
+        m_indent += "    ";
+        tree.accept(*this);
+        line(std::format("{} = {};", result, m_result));
+        m_indent.resize(m_indent.size() - 4);
+        line("}");
+    }
+
+    void line(const std::string& text) { m_body += std::format("{}{}\n", m_indent, text); }
+
+    const SymbolTable& m_symbols;
+    std::string m_body;
+    std::string m_result;
+    std::string m_indent = "    ";
+    std::size_t m_count = 0;
+};
+
+constexpr std::string_view HeaderPrologue = R"(// Generated by the Lox C++ transpiler. Do not edit.
+
+#pragma once
+
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <variant>
+
+namespace {}
+{{
+
+struct Nil
+{{
+    bool operator==(const Nil&) const = default;
+}};
+
+// Ordered like the values of the interpreter
+using Value = std::variant<std::string, double, bool, Nil>;
+
+class RuntimeError : public std::runtime_error
+{{
+public:
+    using std::runtime_error::runtime_error;
+}};
+
+// The value of a variable, or nullopt when it is not bound
+using Lookup = std::function<std::optional<Value>(std::string_view name)>;
+
+)";
+
+constexpr std::string_view SourcePrologue = R"(// Generated by the Lox C++ transpiler. Do not edit.
+
+#include "{}.h"
+
+#include <bit>
+#include <cstdint>
+#include <utility>
+
+namespace {}
+{{
+
+namespace
+{{
+
+[[maybe_unused]] bool isTruthy(const Value& value)
+{{
+    if (const auto* boolean = std::get_if<bool>(&value))
+    {{
+        return *boolean;
+    }}
+    return !std::holds_alternative<Nil>(value);
+}}
+
+[[maybe_unused]] double number(const Value& value, const char* error)
+{{
+    if (const auto* number = std::get_if<double>(&value))
+    {{
+        return *number;
+    }}
+    throw RuntimeError{{ error }};
+}}
+
+[[maybe_unused]] Value add(const Value& left, const Value& right, const char* error)
+{{
+    const auto* leftString = std::get_if<std::string>(&left);
+    const auto* rightString = std::get_if<std::string>(&right);
+    if (leftString && rightString)
+    {{
+        return Value{{ *leftString + *rightString }};
+    }}
+    const auto* leftNumber = std::get_if<double>(&left);
+    const auto* rightNumber = std::get_if<double>(&right);
+    if (leftNumber && rightNumber)
+    {{
+        return Value{{ *leftNumber + *rightNumber }};
+    }}
+    throw RuntimeError{{ error }};
+}}
+
+[[maybe_unused]] Value variable(const Lookup& lookup, std::string_view name, const char* error)
+{{
+    if (auto value = lookup(name))
+    {{
+        return std::move(*value);
+    }}
+    throw RuntimeError{{ error }};
+}}
+
+}} // namespace
+)";
+
+} // namespace
+
+CppTranspiler::CppTranspiler(std::string unit, const SymbolTable& symbols)
+    : m_unit(std::move(unit))
+    , m_symbols(symbols)
+{
+    if (!isIdentifier(m_unit))
+    {
+        throw std::invalid_argument("Not a usable C++ identifier: " + m_unit);
+    }
+}
+
+void CppTranspiler::add(std::string_view function, const Expression& tree)
+{
+    if (!isIdentifier(function) || function == m_unit)
+    {
+        throw std::invalid_argument("Not a usable C++ identifier: " + std::string{ function });
+    }
+    if (std::ranges::find(m_functions, function, &Function::name) != m_functions.end())
+    {
+        throw std::invalid_argument("A function is already named " + std::string{ function });
+    }
+    m_functions.push_back(Function{ std::string{ function }, BodyGenerator{ m_symbols }.generate(tree) });
+}
+
+std::string CppTranspiler::header() const
+{
+    auto header = std::format(HeaderPrologue, m_unit);
+    for (const auto& function : m_functions)
+    {
+        header += std::format("Value {}(const Lookup& lookup);\n", function.name);
+    }
+    return header + std::format("\n}} // namespace {}\n", m_unit);
+}
+
+std::string CppTranspiler::source() const
+{
+    auto source = std::format(SourcePrologue, m_unit, m_unit);
+    for (const auto& function : m_functions)
+    {
+        source += std::format("\nValue {}([[maybe_unused]] const Lookup& lookup)\n{{\n{}}}\n", function.name,
+                              function.body);
+    }
+    return source + std::format("\n}} // namespace {}\n", m_unit);
+}
+
+bool CppTranspiler::write(const std::filesystem::path& directory) const
+{
+    std::error_code error{};
+    std::filesystem::create_directories(directory, error);
+    if (error)
+    {
+        return false;
+    }
+    std::ofstream header{ directory / (m_unit + ".h"), std::ios::binary };
+    header << this->header();
+    std::ofstream source{ directory / (m_unit + ".cpp"), std::ios::binary };
+    source << this->source();
+    header.close();
+    source.close();
+    return header.good() && source.good();
+}
+
+} // namespace lox
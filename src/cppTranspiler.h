@@ -0,0 +1,67 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include "BaseExpression.h"
+#include "symbolTable.h"
+
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace lox
+{
+
+// Translates trees into a C++20 header and source that evaluate them without the interpreter, for expressions that
+// are fixed at build time.
+//
+// The generated unit depends on the standard library only. Its namespace, named after the unit, holds `Value`, a
+// variant ordered like LiteralValues, `RuntimeError`, and one `Value <function>(const Lookup& lookup)` per tree, which
+// asks `lookup` for the value of every variable it reads. A function computes what Interpreter::evaluateTree would,
+// and throws RuntimeError with the very message of the InterpreterException the interpreter would throw.
+class CppTranspiler
+{
+public:
+    // `unit` names the namespace and the files. Throws std::invalid_argument when it is not a C++ identifier.
+    CppTranspiler(std::string unit, const SymbolTable& symbols);
+
+    // Adds a function evaluating `tree`, whose variables are in the symbol table. Throws std::invalid_argument when
+    // `function` is not a C++ identifier, or is taken, and when the tree has arrays.
+    void add(std::string_view function, const Expression& tree);
+
+    std::string header() const;
+    std::string source() const;
+    // Writes `<unit>.h` and `<unit>.cpp` into `directory`, creating it when needed. False when they could not be
+    // written.
+    bool write(const std::filesystem::path& directory) const;
+
+    const std::string& unit() const { return m_unit; }
+
+private:
+    struct Function
+    {
+        std::string name;
+        std::string body;
+    };
+
+    std::string m_unit;
+    const SymbolTable& m_symbols;
+    std::vector<Function> m_functions;
+};
+
+} // namespace lox
@@ -0,0 +1,75 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+#include "evaluationBudget.h"
+
+#include <algorithm>
+#include <format>
+
+namespace lox
+{
+
+void EvaluationBudget::checkString(std::size_t size) const
+{
+    if (maxStringSize && size > maxStringSize.value())
+    {
+        throw BudgetExceededException{ Limit::StringSize,
+                                       std::format("a string of {} characters, over {}", size, maxStringSize.value()) };
+    }
+}
+
+void BudgetMeter::start(const EvaluationBudget& budget)
+{
+    m_budget = &budget;
+    m_visits = 0;
+    if (budget.timeLimit)
+    {
+        m_deadline = std::chrono::steady_clock::now() + budget.timeLimit.value();
+    }
+    schedule();
+}
+
+void BudgetMeter::check()
+{
+    if (m_budget->maxNodes && m_visits > m_budget->maxNodes.value())
+    {
+        throw BudgetExceededException{ EvaluationBudget::Limit::Nodes,
+                                       std::format("more than {} node visits", m_budget->maxNodes.value()) };
+    }
+    if (m_budget->timeLimit && std::chrono::steady_clock::now() > m_deadline)
+    {
+        throw BudgetExceededException{
+            EvaluationBudget::Limit::Time,
+            std::format("over {}ns after {} node visits", m_budget->timeLimit->count(), m_visits)
+        };
+    }
+    schedule();
+}
+
+void BudgetMeter::schedule()
+{
+    m_nextCheck = UINT64_MAX;
+    if (m_budget->timeLimit)
+    {
+        m_nextCheck = m_visits + std::max<std::uint64_t>(m_budget->checkInterval, 1);
+    }
+    if (m_budget->maxNodes)
+    {
+        m_nextCheck = std::min(m_nextCheck, m_budget->maxNodes.value() + 1);
+    }
+}
+
+} // namespace lox
@@ -0,0 +1,100 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <optional>
+#include <string>
+
+namespace lox
+{
+
+// Limits on one evaluation, so that a single pathological input cannot hold the interpreter for long. Limits left
+// unset are not checked.
+struct EvaluationBudget
+{
+    enum class Limit
+    {
+        Nodes,
+        StringSize,
+        Time
+    };
+
+    static constexpr std::uint64_t DefaultCheckInterval = 1024;
+
+    // Node visits, counting every visit of a node evaluated more than once
+    std::optional<std::uint64_t> maxNodes;
+    // Characters in a string made by concatenation
+    std::optional<std::size_t> maxStringSize;
+    // Wall-clock time from the start of the evaluation, read once every `checkInterval` visits
+    std::optional<std::chrono::nanoseconds> timeLimit;
+    std::uint64_t checkInterval = DefaultCheckInterval;
+
+    // Throws BudgetExceededException when a string of `size` characters is over the budget
+    void checkString(std::size_t size) const;
+};
+
+// An evaluation went over its budget. Not an InterpreterException, as the input may well be correct.
+class BudgetExceededException : public std::exception
+{
+public:
+    BudgetExceededException(EvaluationBudget::Limit limit, const std::string& msg)
+        : m_limit(limit)
+        , m_message("Evaluation budget exceeded: " + msg + ".")
+    {
+    }
+
+    EvaluationBudget::Limit limit() const { return m_limit; }
+    const char* what() const noexcept override { return m_message.c_str(); }
+
+private:
+    EvaluationBudget::Limit m_limit;
+    std::string m_message;
+};
+
+// Holds one evaluation to a budget. Checks nothing until started.
+class BudgetMeter
+{
+public:
+    // Starts counting a new evaluation, whose deadline runs from now. `budget` must outlive the evaluation.
+    void start(const EvaluationBudget& budget);
+
+    // Counts a visit, checking the node and time limits once every few
+    void charge()
+    {
+        if (++m_visits >= m_nextCheck) [[unlikely]]
+        {
+            check();
+        }
+    }
+    std::uint64_t visits() const { return m_visits; }
+
+private:
+    void check();
+    // Sets the visit of the next check, after one at `m_visits`
+    void schedule();
+
+    const EvaluationBudget* m_budget = nullptr;
+    std::uint64_t m_visits = 0;
+    std::uint64_t m_nextCheck = UINT64_MAX;
+    std::chrono::steady_clock::time_point m_deadline{};
+};
+
+} // namespace lox
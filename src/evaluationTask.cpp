@@ -0,0 +1,110 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+#include "evaluationTask.h"
+
+#include <stdexcept>
+#include <utility>
+
+namespace lox
+{
+
+EvaluationTask::EvaluationTask(EvaluationTask&& other) noexcept
+    : m_handle(std::exchange(other.m_handle, nullptr))
+    , m_slices(other.m_slices)
+{
+}
+
+EvaluationTask& EvaluationTask::operator=(EvaluationTask&& other) noexcept
+{
+    if (this != &other)
+    {
+        if (m_handle)
+        {
+            m_handle.destroy();
+        }
+        m_handle = std::exchange(other.m_handle, nullptr);
+        m_slices = other.m_slices;
+    }
+    return *this;
+}
+
+EvaluationTask::~EvaluationTask()
+{
+    if (m_handle)
+    {
+        m_handle.destroy();
+    }
+}
+
+bool EvaluationTask::resume()
+{
+    if (!done())
+    {
+        m_slices++;
+        m_handle.resume();
+    }
+    return done();
+}
+
+bool EvaluationTask::done() const
+{
+    return !m_handle || m_handle.done();
+}
+
+LiteralValues EvaluationTask::result() const
+{
+    if (!m_handle || !m_handle.done())
+    {
+        throw std::logic_error("The evaluation has not finished.");
+    }
+    auto& promise = m_handle.promise();
+    if (promise.error)
+    {
+        std::rethrow_exception(promise.error);
+    }
+    return promise.value.value();
+}
+
+std::size_t EvaluationScheduler::add(EvaluationTask task)
+{
+    m_tasks.push_back(std::move(task));
+    m_ready.push_back(m_tasks.size() - 1);
+    return m_tasks.size() - 1;
+}
+
+std::size_t EvaluationScheduler::step()
+{
+    for (auto count = m_ready.size(); count > 0; --count)
+    {
+        auto index = m_ready.front();
+        m_ready.pop_front();
+        if (!m_tasks[index].resume())
+        {
+            m_ready.push_back(index);
+        }
+    }
+    return m_ready.size();
+}
+
+void EvaluationScheduler::run()
+{
+    while (step() > 0)
+    {
+    }
+}
+
+} // namespace lox
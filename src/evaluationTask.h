@@ -0,0 +1,111 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include "BaseExpression.h"
+
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <optional>
+#include <vector>
+
+namespace lox
+{
+
+// How much work an EvaluationTask does before it lets the others run
+struct EvaluationSlice
+{
+    static constexpr std::uint64_t DefaultNodes = 256;
+    static constexpr std::size_t DefaultStringBytes = 64 * 1024;
+
+    // Node visits
+    std::uint64_t nodes = DefaultNodes;
+    // Characters of the strings made by concatenation
+    std::size_t stringBytes = DefaultStringBytes;
+};
+
+// An evaluation that runs a slice at a time, made by Interpreter::evaluateCooperatively.
+//
+// The tree is walked with an explicit stack of nodes and values held in the coroutine frame, so a suspended evaluation
+// is that frame and its two vectors, however deep the tree, and never needs the native stack of the thread. Nothing
+// runs until the first resume().
+class EvaluationTask
+{
+public:
+    struct promise_type
+    {
+        std::optional<LiteralValues> value;
+        std::exception_ptr error;
+
+        EvaluationTask get_return_object() { return EvaluationTask{ Handle::from_promise(*this) }; }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_value(LiteralValues result) { value = std::move(result); }
+        void unhandled_exception() { error = std::current_exception(); }
+    };
+
+    EvaluationTask(EvaluationTask&& other) noexcept;
+    EvaluationTask& operator=(EvaluationTask&& other) noexcept;
+    EvaluationTask(const EvaluationTask&) = delete;
+    EvaluationTask& operator=(const EvaluationTask&) = delete;
+    ~EvaluationTask();
+
+    // Runs the next slice. True once the evaluation is over, successfully or not.
+    bool resume();
+    bool done() const;
+    // The value of a finished evaluation. Rethrows what stopped it, when something did.
+    LiteralValues result() const;
+    // The slices run so far
+    std::uint64_t slices() const { return m_slices; }
+
+private:
+    using Handle = std::coroutine_handle<promise_type>;
+
+    explicit EvaluationTask(Handle handle)
+        : m_handle(handle)
+    {
+    }
+
+    Handle m_handle;
+    std::uint64_t m_slices = 0;
+};
+
+// Runs many tasks on the calling thread, one slice of each in turn, so that a long evaluation does not hold back the
+// short ones behind it.
+class EvaluationScheduler
+{
+public:
+    // The task runs on the next step(). Returns its index.
+    std::size_t add(EvaluationTask task);
+    // Runs one slice of every unfinished task, in the order they were added. Returns how many are still unfinished.
+    std::size_t step();
+    // Steps until every task is finished
+    void run();
+
+    EvaluationTask& task(std::size_t index) { return m_tasks[index]; }
+    std::size_t size() const { return m_tasks.size(); }
+    std::size_t pending() const { return m_ready.size(); }
+
+private:
+    std::vector<EvaluationTask> m_tasks;
+    std::deque<std::size_t> m_ready;
+};
+
+} // namespace lox
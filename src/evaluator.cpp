@@ -0,0 +1,69 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+#include "evaluator.h"
+
+#include <algorithm>
+
+namespace lox
+{
+
+namespace
+{
+
+// Looks for string literals, or for array literals
+class LiteralFinder : public StaticVisitor<LiteralFinder, bool>
+{
+public:
+    explicit LiteralFinder(bool arrays)
+        : m_arrays(arrays)
+    {
+    }
+
+    bool visit(const BinaryExpression& expr) { return dispatch(*expr.left) || dispatch(*expr.right); }
+    bool visit(const LiteralExpression& expr) { return !m_arrays && std::holds_alternative<LoxString>(expr.value); }
+    bool visit(const UnaryExpression& expr) { return dispatch(*expr.right); }
+    bool visit(const GroupingExpression& expr) { return dispatch(*expr.expression); }
+    bool visit(const VariableExpression& /*expr*/) { return false; }
+    bool visit(const LogicalExpression& expr) { return dispatch(*expr.left) || dispatch(*expr.right); }
+    bool visit(const ConditionalExpression& expr)
+    {
+        return dispatch(*expr.condition) || dispatch(*expr.thenBranch) || dispatch(*expr.elseBranch);
+    }
+    bool visit(const ArrayExpression& expr)
+    {
+        return m_arrays ||
+               std::ranges::any_of(expr.elements, [this](const auto& element) { return dispatch(*element); });
+    }
+    bool visit(const CallExpression& expr) { return dispatch(*expr.argument); }
+
+private:
+    bool m_arrays;
+};
+
+} // namespace
+
+bool hasStringLiterals(const Expression& tree)
+{
+    return LiteralFinder{ false }.dispatch(tree);
+}
+
+bool hasArrayLiterals(const Expression& tree)
+{
+    return LiteralFinder{ true }.dispatch(tree);
+}
+
+} // namespace lox
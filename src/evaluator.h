@@ -0,0 +1,503 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include "BaseExpression.h"
+#include "evaluationBudget.h"
+#include "interpreterException.h"
+#include "profiler.h"
+#include "staticVisitor.h"
+#include "symbolTable.h"
+
+#include <cassert>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace lox
+{
+
+// The values of the global variables, indexed by Symbol
+using Globals = std::vector<std::optional<LiteralValues>>;
+
+// The messages of the operators given operands of the wrong type
+inline constexpr const char* AdditionErrorMessage =
+    "Addition on something other than two doubles or two strings not allowed.";
+inline std::string operandsErrorMessage()
+{
+    return "variables do not hold the same type " + std::string{ typeid(double).name() };
+}
+
+[[noreturn]] inline void additionError(const Token& op)
+{
+    throw InterpreterException{ op, AdditionErrorMessage };
+}
+
+// A value policy says what an Evaluator computes with, and the parts of the operators that depend on it:
+//
+//     using Value = ...;
+//     static Value literal(const LiteralValues& value);              // The value of a literal node
+//     static std::optional<Value> global(const LiteralValues& value); // nullopt when a global does not fit in a Value
+//     static LiteralValues toLiteral(const Value& value);
+//     static bool isTruthy(const Value& value);
+//     static bool isEqual(const Value& a, const Value& b);
+//     static Value add(const Token& op, const Value& a, const Value& b, const EvaluationBudget& budget);
+//     static Value fromArray(NumberArray array);
+//     static const NumberArray* asArray(const Value& value);           // nullptr when the value is not an array
+
+// Every Lox value. The default.
+struct DynamicValues
+{
+    using Value = LiteralValues;
+
+    static Value literal(const LiteralValues& value) { return value; }
+    static std::optional<Value> global(const LiteralValues& value) { return value; }
+    static LiteralValues toLiteral(const Value& value) { return value; }
+
+    // Follows Lox (Ruby)s convention
+    static bool isTruthy(const Value& value)
+    {
+        if (std::holds_alternative<bool>(value))
+        {
+            return std::get<bool>(value);
+        }
+        if (std::holds_alternative<NullLiteral>(value))
+        {
+            return false;
+        }
+        return true;
+    }
+
+    static bool isEqual(const Value& a, const Value& b)
+    {
+        if (std::holds_alternative<bool>(a) && std::holds_alternative<bool>(b))
+        {
+            return std::get<bool>(a) == std::get<bool>(b);
+        }
+        if (std::holds_alternative<LoxString>(a) && std::holds_alternative<LoxString>(b))
+        {
+            return std::get<LoxString>(a) == std::get<LoxString>(b);
+        }
+
+        if (std::holds_alternative<double>(a) && std::holds_alternative<double>(b))
+        {
+            return std::get<double>(a) == std::get<double>(b);
+        }
+        if (std::holds_alternative<NumberArray>(a) && std::holds_alternative<NumberArray>(b))
+        {
+            return std::get<NumberArray>(a) == std::get<NumberArray>(b);
+        }
+
+        if (std::holds_alternative<NullLiteral>(a) || std::holds_alternative<NullLiteral>(b))
+        {
+            if (std::holds_alternative<NullLiteral>(a) && std::holds_alternative<NullLiteral>(b))
+            {
+                return true;
+            }
+            return false;
+        }
+        return false;
+    }
+
+    static Value add(const Token& op, const Value& a, const Value& b, const EvaluationBudget& budget)
+    {
+        if (std::holds_alternative<LoxString>(a) && std::holds_alternative<LoxString>(b))
+        {
+            auto& leftString = std::get<LoxString>(a);
+            auto& rightString = std::get<LoxString>(b);
+            budget.checkString(leftString.size() + rightString.size());
+            return leftString + rightString;
+        }
+        else if (std::holds_alternative<double>(a) && std::holds_alternative<double>(b))
+        {
+            return std::get<double>(a) + std::get<double>(b);
+        }
+        additionError(op);
+    }
+
+    static Value fromArray(NumberArray array) { return array; }
+    static const NumberArray* asArray(const Value& value) { return std::get_if<NumberArray>(&value); }
+};
+
+// Numbers, booleans and nil, for the many inputs that never touch strings
+using NumericValue = std::variant<double, bool, NullLiteral>;
+static_assert(sizeof(NumericValue) <= 16, "A NumericValue should fit in two registers");
+
+// Values without strings or arrays, copied without branching on a string and compared without string compares.
+// Reaching a string or an array literal throws std::invalid_argument, so inputs are best checked with
+// hasStringLiterals() and hasArrayLiterals() beforehand.
+struct NumericOnly
+{
+    using Value = NumericValue;
+
+    static Value literal(const LiteralValues& value)
+    {
+        if (auto converted = global(value)) [[likely]]
+        {
+            return converted.value();
+        }
+        throw std::invalid_argument("Numeric-only evaluation takes no strings.");
+    }
+
+    static std::optional<Value> global(const LiteralValues& value)
+    {
+        if (const auto* number = std::get_if<double>(&value))
+        {
+            return *number;
+        }
+        if (const auto* boolean = std::get_if<bool>(&value))
+        {
+            return *boolean;
+        }
+        if (std::holds_alternative<NullLiteral>(value))
+        {
+            return NullLiteral{};
+        }
+        return std::nullopt; // A string or an array
+    }
+
+    static LiteralValues toLiteral(const Value& value)
+    {
+        return std::visit([](auto alternative) -> LiteralValues { return alternative; }, value);
+    }
+
+    static bool isTruthy(const Value& value)
+    {
+        if (const auto* boolean = std::get_if<bool>(&value))
+        {
+            return *boolean;
+        }
+        return !std::holds_alternative<NullLiteral>(value);
+    }
+
+    static bool isEqual(const Value& a, const Value& b)
+    {
+        if (a.index() != b.index())
+        {
+            return false;
+        }
+        if (const auto* number = std::get_if<double>(&a))
+        {
+            return *number == std::get<double>(b);
+        }
+        if (const auto* boolean = std::get_if<bool>(&a))
+        {
+            return *boolean == std::get<bool>(b);
+        }
+        return true; // Both nil
+    }
+
+    static Value add(const Token& op, const Value& a, const Value& b, const EvaluationBudget& /*budget*/)
+    {
+        if (std::holds_alternative<double>(a) && std::holds_alternative<double>(b))
+        {
+            return std::get<double>(a) + std::get<double>(b);
+        }
+        additionError(op);
+    }
+
+    static Value fromArray(NumberArray /*array*/)
+    {
+        throw std::invalid_argument("Numeric-only evaluation takes no arrays.");
+    }
+    static const NumberArray* asArray(const Value& /*value*/) { return nullptr; }
+};
+
+// Whether the tree has a string literal, which a NumericOnly Evaluator cannot hold
+bool hasStringLiterals(const Expression& tree);
+// Whether the tree has an array literal, which a NumericOnly Evaluator cannot hold either
+bool hasArrayLiterals(const Expression& tree);
+
+// Walks a tree with the values of `Policy`, the way the Interpreter evaluates it. Reads the globals, and charges every
+// node it visits to the meter, which the caller starts.
+template <typename Policy = DynamicValues>
+class Evaluator : public StaticVisitor<Evaluator<Policy>, typename Policy::Value>
+{
+public:
+    using Value = typename Policy::Value;
+
+    // Everything must outlive the evaluator
+    Evaluator(const Globals& globals, const SymbolTable& symbols, const EvaluationBudget& budget, BudgetMeter& meter)
+        : m_globals(globals)
+        , m_symbols(symbols)
+        , m_budget(budget)
+        , m_meter(meter)
+    {
+    }
+
+    // Records the profile of every node into `profiler`. nullptr stops profiling.
+    void setProfiler(Profiler* profiler)
+        requires std::is_same_v<Value, LiteralValues>
+    {
+        m_profiler = profiler;
+    }
+
+    Value evaluate(const Expression& expr)
+    {
+        m_meter.charge();
+        if constexpr (std::is_same_v<Value, LiteralValues>)
+        {
+            if (m_profiler) [[unlikely]]
+            {
+                return m_profiler->measure(expr, [this, &expr]() { return this->dispatch(expr); });
+            }
+        }
+        return this->dispatch(expr);
+    }
+
+    Value visit(const LiteralExpression& expr) { return Policy::literal(expr.value); }
+
+    Value visit(const GroupingExpression& expr) { return evaluate(*expr.expression); }
+
+    Value visit(const BinaryExpression& expr)
+    {
+        Value left = evaluate(*(expr.left));
+        Value right = evaluate(*(expr.right));
+        return apply(expr, left, right);
+    }
+
+    Value visit(const UnaryExpression& expr) { return apply(expr, evaluate(*expr.right)); }
+
+    // The right operand is only evaluated when the left one does not decide the value
+    Value visit(const LogicalExpression& expr)
+    {
+        Value left = evaluate(*expr.left);
+        if (decides(expr, left))
+        {
+            return left;
+        }
+        return evaluate(*expr.right);
+    }
+
+    Value visit(const ConditionalExpression& expr) { return evaluate(branch(expr, evaluate(*expr.condition))); }
+
+    Value visit(const ArrayExpression& expr)
+    {
+        return Policy::fromArray(NumberArray::make(expr.elements.size(),
+                                                   [this, &expr](double* elements)
+                                                   {
+                                                       for (std::size_t i = 0; i < expr.elements.size(); ++i)
+                                                       {
+                                                           elements[i] = element(expr, evaluate(*expr.elements[i]));
+                                                       }
+                                                   }));
+    }
+
+    Value visit(const CallExpression& expr) { return apply(expr, evaluate(*expr.argument)); }
+
+    Value visit(const VariableExpression& expr)
+    {
+        if (expr.symbol.id < m_globals.size() && m_globals[expr.symbol.id])
+        {
+            if (auto value = Policy::global(m_globals[expr.symbol.id].value()))
+            {
+                return std::move(value.value());
+            }
+            bool array = std::holds_alternative<NumberArray>(m_globals[expr.symbol.id].value());
+            variableError(expr, "variable " + std::string{ m_symbols.name(expr.symbol) } +
+                                    (array ? " holds an array" : " holds a string"));
+        }
+        variableError(expr, "undefined variable " + std::string{ m_symbols.name(expr.symbol) });
+    }
+
+    // The operators, on the values of the operands
+    Value apply(const BinaryExpression& expr, const Value& left, const Value& right)
+    {
+        using enum TokenType;
+        switch (expr.op.type)
+        {
+        case Minus:
+            if (!bothNumbers(left, right)) [[unlikely]]
+            {
+                return broadcast(expr.op, left, right);
+            }
+            return std::get<double>(left) - std::get<double>(right);
+        case Slash:
+            if (!bothNumbers(left, right)) [[unlikely]]
+            {
+                return broadcast(expr.op, left, right);
+            }
+            return std::get<double>(left) / std::get<double>(right);
+        case Star:
+            if (!bothNumbers(left, right)) [[unlikely]]
+            {
+                return broadcast(expr.op, left, right);
+            }
+            return std::get<double>(left) * std::get<double>(right);
+        case Plus:
+            if (bothNumbers(left, right)) [[likely]]
+            {
+                return std::get<double>(left) + std::get<double>(right);
+            }
+            if (Policy::asArray(left) || Policy::asArray(right))
+            {
+                return broadcast(expr.op, left, right);
+            }
+            return Policy::add(expr.op, left, right, m_budget);
+
+        case Greater:
+            if (!bothNumbers(left, right)) [[unlikely]]
+            {
+                return broadcast(expr.op, left, right);
+            }
+            return std::get<double>(left) > std::get<double>(right);
+        case GreaterEqual:
+            if (!bothNumbers(left, right)) [[unlikely]]
+            {
+                return broadcast(expr.op, left, right);
+            }
+            return std::get<double>(left) >= std::get<double>(right);
+        case Less:
+            if (!bothNumbers(left, right)) [[unlikely]]
+            {
+                return broadcast(expr.op, left, right);
+            }
+            return std::get<double>(left) < std::get<double>(right);
+        case LessEqual:
+            if (!bothNumbers(left, right)) [[unlikely]]
+            {
+                return broadcast(expr.op, left, right);
+            }
+            return std::get<double>(left) <= std::get<double>(right);
+
+        case BangEqual:
+            return !Policy::isEqual(left, right);
+        case EqualEqual:
+            return Policy::isEqual(left, right);
+
+        default:
+            break;
+        }
+        // Temporary
+        return NullLiteral{};
+    }
+
+    Value apply(const UnaryExpression& expr, const Value& right)
+    {
+        if (const auto* array = Policy::asArray(right)) [[unlikely]]
+        {
+            return Policy::fromArray(elementWise(expr.op.type, *array));
+        }
+        if (expr.op.type == TokenType::Minus)
+        {
+            assert(std::holds_alternative<double>(right));
+            // Note: mind the overflow  (MAX_DOUBLE vs MIN_DOUBLE), probably in the scannser
+            return -std::get<double>(right); // Pay attention to the minus
+        }
+
+        return !Policy::isTruthy(right);
+    }
+
+    Value apply(const CallExpression& expr, const Value& argument)
+    {
+        const auto* array = Policy::asArray(argument);
+        auto name = std::string{ CallExpression::nameOf(expr.builtin) };
+        if (!array)
+        {
+            throw InterpreterException{ expr.name, name + "() takes an array." };
+        }
+        if (expr.builtin == CallExpression::Builtin::Sum)
+        {
+            return array->sum();
+        }
+        if (array->empty())
+        {
+            throw InterpreterException{ expr.name, name + "() of an empty array." };
+        }
+        return expr.builtin == CallExpression::Builtin::Min ? array->min() : array->max();
+    }
+
+    // The value of an element of `expr`
+    static double element(const ArrayExpression& expr, const Value& value)
+    {
+        if (const auto* number = std::get_if<double>(&value)) [[likely]]
+        {
+            return *number;
+        }
+        throw InterpreterException{ expr.bracket, "Array elements must be numbers." };
+    }
+
+    // Whether the left operand is the value of the whole expression: a truthy one for `or`, a falsey one for `and`
+    static bool decides(const LogicalExpression& expr, const Value& left)
+    {
+        return Policy::isTruthy(left) == (expr.op.type == TokenType::Or);
+    }
+
+    // The branch selected by the value of the condition
+    static const Expression& branch(const ConditionalExpression& expr, const Value& condition)
+    {
+        return Policy::isTruthy(condition) ? *expr.thenBranch : *expr.elseBranch;
+    }
+
+private:
+    static bool bothNumbers(const Value& a, const Value& b)
+    {
+        return std::holds_alternative<double>(a) && std::holds_alternative<double>(b);
+    }
+
+    // An operator with an array operand, applied to every element, the other operand being an array as long or a
+    // number. Throws the error of the operator for other operands.
+    static Value broadcast(const Token& op, const Value& a, const Value& b)
+    {
+        const auto* leftArray = Policy::asArray(a);
+        const auto* rightArray = Policy::asArray(b);
+        const auto* leftNumber = std::get_if<double>(&a);
+        const auto* rightNumber = std::get_if<double>(&b);
+        if ((!leftArray && !rightArray) || (!leftArray && !leftNumber) || (!rightArray && !rightNumber))
+        {
+            if (op.type == TokenType::Plus)
+            {
+                additionError(op);
+            }
+            throw InterpreterException{ op, operandsErrorMessage() };
+        }
+        if (!leftArray)
+        {
+            return Policy::fromArray(elementWise(op.type, *leftNumber, *rightArray));
+        }
+        if (!rightArray)
+        {
+            return Policy::fromArray(elementWise(op.type, *leftArray, *rightNumber));
+        }
+        if (leftArray->size() != rightArray->size())
+        {
+            throw InterpreterException{ op,
+                                        "Arrays of different lengths, " + std::to_string(leftArray->size()) + " and " +
+                                            std::to_string(rightArray->size()) + "." };
+        }
+        return Policy::fromArray(elementWise(op.type, *leftArray, *rightArray));
+    }
+
+    [[noreturn]] void variableError(const VariableExpression& expr, const std::string& message) const
+    {
+        throw InterpreterException{ Token{ TokenType::Identifier, expr.symbol, m_symbols.name(expr.symbol), expr.line },
+                                    message };
+    }
+
+    const Globals& m_globals;
+    const SymbolTable& m_symbols;
+    const EvaluationBudget& m_budget;
+    BudgetMeter& m_meter;
+    Profiler* m_profiler = nullptr;
+};
+
+} // namespace lox
@@ -0,0 +1,126 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include "evaluator.h"
+#include "workStealingPool.h"
+
+#include <cstdint>
+#include <optional>
+
+namespace lox
+{
+
+// Evaluates big trees on a WorkStealingPool. Where both operands of a binary operator have at least `grain` nodes, as
+// counted by the parser, the right one is forked while the left one is evaluated. Smaller subtrees are evaluated by an
+// Evaluator on the thread that reaches them.
+//
+// The value is the one of Evaluator<Policy>, and so is the error: an error in a left operand is the one thrown, even
+// when its right operand failed first. The node and time limits of the budget are not checked, the string size is.
+// Logical and conditional operators are not forked, as the value of their first operand says which others to evaluate.
+// Neither are the elements of arrays, which are evaluated in order.
+template <typename Policy = DynamicValues>
+class ForkJoinEvaluator : public StaticVisitor<ForkJoinEvaluator<Policy>, typename Policy::Value>
+{
+public:
+    using Value = typename Policy::Value;
+
+    static constexpr std::uint32_t DefaultGrain = 1 << 12;
+
+    // Everything must outlive the evaluator
+    ForkJoinEvaluator(WorkStealingPool& pool,
+                      const Globals& globals,
+                      const SymbolTable& symbols,
+                      const EvaluationBudget& budget,
+                      std::uint32_t grain = DefaultGrain)
+        : m_pool(pool)
+        , m_globals(globals)
+        , m_symbols(symbols)
+        , m_budget(budget)
+        , m_grain(grain)
+    {
+    }
+
+    Value evaluate(const Expression& expr)
+    {
+        if (expr.treeSize() < m_grain)
+        {
+            BudgetMeter meter{}; // Never started, so it checks nothing
+            return Evaluator<Policy>{ m_globals, m_symbols, m_budget, meter }.evaluate(expr);
+        }
+        return this->dispatch(expr);
+    }
+
+    Value visit(const BinaryExpression& expr)
+    {
+        if (expr.left->treeSize() < m_grain || expr.right->treeSize() < m_grain)
+        {
+            Value left = evaluate(*expr.left);
+            Value right = evaluate(*expr.right);
+            return sequential().apply(expr, left, right);
+        }
+        std::optional<Value> left{};
+        std::optional<Value> right{};
+        m_pool.join([this, &expr, &left]() { left = evaluate(*expr.left); },
+                    [this, &expr, &right]() { right = evaluate(*expr.right); });
+        return sequential().apply(expr, left.value(), right.value());
+    }
+
+    Value visit(const LiteralExpression& expr) { return sequential().visit(expr); }
+    Value visit(const GroupingExpression& expr) { return evaluate(*expr.expression); }
+    Value visit(const UnaryExpression& expr) { return sequential().apply(expr, evaluate(*expr.right)); }
+    Value visit(const VariableExpression& expr) { return sequential().visit(expr); }
+
+    Value visit(const LogicalExpression& expr)
+    {
+        Value left = evaluate(*expr.left);
+        return Evaluator<Policy>::decides(expr, left) ? left : evaluate(*expr.right);
+    }
+
+    Value visit(const ConditionalExpression& expr)
+    {
+        return evaluate(Evaluator<Policy>::branch(expr, evaluate(*expr.condition)));
+    }
+
+    Value visit(const ArrayExpression& expr)
+    {
+        return Policy::fromArray(NumberArray::make(
+            expr.elements.size(),
+            [this, &expr](double* elements)
+            {
+                for (std::size_t i = 0; i < expr.elements.size(); ++i)
+                {
+                    elements[i] = Evaluator<Policy>::element(expr, evaluate(*expr.elements[i]));
+                }
+            }));
+    }
+
+    Value visit(const CallExpression& expr) { return sequential().apply(expr, evaluate(*expr.argument)); }
+
+private:
+    // For the operators of the nodes evaluated here, which charge no meter
+    Evaluator<Policy> sequential() { return Evaluator<Policy>{ m_globals, m_symbols, m_budget, m_idleMeter }; }
+
+    WorkStealingPool& m_pool;
+    const Globals& m_globals;
+    const SymbolTable& m_symbols;
+    const EvaluationBudget& m_budget;
+    std::uint32_t m_grain;
+    BudgetMeter m_idleMeter;
+};
+
+} // namespace lox
@@ -0,0 +1,815 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+#include "incrementalParser.h"
+
+#include "lexer.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <cstring>
+#include <functional>
+#include <ranges>
+
+namespace lox
+{
+
+namespace
+{
+
+using Rule = Parser::Rule;
+using Kind = Expression::Kind;
+
+// How far past an edit the lexer first looks, before it knows where the tokens line up again
+constexpr unsigned int Lookahead = 16;
+// The least room a gap buffer grows by
+constexpr unsigned int MinimumGap = 64;
+
+// The rule whose loop builds binary and logical expressions with this operator, Primary for other tokens
+Rule ruleFor(TokenType op)
+{
+    using enum TokenType;
+    switch (op)
+    {
+    case Comma:
+        return Rule::Comma;
+    case Or:
+        return Rule::LogicOr;
+    case And:
+        return Rule::LogicAnd;
+    case BangEqual:
+    case EqualEqual:
+        return Rule::Equality;
+    case Greater:
+    case GreaterEqual:
+    case Less:
+    case LessEqual:
+        return Rule::Comparison;
+    case Plus:
+    case Minus:
+        return Rule::Term;
+    case Star:
+    case Slash:
+        return Rule::Factor;
+    default:
+        return Rule::Primary;
+    }
+}
+
+// The rule parsing the operands of a binary rule
+Rule higherPrecedence(Rule rule)
+{
+    switch (rule)
+    {
+    case Rule::Comma:
+        return Rule::Conditional;
+    case Rule::LogicOr:
+        return Rule::LogicAnd;
+    case Rule::LogicAnd:
+        return Rule::Equality;
+    case Rule::Equality:
+        return Rule::Comparison;
+    case Rule::Comparison:
+        return Rule::Term;
+    case Rule::Term:
+        return Rule::Factor;
+    default:
+        return Rule::Unary;
+    }
+}
+
+// Calls `fn` for the parts of `expr` in the order of their tokens: with the slot of every child and the rule parsing
+// it, and with nullptr for every token of `expr` itself
+template <typename Fn>
+void forEachPart(Expression& expr, Fn&& fn)
+{
+    switch (expr.kind())
+    {
+    case Kind::Binary:
+    {
+        // Left operands are built by the rule's own loop, right ones by the rule of higher precedence
+        auto& binary = static_cast<BinaryExpression&>(expr);
+        auto rule = ruleFor(binary.op.type);
+        fn(&binary.left, rule);
+        fn(nullptr, rule);
+        fn(&binary.right, higherPrecedence(rule));
+        break;
+    }
+    case Kind::Logical:
+    {
+        auto& logical = static_cast<LogicalExpression&>(expr);
+        auto rule = ruleFor(logical.op.type);
+        fn(&logical.left, rule);
+        fn(nullptr, rule);
+        fn(&logical.right, higherPrecedence(rule));
+        break;
+    }
+    case Kind::Conditional:
+    {
+        // The then branch sits between "?" and ":", the else branch nests to the right
+        auto& conditional = static_cast<ConditionalExpression&>(expr);
+        fn(&conditional.condition, Rule::LogicOr);
+        fn(nullptr, Rule::Conditional);
+        fn(&conditional.thenBranch, Rule::Expression);
+        fn(nullptr, Rule::Conditional);
+        fn(&conditional.elseBranch, Rule::Conditional);
+        break;
+    }
+    case Kind::Array:
+    {
+        // Elements follow the bracket, a comma after each but the last
+        auto& array = static_cast<ArrayExpression&>(expr);
+        fn(nullptr, Rule::Primary);
+        for (auto& element : array.elements)
+        {
+            if (&element != &array.elements.front())
+            {
+                fn(nullptr, Rule::Primary);
+            }
+            fn(&element, Rule::Conditional);
+        }
+        fn(nullptr, Rule::Primary);
+        break;
+    }
+    case Kind::Call:
+    {
+        auto& call = static_cast<CallExpression&>(expr);
+        fn(nullptr, Rule::Primary);
+        fn(nullptr, Rule::Primary);
+        fn(&call.argument, Rule::Conditional);
+        fn(nullptr, Rule::Primary);
+        break;
+    }
+    case Kind::Unary:
+        fn(nullptr, Rule::Unary);
+        fn(&static_cast<UnaryExpression&>(expr).right, Rule::Unary);
+        break;
+    case Kind::Grouping:
+        fn(nullptr, Rule::Primary);
+        fn(&static_cast<GroupingExpression&>(expr).expression, Rule::Expression);
+        fn(nullptr, Rule::Primary);
+        break;
+    default:
+        fn(nullptr, Rule::Primary);
+        break;
+    }
+}
+
+// Sets the line a node keeps for one of its own tokens
+void setLine(Expression& expr, TokenType type, unsigned int line)
+{
+    switch (expr.kind())
+    {
+    case Kind::Binary:
+        static_cast<BinaryExpression&>(expr).op.lineNo = line;
+        break;
+    case Kind::Logical:
+        static_cast<LogicalExpression&>(expr).op.lineNo = line;
+        break;
+    case Kind::Unary:
+        static_cast<UnaryExpression&>(expr).op.lineNo = line;
+        break;
+    case Kind::Variable:
+        static_cast<VariableExpression&>(expr).line = line;
+        break;
+    case Kind::Array:
+        if (type == TokenType::LeftBracket)
+        {
+            static_cast<ArrayExpression&>(expr).bracket.lineNo = line;
+        }
+        break;
+    case Kind::Call:
+        if (type == TokenType::Identifier)
+        {
+            static_cast<CallExpression&>(expr).name.lineNo = line;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+// Points a view into the `length` characters at `from` at the same text at `to`. Views into other buffers, like the
+// static error messages of the lexer, are left alone.
+std::string_view rebase(std::string_view view, const char* from, std::size_t length, const char* to)
+{
+    std::less_equal<const char*> lessEqual;
+    if (!lessEqual(from, view.data()) || !lessEqual(view.data(), from + length))
+    {
+        return view;
+    }
+    return { to + (view.data() - from), view.size() };
+}
+
+void rebase(Token& tok, const char* from, std::size_t length, const char* to)
+{
+    if (std::holds_alternative<std::string_view>(tok.literal))
+    {
+        tok.literal = rebase(std::get<std::string_view>(tok.literal), from, length, to);
+    }
+    tok.location = rebase(tok.location, from, length, to);
+}
+
+// The first index in [begin, end) for which `pred` is false, `pred` being true for every index before it
+template <typename Pred>
+unsigned int partitionPoint(unsigned int begin, unsigned int end, Pred pred)
+{
+    auto indices = std::views::iota(begin, end);
+    return begin + static_cast<unsigned int>(std::ranges::partition_point(indices, pred) - indices.begin());
+}
+
+} // namespace
+
+IncrementalParser::IncrementalParser(std::string source)
+    : m_text(std::move(source))
+{
+    m_textGap = size();
+    lexAll();
+    parseAll();
+}
+
+IncrementalParser::~IncrementalParser()
+{
+    m_nodes.clear();
+    discard(std::move(m_tree));
+}
+
+std::string IncrementalParser::source() const
+{
+    std::string source{};
+    source.reserve(size());
+    source.append(m_text, 0, m_textGap).append(m_text, m_textGap + m_textGapSize);
+    return source;
+}
+
+std::vector<Token> IncrementalParser::tokens() const
+{
+    std::vector<Token> tokens{};
+    tokens.reserve(tokenCount());
+    for (unsigned int i = 0; i < tokenCount(); ++i)
+    {
+        tokens.emplace_back(token(i));
+    }
+    return tokens;
+}
+
+const Expression* IncrementalParser::tree()
+{
+    refreshLines();
+    rehash();
+    return m_tree.get();
+}
+
+IncrementalParser::Span IncrementalParser::span(unsigned int index) const
+{
+    auto span = entry(index).span;
+    return index < m_entryGap ? span : Span{ size() - span.begin, size() - span.end };
+}
+
+Token IncrementalParser::token(unsigned int index) const
+{
+    auto tok = entry(index).token;
+    if (index >= m_entryGap)
+    {
+        tok.lineNo = m_lines - tok.lineNo;
+    }
+    return tok;
+}
+
+void IncrementalParser::lexAll()
+{
+    m_entries.clear();
+    Lexer lexer{ m_text, 0, 1, true, &m_symbols };
+    while (true)
+    {
+        unsigned int begin = 0;
+        auto tok = lexer.scanToken(begin);
+        m_entries.emplace_back(Entry{ tok, Span{ begin, lexer.position() } });
+        if (tok.type == TokenType::Eof)
+        {
+            m_lines = tok.lineNo;
+            break;
+        }
+    }
+    m_entryGap = tokenCount();
+}
+
+void IncrementalParser::parseAll()
+{
+    discard(std::move(m_tree));
+    m_nodes.clear();
+    m_staleHashes.clear();
+    m_staleLines.reset();
+
+    auto tokens = this->tokens();
+    m_stats.reparsedTokens = tokens.size();
+    auto tree = Parser{ tokens, m_strings }.parse();
+    m_tree = tree ? std::move(tree.value()) : nullptr;
+    for (auto& entry : m_entries)
+    {
+        entry.node = nullptr;
+    }
+    if (m_tree)
+    {
+        adopt(m_tree, nullptr, Rule::Expression, 0, 0);
+    }
+}
+
+void IncrementalParser::edit(const Edit& edit)
+{
+    assert(edit.offset + edit.removed <= size());
+    m_stats = {};
+    m_strings.clear();
+
+    const auto offset = static_cast<unsigned int>(edit.offset);
+    const auto removedEnd = offset + static_cast<unsigned int>(edit.removed);
+    const auto editEnd = offset + static_cast<unsigned int>(edit.inserted.size());
+
+    // The first token that may change is the first one reaching the edit, as it might now continue into it. Lexing
+    // resumes where the token before it ended, a spot whose text and line did not change. The tokens from there to the
+    // first one past the removed text lose their text to the edit.
+    const auto first = partitionPoint(0, tokenCount(), [&](unsigned int i) { return span(i).end < offset; });
+    const auto kept = partitionPoint(first, tokenCount(), [&](unsigned int i) { return span(i).begin < removedEnd; });
+    const auto resume = first ? span(first - 1).end : 0;
+    const auto line = first ? token(first - 1).lineNo : 1;
+    moveGap(first, resume);
+
+    // Keep them with a copy of their text, to tell whether re-lexing changed them
+    std::vector<Entry> replaced{};
+    std::string replacedText{};
+    if (kept > first)
+    {
+        const char* text = m_text.data() + m_textGapSize + span(first).begin; // Past the gap
+        replacedText.assign(text, span(kept - 1).end - span(first).begin);
+        for (auto i = first; i < kept; ++i)
+        {
+            auto& copy = replaced.emplace_back(Entry{ token(i), span(i), entry(i).node });
+            rebase(copy.token, text, replacedText.size(), replacedText.data());
+        }
+    }
+
+    const auto removedText = std::string_view{ m_text }.substr(m_textGapSize + offset, edit.removed);
+    const auto lineShift = static_cast<int>(std::count(edit.inserted.begin(), edit.inserted.end(), '\n')) -
+                           static_cast<int>(std::count(removedText.begin(), removedText.end(), '\n'));
+
+    // The text from where lexing resumes to the edit stays, the removed text goes into the gap and the inserted text
+    // comes out of it. The tokens past the edit keep their text, offsets and lines, as they count them from the end.
+    moveTextGap(offset);
+    m_textGapSize += static_cast<unsigned int>(edit.removed);
+    reserveText(static_cast<unsigned int>(edit.inserted.size()));
+    std::copy(edit.inserted.begin(), edit.inserted.end(), m_text.begin() + m_textGap);
+    m_textGap = editEnd;
+    m_textGapSize -= static_cast<unsigned int>(edit.inserted.size());
+    m_lines += lineShift;
+
+    // The lexer reads the text before the gap, which is moved on, over the old tokens, when it needs more. Only the
+    // end of the source ends the text for good.
+    auto extend = [&](unsigned int target)
+    {
+        target = std::min(target, size());
+        auto next = partitionPoint(
+            std::max(m_entryGap, kept), tokenCount(), [&](unsigned int i) { return span(i).begin < target; });
+        moveGap(next, span(next).begin);
+    };
+    extend(editEnd + Lookahead);
+
+    // Re-lex until a token starts past the edit where an old token started, from there on nothing changed
+    std::vector<Entry> relexed{};
+    auto lexAfterRelexed = [&]()
+    {
+        const std::string_view text{ m_text.data(), m_textGap };
+        return relexed.empty() ? Lexer{ text, resume, line, true, &m_symbols }
+                               : Lexer{ text, relexed.back().span.end, relexed.back().token.lineNo, true, &m_symbols };
+    };
+    auto last = kept;
+    auto lexer = lexAfterRelexed();
+    while (true)
+    {
+        unsigned int begin = 0;
+        auto tok = lexer.scanToken(begin);
+        m_stats.relexedTokens++;
+        const bool whole = m_textGap == size();
+        // Ends of the text before the gap are no tokens, and characters past it may continue the ones ending close by
+        if (begin >= editEnd && (whole || tok.type != TokenType::Eof))
+        {
+            last = partitionPoint(kept, tokenCount(), [&](unsigned int i) { return span(i).begin < begin; });
+            if (last < tokenCount() && span(last).begin == begin)
+            {
+                break;
+            }
+        }
+        if (!whole && lexer.position() + 2 > m_textGap)
+        {
+            extend(m_textGap + std::max(Lookahead, m_textGap - resume));
+            lexer = lexAfterRelexed();
+            continue;
+        }
+        relexed.emplace_back(Entry{ tok, Span{ begin, lexer.position() } });
+    }
+    for (auto i = kept; i < last; ++i)
+    {
+        replaced.emplace_back(Entry{ token(i), span(i), entry(i).node });
+    }
+    const bool sameTokens = std::ranges::equal(relexed, replaced, {}, &Entry::token, &Entry::token);
+
+    // Put the new tokens in place of the old ones, right before the gap
+    moveGap(last, span(last).begin);
+    m_entryGap = first;
+    m_entryGapSize += last - first;
+    reserveEntries(static_cast<unsigned int>(relexed.size()));
+    for (std::size_t i = 0; i < relexed.size(); ++i)
+    {
+        auto& entry = m_entries[m_entryGap++];
+        entry = relexed[i];
+        entry.node = sameTokens ? replaced[i].node : nullptr;
+    }
+    m_entryGapSize -= static_cast<unsigned int>(relexed.size());
+
+    // Past the edit the lines of the tree are off when it added or removed lines
+    const auto inserted = static_cast<unsigned int>(relexed.size());
+    if (m_staleLines && *m_staleLines >= last)
+    {
+        *m_staleLines = *m_staleLines + inserted - (last - first);
+    }
+    else if (m_staleLines && *m_staleLines > first)
+    {
+        m_staleLines = first;
+    }
+    if (lineShift)
+    {
+        m_staleLines = std::min(m_staleLines.value_or(first + inserted), first + inserted);
+    }
+
+    if (!sameTokens && !swapOperator(first, replaced))
+    {
+        reparse(first, replaced, inserted);
+    }
+}
+
+bool IncrementalParser::swapOperator(unsigned int index, const std::vector<Entry>& replaced)
+{
+    // An operator replaced by another of the same precedence leaves the shape of the tree as it was
+    if (replaced.size() != 1 || !replaced.front().node || replaced.front().node->kind() != Kind::Binary)
+    {
+        return false;
+    }
+    auto& binary = static_cast<BinaryExpression&>(*replaced.front().node);
+    auto& entry = this->entry(index);
+    if (index + 1 != m_entryGap || ruleFor(entry.token.type) != ruleFor(binary.op.type))
+    {
+        return false;
+    }
+    binary.op = entry.token;
+    entry.node = &binary;
+    m_staleHashes.emplace_back(&binary);
+    return true;
+}
+
+void IncrementalParser::reparse(unsigned int first, const std::vector<Entry>& replaced, unsigned int inserted)
+{
+    if (!m_tree)
+    {
+        parseAll();
+        return;
+    }
+
+    // Start from the deepest node holding every replaced token, or when tokens were only added, the deeper of the
+    // nodes holding the tokens around them. Tokens past those the tree was parsed from belong to none.
+    Expression* expr = nullptr;
+    if (!replaced.empty())
+    {
+        if (replaced.front().node && replaced.back().node)
+        {
+            expr = commonAncestor(replaced.front().node, replaced.back().node);
+        }
+    }
+    else
+    {
+        auto* before = first ? entry(first - 1).node : nullptr;
+        auto* after = entry(first + inserted).node;
+        expr = !before || (after && m_nodes.at(after).depth > m_nodes.at(before).depth) ? after : before;
+    }
+
+    // Widen the tokens to re-parse to those of the node, and of its parent when that fails. The root is parsed like a
+    // whole buffer, which is what parseAll() does. After a failure only a node with at least twice the tokens is
+    // tried, or an edit that breaks a long chain would parse it again once per link.
+    auto begin = first;
+    auto end = first + inserted;
+    unsigned int tried = 0;
+    const auto mark = ++m_mark;
+    while (expr && m_nodes.at(expr).parent)
+    {
+        m_nodes.at(expr).mark = mark;
+        while (begin > 0 && contains(expr, entry(begin - 1).node, mark))
+        {
+            --begin;
+        }
+        while (contains(expr, entry(end).node, mark))
+        {
+            ++end;
+        }
+        if (end - begin >= 2 * tried)
+        {
+            if (reparseSlot(expr, begin, end))
+            {
+                return;
+            }
+            tried = end - begin;
+        }
+        expr = m_nodes.at(expr).parent;
+    }
+    parseAll();
+}
+
+bool IncrementalParser::contains(const Expression* root, const Expression* expr, unsigned int mark)
+{
+    // Walks up from `expr` until it meets a node known to be in the subtree, or one no deeper than its root. The nodes
+    // on the way are marked when they are in it, so no node is walked through twice.
+    const auto rootDepth = m_nodes.at(root).depth;
+    auto* node = expr;
+    while (node)
+    {
+        const auto& info = m_nodes.at(node);
+        m_stats.visitedNodes++;
+        if (info.mark == mark)
+        {
+            break;
+        }
+        if (info.depth <= rootDepth)
+        {
+            return false;
+        }
+        node = info.parent;
+    }
+    if (!node)
+    {
+        return false;
+    }
+    for (node = expr; m_nodes.at(node).mark != mark; node = m_nodes.at(node).parent)
+    {
+        m_nodes.at(node).mark = mark;
+    }
+    return true;
+}
+
+Expression* IncrementalParser::commonAncestor(Expression* a, Expression* b)
+{
+    while (a != b)
+    {
+        m_stats.visitedNodes++;
+        const auto& infoA = m_nodes.at(a);
+        const auto& infoB = m_nodes.at(b);
+        if (infoA.depth >= infoB.depth)
+        {
+            a = infoA.parent;
+        }
+        if (infoB.depth >= infoA.depth)
+        {
+            b = infoB.parent;
+        }
+    }
+    return a;
+}
+
+bool IncrementalParser::reparseSlot(Expression* expr, unsigned int begin, unsigned int end)
+{
+    if (begin == end)
+    {
+        return false;
+    }
+
+    const auto node = m_nodes.at(expr);
+    std::vector<Token> tokens{};
+    tokens.reserve(end - begin + 1);
+    for (auto i = begin; i < end; ++i)
+    {
+        tokens.emplace_back(token(i));
+    }
+    tokens.emplace_back(Token{ TokenType::Eof, std::monostate{}, "", tokens.back().lineNo });
+    m_stats.reparsedTokens += end - begin;
+    auto parsed = Parser{ tokens, m_strings }.parse(node.rule);
+    if (!parsed)
+    {
+        return false;
+    }
+
+    discard(std::move(*node.owner));
+    *node.owner = std::move(parsed.value());
+    [[maybe_unused]] auto adopted = adopt(*node.owner, node.parent, node.rule, node.depth, begin);
+    assert(adopted == end);
+    if (m_staleHashes.empty() || m_staleHashes.back() != node.parent)
+    {
+        m_staleHashes.emplace_back(node.parent);
+    }
+    return true;
+}
+
+unsigned int IncrementalParser::adopt(
+    ExpressionUPTR& owner, Expression* parent, Rule rule, unsigned int depth, unsigned int begin)
+{
+    // Records where every node of the subtree is held, and gives its tokens, from `begin` on, to the nodes they
+    // belong to
+    struct Part
+    {
+        Expression* expr;
+        ExpressionUPTR* child; // nullptr for a token of `expr`
+        Node node;
+    };
+    std::vector<Part> parts{ Part{ parent, &owner, Node{ parent, &owner, rule, depth } } };
+    auto index = begin;
+    while (!parts.empty())
+    {
+        auto part = parts.back();
+        parts.pop_back();
+        if (!part.child)
+        {
+            entry(index++).node = part.expr;
+            continue;
+        }
+        auto* expr = part.child->get();
+        m_nodes[expr] = part.node;
+        const auto from = parts.size();
+        forEachPart(
+            *expr,
+            [&](ExpressionUPTR* child, Rule rule)
+            { parts.emplace_back(Part{ expr, child, Node{ expr, child, rule, part.node.depth + 1 } }); });
+        std::reverse(parts.begin() + static_cast<std::ptrdiff_t>(from), parts.end());
+    }
+    return index;
+}
+
+void IncrementalParser::discard(ExpressionUPTR tree)
+{
+    // Frees the nodes one at a time, as deleting a long chain of them from the top would recurse as deep as it goes
+    std::vector<ExpressionUPTR> pending{};
+    pending.emplace_back(std::move(tree));
+    while (!pending.empty())
+    {
+        auto expr = std::move(pending.back());
+        pending.pop_back();
+        if (!expr)
+        {
+            continue;
+        }
+        m_nodes.erase(expr.get());
+        forEachPart(
+            *expr,
+            [&](ExpressionUPTR* child, Rule)
+            {
+                if (child)
+                {
+                    pending.emplace_back(std::move(*child));
+                }
+            });
+    }
+}
+
+void IncrementalParser::rehash()
+{
+    // The ancestors of every stale node are stale too. Deepest first, so every node is rehashed after its children.
+    std::vector<std::pair<unsigned int, Expression*>> stale{};
+    const auto mark = ++m_mark;
+    for (auto* expr : m_staleHashes)
+    {
+        // Nodes discarded since had their parent marked in turn
+        for (auto found = m_nodes.find(expr); found != m_nodes.end() && found->second.mark != mark;
+             found = m_nodes.find(expr))
+        {
+            found->second.mark = mark;
+            stale.emplace_back(found->second.depth, expr);
+            expr = found->second.parent;
+        }
+    }
+    m_staleHashes.clear();
+    std::ranges::sort(stale, std::greater{});
+    for (auto [depth, expr] : stale)
+    {
+        expr->rehash();
+    }
+}
+
+void IncrementalParser::refreshLines()
+{
+    if (!m_staleLines)
+    {
+        return;
+    }
+    for (auto i = *m_staleLines; i < tokenCount(); ++i)
+    {
+        if (auto* node = entry(i).node)
+        {
+            setLine(*node, entry(i).token.type, token(i).lineNo);
+        }
+    }
+    m_staleLines.reset();
+}
+
+void IncrementalParser::moveGap(unsigned int index, unsigned int offset)
+{
+    // The tokens between the old and the new place of the gap cross it, with their text. Before the gap they count
+    // their offsets and lines from the start of the buffer, past it from the end.
+    const auto textSize = size();
+    if (index < m_entryGap)
+    {
+        const char* from = m_text.data() + offset;
+        for (auto i = m_entryGap; i-- > index;)
+        {
+            auto& moved = m_entries[i + m_entryGapSize];
+            if (m_entryGapSize)
+            {
+                moved = std::move(m_entries[i]);
+            }
+            rebase(moved.token, from, m_textGap - offset, from + m_textGapSize);
+            moved.span = { textSize - moved.span.begin, textSize - moved.span.end };
+            moved.token.lineNo = m_lines - moved.token.lineNo;
+        }
+        m_stats.movedTokens += m_entryGap - index;
+    }
+    else
+    {
+        const char* from = m_text.data() + m_textGap + m_textGapSize;
+        for (auto i = m_entryGap; i < index; ++i)
+        {
+            auto& moved = m_entries[i];
+            if (m_entryGapSize)
+            {
+                moved = std::move(m_entries[i + m_entryGapSize]);
+            }
+            rebase(moved.token, from, offset - m_textGap, from - m_textGapSize);
+            moved.span = { textSize - moved.span.begin, textSize - moved.span.end };
+            moved.token.lineNo = m_lines - moved.token.lineNo;
+        }
+        m_stats.movedTokens += index - m_entryGap;
+    }
+    m_entryGap = index;
+    moveTextGap(offset);
+}
+
+void IncrementalParser::moveTextGap(unsigned int offset)
+{
+    auto* text = m_text.data();
+    if (offset < m_textGap)
+    {
+        std::memmove(text + offset + m_textGapSize, text + offset, m_textGap - offset);
+    }
+    else
+    {
+        std::memmove(text + m_textGap, text + m_textGap + m_textGapSize, offset - m_textGap);
+    }
+    m_textGap = offset;
+}
+
+void IncrementalParser::reserveText(unsigned int length)
+{
+    if (m_textGapSize >= length)
+    {
+        return;
+    }
+    // Grows geometrically, so that moving every token onto the new text is paid for by the edits that filled it
+    const auto textSize = size();
+    const auto after = static_cast<unsigned int>(m_text.size()) - m_textGap - m_textGapSize;
+    std::string text(std::max({ 2 * textSize, textSize + length, MinimumGap }), '\0');
+    const auto gapSize = static_cast<unsigned int>(text.size()) - textSize;
+    const char* before = m_text.data();
+    const char* past = before + m_textGap + m_textGapSize;
+    std::copy(before, before + m_textGap, text.data());
+    std::copy(past, past + after, text.data() + m_textGap + gapSize);
+    for (auto& entry : m_entries)
+    {
+        rebase(entry.token, before, m_textGap, text.data());
+        rebase(entry.token, past, after, text.data() + m_textGap + gapSize);
+    }
+    m_text = std::move(text);
+    m_textGapSize = gapSize;
+}
+
+void IncrementalParser::reserveEntries(unsigned int count)
+{
+    if (m_entryGapSize >= count)
+    {
+        return;
+    }
+    const auto tokens = tokenCount();
+    const auto after = static_cast<unsigned int>(m_entries.size()) - m_entryGap - m_entryGapSize;
+    std::vector<Entry> entries(std::max({ 2 * tokens, tokens + count, MinimumGap }));
+    const auto gapSize = static_cast<unsigned int>(entries.size()) - tokens;
+    std::move(m_entries.begin(), m_entries.begin() + m_entryGap, entries.begin());
+    std::move(m_entries.end() - after, m_entries.end(), entries.begin() + m_entryGap + gapSize);
+    m_entries = std::move(entries);
+    m_entryGapSize = gapSize;
+}
+
+} // namespace lox
@@ -0,0 +1,162 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include "BaseExpression.h"
+#include "loxString.h"
+#include "parser.h"
+#include "symbolTable.h"
+#include "token.h"
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace lox
+{
+
+// Replaces `removed` characters at `offset` with `inserted`
+struct Edit
+{
+    std::size_t offset = 0;
+    std::size_t removed = 0;
+    std::string_view inserted{};
+};
+
+// Keeps the tokens and the tree of a buffer up to date while it is edited.
+//
+// An edit re-lexes from the token it touches until the new tokens line up with the old ones again, and re-parses only
+// the deepest subtree whose tokens cover the re-lexed ones, with the grammar rule that produced that subtree. If that
+// fails the nearest ancestor with at least twice its tokens is tried, up to the whole buffer. Untouched subtrees are
+// kept as they are, and an operator replaced by another of the same precedence is swapped in place. The result is
+// always the same as lexing and parsing the edited buffer from scratch.
+//
+// The text and the tokens are kept in gap buffers whose gaps follow the edits, and the tokens past the gaps count their
+// offsets and lines from the end of the buffer, so an edit only moves what lies between it and the previous one. Every
+// token knows the node it belongs to and every node its parent, so the subtree to re-parse is found by walking up from
+// the edited tokens rather than down from the root. What an edit leaves behind higher up the tree, the hashes of the
+// ancestors of a new subtree and the line numbers past an edit that adds or removes lines, is brought up to date by
+// tree(). Edits that change the shape of a long chain of operators still re-parse the chain, and while the buffer
+// does not parse every edit parses it whole.
+class IncrementalParser
+{
+public:
+    explicit IncrementalParser(std::string source);
+    ~IncrementalParser();
+
+    IncrementalParser(const IncrementalParser&) = delete; // The nodes know where the tree is held
+    IncrementalParser& operator=(const IncrementalParser&) = delete;
+
+    void edit(const Edit& edit);
+
+    // Assembles the buffer, and its tokens with their lines, in time proportional to their size
+    std::string source() const;
+    std::vector<Token> tokens() const;
+    // Shared by every re-lex, so an identifier keeps its Symbol through edits
+    const SymbolTable& symbols() const { return m_symbols; }
+    // Interns the string literals of one parse, and is cleared on every edit, so the literals of earlier versions of
+    // the buffer are not kept. The tree holds on to its own strings.
+    const StringInterner& strings() const { return m_strings; }
+    // nullptr when the buffer does not parse. Brings the hashes and lines the edits left behind up to date first.
+    const Expression* tree();
+
+    struct Stats
+    {
+        std::size_t relexedTokens = 0;
+        std::size_t reparsedTokens = 0;
+        std::size_t visitedNodes = 0; // Looked at to find the subtree to re-parse
+        std::size_t movedTokens = 0;  // Moved across the gaps, along with their text
+    };
+    const Stats& lastEditStats() const { return m_stats; }
+
+private:
+    struct Span
+    {
+        unsigned int begin = 0;
+        unsigned int end = 0;
+    };
+
+    // A token, where it lies in the source and the node of the tree it belongs to. Past the gap the span and the line
+    // count from the end of the buffer.
+    struct Entry
+    {
+        Token token{ TokenType::Eof };
+        Span span{};
+        Expression* node = nullptr;
+    };
+
+    // Where a node of the tree is held, and the rule that can parse it again
+    struct Node
+    {
+        Expression* parent = nullptr;
+        ExpressionUPTR* owner = nullptr;
+        Parser::Rule rule = Parser::Rule::Expression;
+        unsigned int depth = 0;
+        unsigned int mark = 0; // Set by the walks that must not visit a node twice
+    };
+
+    void lexAll();
+    void parseAll();
+    void reparse(unsigned int first, const std::vector<Entry>& replaced, unsigned int inserted);
+    bool reparseSlot(Expression* expr, unsigned int begin, unsigned int end);
+    bool swapOperator(unsigned int index, const std::vector<Entry>& replaced);
+    bool contains(const Expression* root, const Expression* expr, unsigned int mark);
+    Expression* commonAncestor(Expression* a, Expression* b);
+
+    unsigned int adopt(
+        ExpressionUPTR& owner, Expression* parent, Parser::Rule rule, unsigned int depth, unsigned int begin);
+    void discard(ExpressionUPTR tree);
+    void rehash();
+    void refreshLines();
+
+    unsigned int size() const { return static_cast<unsigned int>(m_text.size()) - m_textGapSize; }
+    unsigned int tokenCount() const { return static_cast<unsigned int>(m_entries.size()) - m_entryGapSize; }
+    Entry& entry(unsigned int index) { return m_entries[index < m_entryGap ? index : index + m_entryGapSize]; }
+    const Entry& entry(unsigned int index) const
+    {
+        return m_entries[index < m_entryGap ? index : index + m_entryGapSize];
+    }
+    Span span(unsigned int index) const;
+    Token token(unsigned int index) const;
+
+    void moveGap(unsigned int index, unsigned int offset);
+    void moveTextGap(unsigned int offset);
+    void reserveText(unsigned int length);
+    void reserveEntries(unsigned int count);
+
+    std::string m_text; // The source, with m_textGapSize unused characters at m_textGap
+    unsigned int m_textGap = 0;
+    unsigned int m_textGapSize = 0;
+    std::vector<Entry> m_entries; // The tokens, with m_entryGapSize unused entries at m_entryGap
+    unsigned int m_entryGap = 0;
+    unsigned int m_entryGapSize = 0;
+    unsigned int m_lines = 1; // The line the source ends on
+
+    SymbolTable m_symbols;
+    StringInterner m_strings;
+    ExpressionUPTR m_tree;
+    std::unordered_map<const Expression*, Node> m_nodes;
+    std::vector<Expression*> m_staleHashes;   // Nodes whose hash, and the hashes of their ancestors, are out of date
+    std::optional<unsigned int> m_staleLines; // The first token whose line the tree may have wrong
+    unsigned int m_mark = 0;
+    Stats m_stats;
+};
+
+} // namespace lox
@@ -17,75 +17,17 @@
 #include "interpreter.h"
 
 #include "AstPrinter.hpp" // Debugging
+#include "tracer.h"
 
 #include <assert.h>
 #include <exception>
 #include <fstream>
 #include <iostream>
-#include <typeinfo>
+#include <utility>
 
 namespace lox
 {
 
-namespace
-{
-
-// Follows Lox (Ruby)s convention
-bool isTruthy(const LiteralValues& value)
-{
-    if (std::holds_alternative<bool>(value))
-    {
-        return std::get<bool>(value);
-    }
-    if (std::holds_alternative<NullLiteral>(value))
-    {
-        return false;
-    }
-    return true;
-}
-
-bool isEqual(const LiteralValues& a, const LiteralValues& b)
-{
-    if (std::holds_alternative<bool>(a) && std::holds_alternative<bool>(b))
-    {
-        return std::get<bool>(a) == std::get<bool>(b);
-    }
-    if (std::holds_alternative<std::string>(a) && std::holds_alternative<std::string>(b))
-    {
-        return std::get<std::string>(a) == std::get<std::string>(b);
-    }
-
-    if (std::holds_alternative<double>(a) && std::holds_alternative<double>(b))
-    {
-        return std::get<double>(a) == std::get<double>(b);
-    }
-
-    if (std::holds_alternative<NullLiteral>(a) || std::holds_alternative<NullLiteral>(b))
-    {
-        if (std::holds_alternative<NullLiteral>(a) && std::holds_alternative<NullLiteral>(b))
-        {
-            return true;
-        }
-        return false;
-    }
-    return false;
-}
-
-template <typename T> void assertBothAreType(const Token& tok, const LiteralValues& a, const LiteralValues& b)
-{
-    if (std::holds_alternative<T>(a) && std::holds_alternative<T>(b))
-    {
-        return;
-    }
-
-    T debug;
-    throw Interpreter::InterpreterException{
-        tok, "variables do not hold the same type " + std::string{ typeid(debug).name() }
-    };
-}
-
-} // namespace
-
 Interpreter::Interpreter() {}
 
 Interpreter::Interpreter(std::filesystem::path path)
@@ -109,29 +51,37 @@ int Interpreter::run()
 int Interpreter::interpretFile()
 {
     assert(m_path.has_value());
-    std::ifstream file(m_path.value());
-    if (!file.is_open())
-    {
-        m_logger.error(std::format("[interpretFile]: Failed to open file at {}.", m_path.value().string()));
-        return EXIT_FAILURE;
-    }
-
     std::string lineBuffer, wholeFile;
-    while (getline(file, lineBuffer))
     {
-        wholeFile += lineBuffer;
-    }
+        PhaseScope phase{ Phase::ReadInput };
+        std::ifstream file(m_path.value());
+        if (!file.is_open())
+        {
+            m_logger.error(std::format("[interpretFile]: Failed to open file at {}.", m_path.value().string()));
+            return EXIT_FAILURE;
+        }
+
+        while (getline(file, lineBuffer))
+        {
+            wholeFile += lineBuffer;
+        }
 
-    file.close();
-    return interpret(wholeFile);
+        file.close();
+    }
+    return interpret(wholeFile, m_astCache);
 }
 
 int Interpreter::interpretStdin()
 {
     auto exitCode = EXIT_FAILURE;
     std::string lineBuffer{};
+    auto readLine = [&lineBuffer]()
+    {
+        PhaseScope phase{ Phase::ReadInput };
+        return static_cast<bool>(getline(std::cin, lineBuffer));
+    };
     std::cout << ">\t";
-    while (getline(std::cin, lineBuffer))
+    while (readLine())
     {
         exitCode = interpret(lineBuffer);
         std::cout << ">\t";
@@ -140,7 +90,7 @@ int Interpreter::interpretStdin()
     return exitCode;
 }
 
-int Interpreter::interpret(const std::string& content)
+int Interpreter::interpret(const std::string& content, AstCache* astCache)
 {
     if (content.empty())
     {
@@ -148,29 +98,120 @@ int Interpreter::interpret(const std::string& content)
         return EXIT_FAILURE;
     }
 
-    m_logger.debug(std::format("[interpret]: Content: {}", content));
-    std::string_view content_view{ content };
-    m_lexer = std::make_unique<Lexer>(std::move(content_view));
-    m_parser = std::make_unique<Parser>(m_lexer->tokenize());
-    auto expr = m_parser->parse();
+    if (Logger::enabled(Logger::Debug))
+    {
+        m_logger.debug(std::format("[interpret]: Content: {}", content));
+    }
+    // A profile needs the evaluation to actually happen
+    auto* cache = m_profiler ? nullptr : m_cache;
+    if (cache)
+    {
+        if (auto* cached = cache->find(content))
+        {
+            return conclude(*cached);
+        }
+    }
+
+    const Expression* expr = nullptr;
+    if (astCache)
+    {
+        PhaseScope phase{ Phase::Parse };
+        expr = astCache->load(content, m_session);
+    }
     if (!expr)
     {
-        return EXIT_FAILURE;
+        {
+            PhaseScope phase{ Phase::Lex };
+            m_session.lex(content);
+        }
+        {
+            PhaseScope phase{ Phase::Parse };
+            expr = m_session.parse();
+        }
+        if (!expr)
+        {
+            return EXIT_FAILURE;
+        }
+        if (astCache)
+        {
+            astCache->store(content, *expr, m_session.symbols());
+        }
+    }
+    {
+        PhaseScope phase{ Phase::Print };
+        AstPrinter printer{ m_session.output() };
+        printer.print(*expr); // Refactor!!!!!!!!
+        m_session.flush(std::cout);
+    }
+    if (m_numericOnly && hasStringLiterals(*expr))
+    {
+        return conclude(ResultCache::Result{ NullLiteral{}, "Numeric-only evaluation takes no strings." });
+    }
+    if (m_numericOnly && hasArrayLiterals(*expr))
+    {
+        return conclude(ResultCache::Result{ NullLiteral{}, "Numeric-only evaluation takes no arrays." });
     }
-    AstPrinter printer;
-    printer.print(*(expr.value())); // Refactor!!!!!!!!
 
-    try
+    ResultCache::Result result{ NullLiteral{}, std::nullopt };
+    if (auto* cached = cache ? cache->find(*expr) : nullptr)
     {
-        auto value = evaluate(*(expr.value()));
-        Logger::info(print(value));
+        result = *cached;
     }
-    catch (InterpreterException& e)
+    else
     {
-        Logger::error("Runtime error: " + std::string{ e.what() });
-        return EXIT_FAILURE;
+        try
+        {
+            PhaseScope phase{ Phase::Evaluate };
+            auto function = m_jit && !m_profiler ? JitFunction::compile(*expr) : std::nullopt;
+            if (function)
+            {
+                result.value = evaluateCompiled(*function, *expr);
+            }
+            else if (m_pool && !m_profiler)
+            {
+                result.value = evaluateForked(*expr);
+            }
+            else
+            {
+                result.value = m_numericOnly && !m_profiler ? evaluateNumeric(*expr) : evaluateTree(*expr);
+            }
+        }
+        catch (InterpreterException& e)
+        {
+            result.error = e.what();
+        }
+        catch (BudgetExceededException& e)
+        {
+            result.error = e.what();
+            cache = nullptr; // Another budget, or a less loaded machine, may see it through
+        }
+    }
+    if (cache)
+    {
+        cache->insert(content, *expr, result);
     }
 
+    if (m_profiler)
+    {
+        if (!result.error)
+        {
+            m_profiler->printAnnotated(*expr, std::cerr);
+            std::cerr << m_profiler->report();
+        }
+        m_profiler->reset(); // The next input replaces the tree
+    }
+
+    return conclude(result);
+}
+
+int Interpreter::conclude(const ResultCache::Result& result)
+{
+    if (result.error)
+    {
+        Logger::error("Runtime error: " + result.error.value());
+        return EXIT_FAILURE;
+    }
+    Logger::info(print(result.value));
     return EXIT_SUCCESS;
 }
 
@@ -179,91 +220,303 @@ void Interpreter::logError(unsigned int line, std::string_view location, std::st
     m_logger.error(std::format("[line {}] {}: {}", line, location, message));
 }
 
-LiteralValues Interpreter::evaluate(const Expression& expr)
+LiteralValues Interpreter::profile(const Expression& expr, Profiler& profiler)
 {
-    return expr.accept(*this);
+    auto* previous = std::exchange(m_profiler, &profiler);
+    try
+    {
+        auto value = evaluateTree(expr);
+        m_profiler = previous;
+        return value;
+    }
+    catch (...)
+    {
+        m_profiler = previous;
+        throw;
+    }
 }
 
-LiteralValues Interpreter::visit(const LiteralExpression& expr)
+void Interpreter::setGlobal(std::string_view name, LiteralValues value)
 {
-    // Temporary
-    return expr.value;
+    if (m_cache)
+    {
+        m_cache->clear(); // The results may have read the old value
+    }
+    auto symbol = m_session.symbols().intern(name);
+    if (symbol.id >= m_globals.size())
+    {
+        m_globals.resize(symbol.id + 1);
+    }
+    m_globals[symbol.id] = std::move(value);
+}
+
+LiteralValues Interpreter::evaluateTree(const Expression& tree)
+{
+    m_meter.start(m_budget);
+    auto dynamic = evaluator<DynamicValues>(m_meter);
+    dynamic.setProfiler(m_profiler);
+    return dynamic.evaluate(tree);
+}
+
+void Interpreter::setNumericOnly(bool enabled)
+{
+    if (m_cache)
+    {
+        m_cache->clear(); // Strings are errors in one mode only
+    }
+    m_numericOnly = enabled;
+}
+
+LiteralValues Interpreter::evaluateNumeric(const Expression& tree)
+{
+    m_meter.start(m_budget);
+    return NumericOnly::toLiteral(evaluator<NumericOnly>(m_meter).evaluate(tree));
 }
 
-LiteralValues Interpreter::visit(const GroupingExpression& expr)
+std::optional<PreparedExpression> Interpreter::prepare(std::string_view source)
 {
-    return evaluate(*expr.expression);
+    m_session.lex(source);
+    const auto* tree = m_session.parse();
+    if (!tree)
+    {
+        return std::nullopt;
+    }
+    return PreparedExpression::prepare(*tree);
 }
 
-LiteralValues Interpreter::visit(const BinaryExpression& expr)
+LiteralValues Interpreter::evaluateCompiled(const JitFunction& function, const Expression& tree)
 {
-    using enum TokenType;
-    LiteralValues left = evaluate(*(expr.left));
-    LiteralValues right = evaluate(*(expr.right));
-
-    switch (expr.op.type)
-    {
-        // TODO: type check here
-    case Minus:
-        assertBothAreType<double>(expr.op, left, right);
-        return std::get<double>(left) - std::get<double>(right);
-    case Slash:
-        assertBothAreType<double>(expr.op, left, right);
-        return std::get<double>(left) / std::get<double>(right);
-    case Star:
-        assertBothAreType<double>(expr.op, left, right);
-        return std::get<double>(left) * std::get<double>(right);
-    case Plus:
-        if (std::holds_alternative<std::string>(left) && std::holds_alternative<std::string>(right))
+    if (m_budget.maxNodes && m_budget.maxNodes.value() < function.nodes())
+    {
+        return m_numericOnly ? evaluateNumeric(tree) : evaluateTree(tree);
+    }
+    m_jitValues.clear();
+    for (auto symbol : function.variables())
+    {
+        const auto* value = symbol.id < m_globals.size() && m_globals[symbol.id]
+                                ? std::get_if<double>(&m_globals[symbol.id].value())
+                                : nullptr;
+        if (!value)
         {
-            return std::get<std::string>(left) + std::get<std::string>(right);
+            return m_numericOnly ? evaluateNumeric(tree) : evaluateTree(tree);
         }
-        else if (std::holds_alternative<double>(left) && std::holds_alternative<double>(right))
+        m_jitValues.push_back(*value);
+    }
+    return function.call(m_jitValues);
+}
+
+LiteralValues Interpreter::evaluateForked(const Expression& tree)
+{
+    bool sequential = !m_pool || tree.treeSize() < m_grain || m_budget.timeLimit ||
+                      (m_budget.maxNodes && m_budget.maxNodes.value() < tree.treeSize());
+    if (sequential)
+    {
+        return m_numericOnly ? evaluateNumeric(tree) : evaluateTree(tree);
+    }
+    auto& symbols = m_session.symbols();
+    if (m_numericOnly)
+    {
+        ForkJoinEvaluator<NumericOnly> numeric{ *m_pool, m_globals, symbols, m_budget, m_grain };
+        return NumericOnly::toLiteral(numeric.evaluate(tree));
+    }
+    return ForkJoinEvaluator<>{ *m_pool, m_globals, symbols, m_budget, m_grain }.evaluate(tree);
+}
+
+// Walks a tree with explicit stacks rather than recursion, one node at a time. A node is expanded when first reached,
+// pushing its children, and combined once they are all evaluated, replacing their values with its own. Logical and
+// conditional nodes push their first operand only, and when combined either keep its value or replace it with the
+// operand it selects, which takes their place on the stack. Arrays push all their elements, and replace their values
+// with the array of them.
+class Interpreter::StackMachine : public StaticVisitor<StackMachine>
+{
+public:
+    StackMachine(Evaluator<> evaluator, BudgetMeter& meter, const Expression& tree)
+        : m_evaluator(std::move(evaluator))
+        , m_meter(meter)
+    {
+        m_steps.push_back(Step{ &tree, false });
+    }
+
+    bool finished() const { return m_steps.empty(); }
+    LiteralValues result() { return std::move(m_values.back()); }
+
+    void step()
+    {
+        auto& top = m_steps.back();
+        const auto* node = top.node;
+        m_combining = top.expanded;
+        if (m_combining)
         {
-            return std::get<double>(left) + std::get<double>(right);
+            m_steps.pop_back();
         }
         else
         {
-            throw InterpreterException{ expr.op,
-                                        "Addition on something other than two doubles or two strings not allowed." };
+            top.expanded = true;
+            m_meter.charge();
+            m_sliceNodes++;
         }
+        dispatch(*node);
+    }
 
-    case Greater:
-        assertBothAreType<double>(expr.op, left, right);
-        return std::get<double>(left) > std::get<double>(right);
-    case GreaterEqual:
-        assertBothAreType<double>(expr.op, left, right);
-        return std::get<double>(left) >= std::get<double>(right);
-    case Less:
-        assertBothAreType<double>(expr.op, left, right);
-        return std::get<double>(left) < std::get<double>(right);
-    case LessEqual:
-        assertBothAreType<double>(expr.op, left, right);
-        return std::get<double>(left) <= std::get<double>(right);
-
-    case BangEqual:
-        return !isEqual(left, right);
-    case EqualEqual:
-        return isEqual(left, right);
-
-    default:
-        break;
-    }
-    // Temporary
-    return NullLiteral{};
-}
+    // The work done since the last call to startSlice()
+    std::uint64_t sliceNodes() const { return m_sliceNodes; }
+    std::size_t sliceStringBytes() const { return m_sliceStringBytes; }
+    void startSlice()
+    {
+        m_sliceNodes = 0;
+        m_sliceStringBytes = 0;
+    }
 
-LiteralValues Interpreter::visit(const UnaryExpression& expr)
-{
-    LiteralValues right = evaluate(*expr.right);
-    if (expr.op.type == TokenType::Minus)
+    void visit(const BinaryExpression& expr)
+    {
+        if (!m_combining)
+        {
+            m_steps.push_back(Step{ expr.right.get(), false });
+            m_steps.push_back(Step{ expr.left.get(), false }); // On top, so it goes first
+            return;
+        }
+        auto right = pop();
+        auto left = pop();
+        push(m_evaluator.apply(expr, left, right));
+    }
+
+    void visit(const LiteralExpression& expr)
+    {
+        m_steps.pop_back();
+        push(expr.value);
+    }
+
+    void visit(const UnaryExpression& expr)
+    {
+        if (!m_combining)
+        {
+            m_steps.push_back(Step{ expr.right.get(), false });
+            return;
+        }
+        push(m_evaluator.apply(expr, pop()));
+    }
+
+    void visit(const GroupingExpression& expr)
+    {
+        // Its value is the one of its expression, left on the stack
+        if (!m_combining)
+        {
+            m_steps.push_back(Step{ expr.expression.get(), false });
+        }
+    }
+
+    void visit(const VariableExpression& expr)
+    {
+        m_steps.pop_back();
+        push(m_evaluator.visit(expr));
+    }
+
+    void visit(const LogicalExpression& expr)
+    {
+        if (!m_combining)
+        {
+            m_steps.push_back(Step{ expr.left.get(), false });
+            return;
+        }
+        if (!Evaluator<>::decides(expr, m_values.back()))
+        {
+            pop();
+            m_steps.push_back(Step{ expr.right.get(), false });
+        }
+    }
+
+    void visit(const ConditionalExpression& expr)
+    {
+        if (!m_combining)
+        {
+            m_steps.push_back(Step{ expr.condition.get(), false });
+            return;
+        }
+        m_steps.push_back(Step{ &Evaluator<>::branch(expr, pop()), false });
+    }
+
+    void visit(const ArrayExpression& expr)
     {
-        assert(std::holds_alternative<double>(right));
-        // Note: mind the overflow  (MAX_DOUBLE vs MIN_DOUBLE), probably in the scannser
-        return -std::get<double>(right); // Pay attention to the minus
+        const auto size = expr.elements.size();
+        if (!m_combining)
+        {
+            // The first element on top, so they are evaluated in order
+            for (auto element = expr.elements.rbegin(); element != expr.elements.rend(); ++element)
+            {
+                m_steps.push_back(Step{ element->get(), false });
+            }
+            return;
+        }
+        auto first = m_values.end() - static_cast<std::ptrdiff_t>(size);
+        auto array = NumberArray::make(size,
+                                       [&expr, first, size](double* elements)
+                                       {
+                                           for (std::size_t i = 0; i < size; ++i)
+                                           {
+                                               elements[i] = Evaluator<>::element(expr, first[i]);
+                                           }
+                                       });
+        m_values.erase(first, m_values.end());
+        push(std::move(array));
+    }
+
+    void visit(const CallExpression& expr)
+    {
+        if (!m_combining)
+        {
+            m_steps.push_back(Step{ expr.argument.get(), false });
+            return;
+        }
+        push(m_evaluator.apply(expr, pop()));
+    }
+
+private:
+    struct Step
+    {
+        const Expression* node;
+        bool expanded;
+    };
+
+    LiteralValues pop()
+    {
+        auto value = std::move(m_values.back());
+        m_values.pop_back();
+        return value;
+    }
+
+    void push(LiteralValues value)
+    {
+        if (auto* string = std::get_if<LoxString>(&value))
+        {
+            m_sliceStringBytes += string->size();
+        }
+        m_values.push_back(std::move(value));
     }
 
-    return !isTruthy(right);
+    Evaluator<> m_evaluator;
+    BudgetMeter& m_meter;
+    std::vector<Step> m_steps;
+    std::vector<LiteralValues> m_values;
+    bool m_combining = false;
+    std::uint64_t m_sliceNodes = 0;
+    std::size_t m_sliceStringBytes = 0;
+};
+
+EvaluationTask Interpreter::evaluateCooperatively(const Expression& tree, EvaluationSlice slice)
+{
+    BudgetMeter meter{};
+    meter.start(m_budget);
+    StackMachine machine{ evaluator<DynamicValues>(meter), meter, tree };
+    while (!machine.finished())
+    {
+        machine.step();
+        if (machine.sliceNodes() >= slice.nodes || machine.sliceStringBytes() >= slice.stringBytes)
+        {
+            machine.startSlice();
+            co_await std::suspend_always{};
+        }
+    }
+    co_return machine.result();
 }
 
 } // namespace lox
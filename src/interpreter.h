@@ -16,9 +16,18 @@
 
 #pragma once
 
-#include "lexer.h"
+#include "astCache.h"
+#include "evaluationBudget.h"
+#include "evaluationTask.h"
+#include "evaluator.h"
+#include "forkJoinEvaluator.h"
+#include "jit.h"
 #include "logger.h"
-#include "parser.h"
+#include "preparedExpression.h"
+#include "profiler.h"
+#include "resultCache.h"
+#include "session.h"
+#include "workStealingPool.h"
 
 #include "BaseExpression.h"
 
@@ -26,55 +35,118 @@
 #include <memory>
 #include <optional>
 #include <string>
+#include <string_view>
+#include <vector>
 
 namespace lox
 {
 
-class Interpreter : public ExpressionVisitor
+class Interpreter
 {
 public:
     Interpreter();
     explicit Interpreter(std::filesystem::path file);
 
     int run();
-    LiteralValues visit(const BinaryExpression& expr) override;
-    LiteralValues visit(const LiteralExpression& expr) override;
-    LiteralValues visit(const GroupingExpression& expr) override;
-    LiteralValues visit(const UnaryExpression& expr) override;
+
+    // Profiles every evaluation from now on, printing the profile of each input. nullptr stops profiling.
+    void setProfiler(Profiler* profiler) { m_profiler = profiler; }
+    // Evaluates a tree, recording its profile into `profiler`
+    LiteralValues profile(const Expression& expr, Profiler& profiler);
+
+    // Bounds every evaluation from now on. Going over it throws BudgetExceededException.
+    void setBudget(const EvaluationBudget& budget) { m_budget = budget; }
+    const EvaluationBudget& budget() const { return m_budget; }
+    // Evaluates a whole tree within the budget
+    LiteralValues evaluateTree(const Expression& tree);
+    // Evaluates a whole tree a slice at a time, each task within a budget of its own that starts on its first resume.
+    // The interpreter and the tree must outlive the task. Not profiled.
+    EvaluationTask evaluateCooperatively(const Expression& tree, EvaluationSlice slice = {});
+    // Compiles every input from now on, when the JIT supports this machine and the tree, and runs the code instead of
+    // walking the tree. Not while profiling.
+    void setJit(bool enabled) { m_jit = enabled; }
+    // Runs `function`, compiled from `tree`, on the current globals. Falls back to evaluateTree, or to evaluateNumeric
+    // when numeric-only, when a variable is not bound to a number, or when the tree is too big for the node budget, so
+    // errors are those of the interpreter.
+    LiteralValues evaluateCompiled(const JitFunction& function, const Expression& tree);
+    // Evaluates every input from now on with NumericOnly values, rejecting inputs with string or array literals before
+    // they are evaluated. Clears the result cache. Not while profiling.
+    void setNumericOnly(bool enabled);
+    // Evaluates a whole tree within the budget with NumericOnly values. Throws std::invalid_argument when it reaches a
+    // string or an array literal, and InterpreterException when it reads a variable bound to a string or an array.
+    LiteralValues evaluateNumeric(const Expression& tree);
+
+    // Lexes, parses and prepares `source` for evaluatePrepared(), as a new input. nullopt when it does not parse, or
+    // when PreparedExpression cannot take it.
+    std::optional<PreparedExpression> prepare(std::string_view source);
+    // Evaluates `expression` on the current globals without allocating or throwing: nullopt when the evaluation fails,
+    // with the error written into `error`. Not within the budget, which a prepared expression needs none of.
+    std::optional<NumericValue> evaluatePrepared(PreparedExpression& expression, EvaluationError& error) noexcept
+    {
+        return expression.evaluate(m_globals, error);
+    }
+    // The message evaluateNumeric() would have thrown for `error`. Allocates.
+    std::string errorMessage(const EvaluationError& error) { return error.exception(m_session.symbols()).what(); }
+
+    // Evaluates every input from now on with ForkJoinEvaluator on `pool`, forking subtrees of `grain` nodes or more.
+    // nullptr evaluates on the calling thread only. Not while profiling.
+    void setPool(WorkStealingPool* pool, std::uint32_t grain = ForkJoinEvaluator<>::DefaultGrain)
+    {
+        m_pool = pool;
+        m_grain = grain;
+    }
+    // Evaluates a whole tree on the pool, with NumericOnly values when numeric-only. Evaluates it on the calling thread
+    // when there is no pool, when it is smaller than the grain, or when the budget limits the time or the node visits
+    // to less than the tree has.
+    LiteralValues evaluateForked(const Expression& tree);
+
+    // Answers inputs seen before from `cache`, which must not be shared with other interpreters. nullptr stops caching.
+    void setResultCache(ResultCache* cache) { m_cache = cache; }
+    // Loads the trees of scripts run from a file from `cache`, and stores them there. nullptr stops caching.
+    void setAstCache(AstCache* cache) { m_astCache = cache; }
+
+    // Binds a global variable, visible to every input evaluated from now on. Clears the result cache.
+    void setGlobal(std::string_view name, LiteralValues value);
 
 private:
     int interpretFile();
     int interpretStdin();
-    int interpret(const std::string& content);
+    // Takes the tree from `astCache`, when given one that has it, instead of lexing and parsing
+    int interpret(const std::string& content, AstCache* astCache = nullptr);
+    // Logs the result of an input, returning the exit code it warrants
+    int conclude(const ResultCache::Result& result);
+
+    // An evaluator of the globals within the budget, charging `meter`
+    template <typename Policy> Evaluator<Policy> evaluator(BudgetMeter& meter)
+    {
+        return Evaluator<Policy>{ m_globals, m_session.symbols(), m_budget, meter };
+    }
 
-    LiteralValues evaluate(const Expression& expr);
+    class StackMachine;
 
     void logError(unsigned int line, std::string_view location, std::string_view message);
 
     std::optional<std::filesystem::path> m_path;
-    std::unique_ptr<Lexer> m_lexer;
-    std::unique_ptr<Parser> m_parser;
+    // Lives as long as the interpreter, so a name has the same Symbol on every line
+    Session m_session;
     Logger m_logger;
+    Profiler* m_profiler = nullptr;
+    ResultCache* m_cache = nullptr;
+    AstCache* m_astCache = nullptr;
+    Globals m_globals;
+
+    EvaluationBudget m_budget;
+    BudgetMeter m_meter;
+
+    bool m_jit = false;
+    bool m_numericOnly = false;
+    WorkStealingPool* m_pool = nullptr;
+    std::uint32_t m_grain = ForkJoinEvaluator<>::DefaultGrain;
+    std::vector<double> m_jitValues; // The arguments of evaluateCompiled, kept for their capacity
 
 public:
-    // Custom exception class
-    class InterpreterException : public std::exception
-    {
-    private:
-        Token token;
-        std::string message;
-
-    public:
-        // Constructor to initialize the exception with a Token and custom message
-        InterpreterException(const Token& token, const std::string& msg)
-            : token(token)
-            , message("Interpreter Error: Operator: " + token.print() + msg + ".")
-        {
-        }
-
-        // Override the what() function to return the error message
-        const char* what() const noexcept override { return message.c_str(); }
-    };
+    using InterpreterException = lox::InterpreterException;
+    using BudgetExceededException = lox::BudgetExceededException;
 };
 
 } // namespace lox
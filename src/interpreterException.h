@@ -0,0 +1,46 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include "token.h"
+
+#include <exception>
+#include <string>
+
+namespace lox
+{
+
+// A runtime error of the input, such as an operand of the wrong type or an undefined variable
+class InterpreterException : public std::exception
+{
+private:
+    Token token;
+    std::string message;
+
+public:
+    // Constructor to initialize the exception with a Token and custom message
+    InterpreterException(const Token& token, const std::string& msg)
+        : token(token)
+        , message("Interpreter Error: Operator: " + token.print() + msg + ".")
+    {
+    }
+
+    // Override the what() function to return the error message
+    const char* what() const noexcept override { return message.c_str(); }
+};
+
+} // namespace lox
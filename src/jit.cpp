@@ -0,0 +1,391 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+#include "jit.h"
+
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#if defined(__x86_64__) && defined(__linux__)
+#define LOX_JIT 1
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace lox
+{
+
+namespace
+{
+
+enum class ValueType
+{
+    Number,
+    Boolean
+};
+
+// The predicates of cmpsd
+enum class Predicate : std::uint8_t
+{
+    Equal = 0,
+    Less = 1,
+    LessOrEqual = 2,
+    NotEqual = 4,
+};
+
+constexpr std::uint64_t One = std::bit_cast<std::uint64_t>(1.0);
+constexpr std::uint64_t SignBit = std::uint64_t{ 1 } << 63;
+
+// Emits the code of a tree, and works out the type of every node on the way. Uses xmm0 and xmm1, and rax for
+// constants. The System V calling convention passes the array of variables in rdi and takes the result from xmm0.
+class CodeGenerator : public ExpressionVisitor
+{
+public:
+    // False when the tree may hold something else than numbers and booleans
+    bool generate(const Expression& tree)
+    {
+        tree.accept(*this);
+        m_code.push_back(0xC3); // ret
+        return !m_failed;
+    }
+
+    const std::string& code() const { return m_code; }
+    std::vector<Symbol>& variables() { return m_variables; }
+    ValueType type() const { return m_type; }
+    std::size_t nodes() const { return m_nodes; }
+
+    LiteralValues visit(const BinaryExpression& expr) override
+    {
+        m_nodes++;
+        expr.left->accept(*this);
+        auto leftType = m_type;
+        if (!loadLeaf(*expr.right, 1))
+        {
+            push();
+            expr.right->accept(*this);
+            sse(0x66, 0x28, 1, 0); // movapd xmm1, xmm0
+            pop();
+        }
+        auto rightType = m_type;
+
+        using enum TokenType;
+        switch (expr.op.type)
+        {
+        case Plus:
+            return arithmetic(0x58, leftType, rightType);
+        case Minus:
+            return arithmetic(0x5C, leftType, rightType);
+        case Star:
+            return arithmetic(0x59, leftType, rightType);
+        case Slash:
+            return arithmetic(0x5E, leftType, rightType);
+        case Less:
+            return comparison(Predicate::Less, false, leftType, rightType);
+        case LessEqual:
+            return comparison(Predicate::LessOrEqual, false, leftType, rightType);
+        case Greater:
+            return comparison(Predicate::Less, true, leftType, rightType);
+        case GreaterEqual:
+            return comparison(Predicate::LessOrEqual, true, leftType, rightType);
+        case EqualEqual:
+        case BangEqual:
+            if (leftType != rightType)
+            {
+                // A number never equals a boolean
+                loadConstant(0, expr.op.type == BangEqual ? One : 0);
+                m_type = ValueType::Boolean;
+                return NullLiteral{};
+            }
+            // Booleans compare as 0.0 and 1.0
+            if (expr.op.type == EqualEqual)
+            {
+                return comparison(Predicate::Equal, false, ValueType::Number, ValueType::Number);
+            }
+            return comparison(Predicate::NotEqual, false, ValueType::Number, ValueType::Number);
+        default:
+            return fail();
+        }
+    }
+
+    LiteralValues visit(const LiteralExpression& expr) override
+    {
+        loadLeaf(expr, 0);
+        return NullLiteral{};
+    }
+
+    LiteralValues visit(const UnaryExpression& expr) override
+    {
+        m_nodes++;
+        expr.right->accept(*this);
+        if (expr.op.type == TokenType::Minus)
+        {
+            if (m_type != ValueType::Number)
+            {
+                return fail();
+            }
+            loadConstant(1, SignBit);
+            sse(0x66, 0x57, 0, 1); // xorpd xmm0, xmm1
+            return NullLiteral{};
+        }
+        if (m_type == ValueType::Number)
+        {
+            loadConstant(0, 0); // Every number is truthy
+        }
+        else
+        {
+            loadConstant(1, One);
+            sse(0x66, 0x57, 0, 1); // xorpd xmm0, xmm1 flips 0.0 and 1.0
+        }
+        m_type = ValueType::Boolean;
+        return NullLiteral{};
+    }
+
+    LiteralValues visit(const GroupingExpression& expr) override
+    {
+        m_nodes++;
+        return expr.expression->accept(*this);
+    }
+
+    LiteralValues visit(const VariableExpression& expr) override
+    {
+        loadLeaf(expr, 0);
+        return NullLiteral{};
+    }
+
+    // Branches are left to the interpreter, whose operands may also be of either type
+    LiteralValues visit(const LogicalExpression& /*expr*/) override { return fail(); }
+    LiteralValues visit(const ConditionalExpression& /*expr*/) override { return fail(); }
+    // Arrays are not numbers, which is all the code keeps in registers
+    LiteralValues visit(const ArrayExpression& /*expr*/) override { return fail(); }
+    LiteralValues visit(const CallExpression& /*expr*/) override { return fail(); }
+
+private:
+    // Loads a literal or a variable into xmm`reg`. False for other nodes, which are left alone.
+    bool loadLeaf(const Expression& expr, int reg)
+    {
+        if (auto* literal = dynamic_cast<const LiteralExpression*>(&expr))
+        {
+            m_nodes++;
+            if (auto* number = std::get_if<double>(&literal->value))
+            {
+                loadConstant(reg, std::bit_cast<std::uint64_t>(*number));
+                m_type = ValueType::Number;
+            }
+            else if (auto* boolean = std::get_if<bool>(&literal->value))
+            {
+                loadConstant(reg, *boolean ? One : 0);
+                m_type = ValueType::Boolean;
+            }
+            else
+            {
+                fail();
+            }
+            return true;
+        }
+        if (auto* variable = dynamic_cast<const VariableExpression*>(&expr))
+        {
+            m_nodes++;
+            // movsd xmm`reg`, [rdi + 8 * slot]
+            emit({ 0xF2, 0x0F, 0x10, static_cast<std::uint8_t>(0x87 | reg << 3) });
+            emit32(static_cast<std::uint32_t>(slot(variable->symbol) * sizeof(double)));
+            m_type = ValueType::Number;
+            return true;
+        }
+        return false;
+    }
+
+    LiteralValues arithmetic(std::uint8_t opcode, ValueType left, ValueType right)
+    {
+        if (left != ValueType::Number || right != ValueType::Number)
+        {
+            return fail();
+        }
+        sse(0xF2, opcode, 0, 1); // addsd, subsd, mulsd or divsd xmm0, xmm1
+        m_type = ValueType::Number;
+        return NullLiteral{};
+    }
+
+    // Leaves 1.0 in xmm0 when the predicate holds, 0.0 when it does not. `swapped` compares right to left.
+    LiteralValues comparison(Predicate predicate, bool swapped, ValueType left, ValueType right)
+    {
+        if (left != ValueType::Number || right != ValueType::Number)
+        {
+            return fail();
+        }
+        int dst = swapped ? 1 : 0;
+        int src = swapped ? 0 : 1;
+        sse(0xF2, 0xC2, dst, src); // cmpsd dst, src, predicate
+        m_code.push_back(static_cast<char>(predicate));
+        if (swapped)
+        {
+            sse(0x66, 0x28, 0, 1); // movapd xmm0, xmm1
+        }
+        loadConstant(1, One);
+        sse(0x66, 0x54, 0, 1); // andpd xmm0, xmm1 turns the all ones mask into 1.0
+        m_type = ValueType::Boolean;
+        return NullLiteral{};
+    }
+
+    LiteralValues fail()
+    {
+        m_failed = true;
+        return NullLiteral{};
+    }
+
+    std::size_t slot(Symbol symbol)
+    {
+        for (std::size_t i = 0; i < m_variables.size(); ++i)
+        {
+            if (m_variables[i] == symbol)
+            {
+                return i;
+            }
+        }
+        m_variables.push_back(symbol);
+        return m_variables.size() - 1;
+    }
+
+    void loadConstant(int reg, std::uint64_t bits)
+    {
+        emit({ 0x48, 0xB8 }); // mov rax, imm64
+        for (int i = 0; i < 8; ++i)
+        {
+            m_code.push_back(static_cast<char>(bits >> (8 * i)));
+        }
+        emit({ 0x66, 0x48, 0x0F, 0x6E, static_cast<std::uint8_t>(0xC0 | reg << 3) }); // movq xmm`reg`, rax
+    }
+
+    // Keeps xmm0 on the machine stack
+    void push()
+    {
+        emit({ 0x48, 0x83, 0xEC, 0x08 });       // sub rsp, 8
+        emit({ 0xF2, 0x0F, 0x11, 0x04, 0x24 }); // movsd [rsp], xmm0
+    }
+
+    void pop()
+    {
+        emit({ 0xF2, 0x0F, 0x10, 0x04, 0x24 }); // movsd xmm0, [rsp]
+        emit({ 0x48, 0x83, 0xC4, 0x08 });       // add rsp, 8
+    }
+
+    // An SSE2 instruction between two registers
+    void sse(std::uint8_t prefix, std::uint8_t opcode, int dst, int src)
+    {
+        emit({ prefix, 0x0F, opcode, static_cast<std::uint8_t>(0xC0 | dst << 3 | src) });
+    }
+
+    void emit(std::initializer_list<std::uint8_t> bytes)
+    {
+        for (auto byte : bytes)
+        {
+            m_code.push_back(static_cast<char>(byte));
+        }
+    }
+
+    void emit32(std::uint32_t value)
+    {
+        for (int i = 0; i < 4; ++i)
+        {
+            m_code.push_back(static_cast<char>(value >> (8 * i)));
+        }
+    }
+
+    std::string m_code;
+    std::vector<Symbol> m_variables;
+    ValueType m_type = ValueType::Number;
+    std::size_t m_nodes = 0;
+    bool m_failed = false;
+};
+
+} // namespace
+
+bool JitFunction::supported()
+{
+#ifdef LOX_JIT
+    static const bool sse2 = __builtin_cpu_supports("sse2");
+    return sse2;
+#else
+    return false;
+#endif
+}
+
+std::optional<JitFunction> JitFunction::compile(const Expression& tree)
+{
+    if (!supported())
+    {
+        return std::nullopt;
+    }
+    CodeGenerator generator{};
+    if (!generator.generate(tree))
+    {
+        return std::nullopt;
+    }
+#ifdef LOX_JIT
+    const auto& code = generator.code();
+    auto page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    auto size = (code.size() + page - 1) / page * page;
+    void* memory = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED)
+    {
+        return std::nullopt;
+    }
+    std::memcpy(memory, code.data(), code.size());
+    // Never writable and executable at once
+    if (::mprotect(memory, size, PROT_READ | PROT_EXEC) != 0)
+    {
+        ::munmap(memory, size);
+        return std::nullopt;
+    }
+
+    JitFunction function{};
+    function.m_code = std::unique_ptr<void, Unmap>{ memory, Unmap{ size } };
+    function.m_codeSize = code.size();
+    function.m_variables = std::move(generator.variables());
+    function.m_nodes = generator.nodes();
+    function.m_returnsBool = generator.type() == ValueType::Boolean;
+    return function;
+#else
+    return std::nullopt;
+#endif
+}
+
+LiteralValues JitFunction::call(std::span<const double> values) const
+{
+    if (values.size() != m_variables.size())
+    {
+        throw std::invalid_argument("Expected a value for every variable.");
+    }
+    auto entry = reinterpret_cast<Entry>(m_code.get());
+    double result = entry(values.data());
+    if (m_returnsBool)
+    {
+        return result != 0.0;
+    }
+    return result;
+}
+
+void JitFunction::Unmap::operator()(void* code) const
+{
+#ifdef LOX_JIT
+    ::munmap(code, size);
+#else
+    (void)code;
+#endif
+}
+
+} // namespace lox
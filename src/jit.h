@@ -0,0 +1,74 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include "BaseExpression.h"
+#include "symbolTable.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace lox
+{
+
+// x86-64 machine code for a tree whose every value is a number or a boolean.
+//
+// Every node is translated on its own into a fixed sequence of SSE2 scalar double instructions leaving its value in
+// xmm0, with booleans as 0.0 and 1.0, so the code behaves exactly like the Interpreter, NaNs and infinities included.
+// The left operand of a binary node is kept on the machine stack while the right one is computed, unless the right one
+// is a literal or a variable, which are loaded straight into xmm1. Variables are read from an array of doubles.
+// The code is written into fresh pages that are made executable, and no longer writable, before it runs.
+class JitFunction
+{
+public:
+    // x86-64 with SSE2, on an OS whose calling convention and executable pages the code generator knows
+    static bool supported();
+    // nullopt when `tree` may produce anything other than numbers and booleans, or when the JIT is not supported
+    static std::optional<JitFunction> compile(const Expression& tree);
+
+    // The variables the code reads, in the order call() takes their values
+    const std::vector<Symbol>& variables() const { return m_variables; }
+    // Runs the code. `values` holds the value of every variable, which must all be numbers.
+    LiteralValues call(std::span<const double> values) const;
+
+    // Nodes in the tree it was compiled from
+    std::size_t nodes() const { return m_nodes; }
+    std::size_t codeSize() const { return m_codeSize; }
+
+private:
+    struct Unmap
+    {
+        std::size_t size;
+        void operator()(void* code) const;
+    };
+
+    using Entry = double (*)(const double* values);
+
+    JitFunction() = default;
+
+    std::unique_ptr<void, Unmap> m_code{ nullptr, Unmap{ 0 } };
+    std::size_t m_codeSize = 0;
+    std::vector<Symbol> m_variables;
+    std::size_t m_nodes = 0;
+    bool m_returnsBool = false;
+};
+
+} // namespace lox
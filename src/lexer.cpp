@@ -15,52 +15,43 @@
  ******************************************************************************/
 
 #include "lexer.h"
+#include "lexical.h"
 #include "logger.h"
 
+#include <charconv>
+#include <cstdint>
 #include <sstream>
 #include <string>
-#include <unordered_map>
-namespace
-{
-
-bool isDigit(char c)
-{
-    return c >= '0' && c <= '9';
-}
 
-bool isAlpha(char c)
+namespace lox
 {
-    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
-}
 
-bool isAlphaNumeric(char c)
+Lexer::Lexer(std::string_view source, SymbolTable* symbols)
+    : m_source(std::move(source))
+    , m_symbols(symbols)
 {
-    return isAlpha(c) || isDigit(c);
 }
 
-const std::unordered_map<std::string_view, lox::TokenType> KeywordsMap{
-    { "and", lox::TokenType::And },     { "class", lox::TokenType::Class },   { "else", lox::TokenType::Else },
-    { "false", lox::TokenType::False }, { "for", lox::TokenType::For },       { "fun", lox::TokenType::Fun },
-    { "if", lox::TokenType::If },       { "nil", lox::TokenType::Nil },       { "or", lox::TokenType::Or },
-    { "print", lox::TokenType::Print }, { "return", lox::TokenType::Return }, { "super", lox::TokenType::Super },
-    { "this", lox::TokenType::This },   { "true", lox::TokenType::True },     { "var", lox::TokenType::Var },
-    { "while", lox::TokenType::While }
-};
-
-} // namespace
-
-namespace lox
-{
-
-Lexer::Lexer(std::string_view source)
+Lexer::Lexer(std::string_view source, unsigned int offset, unsigned int line, bool speculative, SymbolTable* symbols)
     : m_source(std::move(source))
+    , m_start(offset)
+    , m_current(offset)
+    , m_line(line)
+    , m_speculative(speculative)
+    , m_symbols(symbols)
 {
 }
 
 std::vector<Token> Lexer::tokenize()
 {
     std::vector<Token> tokens{};
+    tokenize(tokens);
+    return tokens;
+}
 
+void Lexer::tokenize(std::vector<Token>& tokens)
+{
+    tokens.clear();
     while (true)
     {
         auto tok = getNextToken();
@@ -71,13 +62,24 @@ std::vector<Token> Lexer::tokenize()
             break;
         }
     }
+    if (!Logger::enabled(Logger::Debug))
+    {
+        return;
+    }
     for (auto tok : tokens)
     {
         std::stringstream ss;
         ss << tok;
         Logger::debug(std::format("Got Token: {}", ss.str()));
     }
-    return tokens;
+}
+
+Token Lexer::scanToken(unsigned int& offset)
+{
+    auto tok = getNextToken();
+    offset = m_start;
+    m_start = m_current;
+    return tok;
 }
 
 char Lexer::advance()
@@ -105,6 +107,10 @@ Token Lexer::getNextToken()
         return Token{ LeftBrace, std::monostate{}, "", m_line };
     case '}':
         return Token{ RightBrace, std::monostate{}, "", m_line };
+    case '[':
+        return Token{ LeftBracket, std::monostate{}, "", m_line };
+    case ']':
+        return Token{ RightBracket, std::monostate{}, "", m_line };
     case ',':
         return Token{ Comma, std::monostate{}, "", m_line };
     case '.':
@@ -117,6 +123,10 @@ Token Lexer::getNextToken()
         return Token{ Semicolon, std::monostate{}, "", m_line };
     case '*':
         return Token{ Star, std::monostate{}, "", m_line };
+    case '?':
+        return Token{ Question, std::monostate{}, "", m_line };
+    case ':':
+        return Token{ Colon, std::monostate{}, "", m_line };
     case '!':
         if (match('='))
         {
@@ -170,17 +180,20 @@ Token Lexer::getNextToken()
     case '"':
         return getStringToken();
     default:
-        if (isDigit(c))
+        if (lexical::isDigit(c))
         {
             return getNumberToken();
         }
-        else if (isAlpha(c))
+        else if (lexical::isAlpha(c))
         {
             return getIdentifierToken();
         }
     }
-    Logger::error(std::format("[Line {}] Unexpected character -> {}.", m_line, c));
-    return Token{ Error, std::monostate{}, std::string{ c }, m_line }; // Maybe throw here???
+    if (!m_speculative)
+    {
+        Logger::error(std::format("[Line {}] Unexpected character -> {}.", m_line, c));
+    }
+    return Token{ Error, std::monostate{}, m_source.substr(m_start, 1), m_line }; // Maybe throw here???
 }
 
 Token Lexer::rerun()
@@ -194,7 +207,10 @@ Token Lexer::getStringToken()
     // Get to end of string
     while (peek() != '"')
     {
-        Logger::debug(std::format("peek is {}", peek()));
+        if (!m_speculative && Logger::enabled(Logger::Debug))
+        {
+            Logger::debug(std::format("peek is {}", peek()));
+        }
         if (isAtEnd())
         {
             return Token{ Error, std::monostate{}, "Unterminated string.", m_line }; // Maybe throw here???
@@ -211,11 +227,14 @@ Token Lexer::getStringToken()
         return Token{ Error, std::monostate{}, "Unterminated string.", m_line }; // Maybe throw here???
     }
 
-    Logger::debug(std::format(
-        "Building token with value {}, from index {} to index {}",
-        m_source.substr(m_start + 1, m_current - (m_start + 1) - 1),
-        m_start + 1,
-        m_current - (m_start + 1) - 1));
+    if (!m_speculative && Logger::enabled(Logger::Debug))
+    {
+        Logger::debug(std::format(
+            "Building token with value {}, from index {} to index {}",
+            m_source.substr(m_start + 1, m_current - (m_start + 1) - 1),
+            m_start + 1,
+            m_current - (m_start + 1) - 1));
+    }
     return Token{
         String, m_source.substr(m_start + 1, m_current - (m_start + 1) - 1), "", m_line
     }; // Maybe throw here???
@@ -223,58 +242,72 @@ Token Lexer::getStringToken()
 
 Token Lexer::getNumberToken()
 {
-    // In Lox every number is double!
-    while (isDigit(peek()))
+    // In Lox every number is double! Short literals are built while they are scanned, without a second pass.
+    std::uint64_t mantissa = static_cast<unsigned int>(m_source[m_start] - '0'); // Consumed by getNextToken()
+    unsigned int digits = 1;
+    unsigned int fractionDigits = 0;
+    auto scanDigits = [&]()
     {
-        advance();
-    }
+        while (lexical::isDigit(peek()))
+        {
+            mantissa = mantissa * 10 + static_cast<unsigned int>(advance() - '0'); // Wraps, only used when short
+            digits++;
+        }
+    };
 
+    scanDigits();
     // Look for a fractional part.
-    if (peek() == '.' && isDigit(peekNext()))
+    if (peek() == '.' && lexical::isDigit(peekNext()))
     {
         // Consume the "."
         advance();
-
-        while (isDigit(peek()))
-        {
-            advance();
-        }
+        auto integerDigits = digits;
+        scanDigits();
+        fractionDigits = digits - integerDigits;
     }
 
-    auto str = m_source.substr(m_start, m_current - m_start);
-    try
+    if (auto value = lexical::shortNumber(mantissa, digits, fractionDigits))
     {
-        std::size_t index;
-        double value = std::stod(str.data(), &index);
-        return Token{ Number, std::move(value), "", m_line }; // Maybe throw here???
+        return Token{ Number, value.value(), "", m_line };
     }
-    catch (const std::invalid_argument& e)
-    {
-        std::cerr << "Invalid argument: " << e.what() << std::endl;
-        return Token{ Error, std::monostate{}, str, m_line }; // Maybe throw here???
-    }
-    catch (const std::out_of_range& e)
+
+    auto str = m_source.substr(m_start, m_current - m_start);
+    double value = 0;
+    auto [end, error] = std::from_chars(str.data(), str.data() + str.size(), value);
+    if (error != std::errc{} || end != str.data() + str.size())
     {
-        std::cerr << "Out of range: " << e.what() << std::endl;
-        return Token{ Error, std::monostate{}, str, m_line }; // Maybe throw here???
+        if (!m_speculative)
+        {
+            Logger::error(std::format("[Line {}] Number literal out of range -> {}.", m_line, str));
+        }
+        return Token{ Error, std::monostate{}, "Number literal out of range.", m_line };
     }
+    return Token{ Number, value, "", m_line };
 }
 
 Token Lexer::getIdentifierToken()
 {
-    while (isAlphaNumeric(peek()))
+    while (lexical::isAlphaNumeric(peek()))
     {
         advance();
     }
 
     auto text = m_source.substr(m_start, m_current - m_start);
-    auto type = TokenType::Identifier;
-    if (KeywordsMap.contains(text))
+    if (auto type = lexical::keyword(text))
+    {
+        return Token{ type.value(), std::monostate{}, "", m_line };
+    }
+    return Token{ TokenType::Identifier, symbols().intern(text), text, m_line };
+}
+
+SymbolTable& Lexer::symbols()
+{
+    if (!m_symbols)
     {
-        type = KeywordsMap.at(text);
-        return Token{ type, std::monostate{} };
+        m_ownSymbols = std::make_unique<SymbolTable>();
+        m_symbols = m_ownSymbols.get();
     }
-    return Token{ type, text };
+    return *m_symbols;
 }
 
 bool Lexer::isAtEnd()
@@ -306,15 +339,18 @@ void Lexer::advanceUntilEndOfLine()
 
 void Lexer::advanceUntilEndOfComment()
 {
-    advance(); // consume the / in /*
-    advance(); // consume the * in /*
-    while (peek() != '*' && !isAtEnd() && peekNext() != '/')
+    advance(); // consume the * in /*, the / is already consumed
+    while (!isAtEnd() && !(peek() == '*' && peekNext() == '/'))
     {
         if ('\n' == advance())
         {
             m_line++;
         }
     }
+    if (isAtEnd()) // Unterminated comments run until the end of the source
+    {
+        return;
+    }
     advance(); // consume the * in */
     advance(); // consume the / in */
 }
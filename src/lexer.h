@@ -16,8 +16,10 @@
 
 #pragma once
 
+#include "symbolTable.h"
 #include "token.h"
 
+#include <memory>
 #include <string_view>
 #include <vector>
 
@@ -27,9 +29,25 @@ namespace lox
 class Lexer
 {
 public:
-    Lexer(std::string_view source);
+    // Identifiers are interned into `symbols`, which outlives the lexer. Without one the lexer keeps its own.
+    Lexer(std::string_view source, SymbolTable* symbols = nullptr);
+    // Starts lexing at an arbitrary offset of the source, as if every previous character had already been consumed.
+    // A speculative lexer does not log, since its output might be thrown away.
+    Lexer(
+        std::string_view source,
+        unsigned int offset,
+        unsigned int line,
+        bool speculative,
+        SymbolTable* symbols = nullptr);
 
     std::vector<Token> tokenize();
+    // Replaces the contents of `tokens`, keeping its capacity
+    void tokenize(std::vector<Token>& tokens);
+
+    // Scans a single token, reporting the offset of its first character.
+    Token scanToken(unsigned int& offset);
+    // Offset of the first character that was not consumed yet
+    unsigned int position() const { return m_current; }
 
 private:
     Token getNextToken();
@@ -44,6 +62,8 @@ private:
 
     Token rerun();
 
+    SymbolTable& symbols();
+
     void advanceUntilEndOfLine();
     void advanceUntilEndOfComment();
 
@@ -53,6 +73,9 @@ private:
     unsigned int m_start = 0;   // Start of current token being parsed
     unsigned int m_current = 0; // Character being currently considered
     unsigned int m_line = 1;
+    bool m_speculative = false;
+    SymbolTable* m_symbols = nullptr;
+    std::unique_ptr<SymbolTable> m_ownSymbols;
 };
 
 } // namespace lox
\ No newline at end of file
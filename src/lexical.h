@@ -0,0 +1,99 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include "token.h"
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <utility>
+
+// The parts of the Lexer that need no allocation, shared with the compile-time evaluation of constant.h
+namespace lox::lexical
+{
+
+constexpr bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+constexpr bool isAlpha(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+constexpr bool isAlphaNumeric(char c)
+{
+    return isAlpha(c) || isDigit(c);
+}
+
+// Literals with this many digits or less have a mantissa below 2^53, which a double holds exactly
+constexpr unsigned int MaxExactDigits = 15;
+
+constexpr std::array<double, MaxExactDigits + 1> PowersOfTen = []()
+{
+    std::array<double, MaxExactDigits + 1> powers{};
+    double power = 1;
+    for (auto& entry : powers)
+    {
+        entry = power;
+        power *= 10;
+    }
+    return powers;
+}();
+
+// The value of a literal of `digits` digits, `fractionDigits` of them after the point, whose digits read as the
+// integer `mantissa`. nullopt when the literal is too long for the mantissa to be exact, and needs a full parse.
+constexpr std::optional<double> shortNumber(std::uint64_t mantissa, unsigned int digits, unsigned int fractionDigits)
+{
+    if (digits > MaxExactDigits)
+    {
+        return std::nullopt;
+    }
+    // Both the mantissa and the power of ten are exact doubles, so the one rounding of the division is the right one
+    auto value = static_cast<double>(mantissa);
+    if (fractionDigits)
+    {
+        value /= PowersOfTen[fractionDigits];
+    }
+    return value;
+}
+
+// The keyword spelled `text`, if it is one
+constexpr std::optional<TokenType> keyword(std::string_view text)
+{
+    constexpr std::pair<std::string_view, TokenType> Keywords[] = {
+        { "and", TokenType::And },     { "class", TokenType::Class },   { "else", TokenType::Else },
+        { "false", TokenType::False }, { "for", TokenType::For },       { "fun", TokenType::Fun },
+        { "if", TokenType::If },       { "nil", TokenType::Nil },       { "or", TokenType::Or },
+        { "print", TokenType::Print }, { "return", TokenType::Return }, { "super", TokenType::Super },
+        { "this", TokenType::This },   { "true", TokenType::True },     { "var", TokenType::Var },
+        { "while", TokenType::While },
+    };
+    for (const auto& [spelling, type] : Keywords)
+    {
+        if (spelling == text)
+        {
+            return type;
+        }
+    }
+    return std::nullopt;
+}
+
+} // namespace lox::lexical
@@ -37,6 +37,10 @@ std::string centerString(std::string_view str, size_t width)
 
 void Logger::log(LogLevel level, std::string_view data)
 {
+    if (level < s_level)
+    {
+        return;
+    }
     static std::unordered_map<Logger::LogLevel, std::string_view> levelToString{ { LogLevel::Debug, "DEBUG" },
                                                                                  { LogLevel::Info, "INFO" },
                                                                                  { LogLevel::Warn, "WARN" },
@@ -45,6 +49,11 @@ void Logger::log(LogLevel level, std::string_view data)
     std::cout << "[" << centerString(levelStr, 7) << "]\t" << data << std::endl;
 }
 
+void Logger::setLevel(LogLevel level)
+{
+    s_level = level;
+}
+
 void Logger::debug(const std::string& data)
 {
     return log(LogLevel::Debug, data);
@@ -26,12 +26,6 @@ namespace lox
 struct Logger
 {
 public:
-    static void info(const std::string& data);
-    static void debug(const std::string& data);
-    static void warn(const std::string& data);
-    static void error(const std::string& data);
-
-private:
     enum LogLevel
     {
         Debug,
@@ -39,7 +33,21 @@ private:
         Warn,
         Error
     };
+
+    static void info(const std::string& data);
+    static void debug(const std::string& data);
+    static void warn(const std::string& data);
+    static void error(const std::string& data);
+
+    // Messages below this level are dropped, everything is logged by default
+    static void setLevel(LogLevel level);
+    // Whether messages of this level are logged, to skip building the ones that are not
+    static bool enabled(LogLevel level) { return level >= s_level; }
+
+private:
     static void log(LogLevel level, std::string_view data);
+
+    static inline LogLevel s_level = LogLevel::Debug;
 };
 
 } // namespace lox
\ No newline at end of file
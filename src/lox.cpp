@@ -15,17 +15,300 @@
  ******************************************************************************/
 
 #include "lox.h"
+#include "allocStats.h"
+#include "cppTranspiler.h"
 #include "interpreter.h"
+#include "perfCounters.h"
+#include "tracer.h"
 
+#include <charconv>
+#include <cstdlib>
+#include <format>
+#include <fstream>
 #include <iostream>
+#include <optional>
+#include <string_view>
+#include <thread>
 
 namespace lox
 {
 
+namespace
+{
+
+constexpr std::string_view TraceFlag = "--trace=";
+constexpr std::string_view AllocStatsFlag = "--alloc-stats";
+constexpr std::string_view PerfStatsFlag = "--perf-stats";
+constexpr std::string_view ProfileFlag = "--profile";
+constexpr std::string_view ResultCacheFlag = "--result-cache";
+constexpr std::string_view AstCacheFlag = "--ast-cache=";
+constexpr std::string_view JitFlag = "--jit";
+constexpr std::string_view NumericOnlyFlag = "--numeric-only";
+constexpr std::string_view ParallelFlag = "--parallel";
+constexpr std::string_view EmitCppFlag = "--emit-cpp=";
+constexpr const char* TraceEnvironmentVariable = "LOX_TRACE";
+
+struct Options
+{
+    std::optional<std::filesystem::path> tracePath;
+    bool allocStats = false;
+    bool perfStats = false;
+    std::optional<unsigned int> samplePeriod;
+    std::optional<std::size_t> cacheBytes;
+    std::optional<std::filesystem::path> astCachePath;
+    bool jit = false;
+    bool numericOnly = false;
+    std::optional<unsigned int> threads;
+    std::optional<std::filesystem::path> emitCppPath;
+};
+
+int runWithOptions(Interpreter& interpreter, const Options& options)
+{
+    if (options.tracePath)
+    {
+        Tracer::enable();
+    }
+    if (options.allocStats)
+    {
+        AllocStats::reset();
+    }
+    bool perfStats = false;
+    if (options.perfStats)
+    {
+        PerfCounters::reset();
+        perfStats = PerfCounters::enable();
+        if (!perfStats)
+        {
+            Logger::warn("Hardware counters are not available, check /proc/sys/kernel/perf_event_paranoid.");
+        }
+    }
+    std::optional<Profiler> profiler{};
+    if (options.samplePeriod)
+    {
+        interpreter.setProfiler(&profiler.emplace(options.samplePeriod.value()));
+    }
+    std::optional<ResultCache> cache{};
+    if (options.cacheBytes)
+    {
+        interpreter.setResultCache(&cache.emplace(options.cacheBytes.value()));
+    }
+    std::optional<AstCache> astCache{};
+    if (options.astCachePath)
+    {
+        interpreter.setAstCache(&astCache.emplace(options.astCachePath.value()));
+    }
+    if (options.jit)
+    {
+        if (!JitFunction::supported())
+        {
+            Logger::warn("The JIT does not support this machine, every input is interpreted.");
+        }
+        interpreter.setJit(true);
+    }
+    interpreter.setNumericOnly(options.numericOnly);
+    std::optional<WorkStealingPool> pool{};
+    if (options.threads)
+    {
+        interpreter.setPool(&pool.emplace(options.threads.value()));
+    }
+    auto exitCode = interpreter.run();
+    interpreter.setProfiler(nullptr);
+    interpreter.setResultCache(nullptr);
+    interpreter.setAstCache(nullptr);
+    interpreter.setJit(false);
+    interpreter.setNumericOnly(false);
+    interpreter.setPool(nullptr);
+    if (options.tracePath)
+    {
+        Tracer::disable();
+        if (!Tracer::write(options.tracePath.value()))
+        {
+            Logger::error(std::format("Failed to write the trace to {}.", options.tracePath->string()));
+        }
+    }
+    if (options.allocStats)
+    {
+        std::cerr << AllocStats::report();
+    }
+    if (perfStats)
+    {
+        PerfCounters::disable();
+        std::cerr << PerfCounters::report();
+    }
+    if (cache)
+    {
+        std::cerr << cache->report();
+    }
+    return exitCode;
+}
+
+// Writes the script as C++ into `directory`, rather than running it, as `<stem>.h` and `<stem>.cpp` declaring
+// `<stem>::evaluate`
+int emitCpp(const std::filesystem::path& script, const std::filesystem::path& directory)
+{
+    std::ifstream file{ script };
+    if (!file.is_open())
+    {
+        Logger::error(std::format("Failed to open file at {}.", script.string()));
+        return EXIT_FAILURE;
+    }
+    // Joined like Interpreter::interpretFile does
+    std::string source{}, line{};
+    while (getline(file, line))
+    {
+        source += line;
+    }
+
+    Session session{};
+    session.lex(source);
+    const auto* tree = session.parse();
+    if (!tree)
+    {
+        return EXIT_FAILURE;
+    }
+    try
+    {
+        CppTranspiler transpiler{ script.stem().string(), session.symbols() };
+        transpiler.add("evaluate", *tree);
+        if (!transpiler.write(directory))
+        {
+            Logger::error(std::format("Failed to write the C++ source to {}.", directory.string()));
+            return EXIT_FAILURE;
+        }
+    }
+    catch (const std::invalid_argument& e)
+    {
+        Logger::error(e.what());
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+template <typename Number>
+bool parsePositive(std::string_view text, Number& number)
+{
+    auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), number);
+    return error == std::errc{} && end == text.data() + text.size() && number > 0;
+}
+
+std::optional<std::filesystem::path> traceFromEnvironment()
+{
+    const char* path = std::getenv(TraceEnvironmentVariable);
+    if (!path || !*path)
+    {
+        return std::nullopt;
+    }
+    return path;
+}
+
+} // namespace
+
 void run()
 {
     Interpreter interpreter;
-    interpreter.run();
+    Options options{};
+    options.tracePath = traceFromEnvironment();
+    runWithOptions(interpreter, options);
+}
+
+int run(int argc, char** argv)
+{
+    Options options{};
+    options.tracePath = traceFromEnvironment();
+    std::optional<std::filesystem::path> script{};
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string_view arg{ argv[i] };
+        if (arg.starts_with(TraceFlag))
+        {
+            options.tracePath = arg.substr(TraceFlag.size());
+        }
+        else if (arg.starts_with(EmitCppFlag))
+        {
+            options.emitCppPath = arg.substr(EmitCppFlag.size());
+        }
+        else if (arg.starts_with(AstCacheFlag))
+        {
+            options.astCachePath = arg.substr(AstCacheFlag.size());
+        }
+        else if (arg == AllocStatsFlag)
+        {
+            options.allocStats = true;
+        }
+        else if (arg == PerfStatsFlag)
+        {
+            options.perfStats = true;
+        }
+        else if (arg == JitFlag)
+        {
+            options.jit = true;
+        }
+        else if (arg == NumericOnlyFlag)
+        {
+            options.numericOnly = true;
+        }
+        else if (arg.starts_with(ProfileFlag))
+        {
+            // --profile times every node, --profile=<N> one visit in N
+            unsigned int period = 1;
+            auto value = arg.substr(ProfileFlag.size());
+            if (!value.empty() && (!value.starts_with('=') || !parsePositive(value.substr(1), period)))
+            {
+                std::cerr << "Invalid sample period: " << arg << std::endl;
+                return EXIT_FAILURE;
+            }
+            options.samplePeriod = period;
+        }
+        else if (arg.starts_with(ParallelFlag))
+        {
+            // --parallel uses every core, --parallel=<N> N threads
+            unsigned int threads = std::thread::hardware_concurrency();
+            auto value = arg.substr(ParallelFlag.size());
+            if (!value.empty() && (!value.starts_with('=') || !parsePositive(value.substr(1), threads)))
+            {
+                std::cerr << "Invalid thread count: " << arg << std::endl;
+                return EXIT_FAILURE;
+            }
+            options.threads = threads;
+        }
+        else if (arg.starts_with(ResultCacheFlag))
+        {
+            // --result-cache keeps up to 16 MiB of results, --result-cache=<bytes> sets the cap
+            std::size_t bytes = ResultCache::DefaultMaxBytes;
+            auto value = arg.substr(ResultCacheFlag.size());
+            if (!value.empty() && (!value.starts_with('=') || !parsePositive(value.substr(1), bytes)))
+            {
+                std::cerr << "Invalid result cache size: " << arg << std::endl;
+                return EXIT_FAILURE;
+            }
+            options.cacheBytes = bytes;
+        }
+        else if (!script)
+        {
+            script = arg;
+        }
+        else
+        {
+            std::cerr << "Usage: lox [--trace=<file>] [--alloc-stats] [--perf-stats] [--profile[=<N>]] "
+                         "[--result-cache[=<bytes>]] [--ast-cache=<dir>] [--jit] [--numeric-only] [--parallel[=<N>]] "
+                         "[--emit-cpp=<dir>] [script]"
+                      << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (options.emitCppPath)
+    {
+        if (!script)
+        {
+            std::cerr << "--emit-cpp needs a script." << std::endl;
+            return EXIT_FAILURE;
+        }
+        return emitCpp(script.value(), options.emitCppPath.value());
+    }
+
+    auto interpreter = script ? Interpreter{ script.value() } : Interpreter{};
+    return runWithOptions(interpreter, options);
 }
 
-} // namespace lox
\ No newline at end of file
+} // namespace lox
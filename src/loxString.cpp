@@ -0,0 +1,346 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+#include "loxString.h"
+
+#include <cstring>
+#include <functional>
+#include <new>
+#include <vector>
+
+namespace lox
+{
+
+struct LoxString::RopeRep : Rep
+{
+    RopeRep(LoxString leftHalf, LoxString rightHalf)
+        : Rep{ 1, true, 0, 0, leftHalf.size() + rightHalf.size() }
+        , left(std::move(leftHalf))
+        , right(std::move(rightHalf))
+    {
+    }
+
+    // The halves are kept after flattening, as other threads may still be walking them
+    LoxString left;
+    LoxString right;
+    std::atomic<Rep*> flat = nullptr; // Threads racing to flatten agree on the first one published
+};
+
+LoxString::LoxString(std::string_view text)
+{
+    if (text.size() <= InlineCapacity)
+    {
+        std::memcpy(m_bytes, text.data(), text.size());
+        m_bytes[TagByte] = static_cast<unsigned char>(text.size());
+        return;
+    }
+    auto* rep = allocate(text.size(), 0);
+    std::memcpy(rep->data(), text.data(), text.size());
+    rep->hash = std::hash<std::string_view>{}(text);
+    *this = LoxString{ rep };
+}
+
+LoxString::LoxString(Rep* rep)
+{
+    std::memcpy(m_bytes, &rep, sizeof(rep));
+    m_bytes[TagByte] = HeapTag;
+}
+
+LoxString::LoxString(const LoxString& other)
+{
+    std::memcpy(m_bytes, other.m_bytes, sizeof(m_bytes));
+    if (!isInline())
+    {
+        rep()->references.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+LoxString::LoxString(LoxString&& other) noexcept
+{
+    std::memcpy(m_bytes, other.m_bytes, sizeof(m_bytes));
+    std::memset(other.m_bytes, 0, sizeof(other.m_bytes));
+}
+
+LoxString& LoxString::operator=(const LoxString& other)
+{
+    if (this != &other)
+    {
+        LoxString copy{ other };
+        *this = std::move(copy);
+    }
+    return *this;
+}
+
+LoxString& LoxString::operator=(LoxString&& other) noexcept
+{
+    if (this != &other)
+    {
+        release();
+        std::memcpy(m_bytes, other.m_bytes, sizeof(m_bytes));
+        std::memset(other.m_bytes, 0, sizeof(other.m_bytes));
+    }
+    return *this;
+}
+
+LoxString::~LoxString()
+{
+    release();
+}
+
+std::string_view LoxString::view() const
+{
+    if (isInline())
+    {
+        return { reinterpret_cast<const char*>(m_bytes), m_bytes[TagByte] };
+    }
+    auto* heap = flatRep();
+    return { heap->data(), heap->size };
+}
+
+bool LoxString::isRope() const
+{
+    return !isInline() && rep()->rope && !static_cast<RopeRep*>(rep())->flat.load(std::memory_order_acquire);
+}
+
+std::size_t LoxString::hash() const
+{
+    return isInline() ? std::hash<std::string_view>{}(view()) : flatRep()->hash;
+}
+
+bool LoxString::operator==(const LoxString& other) const
+{
+    if (isInline() || other.isInline())
+    {
+        // Heap strings are never short enough to equal an inline one
+        return std::memcmp(m_bytes, other.m_bytes, sizeof(m_bytes)) == 0;
+    }
+    auto* mine = rep();
+    auto* theirs = other.rep();
+    if (mine == theirs)
+    {
+        return true;
+    }
+    if (mine->size != theirs->size)
+    {
+        return false;
+    }
+    if (mine->internEpoch && mine->internEpoch == theirs->internEpoch)
+    {
+        return false; // Interned together, so different buffers hold different strings
+    }
+    mine = flatRep();
+    theirs = other.flatRep();
+    return mine == theirs ||
+           (mine->hash == theirs->hash && std::memcmp(mine->data(), theirs->data(), mine->size) == 0);
+}
+
+LoxString operator+(const LoxString& left, const LoxString& right)
+{
+    const auto size = left.size() + right.size();
+    if (size >= LoxString::MinRopeSize)
+    {
+        return LoxString{ new LoxString::RopeRep{ left, right } };
+    }
+
+    // Neither half is a rope, as both are shorter than one
+    auto leftView = left.view();
+    auto rightView = right.view();
+    if (size <= LoxString::InlineCapacity)
+    {
+        char buffer[LoxString::InlineCapacity];
+        std::memcpy(buffer, leftView.data(), leftView.size());
+        std::memcpy(buffer + leftView.size(), rightView.data(), rightView.size());
+        return LoxString{ std::string_view{ buffer, size } };
+    }
+    auto* rep = LoxString::allocate(size, 0);
+    std::memcpy(rep->data(), leftView.data(), leftView.size());
+    std::memcpy(rep->data() + leftView.size(), rightView.data(), rightView.size());
+    rep->hash = std::hash<std::string_view>{}(std::string_view{ rep->data(), size });
+    return LoxString{ rep };
+}
+
+LoxString::Rep* LoxString::allocate(std::size_t size, std::uint64_t internEpoch)
+{
+    void* memory = ::operator new(sizeof(Rep) + size);
+    return new (memory) Rep{ 1, false, internEpoch, 0, size };
+}
+
+LoxString::Rep* LoxString::rep() const
+{
+    Rep* heap = nullptr;
+    std::memcpy(&heap, m_bytes, sizeof(heap));
+    return heap;
+}
+
+LoxString::Rep* LoxString::flatRep() const
+{
+    auto* heap = rep();
+    if (!heap->rope)
+    {
+        return heap;
+    }
+    auto& rope = *static_cast<RopeRep*>(heap);
+    if (auto* flat = rope.flat.load(std::memory_order_acquire))
+    {
+        return flat;
+    }
+    return flatten(rope);
+}
+
+LoxString::Rep* LoxString::flatten(RopeRep& rope)
+{
+    auto* flat = allocate(rope.size, 0);
+    auto* out = flat->data();
+
+    // Ropes built by long chains are as deep as the chain, so they are walked with a stack of our own
+    std::vector<const LoxString*> pending{ &rope.right, &rope.left };
+    while (!pending.empty())
+    {
+        const auto* str = pending.back();
+        pending.pop_back();
+        if (!str->isInline() && str->rep()->rope)
+        {
+            auto& inner = *static_cast<RopeRep*>(str->rep());
+            if (!inner.flat.load(std::memory_order_acquire))
+            {
+                pending.emplace_back(&inner.right);
+                pending.emplace_back(&inner.left);
+                continue;
+            }
+        }
+        auto text = str->view();
+        std::memcpy(out, text.data(), text.size());
+        out += text.size();
+    }
+    flat->hash = std::hash<std::string_view>{}(std::string_view{ flat->data(), flat->size });
+
+    Rep* published = nullptr;
+    if (!rope.flat.compare_exchange_strong(published, flat, std::memory_order_acq_rel, std::memory_order_acquire))
+    {
+        destroy(flat);
+        return published;
+    }
+    return flat;
+}
+
+void LoxString::release()
+{
+    if (isInline())
+    {
+        return;
+    }
+    auto* heap = rep();
+    if (heap->references.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        destroy(heap);
+    }
+    std::memset(m_bytes, 0, sizeof(m_bytes));
+}
+
+void LoxString::destroy(Rep* rep)
+{
+    if (!rep->rope)
+    {
+        rep->~Rep();
+        ::operator delete(rep);
+        return;
+    }
+
+    // Releasing the halves of a rope from its destructor would recurse as deep as the rope
+    std::vector<Rep*> pending{ rep };
+    while (!pending.empty())
+    {
+        auto* heap = pending.back();
+        pending.pop_back();
+        if (!heap->rope)
+        {
+            heap->~Rep();
+            ::operator delete(heap);
+            continue;
+        }
+        auto* rope = static_cast<RopeRep*>(heap);
+        for (auto* half : { &rope->left, &rope->right })
+        {
+            if (!half->isInline() && half->rep()->references.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                pending.emplace_back(half->rep());
+            }
+            std::memset(half->m_bytes, 0, sizeof(half->m_bytes));
+        }
+        if (auto* flat = rope->flat.load(std::memory_order_acquire))
+        {
+            pending.emplace_back(flat);
+        }
+        delete rope;
+    }
+}
+
+std::ostream& operator<<(std::ostream& os, const LoxString& str)
+{
+    return os << str.view();
+}
+
+StringInterner::StringInterner()
+    : m_epoch(nextEpoch())
+{
+}
+
+LoxString StringInterner::intern(std::string_view text)
+{
+    if (text.size() <= LoxString::InlineCapacity)
+    {
+        return LoxString{ text };
+    }
+    std::scoped_lock lock{ m_mutex };
+    if (auto found = m_strings.find(text); found != m_strings.end())
+    {
+        return found->second;
+    }
+    auto* rep = LoxString::allocate(text.size(), m_epoch);
+    std::memcpy(rep->data(), text.data(), text.size());
+    rep->hash = std::hash<std::string_view>{}(text);
+    LoxString interned{ rep };
+    m_strings.emplace(interned.view(), interned);
+    return interned;
+}
+
+std::size_t StringInterner::size() const
+{
+    std::scoped_lock lock{ m_mutex };
+    return m_strings.size();
+}
+
+void StringInterner::clear()
+{
+    std::scoped_lock lock{ m_mutex };
+    m_strings.clear();
+    // Strings interned before still hold their buffers, a new epoch keeps them from being mistaken for unique ones
+    m_epoch = nextEpoch();
+}
+
+StringInterner& StringInterner::global()
+{
+    static StringInterner interner{};
+    return interner;
+}
+
+std::uint64_t StringInterner::nextEpoch()
+{
+    static std::atomic<std::uint64_t> epoch{ 0 };
+    return epoch.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+} // namespace lox
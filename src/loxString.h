@@ -0,0 +1,139 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string_view>
+#include <unordered_map>
+
+namespace lox
+{
+
+// The string value of Lox: immutable, so copies share their characters.
+//
+// Strings of up to InlineCapacity characters live inside the object and never touch the heap. Longer ones live in a
+// reference counted buffer, so copying one is an increment. Buffers made by a StringInterner are unique per content,
+// so two of them from the same interner are equal exactly when they are the same buffer.
+//
+// Concatenating long strings makes a rope node pointing at both halves instead of copying them, so a chain of n
+// concatenations is linear rather than quadratic. A rope is flattened, once, the first time its characters are needed:
+// to view, compare or hash it.
+class LoxString
+{
+public:
+    static constexpr std::size_t InlineCapacity = 15;
+
+    LoxString() = default;
+    explicit LoxString(std::string_view text);
+
+    LoxString(const LoxString& other);
+    LoxString(LoxString&& other) noexcept;
+    LoxString& operator=(const LoxString& other);
+    LoxString& operator=(LoxString&& other) noexcept;
+    ~LoxString();
+
+    // Flattens a rope
+    std::string_view view() const;
+    std::size_t size() const { return isInline() ? m_bytes[TagByte] : rep()->size; }
+    bool isInline() const { return m_bytes[TagByte] != HeapTag; }
+    bool isInterned() const { return !isInline() && rep()->internEpoch; }
+    // A concatenation whose characters have not been needed yet
+    bool isRope() const;
+    std::size_t hash() const;
+
+    bool operator==(const LoxString& other) const;
+    bool operator==(std::string_view other) const { return view() == other; }
+
+    friend LoxString operator+(const LoxString& left, const LoxString& right);
+
+private:
+    friend class StringInterner;
+
+    struct Rep
+    {
+        std::atomic<std::uint32_t> references;
+        bool rope;
+        std::uint64_t internEpoch; // Of the interner that made it, 0 when not interned
+        std::size_t hash;          // Of the characters, not set for ropes
+        std::size_t size;
+
+        // The characters follow the header, except for ropes
+        char* data() { return reinterpret_cast<char*>(this + 1); }
+    };
+
+    struct RopeRep;
+
+    // Concatenations shorter than this are copied, which is cheaper than a rope node for short strings
+    static constexpr std::size_t MinRopeSize = 256;
+
+    // The last byte holds the size of an inline string, or HeapTag
+    static constexpr std::size_t TagByte = InlineCapacity;
+    static constexpr unsigned char HeapTag = 0x80;
+
+    // Takes a new buffer of `size` characters, to be filled by the caller
+    static Rep* allocate(std::size_t size, std::uint64_t internEpoch);
+    explicit LoxString(Rep* rep);
+
+    Rep* rep() const;
+    // The flat buffer holding the characters
+    Rep* flatRep() const;
+    static Rep* flatten(RopeRep& rope);
+    void release();
+    static void destroy(Rep* rep);
+
+    // Zero padded, so two inline strings are equal exactly when their bytes are
+    alignas(8) unsigned char m_bytes[InlineCapacity + 1]{};
+};
+
+std::ostream& operator<<(std::ostream& os, const LoxString& str);
+
+// Hands out one shared buffer per distinct string. Interned strings stay alive until the interner is cleared.
+class StringInterner
+{
+public:
+    StringInterner();
+    ~StringInterner() = default;
+
+    StringInterner(const StringInterner&) = delete;
+    StringInterner& operator=(const StringInterner&) = delete;
+
+    LoxString intern(std::string_view text);
+    // Number of interned strings, short ones are not interned as they are compared inline
+    std::size_t size() const;
+    void clear();
+
+    // The interner used by the Parser for string literals
+    static StringInterner& global();
+
+private:
+    static std::uint64_t nextEpoch();
+
+    mutable std::mutex m_mutex;
+    std::unordered_map<std::string_view, LoxString> m_strings; // The keys point into the values
+    std::uint64_t m_epoch;
+};
+
+} // namespace lox
+
+template <> struct std::hash<lox::LoxString>
+{
+    std::size_t operator()(const lox::LoxString& str) const { return str.hash(); }
+};
@@ -0,0 +1,206 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+
+#include "numberArray.h"
+
+#include "arrayKernels.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <string_view>
+#include <utility>
+
+namespace lox
+{
+
+namespace
+{
+
+kernels::Op kernelOf(TokenType op)
+{
+    using enum TokenType;
+    switch (op)
+    {
+    case Plus:
+        return kernels::Op::Add;
+    case Minus:
+        return kernels::Op::Subtract;
+    case Star:
+        return kernels::Op::Multiply;
+    case Slash:
+        return kernels::Op::Divide;
+    case Greater:
+        return kernels::Op::Greater;
+    case GreaterEqual:
+        return kernels::Op::GreaterEqual;
+    case Less:
+        return kernels::Op::Less;
+    case LessEqual:
+        return kernels::Op::LessEqual;
+    default:
+        assert(false && "Not an element-wise operator");
+        return kernels::Op::Add;
+    }
+}
+
+} // namespace
+
+NumberArray::NumberArray(std::span<const double> elements)
+    : m_rep(allocate(elements.size()))
+{
+    if (m_rep)
+    {
+        std::memcpy(m_rep->data(), elements.data(), elements.size_bytes());
+    }
+}
+
+NumberArray::NumberArray(const NumberArray& other)
+    : m_rep(other.m_rep)
+{
+    if (m_rep)
+    {
+        m_rep->references.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+NumberArray::NumberArray(NumberArray&& other) noexcept
+    : m_rep(std::exchange(other.m_rep, nullptr))
+{
+}
+
+NumberArray& NumberArray::operator=(const NumberArray& other)
+{
+    if (this != &other)
+    {
+        NumberArray copy{ other };
+        *this = std::move(copy);
+    }
+    return *this;
+}
+
+NumberArray& NumberArray::operator=(NumberArray&& other) noexcept
+{
+    if (this != &other)
+    {
+        release();
+        m_rep = std::exchange(other.m_rep, nullptr);
+    }
+    return *this;
+}
+
+NumberArray::~NumberArray()
+{
+    release();
+}
+
+double NumberArray::sum() const
+{
+    return kernels::sum(data(), size());
+}
+
+double NumberArray::min() const
+{
+    assert(!empty());
+    return kernels::min(data(), size());
+}
+
+double NumberArray::max() const
+{
+    assert(!empty());
+    return kernels::max(data(), size());
+}
+
+bool NumberArray::operator==(const NumberArray& other) const
+{
+    return std::ranges::equal(elements(), other.elements());
+}
+
+// Of the bits of the elements, as with the numbers of hashValue, so 0 and -0 differ
+std::size_t NumberArray::hash() const
+{
+    auto bytes = std::as_bytes(elements());
+    return std::hash<std::string_view>{}({ reinterpret_cast<const char*>(bytes.data()), bytes.size() });
+}
+
+NumberArray::Rep* NumberArray::allocate(std::size_t size)
+{
+    if (!size)
+    {
+        return nullptr;
+    }
+    void* memory = ::operator new(sizeof(Rep) + size * sizeof(double));
+    return new (memory) Rep{ 1, size };
+}
+
+void NumberArray::release()
+{
+    if (m_rep && m_rep->references.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        m_rep->~Rep();
+        ::operator delete(m_rep);
+    }
+    m_rep = nullptr;
+}
+
+std::ostream& operator<<(std::ostream& os, const NumberArray& array)
+{
+    os << '[';
+    for (std::size_t i = 0; i < array.size(); ++i)
+    {
+        os << (i ? ", " : "") << array[i];
+    }
+    return os << ']';
+}
+
+NumberArray elementWise(TokenType op, const NumberArray& a, const NumberArray& b)
+{
+    assert(a.size() == b.size());
+    return NumberArray::make(a.size(),
+                             [&](double* out) { kernels::apply(kernelOf(op), a.data(), b.data(), out, a.size()); });
+}
+
+NumberArray elementWise(TokenType op, const NumberArray& a, double b)
+{
+    return NumberArray::make(a.size(), [&](double* out) { kernels::apply(kernelOf(op), a.data(), b, out, a.size()); });
+}
+
+NumberArray elementWise(TokenType op, double a, const NumberArray& b)
+{
+    return NumberArray::make(b.size(), [&](double* out) { kernels::apply(kernelOf(op), a, b.data(), out, b.size()); });
+}
+
+NumberArray elementWise(TokenType op, const NumberArray& a)
+{
+    assert(op == TokenType::Minus || op == TokenType::Bang);
+    return NumberArray::make(a.size(),
+                             [&](double* out)
+                             {
+                                 if (op == TokenType::Minus)
+                                 {
+                                     kernels::negate(a.data(), out, a.size());
+                                 }
+                                 else
+                                 {
+                                     kernels::logicalNot(a.data(), out, a.size());
+                                 }
+                             });
+}
+
+} // namespace lox
@@ -0,0 +1,108 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+
+#pragma once
+
+#include "token.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <span>
+
+namespace lox
+{
+
+// The array value of Lox: a run of numbers, immutable so copies share their elements. The elements live in a reference
+// counted buffer, so copying an array is an increment and the value is a single pointer. An empty array has no buffer.
+//
+// The operators apply element by element through the SIMD loops of arrayKernels.h, each making a new array.
+class NumberArray
+{
+public:
+    NumberArray() = default;
+    explicit NumberArray(std::span<const double> elements);
+
+    // An array of `size` elements, all written by `fill(double* elements)` before it returns
+    template <typename Fill> static NumberArray make(std::size_t size, Fill&& fill)
+    {
+        NumberArray array{ allocate(size) };
+        if (size)
+        {
+            fill(array.m_rep->data());
+        }
+        return array;
+    }
+
+    NumberArray(const NumberArray& other);
+    NumberArray(NumberArray&& other) noexcept;
+    NumberArray& operator=(const NumberArray& other);
+    NumberArray& operator=(NumberArray&& other) noexcept;
+    ~NumberArray();
+
+    std::size_t size() const { return m_rep ? m_rep->size : 0; }
+    bool empty() const { return !m_rep; }
+    const double* data() const { return m_rep ? m_rep->data() : nullptr; }
+    std::span<const double> elements() const { return { data(), size() }; }
+    double operator[](std::size_t index) const { return data()[index]; }
+
+    // Sums in several lanes at once, so the rounding may differ from adding the elements in order
+    double sum() const;
+    // NaN when an element is NaN. The array must not be empty.
+    double min() const;
+    double max() const;
+
+    // The same elements in the same order, so an array holding NaN equals no array
+    bool operator==(const NumberArray& other) const;
+    std::size_t hash() const;
+
+private:
+    struct Rep
+    {
+        std::atomic<std::uint32_t> references;
+        std::size_t size;
+
+        // The elements follow the header
+        double* data() { return reinterpret_cast<double*>(this + 1); }
+        const double* data() const { return reinterpret_cast<const double*>(this + 1); }
+    };
+
+    // Takes a buffer of `size` elements, to be filled by the caller. nullptr when empty.
+    static Rep* allocate(std::size_t size);
+    explicit NumberArray(Rep* rep)
+        : m_rep(rep)
+    {
+    }
+
+    void release();
+
+    Rep* m_rep = nullptr;
+};
+
+std::ostream& operator<<(std::ostream& os, const NumberArray& array);
+
+// The binary operators of arrays, element by element: `+`, `-`, `*` and `/`, and `>`, `>=`, `<` and `<=` which give 1
+// where they hold and 0 where they do not. A number operand counts as an array of that number, as long as the other
+// operand. Arrays must be as long as one another.
+NumberArray elementWise(TokenType op, const NumberArray& a, const NumberArray& b);
+NumberArray elementWise(TokenType op, const NumberArray& a, double b);
+NumberArray elementWise(TokenType op, double a, const NumberArray& b);
+// `-` negates every element, `!` gives 1 where an element is 0 and 0 elsewhere
+NumberArray elementWise(TokenType op, const NumberArray& a);
+
+} // namespace lox
@@ -0,0 +1,255 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+#include "parallelLexer.h"
+
+#include "tracer.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <limits>
+
+namespace lox
+{
+
+namespace
+{
+
+// How far past a cut we look for a new line to move the cut to
+constexpr std::size_t NewLineSearchWindow = 4096;
+
+} // namespace
+
+ParallelLexer::ParallelLexer(std::string_view source, unsigned int threadCount, std::size_t minChunkSize)
+    : m_source(std::move(source))
+    , m_threadCount(std::max(threadCount, 1u))
+    , m_minChunkSize(std::max<std::size_t>(minChunkSize, 1))
+{
+    assert(m_source.size() < std::numeric_limits<unsigned int>::max());
+}
+
+ParallelLexer::ParallelLexer(
+    std::string_view source,
+    SymbolTable* symbols,
+    unsigned int threadCount,
+    std::size_t minChunkSize)
+    : ParallelLexer(source, threadCount, minChunkSize)
+{
+    m_symbols = symbols;
+}
+
+std::vector<Token> ParallelLexer::tokenize()
+{
+    auto chunks = split();
+    if (chunks.size() == 1)
+    {
+        return Lexer{ m_source, m_symbols }.tokenize();
+    }
+
+    forEachChunk(
+        chunks,
+        [this](Chunk& chunk)
+        {
+            auto text = m_source.substr(chunk.begin, chunk.end - chunk.begin);
+            chunk.newLines = static_cast<unsigned int>(std::count(text.begin(), text.end(), '\n'));
+        });
+
+    unsigned int line = 1;
+    for (auto& chunk : chunks)
+    {
+        chunk.firstLine = line;
+        line += chunk.newLines;
+    }
+
+    forEachChunk(chunks, [this](Chunk& chunk) { lexChunk(chunk); });
+
+    std::vector<Token> tokens{};
+    std::vector<Error> errors{};
+    stitch(chunks, tokens, errors);
+    SymbolTable ownSymbols{};
+    renumber(chunks, tokens, m_symbols ? *m_symbols : ownSymbols);
+    tokens.emplace_back(Token{ TokenType::Eof, std::monostate{}, "", line });
+
+    // Speculative lexers stay quiet, so errors are only reported for the tokens that made it to the output. Their
+    // token does not always keep the text the message quotes, so the sequential lexer re-scans it and does the logging.
+    for (const auto& error : errors)
+    {
+        unsigned int offset = 0;
+        Lexer{ m_source, error.offset, tokens[error.index].lineNo, false }.scanToken(offset);
+    }
+    return tokens;
+}
+
+std::vector<ParallelLexer::Chunk> ParallelLexer::split() const
+{
+    const auto size = m_source.size();
+    const auto chunkCount = std::clamp<std::size_t>(size / m_minChunkSize, 1, m_threadCount);
+
+    std::vector<Chunk> chunks{};
+    auto addChunk = [&chunks](std::size_t begin, std::size_t end)
+    {
+        auto& chunk = chunks.emplace_back();
+        chunk.begin = static_cast<unsigned int>(begin);
+        chunk.end = static_cast<unsigned int>(end);
+    };
+    std::size_t begin = 0;
+    for (std::size_t i = 1; i < chunkCount; ++i)
+    {
+        auto cut = size * i / chunkCount;
+
+        // Tokens rarely span lines, so cutting right after a new line makes a misaligned chunk unlikely
+        auto newLine = m_source.substr(cut, NewLineSearchWindow).find('\n');
+        if (newLine != std::string_view::npos)
+        {
+            cut += newLine + 1;
+        }
+        if (cut <= begin || cut >= size)
+        {
+            continue;
+        }
+        addChunk(begin, cut);
+        begin = cut;
+    }
+    addChunk(begin, size);
+    return chunks;
+}
+
+template <typename Fn> void ParallelLexer::forEachChunk(std::vector<Chunk>& chunks, Fn fn) const
+{
+    std::vector<std::jthread> workers{};
+    workers.reserve(chunks.size() - 1);
+    for (std::size_t i = 1; i < chunks.size(); ++i)
+    {
+        workers.emplace_back([&fn, &chunk = chunks[i]]() { fn(chunk); });
+    }
+    fn(chunks.front());
+}
+
+void ParallelLexer::lexChunk(Chunk& chunk) const
+{
+    PhaseScope phase{ Phase::Lex };
+    Lexer lexer{ m_source, chunk.begin, chunk.firstLine, true, &chunk.symbols };
+    while (true)
+    {
+        unsigned int offset = 0;
+        auto tok = lexer.scanToken(offset);
+        if (offset >= chunk.end)
+        {
+            chunk.resume = offset;
+            return;
+        }
+        chunk.tokens.emplace_back(tok);
+        chunk.offsets.emplace_back(offset);
+    }
+}
+
+void ParallelLexer::stitch(std::vector<Chunk>& chunks, std::vector<Token>& tokens, std::vector<Error>& errors) const
+{
+    auto append = [&tokens, &errors](const Chunk& chunk, std::size_t index)
+    {
+        for (; index < chunk.tokens.size(); ++index)
+        {
+            if (chunk.tokens[index].type == TokenType::Error)
+            {
+                errors.push_back(Error{ tokens.size(), chunk.offsets[index] });
+            }
+            tokens.emplace_back(chunk.tokens[index]);
+        }
+    };
+
+    std::size_t tokenCount = 1;
+    for (const auto& chunk : chunks)
+    {
+        tokenCount += chunk.tokens.size();
+    }
+    tokens.reserve(tokenCount);
+
+    // The first chunk starts at the beginning of the source, so its speculation is always right
+    append(chunks.front(), 0);
+    auto expected = chunks.front().resume; // Offset of the next token of the real token stream
+
+    for (std::size_t i = 1; i < chunks.size(); ++i)
+    {
+        auto& chunk = chunks[i];
+        chunk.first = tokens.size();
+        if (expected >= chunk.end) // A token (or comment) swallowed the whole chunk
+        {
+            continue;
+        }
+
+        // Re-lex from the real token boundary until we hit a token the speculative lexer also started on, from there
+        // on both lexers are in the same state and the speculative tokens can be taken as they are.
+        Lexer lexer{ m_source, expected, lineAt(chunk, expected), true, &chunk.symbols };
+        auto synced = chunk.offsets.begin();
+        while (true)
+        {
+            unsigned int offset = 0;
+            auto tok = lexer.scanToken(offset);
+            if (offset >= chunk.end)
+            {
+                expected = offset;
+                break;
+            }
+            synced = std::lower_bound(synced, chunk.offsets.end(), offset);
+            if (synced != chunk.offsets.end() && *synced == offset)
+            {
+                append(chunk, static_cast<std::size_t>(std::distance(chunk.offsets.begin(), synced)));
+                expected = chunk.resume;
+                break;
+            }
+            if (tok.type == TokenType::Error)
+            {
+                errors.push_back(Error{ tokens.size(), offset });
+            }
+            tokens.emplace_back(tok);
+        }
+    }
+    assert(expected == m_source.size());
+}
+
+void ParallelLexer::renumber(const std::vector<Chunk>& chunks, std::vector<Token>& tokens, SymbolTable& symbols) const
+{
+    // Walking the output in order interns every name at its first appearance, as the sequential lexer does
+    std::vector<Symbol> shared{};
+    for (std::size_t i = 0; i < chunks.size(); ++i)
+    {
+        const auto& local = chunks[i].symbols;
+        shared.assign(local.size(), Symbol{});
+        auto end = i + 1 < chunks.size() ? chunks[i + 1].first : tokens.size();
+        for (auto index = chunks[i].first; index < end; ++index)
+        {
+            auto* symbol = std::get_if<Symbol>(&tokens[index].literal);
+            if (!symbol)
+            {
+                continue;
+            }
+            auto& renumbered = shared[symbol->id];
+            if (!renumbered.valid())
+            {
+                renumbered = symbols.intern(local.name(*symbol));
+            }
+            *symbol = renumbered;
+        }
+    }
+}
+
+unsigned int ParallelLexer::lineAt(const Chunk& chunk, unsigned int offset) const
+{
+    auto text = m_source.substr(chunk.begin, offset - chunk.begin);
+    return chunk.firstLine + static_cast<unsigned int>(std::count(text.begin(), text.end(), '\n'));
+}
+
+} // namespace lox
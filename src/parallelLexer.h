@@ -0,0 +1,90 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include "lexer.h"
+#include "symbolTable.h"
+#include "token.h"
+
+#include <cstddef>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace lox
+{
+
+// Tokenizes big sources by splitting them in chunks that are lexed concurrently.
+//
+// Every chunk is lexed speculatively, as if it started at a token boundary. The chunks are then stitched together in
+// order: a chunk whose speculation started in the middle of a string or comment is re-lexed from the real token
+// boundary until it lands on a token it had already produced, from which point its speculative output is correct.
+// Line numbers come from prefix-summing the newlines of every chunk, and identifiers are interned into a table of
+// their chunk then renumbered in source order, so the output is identical to Lexer::tokenize().
+class ParallelLexer
+{
+public:
+    static constexpr std::size_t DefaultMinChunkSize = 1 << 16;
+
+    explicit ParallelLexer(
+        std::string_view source,
+        unsigned int threadCount = std::thread::hardware_concurrency(),
+        std::size_t minChunkSize = DefaultMinChunkSize);
+    // Interns identifiers into `symbols`, which outlives the lexer
+    ParallelLexer(
+        std::string_view source,
+        SymbolTable* symbols,
+        unsigned int threadCount = std::thread::hardware_concurrency(),
+        std::size_t minChunkSize = DefaultMinChunkSize);
+
+    std::vector<Token> tokenize();
+
+private:
+    struct Chunk
+    {
+        unsigned int begin = 0;
+        unsigned int end = 0;
+        unsigned int firstLine = 1;
+        unsigned int newLines = 0;
+        std::vector<Token> tokens;
+        std::vector<unsigned int> offsets; // Offset of the first character of every token
+        unsigned int resume = 0;           // First token at or past the end, as seen by this chunk
+        SymbolTable symbols;               // Local to the chunk, until the output is renumbered
+        std::size_t first = 0;             // Index of the first output token lexed with this chunk's symbols
+    };
+
+    struct Error
+    {
+        std::size_t index = 0;   // Of the token in the output
+        unsigned int offset = 0; // Of its first character in the source
+    };
+
+    std::vector<Chunk> split() const;
+    void lexChunk(Chunk& chunk) const;
+    void stitch(std::vector<Chunk>& chunks, std::vector<Token>& tokens, std::vector<Error>& errors) const;
+    void renumber(const std::vector<Chunk>& chunks, std::vector<Token>& tokens, SymbolTable& symbols) const;
+    unsigned int lineAt(const Chunk& chunk, unsigned int offset) const;
+
+    template <typename Fn> void forEachChunk(std::vector<Chunk>& chunks, Fn fn) const;
+
+    std::string_view m_source;
+    unsigned int m_threadCount;
+    std::size_t m_minChunkSize;
+    SymbolTable* m_symbols = nullptr;
+};
+
+} // namespace lox
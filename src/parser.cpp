@@ -18,11 +18,21 @@
 
 #include "logger.h"
 
+#include <stdexcept>
+
 namespace lox
 {
 
 Parser::Parser(std::vector<Token> tokens)
-    : m_tokens(std::move(tokens))
+    : m_ownTokens(std::move(tokens))
+    , m_tokens(m_ownTokens)
+    , m_strings(&StringInterner::global())
+{
+}
+
+Parser::Parser(std::span<const Token> tokens, StringInterner& strings)
+    : m_tokens(tokens)
+    , m_strings(&strings)
 {
 }
 
@@ -39,6 +49,60 @@ std::optional<ExpressionUPTR> Parser::parse()
     }
 }
 
+std::optional<ExpressionUPTR> Parser::parse(Rule rule)
+{
+    m_quiet = true;
+    try
+    {
+        ExpressionUPTR expr{};
+        switch (rule)
+        {
+        case Rule::Expression:
+            expr = expression();
+            break;
+        case Rule::Comma:
+            expr = comma();
+            break;
+        case Rule::Conditional:
+            expr = conditional();
+            break;
+        case Rule::LogicOr:
+            expr = logicOr();
+            break;
+        case Rule::LogicAnd:
+            expr = logicAnd();
+            break;
+        case Rule::Equality:
+            expr = equality();
+            break;
+        case Rule::Comparison:
+            expr = comparison();
+            break;
+        case Rule::Term:
+            expr = term();
+            break;
+        case Rule::Factor:
+            expr = factor();
+            break;
+        case Rule::Unary:
+            expr = unary();
+            break;
+        case Rule::Primary:
+            expr = primary();
+            break;
+        }
+        if (!isAtEnd())
+        {
+            return std::nullopt;
+        }
+        return expr;
+    }
+    catch (ParserException&)
+    {
+        return std::nullopt;
+    }
+}
+
 ExpressionUPTR Parser::expression()
 {
     // Logger::debug("expression");
@@ -57,10 +121,25 @@ ExpressionUPTR Parser::buildBinaryExpression(ExpressionProducingFn lowerPreceden
     return lowerPrecedence;
 }
 
+ExpressionUPTR Parser::buildLogicalExpression(ExpressionProducingFn lowerPrecedenceFn, TokenType op)
+{
+    auto lowerPrecedence = lowerPrecedenceFn();
+    while (match(op))
+    {
+        Token logical = previous();
+        auto right = lowerPrecedenceFn();
+        lowerPrecedence = std::make_unique<LogicalExpression>(std::move(lowerPrecedence), logical, std::move(right));
+    }
+    return lowerPrecedence;
+}
+
 ExpressionUPTR Parser::comma()
 {
-    Logger::debug("comma");
-    ExpressionProducingFn lowerPrecedenceFn = [this]() { return equality(); };
+    if (!m_quiet && Logger::enabled(Logger::Debug))
+    {
+        Logger::debug("comma");
+    }
+    ExpressionProducingFn lowerPrecedenceFn = [this]() { return conditional(); };
     MatchingFn matchingFn = [this]()
     {
         using enum TokenType;
@@ -70,6 +149,33 @@ ExpressionUPTR Parser::comma()
     return buildBinaryExpression(std::move(lowerPrecedenceFn), std::move(matchingFn));
 }
 
+ExpressionUPTR Parser::conditional()
+{
+    // Logger::debug("conditional");
+    auto condition = logicOr();
+    if (!match(TokenType::Question))
+    {
+        return condition;
+    }
+    // Like in C, the branch between the two is bracketed by them, so it can be any expression
+    auto thenBranch = expression();
+    consumeOrThrow(TokenType::Colon, "Expected ':' after the then branch of a conditional.");
+    auto elseBranch = conditional();
+    return std::make_unique<ConditionalExpression>(std::move(condition), std::move(thenBranch), std::move(elseBranch));
+}
+
+ExpressionUPTR Parser::logicOr()
+{
+    // Logger::debug("logicOr");
+    return buildLogicalExpression([this]() { return logicAnd(); }, TokenType::Or);
+}
+
+ExpressionUPTR Parser::logicAnd()
+{
+    // Logger::debug("logicAnd");
+    return buildLogicalExpression([this]() { return equality(); }, TokenType::And);
+}
+
 ExpressionUPTR Parser::equality()
 {
     // Logger::debug("equality");
@@ -129,7 +235,7 @@ ExpressionUPTR Parser::unary()
 namespace
 {
 
-ExpressionUPTR literalExpressionFromLiteralToken(const Token& tok)
+ExpressionUPTR literalExpressionFromLiteralToken(const Token& tok, StringInterner& strings)
 {
     if (std::holds_alternative<double>(tok.literal))
     {
@@ -138,7 +244,8 @@ ExpressionUPTR literalExpressionFromLiteralToken(const Token& tok)
     else if (std::holds_alternative<std::string_view>(tok.literal))
     {
         auto str = std::get<std::string_view>(tok.literal);
-        return std::make_unique<LiteralExpression>(str.data() ? std::string{ str.data() } : std::string{});
+        // Literals are interned, so the same text in many places shares one buffer and compares by address
+        return std::make_unique<LiteralExpression>(strings.intern(str));
     }
     else
     {
@@ -167,7 +274,22 @@ ExpressionUPTR Parser::primary()
 
     if (match(Number) || match(String))
     {
-        return literalExpressionFromLiteralToken(previous());
+        return literalExpressionFromLiteralToken(previous(), *m_strings);
+    }
+
+    if (match(Identifier))
+    {
+        const auto& name = previous();
+        if (checkCurrentToken(LeftParen))
+        {
+            return call(name);
+        }
+        return std::make_unique<VariableExpression>(std::get<Symbol>(name.literal), name.lineNo);
+    }
+
+    if (match(LeftBracket))
+    {
+        return array();
     }
 
     if (match(LeftParen))
@@ -181,24 +303,64 @@ ExpressionUPTR Parser::primary()
     throw error(peek(), "Expected expression.");
 }
 
-Token Parser::consumeOrThrow(TokenType type, const std::string& error_msg)
+ExpressionUPTR Parser::call(const Token& name)
+{
+    auto builtin = CallExpression::builtinNamed(name.location);
+    if (!builtin)
+    {
+        throw error(name, "Unknown function " + std::string{ name.location } + ".");
+    }
+    consumeOrThrow(TokenType::LeftParen, "Expected '(' after the name of a function.");
+    auto argument = conditional();
+    if (checkCurrentToken(TokenType::Comma))
+    {
+        throw error(peek(), std::string{ name.location } + "() takes a single argument.");
+    }
+    consumeOrThrow(TokenType::RightParen, "Expected ')' after the argument.");
+    return std::make_unique<CallExpression>(builtin.value(), name, std::move(argument));
+}
+
+ExpressionUPTR Parser::array()
+{
+    auto bracket = previous();
+    std::vector<ExpressionUPTR> elements{};
+    if (!checkCurrentToken(TokenType::RightBracket))
+    {
+        // Elements are separated by commas, so they are parsed one level above the comma operator
+        do
+        {
+            elements.push_back(conditional());
+        } while (match(TokenType::Comma));
+    }
+    consumeOrThrow(TokenType::RightBracket, "Expected ']' after the elements of an array.");
+    return std::make_unique<ArrayExpression>(std::move(elements), bracket);
+}
+
+Token Parser::consumeOrThrow(TokenType type, std::string_view error_msg)
 {
     if (checkCurrentToken(type))
     {
         return advance();
     }
-    throw error(peek(), error_msg);
+    throw error(peek(), std::string{ error_msg });
 }
 
 auto Parser::error(const Token& token, const std::string& msg) -> ParserException
 {
-    Logger::error(token.print());
+    if (!m_quiet)
+    {
+        Logger::error(token.print());
+    }
     return { token, msg };
 }
 
 Token Parser::peek()
 {
-    return m_tokens.at(m_current);
+    if (m_current >= m_tokens.size())
+    {
+        throw std::out_of_range{ "Ran past the last token" };
+    }
+    return m_tokens[m_current];
 }
 
 Token Parser::previous()
@@ -207,7 +369,7 @@ Token Parser::previous()
     {
         throw std::domain_error{ "Invalid range" };
     }
-    return m_tokens.at(m_current - 1);
+    return m_tokens[m_current - 1];
 }
 
 bool Parser::isAtEnd()
@@ -17,10 +17,13 @@
 #pragma once
 
 #include "BaseExpression.h"
+#include "loxString.h"
 #include "token.h"
 
 #include <functional>
 #include <optional>
+#include <span>
+#include <string_view>
 #include <vector>
 
 namespace lox
@@ -32,9 +35,33 @@ class Parser
 {
 public:
     Parser(std::vector<Token> tokens);
+    // Parses tokens owned by the caller, which must outlive the parser. String literals are interned into `strings`.
+    Parser(std::span<const Token> tokens, StringInterner& strings);
+
+    Parser(const Parser&) = delete; // Would keep reading the tokens of the original
+    Parser& operator=(const Parser&) = delete;
 
     std::optional<ExpressionUPTR> parse();
 
+    // Grammar rules that can be parsed on their own
+    enum class Rule
+    {
+        Expression,
+        Comma,
+        Conditional,
+        LogicOr,
+        LogicAnd,
+        Equality,
+        Comparison,
+        Term,
+        Factor,
+        Unary,
+        Primary
+    };
+
+    // Parses the tokens with a single grammar rule, without logging. Fails unless every token is consumed.
+    std::optional<ExpressionUPTR> parse(Rule rule);
+
     class ParserException;
 
 private:
@@ -43,8 +70,14 @@ private:
 
     // expression     → comma ;
     ExpressionUPTR expression();
-    // comma          → ternary ( ","  ternary )* ;
+    // comma          → conditional ( "," conditional )* ;
     ExpressionUPTR comma();
+    // conditional    → logic_or ( "?" expression ":" conditional )? ;
+    ExpressionUPTR conditional();
+    // logic_or       → logic_and ( "or" logic_and )* ;
+    ExpressionUPTR logicOr();
+    // logic_and      → equality ( "and" equality )* ;
+    ExpressionUPTR logicAnd();
     // equality       → comparison ( ( "!=" | "==" ) comparison )* ;
     ExpressionUPTR equality();
     // comparison     → term ( ( ">" | ">=" | "<" | "<=" ) term )* ;
@@ -57,14 +90,15 @@ private:
     //                | primary ;
     ExpressionUPTR unary();
     // primary        → NUMBER | STRING | "true" | "false" | "nil"
-    //                | "(" expression ")" ;
+    //                | IDENTIFIER | call | array | "(" expression ")" ;
     ExpressionUPTR primary();
-
-    // Challenge to perhaps tackle in the future
-    // // ternary     → equality "?" equality ":" equality
-    // ExpressionUPTR ternary();
+    // call           → ( "sum" | "min" | "max" ) "(" conditional ")" ;
+    ExpressionUPTR call(const Token& name);
+    // array          → "[" ( conditional ( "," conditional )* )? "]" ;
+    ExpressionUPTR array();
 
     ExpressionUPTR buildBinaryExpression(ExpressionProducingFn lowerPrecedenceFn, MatchingFn matchFn);
+    ExpressionUPTR buildLogicalExpression(ExpressionProducingFn lowerPrecedenceFn, TokenType op);
 
     // Helper functions
     Token peek();
@@ -74,14 +108,18 @@ private:
     bool match(TokenType type);
     Token advance();
 
-    Token consumeOrThrow(TokenType type, const std::string& error_msg = "Unspecified.");
+    // Takes a view so that the message is only built when it is thrown
+    Token consumeOrThrow(TokenType type, std::string_view error_msg = "Unspecified.");
     ParserException error(const Token& token, const std::string& msg);
 
     // Ideally, puts the parser in a statement, in order to recover from panic mode.
     void synchronize();
 
     unsigned int m_current = 0;
-    std::vector<Token> m_tokens;
+    std::vector<Token> m_ownTokens;
+    std::span<const Token> m_tokens;
+    StringInterner* m_strings;
+    bool m_quiet = false;
 
 public:
     // Custom exception class
@@ -97,7 +135,7 @@ public:
             : token(token)
             , message(
                   "Parser Error: " + msg + " at line " + std::to_string(token.lineNo) + ", location " +
-                  token.location.data() + ".")
+                  std::string{ token.location } + ".")
         {
         }
 
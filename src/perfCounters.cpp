@@ -0,0 +1,260 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+#include "perfCounters.h"
+
+#include <array>
+#include <format>
+#include <mutex>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace lox
+{
+
+namespace
+{
+
+using Field = std::uint64_t PerfCounts::*;
+
+constexpr std::array<Field, 6> Fields{ &PerfCounts::cycles,       &PerfCounts::instructions,
+                                       &PerfCounts::branches,     &PerfCounts::branchMisses,
+                                       &PerfCounts::cacheReferences, &PerfCounts::cacheMisses };
+
+double ratio(std::uint64_t numerator, std::uint64_t denominator)
+{
+    return denominator ? static_cast<double>(numerator) / static_cast<double>(denominator) : 0.0;
+}
+
+#ifdef __linux__
+
+constexpr std::array<std::uint64_t, Fields.size()> Events{ PERF_COUNT_HW_CPU_CYCLES,
+                                                           PERF_COUNT_HW_INSTRUCTIONS,
+                                                           PERF_COUNT_HW_BRANCH_INSTRUCTIONS,
+                                                           PERF_COUNT_HW_BRANCH_MISSES,
+                                                           PERF_COUNT_HW_CACHE_REFERENCES,
+                                                           PERF_COUNT_HW_CACHE_MISSES };
+
+// The counter group of one thread. The cycle counter leads it, and the events that fail to open are left out.
+class CounterGroup
+{
+public:
+    CounterGroup()
+    {
+        for (std::size_t i = 0; i < Events.size(); ++i)
+        {
+            int fd = open(Events[i]);
+            if (fd < 0)
+            {
+                if (m_leader < 0)
+                {
+                    return; // Without the leader there is no group
+                }
+                continue;
+            }
+            if (m_leader < 0)
+            {
+                m_leader = fd;
+            }
+            m_fds[m_members] = fd;
+            m_fields[m_members] = Fields[i];
+            m_members++;
+        }
+        ioctl(m_leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(m_leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+
+    ~CounterGroup()
+    {
+        for (std::size_t i = 0; i < m_members; ++i)
+        {
+            close(m_fds[i]);
+        }
+    }
+
+    CounterGroup(const CounterGroup&) = delete;
+    CounterGroup& operator=(const CounterGroup&) = delete;
+
+    std::optional<PerfCounts> read() const
+    {
+        if (m_leader < 0)
+        {
+            return std::nullopt;
+        }
+        // PERF_FORMAT_GROUP layout: the number of members, the two times, and a value per member
+        std::array<std::uint64_t, 3 + Events.size()> buffer{};
+        if (::read(m_leader, buffer.data(), sizeof(buffer)) < 0)
+        {
+            return std::nullopt;
+        }
+        const auto enabled = buffer[1];
+        const auto running = buffer[2];
+        PerfCounts counts{};
+        for (std::size_t i = 0; i < m_members && i < buffer[0]; ++i)
+        {
+            auto value = buffer[3 + i];
+            // When there are more groups than hardware counters the kernel time-shares them, scale back up
+            if (running && running < enabled)
+            {
+                value = static_cast<std::uint64_t>(static_cast<double>(value) * enabled / running);
+            }
+            counts.*m_fields[i] = value;
+        }
+        return counts;
+    }
+
+private:
+    int open(std::uint64_t config) const
+    {
+        perf_event_attr attr{};
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = config;
+        attr.disabled = m_leader < 0 ? 1 : 0;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, m_leader, 0));
+    }
+
+    int m_leader = -1;
+    std::size_t m_members = 0;
+    std::array<int, Events.size()> m_fds{};
+    std::array<Field, Events.size()> m_fields{};
+};
+
+#endif
+
+struct Totals
+{
+    std::mutex mutex;
+    std::array<PerfCounts, PhaseCount> phases{};
+};
+
+Totals& totals()
+{
+    static Totals instance{};
+    return instance;
+}
+
+} // namespace
+
+PerfCounts PerfCounts::operator-(const PerfCounts& other) const
+{
+    PerfCounts result{};
+    for (auto field : Fields)
+    {
+        result.*field = this->*field - other.*field;
+    }
+    return result;
+}
+
+PerfCounts& PerfCounts::operator+=(const PerfCounts& other)
+{
+    for (auto field : Fields)
+    {
+        this->*field += other.*field;
+    }
+    return *this;
+}
+
+double PerfCounts::instructionsPerCycle() const
+{
+    return ratio(instructions, cycles);
+}
+
+double PerfCounts::branchMissRate() const
+{
+    return ratio(branchMisses, branches);
+}
+
+double PerfCounts::cacheMissRate() const
+{
+    return ratio(cacheMisses, cacheReferences);
+}
+
+bool PerfCounters::enable()
+{
+    if (!read())
+    {
+        return false;
+    }
+    s_enabled.store(true, std::memory_order_relaxed);
+    return true;
+}
+
+void PerfCounters::disable()
+{
+    s_enabled.store(false, std::memory_order_relaxed);
+}
+
+std::optional<PerfCounts> PerfCounters::read()
+{
+#ifdef __linux__
+    thread_local CounterGroup group{};
+    return group.read();
+#else
+    return std::nullopt;
+#endif
+}
+
+void PerfCounters::record(Phase phase, const PerfCounts& delta)
+{
+    auto& sums = totals();
+    std::scoped_lock lock{ sums.mutex };
+    sums.phases[static_cast<std::size_t>(phase)] += delta;
+}
+
+PerfCounts PerfCounters::phase(Phase phase)
+{
+    auto& sums = totals();
+    std::scoped_lock lock{ sums.mutex };
+    return sums.phases[static_cast<std::size_t>(phase)];
+}
+
+void PerfCounters::reset()
+{
+    auto& sums = totals();
+    std::scoped_lock lock{ sums.mutex };
+    sums.phases.fill(PerfCounts{});
+}
+
+std::string PerfCounters::report()
+{
+    std::string out = std::format(
+        "{:<12}{:>16}{:>16}{:>8}{:>14}{:>14}\n", "phase", "cycles", "instructions", "IPC", "branch-miss%", "cache-miss%");
+    for (std::size_t i = 0; i < PhaseCount; ++i)
+    {
+        auto name = phaseName(static_cast<Phase>(i));
+        auto counts = phase(static_cast<Phase>(i));
+        out += std::format(
+            "{:<12}{:>16}{:>16}{:>8.2f}{:>14.2f}{:>14.2f}\n",
+            name,
+            counts.cycles,
+            counts.instructions,
+            counts.instructionsPerCycle(),
+            counts.branchMissRate() * 100,
+            counts.cacheMissRate() * 100);
+    }
+    return out;
+}
+
+} // namespace lox
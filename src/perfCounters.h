@@ -0,0 +1,74 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include "phase.h"
+
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+namespace lox
+{
+
+struct PerfCounts
+{
+    std::uint64_t cycles = 0;
+    std::uint64_t instructions = 0;
+    std::uint64_t branches = 0;
+    std::uint64_t branchMisses = 0;
+    std::uint64_t cacheReferences = 0;
+    std::uint64_t cacheMisses = 0;
+
+    PerfCounts operator-(const PerfCounts& other) const;
+    PerfCounts& operator+=(const PerfCounts& other);
+
+    // Zero when the counters they come from are not supported
+    double instructionsPerCycle() const;
+    double branchMissRate() const;
+    double cacheMissRate() const;
+};
+
+// Hardware performance counters of every phase, read through perf_event_open.
+//
+// Every thread opens its own counter group the first time it reads it. When the kernel does not allow it (see
+// /proc/sys/kernel/perf_event_paranoid), or outside Linux, read() gives nothing and enable() fails, so callers simply
+// go without counters. Events the CPU does not support read as zero.
+class PerfCounters
+{
+public:
+    // Starts counting the phases marked by PhaseScope. False when counters cannot be read on this machine.
+    static bool enable();
+    static void disable();
+    static bool enabled() { return s_enabled.load(std::memory_order_relaxed); }
+
+    // The counters of the calling thread since it first read them
+    static std::optional<PerfCounts> read();
+
+    static void record(Phase phase, const PerfCounts& delta);
+    static PerfCounts phase(Phase phase);
+    static void reset();
+
+    // One line per phase, for humans
+    static std::string report();
+
+private:
+    static inline std::atomic<bool> s_enabled = false;
+};
+
+} // namespace lox
@@ -0,0 +1,55 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+namespace lox
+{
+
+// The steps a piece of Lox source goes through
+enum class Phase
+{
+    ReadInput,
+    Lex,
+    Parse,
+    Print,
+    Evaluate
+};
+
+constexpr std::size_t PhaseCount = static_cast<std::size_t>(Phase::Evaluate) + 1;
+
+constexpr std::string_view phaseName(Phase phase)
+{
+    switch (phase)
+    {
+    case Phase::ReadInput:
+        return "ReadInput";
+    case Phase::Lex:
+        return "Lex";
+    case Phase::Parse:
+        return "Parse";
+    case Phase::Print:
+        return "Print";
+    case Phase::Evaluate:
+        return "Evaluate";
+    }
+    return "Unknown";
+}
+
+} // namespace lox
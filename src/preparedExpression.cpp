@@ -0,0 +1,326 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+
+#include "preparedExpression.h"
+
+#include "staticVisitor.h"
+
+#include <algorithm>
+#include <cassert>
+#include <string>
+
+namespace lox
+{
+
+InterpreterException EvaluationError::exception(const SymbolTable& symbols) const
+{
+    // Tokens like the Lexer's, operators having no text and identifiers their name
+    Token token{ op, std::monostate{}, "", line };
+    switch (kind)
+    {
+    case Kind::Addition:
+        return InterpreterException{ token, AdditionErrorMessage };
+    case Kind::Operands:
+        return InterpreterException{ token, operandsErrorMessage() };
+    case Kind::Negation:
+        return InterpreterException{ token, "Negation of something other than a double not allowed." };
+    case Kind::UndefinedVariable:
+    case Kind::StringVariable:
+    case Kind::ArrayVariable:
+        break;
+    case Kind::None:
+        assert(false && "No error to make an exception of");
+        return InterpreterException{ token, "no error" };
+    }
+    auto name = std::string{ symbols.name(symbol) };
+    Token identifier{ op, symbol, symbols.name(symbol), line };
+    if (kind == Kind::UndefinedVariable)
+    {
+        return InterpreterException{ identifier, "undefined variable " + name };
+    }
+    auto holds = kind == Kind::ArrayVariable ? " holds an array" : " holds a string";
+    return InterpreterException{ identifier, "variable " + name + holds };
+}
+
+// Emits the nodes in postfix order, counting how deep the stack gets
+class PreparedExpression::Compiler : public StaticVisitor<Compiler>
+{
+public:
+    using Code = Instruction::Code;
+
+    explicit Compiler(PreparedExpression& prepared)
+        : m_program(prepared.m_program)
+    {
+    }
+
+    bool supported() const { return m_supported; }
+    std::size_t maxDepth() const { return m_maxDepth; }
+
+    void visit(const LiteralExpression& expr)
+    {
+        auto value = NumericOnly::global(expr.value);
+        if (!value)
+        {
+            m_supported = false;
+            return;
+        }
+        auto& constant = emit(Code::Constant);
+        constant.constant = value.value();
+        push();
+    }
+
+    void visit(const VariableExpression& expr)
+    {
+        auto& variable = emit(Code::Variable, TokenType::Identifier, expr.line);
+        variable.operand = expr.symbol.id;
+        push();
+    }
+
+    void visit(const GroupingExpression& expr) { dispatch(*expr.expression); }
+
+    void visit(const UnaryExpression& expr)
+    {
+        dispatch(*expr.right);
+        emit(expr.op.type == TokenType::Minus ? Code::Negate : Code::Not, expr.op.type, expr.op.lineNo);
+    }
+
+    void visit(const BinaryExpression& expr)
+    {
+        dispatch(*expr.left);
+        dispatch(*expr.right);
+        emit(Code::Binary, expr.op.type, expr.op.lineNo);
+        pop();
+    }
+
+    void visit(const LogicalExpression& expr)
+    {
+        dispatch(*expr.left);
+        auto keep = m_program.size();
+        emit(expr.op.type == TokenType::Or ? Code::KeepIfTruthy : Code::KeepIfFalsey);
+        pop(); // When the right operand is evaluated it replaces the left one
+        dispatch(*expr.right);
+        patch(keep);
+    }
+
+    void visit(const ConditionalExpression& expr)
+    {
+        dispatch(*expr.condition);
+        auto otherwise = m_program.size();
+        emit(Code::JumpIfFalsey);
+        pop();
+        dispatch(*expr.thenBranch);
+        auto end = m_program.size();
+        emit(Code::Jump);
+        pop(); // Only one of the branches leaves its value
+        patch(otherwise);
+        dispatch(*expr.elseBranch);
+        patch(end);
+    }
+
+    void visit(const ArrayExpression& /*expr*/) { m_supported = false; }
+    void visit(const CallExpression& /*expr*/) { m_supported = false; }
+
+private:
+    Instruction& emit(Code code, TokenType op = TokenType::Eof, unsigned int line = 0)
+    {
+        return m_program.emplace_back(Instruction{ code, op, line });
+    }
+
+    // Makes the jump at `jump` go to the next instruction emitted
+    void patch(std::size_t jump) { m_program[jump].operand = static_cast<std::uint32_t>(m_program.size()); }
+
+    void push()
+    {
+        ++m_depth;
+        m_maxDepth = std::max(m_maxDepth, m_depth);
+    }
+    void pop() { --m_depth; }
+
+    std::vector<Instruction>& m_program;
+    std::size_t m_depth = 0;
+    std::size_t m_maxDepth = 0;
+    bool m_supported = true;
+};
+
+std::optional<PreparedExpression> PreparedExpression::prepare(const Expression& tree)
+{
+    PreparedExpression prepared{};
+    prepared.m_program.reserve(tree.treeSize());
+    Compiler compiler{ prepared };
+    compiler.dispatch(tree);
+    if (!compiler.supported())
+    {
+        return std::nullopt;
+    }
+    prepared.m_stack.resize(compiler.maxDepth());
+    return prepared;
+}
+
+namespace
+{
+
+bool fail(EvaluationError& error, EvaluationError::Kind kind, TokenType op, unsigned int line, Symbol symbol = {})
+{
+    error = EvaluationError{ kind, op, line, symbol };
+    return false;
+}
+
+// Replaces `left` with the value of the operator, as Evaluator<NumericOnly> computes it
+bool apply(TokenType op, unsigned int line, NumericValue& left, const NumericValue& right, EvaluationError& error)
+{
+    using enum TokenType;
+    const auto* a = std::get_if<double>(&left);
+    const auto* b = std::get_if<double>(&right);
+    switch (op)
+    {
+    case Minus:
+    case Slash:
+    case Star:
+    case Plus:
+    case Greater:
+    case GreaterEqual:
+    case Less:
+    case LessEqual:
+        if (!a || !b) [[unlikely]]
+        {
+            auto kind = op == Plus ? EvaluationError::Kind::Addition : EvaluationError::Kind::Operands;
+            return fail(error, kind, op, line);
+        }
+        break;
+    case BangEqual:
+        left = !NumericOnly::isEqual(left, right);
+        return true;
+    case EqualEqual:
+        left = NumericOnly::isEqual(left, right);
+        return true;
+    default:
+        left = NullLiteral{};
+        return true;
+    }
+    switch (op)
+    {
+    case Minus:
+        left = *a - *b;
+        break;
+    case Slash:
+        left = *a / *b;
+        break;
+    case Star:
+        left = *a * *b;
+        break;
+    case Plus:
+        left = *a + *b;
+        break;
+    case Greater:
+        left = *a > *b;
+        break;
+    case GreaterEqual:
+        left = *a >= *b;
+        break;
+    case Less:
+        left = *a < *b;
+        break;
+    default:
+        left = *a <= *b;
+        break;
+    }
+    return true;
+}
+
+} // namespace
+
+std::optional<NumericValue> PreparedExpression::evaluate(const Globals& globals, EvaluationError& error) noexcept
+{
+    using enum Instruction::Code;
+    std::size_t depth = 0; // Values on the stack
+    std::size_t next = 0;
+    while (next < m_program.size())
+    {
+        const auto& instruction = m_program[next++];
+        switch (instruction.code)
+        {
+        case Constant:
+            m_stack[depth++] = instruction.constant;
+            break;
+        case Variable:
+        {
+            Symbol symbol{ instruction.operand };
+            if (symbol.id >= globals.size() || !globals[symbol.id])
+            {
+                fail(error, EvaluationError::Kind::UndefinedVariable, instruction.op, instruction.line, symbol);
+                return std::nullopt;
+            }
+            const auto& global = globals[symbol.id].value();
+            auto value = NumericOnly::global(global);
+            if (!value)
+            {
+                auto kind = std::holds_alternative<NumberArray>(global) ? EvaluationError::Kind::ArrayVariable
+                                                                         : EvaluationError::Kind::StringVariable;
+                fail(error, kind, instruction.op, instruction.line, symbol);
+                return std::nullopt;
+            }
+            m_stack[depth++] = value.value();
+            break;
+        }
+        case Binary:
+            --depth;
+            if (!apply(instruction.op, instruction.line, m_stack[depth - 1], m_stack[depth], error))
+            {
+                return std::nullopt;
+            }
+            break;
+        case Negate:
+        {
+            const auto* number = std::get_if<double>(&m_stack[depth - 1]);
+            if (!number)
+            {
+                fail(error, EvaluationError::Kind::Negation, instruction.op, instruction.line);
+                return std::nullopt;
+            }
+            m_stack[depth - 1] = -*number;
+            break;
+        }
+        case Not:
+            m_stack[depth - 1] = !NumericOnly::isTruthy(m_stack[depth - 1]);
+            break;
+        case KeepIfTruthy:
+        case KeepIfFalsey:
+            if (NumericOnly::isTruthy(m_stack[depth - 1]) == (instruction.code == KeepIfTruthy))
+            {
+                next = instruction.operand;
+            }
+            else
+            {
+                --depth;
+            }
+            break;
+        case JumpIfFalsey:
+            if (!NumericOnly::isTruthy(m_stack[--depth]))
+            {
+                next = instruction.operand;
+            }
+            break;
+        case Jump:
+            next = instruction.operand;
+            break;
+        }
+    }
+    assert(depth == 1);
+    return m_stack[0];
+}
+
+} // namespace lox
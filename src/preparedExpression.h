@@ -0,0 +1,114 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+
+#pragma once
+
+#include "BaseExpression.h"
+#include "evaluator.h"
+#include "interpreterException.h"
+#include "symbolTable.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace lox
+{
+
+// The error of an evaluation that does not throw, written into a slot the caller owns. It records what the message is
+// made of rather than the message, so reporting it allocates nothing.
+struct EvaluationError
+{
+    enum class Kind : std::uint8_t
+    {
+        None,
+        Addition,          // `+` on other than two numbers
+        Operands,          // Another arithmetic or comparison operator on other than two numbers
+        Negation,          // `-` on other than a number
+        UndefinedVariable,
+        StringVariable,
+        ArrayVariable
+    };
+
+    Kind kind = Kind::None;
+    TokenType op = TokenType::Eof; // The operator, Identifier for the variable errors
+    unsigned int line = 0;
+    Symbol symbol{}; // The variable, for the variable errors
+
+    explicit operator bool() const { return kind != Kind::None; }
+
+    // The exception the Evaluator throws for the same error, with the same message. Allocates, so it is for once the
+    // latency no longer matters.
+    InterpreterException exception(const SymbolTable& symbols) const;
+};
+
+// A tree of numbers, booleans and nil flattened into a program whose evaluation never touches the heap.
+//
+// Preparing does all the allocating: the nodes become instructions in postfix order, `and`, `or` and `?:` become
+// forward jumps, and the value stack is sized to the deepest the program goes. Evaluating then reads the globals, runs
+// every instruction at most once, and reports errors through an EvaluationError instead of throwing. It computes the
+// values and errors of Evaluator<NumericOnly>, except for `-` on other than a number, which is an error here rather
+// than std::bad_variant_access. As every instruction runs at most once there is no budget to keep.
+//
+// The stack is reused by every evaluation, so one PreparedExpression is evaluated on one thread at a time.
+class PreparedExpression
+{
+public:
+    // nullopt when the tree has a string or an array literal, or a call, whose values live on the heap
+    static std::optional<PreparedExpression> prepare(const Expression& tree);
+
+    // Evaluates on the globals, indexed by Symbol. nullopt when the evaluation fails, with the error written into
+    // `error`, which is left alone otherwise.
+    std::optional<NumericValue> evaluate(const Globals& globals, EvaluationError& error) noexcept;
+
+    // Instructions in the program, at most one per node
+    std::size_t size() const { return m_program.size(); }
+    std::size_t stackDepth() const { return m_stack.size(); }
+
+private:
+    struct Instruction
+    {
+        enum class Code : std::uint8_t
+        {
+            Constant,
+            Variable,
+            Binary,
+            Negate,
+            Not,
+            KeepIfTruthy, // Jumps keeping the value on top when truthy, pops it otherwise. `or`.
+            KeepIfFalsey, // The same when falsey. `and`.
+            JumpIfFalsey, // Pops the value on top, jumping when it is falsey. The condition of `?:`.
+            Jump
+        };
+
+        Code code;
+        TokenType op = TokenType::Eof;
+        unsigned int line = 0;
+        NumericValue constant{};
+        std::uint32_t operand = 0; // The Symbol of a variable, or where a jump goes
+    };
+
+    class Compiler;
+
+    PreparedExpression() = default;
+
+    std::vector<Instruction> m_program;
+    std::vector<NumericValue> m_stack;
+};
+
+} // namespace lox
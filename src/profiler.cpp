@@ -0,0 +1,215 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+#include "profiler.h"
+
+#include "AstPrinter.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <format>
+#include <map>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace lox
+{
+
+namespace
+{
+
+std::string nameOf(const Expression& expr)
+{
+    if (auto* binary = dynamic_cast<const BinaryExpression*>(&expr))
+    {
+        return tokenTypeToString(binary->op.type);
+    }
+    if (auto* unary = dynamic_cast<const UnaryExpression*>(&expr))
+    {
+        return "Unary" + tokenTypeToString(unary->op.type);
+    }
+    if (auto* logical = dynamic_cast<const LogicalExpression*>(&expr))
+    {
+        return tokenTypeToString(logical->op.type);
+    }
+    if (dynamic_cast<const ConditionalExpression*>(&expr))
+    {
+        return "Conditional";
+    }
+    if (dynamic_cast<const ArrayExpression*>(&expr))
+    {
+        return "Array";
+    }
+    if (auto* call = dynamic_cast<const CallExpression*>(&expr))
+    {
+        return std::string{ CallExpression::nameOf(call->builtin) };
+    }
+    if (dynamic_cast<const GroupingExpression*>(&expr))
+    {
+        return "Grouping";
+    }
+    if (dynamic_cast<const VariableExpression*>(&expr))
+    {
+        return "Variable";
+    }
+    return "Literal";
+}
+
+double estimate(std::uint64_t sampledCycles, std::uint64_t samples, std::uint64_t visits)
+{
+    return samples ? static_cast<double>(sampledCycles) * static_cast<double>(visits) / static_cast<double>(samples)
+                   : 0.0;
+}
+
+} // namespace
+
+double Profiler::NodeProfile::selfCycles() const
+{
+    return estimate(sampledSelfCycles, samples, visits);
+}
+
+double Profiler::NodeProfile::totalCycles() const
+{
+    return estimate(sampledTotalCycles, samples, visits);
+}
+
+Profiler::Profiler(unsigned int samplePeriod)
+    : m_samplePeriod(std::max(samplePeriod, 1u))
+{
+}
+
+const Profiler::NodeProfile* Profiler::node(const Expression& expr) const
+{
+    auto found = m_nodes.find(&expr);
+    return found == m_nodes.end() ? nullptr : &found->second;
+}
+
+std::vector<Profiler::OperatorProfile> Profiler::operators() const
+{
+    std::map<std::string_view, OperatorProfile> byName{};
+    for (const auto& [expr, profile] : m_nodes)
+    {
+        auto& op = byName[profile.name];
+        op.name = profile.name;
+        op.nodes++;
+        op.visits += profile.visits;
+        op.selfCycles += profile.selfCycles();
+    }
+
+    std::vector<OperatorProfile> ops{};
+    for (auto& [name, op] : byName)
+    {
+        ops.emplace_back(std::move(op));
+    }
+    std::stable_sort(
+        ops.begin(),
+        ops.end(),
+        [](const OperatorProfile& a, const OperatorProfile& b) { return a.selfCycles > b.selfCycles; });
+    return ops;
+}
+
+void Profiler::printAnnotated(const Expression& root, std::ostream& out) const
+{
+    AstPrinter printer{ out,
+                        [this](const Expression& expr)
+                        {
+                            auto* profile = node(expr);
+                            if (!profile)
+                            {
+                                return std::string{ "visits=0" };
+                            }
+                            return std::format(
+                                "visits={}, self={:.0f}, total={:.0f}",
+                                profile->visits,
+                                profile->selfCycles(),
+                                profile->totalCycles());
+                        } };
+    printer.print(root);
+}
+
+std::string Profiler::report() const
+{
+    auto ops = operators();
+    double total = 0;
+    for (const auto& op : ops)
+    {
+        total += op.selfCycles;
+    }
+
+    std::string out = std::format(
+        "{:<16}{:>10}{:>12}{:>16}{:>8}{:>14}\n", "operator", "nodes", "visits", "self cycles", "%", "cycles/visit");
+    for (const auto& op : ops)
+    {
+        out += std::format(
+            "{:<16}{:>10}{:>12}{:>16.0f}{:>8.1f}{:>14.1f}\n",
+            op.name,
+            op.nodes,
+            op.visits,
+            op.selfCycles,
+            total > 0 ? op.selfCycles * 100 / total : 0.0,
+            op.visits ? op.selfCycles / static_cast<double>(op.visits) : 0.0);
+    }
+    return out;
+}
+
+void Profiler::reset()
+{
+    m_nodes.clear();
+    m_stack.clear();
+    m_countdown = 1;
+}
+
+Profiler::NodeProfile& Profiler::profileOf(const Expression& expr)
+{
+    auto [found, inserted] = m_nodes.try_emplace(&expr);
+    if (inserted)
+    {
+        found->second.name = nameOf(expr);
+    }
+    return found->second;
+}
+
+bool Profiler::sample()
+{
+    if (--m_countdown)
+    {
+        return false;
+    }
+    if (m_samplePeriod == 1)
+    {
+        m_countdown = 1;
+        return true;
+    }
+    // xorshift32, so that samples do not line up with the shape of the tree. The gaps average the sample period.
+    m_random ^= m_random << 13;
+    m_random ^= m_random >> 17;
+    m_random ^= m_random << 5;
+    m_countdown = 1 + m_random % (2 * m_samplePeriod - 1);
+    return true;
+}
+
+std::uint64_t Profiler::ticks()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+} // namespace lox
@@ -0,0 +1,149 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include "BaseExpression.h"
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace lox
+{
+
+// Counts the visits of every node the Interpreter evaluates, and the cycles spent in it.
+//
+// With a sample period of 1 every visit is timed. With a period of N only about one visit in N is, picked at random,
+// and the cycles of a node are estimated from its timed visits, so the clock reads do not swamp cheap nodes. Visit
+// counts are always exact. Nodes are told apart by address, so reset() the profiler before profiling another tree.
+class Profiler
+{
+public:
+    explicit Profiler(unsigned int samplePeriod = 1);
+
+    struct NodeProfile
+    {
+        std::string name; // The operator, or the kind of node when it has none
+        std::uint64_t visits = 0;
+        std::uint64_t samples = 0;
+        std::uint64_t sampledSelfCycles = 0;  // Excluding the children
+        std::uint64_t sampledTotalCycles = 0; // Including the children
+
+        // Estimates over every visit
+        double selfCycles() const;
+        double totalCycles() const;
+    };
+
+    struct OperatorProfile
+    {
+        std::string name;
+        std::uint64_t nodes = 0;
+        std::uint64_t visits = 0;
+        double selfCycles = 0;
+    };
+
+    // nullptr for nodes that were never visited
+    const NodeProfile* node(const Expression& expr) const;
+    // Sorted by self cycles, most expensive first
+    std::vector<OperatorProfile> operators() const;
+
+    // The AstPrinter output of the tree, with the profile of every node in braces
+    void printAnnotated(const Expression& root, std::ostream& out) const;
+    // One line per operator
+    std::string report() const;
+
+    void reset();
+
+    // Times `evaluate`, which evaluates `expr`. Called by the Interpreter for every node.
+    template <typename Fn> LiteralValues measure(const Expression& expr, Fn&& evaluate);
+
+private:
+    struct Frame
+    {
+        bool sampled = false;
+        std::uint64_t childCycles = 0;
+    };
+
+    // Pops the frame of a node even when its evaluation throws
+    class FrameGuard
+    {
+    public:
+        FrameGuard(std::vector<Frame>& stack, bool sampled)
+            : m_stack(stack)
+        {
+            m_stack.emplace_back().sampled = sampled;
+        }
+        ~FrameGuard() { m_stack.pop_back(); }
+
+        FrameGuard(const FrameGuard&) = delete;
+        FrameGuard& operator=(const FrameGuard&) = delete;
+
+    private:
+        std::vector<Frame>& m_stack;
+    };
+
+    NodeProfile& profileOf(const Expression& expr);
+    bool sample();
+    static std::uint64_t ticks();
+
+    unsigned int m_samplePeriod;
+    unsigned int m_countdown = 1;
+    std::uint32_t m_random = 0x9e3779b9;
+    std::unordered_map<const Expression*, NodeProfile> m_nodes;
+    std::vector<Frame> m_stack;
+};
+
+template <typename Fn> LiteralValues Profiler::measure(const Expression& expr, Fn&& evaluate)
+{
+    auto& profile = profileOf(expr);
+    profile.visits++;
+
+    // The direct children of a sampled node are timed too, to tell its own cycles apart from theirs
+    const bool sampled = sample();
+    const bool timedForParent = !m_stack.empty() && m_stack.back().sampled;
+    if (!sampled && !timedForParent)
+    {
+        FrameGuard guard{ m_stack, false };
+        return evaluate();
+    }
+
+    const auto begin = ticks();
+    LiteralValues value{};
+    std::uint64_t childCycles = 0;
+    {
+        FrameGuard guard{ m_stack, sampled };
+        value = evaluate();
+        childCycles = m_stack.back().childCycles;
+    }
+    const auto cycles = ticks() - begin;
+
+    if (sampled)
+    {
+        profile.samples++;
+        profile.sampledSelfCycles += cycles > childCycles ? cycles - childCycles : 0;
+        profile.sampledTotalCycles += cycles;
+    }
+    if (timedForParent)
+    {
+        m_stack.back().childCycles += cycles;
+    }
+    return value;
+}
+
+} // namespace lox
@@ -0,0 +1,221 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+#include "resultCache.h"
+
+#include "staticVisitor.h"
+
+#include <format>
+
+namespace lox
+{
+
+namespace
+{
+
+// The list node, the map node and the bucket of an entry, roughly
+constexpr std::size_t EntryOverhead = 96;
+
+std::size_t bytesOf(const ResultCache::Result& result)
+{
+    std::size_t bytes = result.error ? result.error->capacity() : 0;
+    if (auto* string = std::get_if<LoxString>(&result.value); string && !string->isInline())
+    {
+        bytes += string->size();
+    }
+    return bytes;
+}
+
+// Mixes the line of every token of a tree into its hash, which leaves them out
+class LineHasher : public StaticVisitor<LineHasher>
+{
+public:
+    explicit LineHasher(std::uint64_t hash)
+        : m_hash(hash)
+    {
+    }
+
+    void visit(const BinaryExpression& expr)
+    {
+        dispatch(*expr.left);
+        add(expr.op.lineNo);
+        dispatch(*expr.right);
+    }
+    void visit(const LiteralExpression& /*expr*/) {}
+    void visit(const UnaryExpression& expr)
+    {
+        add(expr.op.lineNo);
+        dispatch(*expr.right);
+    }
+    void visit(const GroupingExpression& expr) { dispatch(*expr.expression); }
+    void visit(const VariableExpression& expr) { add(expr.line); }
+    void visit(const LogicalExpression& expr)
+    {
+        dispatch(*expr.left);
+        add(expr.op.lineNo);
+        dispatch(*expr.right);
+    }
+    void visit(const ConditionalExpression& expr)
+    {
+        dispatch(*expr.condition);
+        dispatch(*expr.thenBranch);
+        dispatch(*expr.elseBranch);
+    }
+    void visit(const ArrayExpression& expr)
+    {
+        add(expr.bracket.lineNo);
+        for (const auto& element : expr.elements)
+        {
+            dispatch(*element);
+        }
+    }
+    void visit(const CallExpression& expr)
+    {
+        add(expr.name.lineNo);
+        dispatch(*expr.argument);
+    }
+
+    std::uint64_t hash() const { return m_hash; }
+
+private:
+    void add(unsigned int line) { m_hash = hashNode({ m_hash, line }); }
+
+    std::uint64_t m_hash;
+};
+
+// Runtime errors quote the line of the token that raised them, so a tree only shares an error with the trees whose
+// tokens sit on the same lines
+std::uint64_t errorKey(const Expression& tree)
+{
+    LineHasher hasher{ tree.hash() };
+    hasher.dispatch(tree);
+    return hasher.hash();
+}
+
+} // namespace
+
+ResultCache::ResultCache(std::size_t maxBytes)
+    : m_maxBytes(maxBytes)
+{
+}
+
+const ResultCache::Result* ResultCache::find(std::string_view source)
+{
+    auto found = m_bySource.find(source);
+    if (found == m_bySource.end())
+    {
+        return nullptr;
+    }
+    m_stats.sourceHits++;
+    return use(found->second);
+}
+
+const ResultCache::Result* ResultCache::find(const Expression& tree)
+{
+    auto found = m_byTree.find(tree.hash());
+    if (found == m_byTree.end())
+    {
+        found = m_byTree.find(errorKey(tree));
+    }
+    if (found == m_byTree.end())
+    {
+        m_stats.misses++;
+        return nullptr;
+    }
+    m_stats.treeHits++;
+    return use(found->second);
+}
+
+void ResultCache::insert(std::string_view source, const Expression& tree, const Result& result)
+{
+    if (!m_bySource.contains(source))
+    {
+        add(Entry{ std::string{ source }, 0, result, 0 });
+    }
+    auto key = result.error ? errorKey(tree) : tree.hash();
+    if (!m_byTree.contains(key))
+    {
+        add(Entry{ std::string{}, key, result, 0 });
+    }
+}
+
+void ResultCache::clear()
+{
+    m_bySource.clear();
+    m_byTree.clear();
+    m_entries.clear();
+    m_bytes = 0;
+}
+
+std::string ResultCache::report() const
+{
+    return std::format(
+        "result cache: {} source hits, {} tree hits, {} misses, {} evictions, {} entries, {} of {} bytes\n",
+        m_stats.sourceHits,
+        m_stats.treeHits,
+        m_stats.misses,
+        m_stats.evictions,
+        size(),
+        m_bytes,
+        m_maxBytes);
+}
+
+const ResultCache::Result* ResultCache::use(Entries::iterator entry)
+{
+    m_entries.splice(m_entries.begin(), m_entries, entry);
+    return &entry->result;
+}
+
+void ResultCache::add(Entry entry)
+{
+    entry.bytes = sizeof(Entry) + EntryOverhead + entry.source.capacity() + bytesOf(entry.result);
+    if (entry.bytes > m_maxBytes)
+    {
+        return;
+    }
+    m_bytes += entry.bytes;
+    auto& added = m_entries.emplace_front(std::move(entry));
+    if (added.source.empty())
+    {
+        m_byTree.emplace(added.hash, m_entries.begin());
+    }
+    else
+    {
+        m_bySource.emplace(added.source, m_entries.begin());
+    }
+    evict();
+}
+
+void ResultCache::evict()
+{
+    while (m_bytes > m_maxBytes)
+    {
+        auto& last = m_entries.back();
+        if (last.source.empty())
+        {
+            m_byTree.erase(last.hash);
+        }
+        else
+        {
+            m_bySource.erase(last.source);
+        }
+        m_bytes -= last.bytes;
+        m_entries.pop_back();
+        m_stats.evictions++;
+    }
+}
+
+} // namespace lox
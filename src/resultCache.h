@@ -0,0 +1,100 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include "BaseExpression.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace lox
+{
+
+// Remembers what inputs evaluated to, so that repeating one skips the work. Every expression is pure, so an input
+// always gives the same result for the same globals.
+//
+// Results are found by the text of the input, which skips lexing, parsing and evaluation, or by the structural hash of
+// its tree, which skips evaluation of inputs that only differ in spacing, comments or parentheses. Runtime errors quote
+// the line they were raised at, so those are found by the tree and the lines of its tokens. Two different trees would
+// only share a result if their 64-bit hashes collided.
+// The least recently used results are evicted to stay under a memory cap.
+class ResultCache
+{
+public:
+    static constexpr std::size_t DefaultMaxBytes = 16 * 1024 * 1024;
+
+    explicit ResultCache(std::size_t maxBytes = DefaultMaxBytes);
+
+    // What evaluating an input gave: its value, or the message of the runtime error it raised
+    struct Result
+    {
+        LiteralValues value;
+        std::optional<std::string> error;
+    };
+
+    struct Stats
+    {
+        std::uint64_t sourceHits = 0;
+        std::uint64_t treeHits = 0;
+        std::uint64_t misses = 0;
+        std::uint64_t evictions = 0;
+    };
+
+    // nullptr when missing. A source that is missing is looked up again by its tree, so only trees count misses.
+    const Result* find(std::string_view source);
+    const Result* find(const Expression& tree);
+    // Stores the result of `tree`, parsed from `source`, under both
+    void insert(std::string_view source, const Expression& tree, const Result& result);
+    void clear();
+
+    const Stats& stats() const { return m_stats; }
+    std::size_t size() const { return m_entries.size(); }
+    // An estimate of the memory held by the results and their keys
+    std::size_t bytes() const { return m_bytes; }
+    std::size_t maxBytes() const { return m_maxBytes; }
+
+    // The hit and miss counts, for humans
+    std::string report() const;
+
+private:
+    struct Entry
+    {
+        std::string source; // Empty when keyed by tree, as inputs are never empty
+        std::uint64_t hash = 0;
+        Result result;
+        std::size_t bytes = 0;
+    };
+    using Entries = std::list<Entry>;
+
+    const Result* use(Entries::iterator entry);
+    void add(Entry entry);
+    void evict();
+
+    std::size_t m_maxBytes;
+    std::size_t m_bytes = 0;
+    Entries m_entries; // Most recently used first
+    std::unordered_map<std::string_view, Entries::iterator> m_bySource; // The keys point into the entries
+    std::unordered_map<std::uint64_t, Entries::iterator> m_byTree;
+    Stats m_stats;
+};
+
+} // namespace lox
@@ -0,0 +1,95 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+#include "session.h"
+
+#include "astSerializer.h"
+#include "lexer.h"
+#include "parallelLexer.h"
+
+namespace lox
+{
+
+Session::Session()
+    : m_output(&m_outputBuffer)
+{
+}
+
+const std::vector<Token>& Session::lex(std::string_view source)
+{
+    reset();
+    // Big sources are lexed concurrently, small ones are not worth the threads
+    if (source.size() < ParallelLexer::DefaultMinChunkSize * 2)
+    {
+        Lexer{ source, &m_symbols }.tokenize(m_tokens);
+    }
+    else
+    {
+        m_tokens = ParallelLexer{ source, &m_symbols }.tokenize();
+    }
+    return m_tokens;
+}
+
+const Expression* Session::parse()
+{
+    m_tree.reset();
+    Arena::Scope scope{ m_arena };
+    auto tree = Parser{ m_tokens, m_strings }.parse();
+    if (tree)
+    {
+        m_tree = std::move(tree.value());
+    }
+    return m_tree.get();
+}
+
+const Expression* Session::restore(std::span<const char> bytes, std::string_view source)
+{
+    reset();
+    Arena::Scope scope{ m_arena };
+    m_tree = deserializeTree(bytes, source, m_symbols, m_strings);
+    return m_tree.get();
+}
+
+void Session::reset()
+{
+    m_tree.reset();
+    m_arena.rewind();
+    m_tokens.clear();
+}
+
+void Session::flush(std::ostream& to)
+{
+    auto& text = m_outputBuffer.text();
+    to.write(text.data(), static_cast<std::streamsize>(text.size()));
+    text.clear();
+}
+
+Session::OutputBuffer::int_type Session::OutputBuffer::overflow(int_type c)
+{
+    if (!traits_type::eq_int_type(c, traits_type::eof()))
+    {
+        m_text.push_back(traits_type::to_char_type(c));
+    }
+    return traits_type::not_eof(c);
+}
+
+std::streamsize Session::OutputBuffer::xsputn(const char* s, std::streamsize count)
+{
+    m_text.append(s, static_cast<std::size_t>(count));
+    return count;
+}
+
+} // namespace lox
@@ -0,0 +1,95 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include "BaseExpression.h"
+#include "arena.h"
+#include "loxString.h"
+#include "parser.h"
+#include "symbolTable.h"
+#include "token.h"
+
+#include <ostream>
+#include <span>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace lox
+{
+
+// Everything the interpreter needs from one input to the next: the tokens, the tree and its arena, the output, and the
+// symbol and string tables.
+//
+// Between inputs the buffers are emptied but keep their memory, so once they have grown to fit the inputs, lexing,
+// parsing and printing similar inputs allocates nothing. The symbol and string tables live as long as the session,
+// so a name or a string literal seen on an earlier line is found rather than added again.
+// Sources big enough for the ParallelLexer still allocate its chunks.
+class Session
+{
+public:
+    Session();
+
+    Session(const Session&) = delete;
+    Session& operator=(const Session&) = delete;
+
+    // Starts a new input, destroying the tree of the last one. `source` must outlive the tokens and the tree.
+    const std::vector<Token>& lex(std::string_view source);
+    // Parses the tokens of the current input. nullptr when they do not parse.
+    const Expression* parse();
+    // Starts a new input from its tree, as written by serializeTree, instead of lexing and parsing `source`. nullptr
+    // when the bytes are not a valid tree. `source` must outlive the tree.
+    const Expression* restore(std::span<const char> bytes, std::string_view source);
+    // Destroys the tree and empties every buffer, keeping their memory
+    void reset();
+
+    const std::vector<Token>& tokens() const { return m_tokens; }
+    const Expression* tree() const { return m_tree.get(); }
+    SymbolTable& symbols() { return m_symbols; }
+    StringInterner& strings() { return m_strings; }
+    const Arena& arena() const { return m_arena; }
+
+    // Text written here is kept until flush()
+    std::ostream& output() { return m_output; }
+    void flush(std::ostream& to);
+
+private:
+    // Appends to a string that is cleared, not freed, on every flush
+    class OutputBuffer : public std::streambuf
+    {
+    public:
+        std::string& text() { return m_text; }
+
+    protected:
+        int_type overflow(int_type c) override;
+        std::streamsize xsputn(const char* s, std::streamsize count) override;
+
+    private:
+        std::string m_text;
+    };
+
+    SymbolTable m_symbols;
+    StringInterner m_strings;
+    std::vector<Token> m_tokens;
+    Arena m_arena;
+    ExpressionUPTR m_tree; // Made in m_arena, so it goes before it
+    OutputBuffer m_outputBuffer;
+    std::ostream m_output;
+};
+
+} // namespace lox
@@ -0,0 +1,68 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include "BaseExpression.h"
+
+namespace lox
+{
+
+// Visits trees without virtual calls. `dispatch` switches on the kind of the node and calls the `visit` overload of
+// `Derived` for its class, so the compiler sees every handler and can inline it. The visits return `Result`, which
+// can be anything, void included:
+//
+//     class Depth : public StaticVisitor<Depth, int>
+//     {
+//     public:
+//         int visit(const BinaryExpression& expr) { return 1 + std::max(dispatch(*expr.left), dispatch(*expr.right)); }
+//         ...
+//     };
+//
+// Derived needs a public `visit` for each of BinaryExpression, LiteralExpression, UnaryExpression, GroupingExpression,
+// VariableExpression, LogicalExpression, ConditionalExpression, ArrayExpression and CallExpression.
+template <typename Derived, typename Result = void> class StaticVisitor
+{
+public:
+    Result dispatch(const Expression& expr)
+    {
+        auto& derived = static_cast<Derived&>(*this);
+        switch (expr.kind())
+        {
+        case Expression::Kind::Binary:
+            return derived.visit(static_cast<const BinaryExpression&>(expr));
+        case Expression::Kind::Literal:
+            return derived.visit(static_cast<const LiteralExpression&>(expr));
+        case Expression::Kind::Unary:
+            return derived.visit(static_cast<const UnaryExpression&>(expr));
+        case Expression::Kind::Grouping:
+            return derived.visit(static_cast<const GroupingExpression&>(expr));
+        case Expression::Kind::Variable:
+            return derived.visit(static_cast<const VariableExpression&>(expr));
+        case Expression::Kind::Logical:
+            return derived.visit(static_cast<const LogicalExpression&>(expr));
+        case Expression::Kind::Conditional:
+            return derived.visit(static_cast<const ConditionalExpression&>(expr));
+        case Expression::Kind::Array:
+            return derived.visit(static_cast<const ArrayExpression&>(expr));
+        case Expression::Kind::Call:
+            return derived.visit(static_cast<const CallExpression&>(expr));
+        }
+        __builtin_unreachable(); // Every node is made with one of the kinds
+    }
+};
+
+} // namespace lox
@@ -0,0 +1,43 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+#include "symbolTable.h"
+
+namespace lox
+{
+
+Symbol SymbolTable::intern(std::string_view name)
+{
+    if (auto found = m_ids.find(name); found != m_ids.end())
+    {
+        return Symbol{ found->second };
+    }
+    auto id = static_cast<std::uint32_t>(m_names.size());
+    auto inserted = m_ids.emplace(std::string{ name }, id).first;
+    m_names.emplace_back(&inserted->first);
+    return Symbol{ id };
+}
+
+std::optional<Symbol> SymbolTable::find(std::string_view name) const
+{
+    if (auto found = m_ids.find(name); found != m_ids.end())
+    {
+        return Symbol{ found->second };
+    }
+    return std::nullopt;
+}
+
+} // namespace lox
@@ -0,0 +1,69 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace lox
+{
+
+// A dense id standing for an identifier, usable as an index into arrays of whatever is bound to identifiers
+struct Symbol
+{
+    std::uint32_t id = Invalid;
+
+    static constexpr std::uint32_t Invalid = ~std::uint32_t{ 0 };
+
+    bool valid() const { return id != Invalid; }
+    bool operator==(const Symbol&) const = default;
+};
+
+// Gives every distinct identifier the next free Symbol, the first time it is seen. Ids never change for the life of
+// the table, so a table kept around for a whole session gives the same id to the same name on every line.
+class SymbolTable
+{
+public:
+    SymbolTable() = default;
+    SymbolTable(const SymbolTable&) = delete; // The names point into the map
+    SymbolTable& operator=(const SymbolTable&) = delete;
+    SymbolTable(SymbolTable&&) = default;
+    SymbolTable& operator=(SymbolTable&&) = default;
+
+    Symbol intern(std::string_view name);
+    std::optional<Symbol> find(std::string_view name) const;
+    std::string_view name(Symbol symbol) const { return *m_names[symbol.id]; }
+    std::size_t size() const { return m_names.size(); }
+
+private:
+    struct Hash
+    {
+        using is_transparent = void;
+        std::size_t operator()(std::string_view name) const { return std::hash<std::string_view>{}(name); }
+    };
+
+    std::unordered_map<std::string, std::uint32_t, Hash, std::equal_to<>> m_ids;
+    std::vector<const std::string*> m_names; // Point at the keys of m_ids, which never move
+};
+
+} // namespace lox
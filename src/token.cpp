@@ -20,13 +20,12 @@
 #include <format>
 #include <iostream>
 #include <sstream>
+#include <type_traits>
+#include <variant>
 
 namespace lox
 {
 
-namespace
-{
-
 std::string tokenTypeToString(TokenType type)
 {
     using enum TokenType;
@@ -40,6 +39,10 @@ std::string tokenTypeToString(TokenType type)
         return "LeftBrace";
     case TokenType::RightBrace:
         return "RightBrace";
+    case TokenType::LeftBracket:
+        return "LeftBracket";
+    case TokenType::RightBracket:
+        return "RightBracket";
     case TokenType::Comma:
         return "Comma";
     case TokenType::Dot:
@@ -54,6 +57,10 @@ std::string tokenTypeToString(TokenType type)
         return "Slash";
     case TokenType::Star:
         return "Star";
+    case TokenType::Question:
+        return "Question";
+    case TokenType::Colon:
+        return "Colon";
     case TokenType::Bang:
         return "Bang";
     case TokenType::BangEqual:
@@ -117,11 +124,14 @@ std::string tokenTypeToString(TokenType type)
     }
 }
 
-std::string literalToString(const std::variant<std::monostate, std::string_view, double>& tok)
+namespace
+{
+
+std::string literalToString(const Token::LiteralValues& tok)
 {
     if (std::holds_alternative<std::string_view>(tok))
     {
-        return std::get<std::string_view>(tok).data();
+        return std::string{ std::get<std::string_view>(tok) };
     }
     else if (std::holds_alternative<double>(tok))
     {
@@ -129,6 +139,10 @@ std::string literalToString(const std::variant<std::monostate, std::string_view,
         ss << std::get<double>(tok);
         return ss.str();
     }
+    else if (std::holds_alternative<Symbol>(tok))
+    {
+        return "#" + std::to_string(std::get<Symbol>(tok).id);
+    }
     else
     {
         return "no-literal-value";
@@ -140,13 +154,33 @@ std::string literalToString(const std::variant<std::monostate, std::string_view,
 std::string Token::print() const
 {
     return "(Token){\"type\": \"" + tokenTypeToString(type) + "\",\"literal\": \"" + literalToString(literal) +
-           "\",\"location\": \"" + (location.data() ? location.data() : "") +
+           "\",\"location\": \"" + std::string{ location } +
            "\",\"lineNo\": " + std::to_string(lineNo) + "}";
 }
 
 std::ostream& operator<<(std::ostream& os, const Token& me)
 {
-    return os << me.print();
+    // Streamed piece by piece rather than through print(), so printing a tree builds no strings
+    os << "(Token){\"type\": \"" << tokenTypeToString(me.type) << "\",\"literal\": \"";
+    std::visit(
+        [&os](const auto& value)
+        {
+            using Type = std::decay_t<decltype(value)>;
+            if constexpr (std::is_same_v<Type, std::monostate>)
+            {
+                os << "no-literal-value";
+            }
+            else if constexpr (std::is_same_v<Type, Symbol>)
+            {
+                os << '#' << value.id;
+            }
+            else
+            {
+                os << value;
+            }
+        },
+        me.literal);
+    return os << "\",\"location\": \"" << me.location << "\",\"lineNo\": " << me.lineNo << "}";
 }
 
 } // namespace lox
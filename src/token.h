@@ -16,7 +16,10 @@
 
 #pragma once
 
+#include "symbolTable.h"
+
 #include <ostream>
+#include <string>
 #include <string_view>
 #include <variant>
 
@@ -30,6 +33,8 @@ enum TokenType
     RightParen,
     LeftBrace,
     RightBrace,
+    LeftBracket,
+    RightBracket,
     Comma,
     Dot,
     Minus,
@@ -37,6 +42,8 @@ enum TokenType
     Semicolon,
     Slash,
     Star,
+    Question,
+    Colon,
 
     // One or two character tokens.
     Bang,
@@ -76,9 +83,12 @@ enum TokenType
     Error,
 };
 
+std::string tokenTypeToString(TokenType type);
+
 struct Token
 {
-    using LiteralValues = std::variant<std::monostate, std::string_view, double>;
+    // Identifiers carry their Symbol, and their name in the location
+    using LiteralValues = std::variant<std::monostate, std::string_view, double, Symbol>;
     TokenType type;
     LiteralValues literal = std::monostate{};
     std::string_view location{};
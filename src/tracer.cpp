@@ -0,0 +1,169 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+#include "tracer.h"
+
+#include <format>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace lox
+{
+
+namespace
+{
+
+struct Span
+{
+    Phase phase;
+    Tracer::Clock::time_point begin;
+    Tracer::Clock::time_point end;
+};
+
+struct ThreadBuffer
+{
+    unsigned int tid = 0;
+    bool inUse = false;
+    std::vector<Span> spans;
+};
+
+// Buffers outlive their threads, so spans recorded by short lived workers are still there when the trace is dumped.
+// A thread that exits hands its buffer over to the next thread that starts recording.
+struct Registry
+{
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    const Tracer::Clock::time_point epoch = Tracer::Clock::now();
+};
+
+Registry& registry()
+{
+    static Registry instance{};
+    return instance;
+}
+
+class BufferLease
+{
+public:
+    ~BufferLease()
+    {
+        if (m_buffer)
+        {
+            std::scoped_lock lock{ registry().mutex };
+            m_buffer->inUse = false;
+        }
+    }
+
+    ThreadBuffer& buffer()
+    {
+        if (!m_buffer)
+        {
+            auto& reg = registry();
+            std::scoped_lock lock{ reg.mutex };
+            for (auto& candidate : reg.buffers)
+            {
+                if (!candidate->inUse)
+                {
+                    m_buffer = candidate.get();
+                    break;
+                }
+            }
+            if (!m_buffer)
+            {
+                m_buffer = reg.buffers.emplace_back(std::make_unique<ThreadBuffer>()).get();
+                m_buffer->tid = static_cast<unsigned int>(reg.buffers.size());
+            }
+            m_buffer->inUse = true;
+        }
+        return *m_buffer;
+    }
+
+private:
+    ThreadBuffer* m_buffer = nullptr;
+};
+
+double microseconds(Tracer::Clock::duration duration)
+{
+    return std::chrono::duration<double, std::micro>(duration).count();
+}
+
+} // namespace
+
+void Tracer::enable()
+{
+    registry(); // Fixes the epoch before the first span
+    s_enabled.store(true, std::memory_order_relaxed);
+}
+
+void Tracer::disable()
+{
+    s_enabled.store(false, std::memory_order_relaxed);
+}
+
+void Tracer::record(Phase phase, Clock::time_point begin, Clock::time_point end)
+{
+    thread_local BufferLease lease{};
+    lease.buffer().spans.emplace_back(Span{ phase, begin, end });
+}
+
+std::string Tracer::json()
+{
+    auto& reg = registry();
+    std::scoped_lock lock{ reg.mutex };
+    std::string out{ "{\"traceEvents\":[" };
+    bool first = true;
+    for (const auto& buffer : reg.buffers)
+    {
+        for (const auto& span : buffer->spans)
+        {
+            out += std::format(
+                "{}\n{{\"name\":\"{}\",\"cat\":\"lox\",\"ph\":\"X\",\"pid\":1,\"tid\":{},\"ts\":{:.3f},\"dur\":{:.3f}}}",
+                first ? "" : ",",
+                phaseName(span.phase),
+                buffer->tid,
+                microseconds(span.begin - reg.epoch),
+                microseconds(span.end - span.begin));
+            first = false;
+        }
+    }
+    out += "\n],\"displayTimeUnit\":\"ns\"}\n";
+    return out;
+}
+
+bool Tracer::write(const std::filesystem::path& path)
+{
+    std::ofstream file(path);
+    if (!file.is_open())
+    {
+        return false;
+    }
+    file << json();
+    return static_cast<bool>(file);
+}
+
+void Tracer::clear()
+{
+    auto& reg = registry();
+    std::scoped_lock lock{ reg.mutex };
+    for (auto& buffer : reg.buffers)
+    {
+        buffer->spans.clear();
+    }
+}
+
+} // namespace lox
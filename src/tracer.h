@@ -0,0 +1,118 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include "perfCounters.h"
+#include "phase.h"
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace lox
+{
+
+// Records how long every phase takes, as spans that can be dumped in the Chrome trace-event format and opened in
+// Perfetto or chrome://tracing.
+//
+// Every thread records into its own buffer, so recording takes no locks. When tracing is disabled a span costs a
+// relaxed atomic load.
+class Tracer
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static void enable();
+    static void disable();
+    static bool enabled() { return s_enabled.load(std::memory_order_relaxed); }
+
+    static void record(Phase phase, Clock::time_point begin, Clock::time_point end);
+
+    // The spans recorded so far, as a trace-event JSON document. Must not run while other threads are recording.
+    static std::string json();
+    static bool write(const std::filesystem::path& path);
+    static void clear();
+
+private:
+    static inline std::atomic<bool> s_enabled = false;
+};
+
+// Marks the phase the current thread is in, from construction to destruction. Records its time when tracing, and
+// its hardware counters when they are enabled.
+class PhaseScope
+{
+public:
+    explicit PhaseScope(Phase phase)
+        : m_phase(phase)
+        , m_traced(Tracer::enabled())
+        , m_parent(s_current)
+    {
+        s_current = this;
+        // A phase nested in itself is already being counted
+        if (PerfCounters::enabled() && (!m_parent || m_parent->m_phase != m_phase))
+        {
+            m_counters = PerfCounters::read();
+        }
+        if (m_traced)
+        {
+            m_begin = Tracer::Clock::now();
+        }
+    }
+
+    ~PhaseScope()
+    {
+        if (m_traced)
+        {
+            Tracer::record(m_phase, m_begin, Tracer::Clock::now());
+        }
+        if (m_counters)
+        {
+            if (auto counters = PerfCounters::read())
+            {
+                PerfCounters::record(m_phase, counters.value() - m_counters.value());
+            }
+        }
+        s_current = m_parent;
+    }
+
+    // The innermost phase of the calling thread, if it is in any
+    static std::optional<Phase> current()
+    {
+        if (!s_current)
+        {
+            return std::nullopt;
+        }
+        return s_current->m_phase;
+    }
+
+    PhaseScope(const PhaseScope&) = delete;
+    PhaseScope& operator=(const PhaseScope&) = delete;
+
+private:
+    Phase m_phase;
+    bool m_traced;
+    const PhaseScope* m_parent;
+    Tracer::Clock::time_point m_begin{};
+    std::optional<PerfCounts> m_counters{};
+
+    static inline thread_local const PhaseScope* s_current = nullptr;
+};
+
+} // namespace lox
@@ -0,0 +1,163 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+#include "workStealingPool.h"
+
+#include <algorithm>
+
+namespace lox
+{
+
+namespace
+{
+
+// The pool the calling thread belongs to, and the index of its queue there
+thread_local const WorkStealingPool* CurrentPool = nullptr;
+thread_local std::size_t CurrentQueue = 0;
+
+} // namespace
+
+WorkStealingPool::WorkStealingPool(unsigned int threadCount)
+{
+    threadCount = std::max(threadCount, 2u);
+    for (unsigned int i = 0; i < threadCount; ++i)
+    {
+        m_queues.push_back(std::make_unique<Queue>());
+    }
+    m_threads.reserve(threadCount - 1);
+    for (unsigned int i = 0; i + 1 < threadCount; ++i)
+    {
+        m_threads.emplace_back([this, i]() { work(i); });
+    }
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    m_stopping = true;
+    m_pushes++;
+    m_pushes.notify_all();
+    m_threads.clear(); // Joins them
+}
+
+WorkStealingPool::Queue& WorkStealingPool::ownQueue()
+{
+    return CurrentPool == this ? *m_queues[CurrentQueue] : *m_queues.back();
+}
+
+void WorkStealingPool::push(Task& task)
+{
+    auto& queue = ownQueue();
+    {
+        std::lock_guard lock{ queue.mutex };
+        queue.tasks.push_back(&task);
+    }
+    m_queued++;
+    m_pushes++;
+    m_pushes.notify_one();
+}
+
+bool WorkStealingPool::reclaim(Task& task)
+{
+    auto& queue = ownQueue();
+    std::lock_guard lock{ queue.mutex };
+    // Tasks forked later were joined before, so an unstolen task is at the back. Outside threads share their queue,
+    // where it may be anywhere.
+    auto found = std::find(queue.tasks.rbegin(), queue.tasks.rend(), &task);
+    if (found == queue.tasks.rend())
+    {
+        return false;
+    }
+    queue.tasks.erase(std::next(found).base());
+    m_queued--;
+    return true;
+}
+
+void WorkStealingPool::execute(Task& task)
+{
+    try
+    {
+        task.run(task.function);
+    }
+    catch (...)
+    {
+        task.error = std::current_exception();
+    }
+    task.done.store(true, std::memory_order_release);
+}
+
+bool WorkStealingPool::runOne()
+{
+    if (!m_queued.load(std::memory_order_relaxed))
+    {
+        return false;
+    }
+    // The own queue first, newest task first, then the oldest task of every other queue
+    auto own = CurrentPool == this ? CurrentQueue : m_queues.size() - 1;
+    for (std::size_t i = 0; i < m_queues.size(); ++i)
+    {
+        auto& queue = *m_queues[(own + i) % m_queues.size()];
+        Task* task = nullptr;
+        {
+            std::lock_guard lock{ queue.mutex };
+            if (queue.tasks.empty())
+            {
+                continue;
+            }
+            if (i == 0)
+            {
+                task = queue.tasks.back();
+                queue.tasks.pop_back();
+            }
+            else
+            {
+                task = queue.tasks.front();
+                queue.tasks.pop_front();
+            }
+            m_queued--;
+        }
+        execute(*task);
+        return true;
+    }
+    return false;
+}
+
+void WorkStealingPool::wait(Task& task)
+{
+    while (!task.done.load(std::memory_order_acquire))
+    {
+        if (!runOne())
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void WorkStealingPool::work(std::size_t index)
+{
+    CurrentPool = this;
+    CurrentQueue = index;
+    while (!m_stopping)
+    {
+        // Read before looking for work, so a push made after the look wakes the thread up
+        auto pushes = m_pushes.load();
+        if (!runOne())
+        {
+            m_pushes.wait(pushes);
+        }
+    }
+}
+
+} // namespace lox
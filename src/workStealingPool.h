@@ -0,0 +1,126 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace lox
+{
+
+// Threads that run fork-join work. Every thread of the pool has a queue of its own: it pushes the tasks it forks at
+// the back and takes them back from there, while idle threads steal from the front of the queues of the others, where
+// the oldest and so largest tasks are. Threads outside of the pool fork into a shared queue.
+//
+// A thread waiting for a forked task to finish runs other tasks meanwhile, so nested joins never leave a thread idle.
+class WorkStealingPool
+{
+public:
+    // Starts `threadCount - 1` threads, the caller of join() being the last one. At least one is started.
+    explicit WorkStealingPool(unsigned int threadCount = std::thread::hardware_concurrency());
+    ~WorkStealingPool();
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    // Runs `left` on the calling thread while `right` may run on another, returning once both are done. Both may join
+    // again. When both throw, the exception of `left` is the one rethrown, as it would be by running them in order.
+    template <typename Left, typename Right> void join(Left&& left, Right&& right);
+
+    unsigned int threadCount() const { return static_cast<unsigned int>(m_queues.size()); }
+
+private:
+    struct Task
+    {
+        void (*run)(void* function);
+        void* function;
+        std::exception_ptr error;
+        std::atomic<bool> done = false;
+    };
+
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<Task*> tasks;
+    };
+
+    void push(Task& task);
+    // Takes `task` back, when no thread stole it yet
+    bool reclaim(Task& task);
+    // Runs other tasks until `task` is done
+    void wait(Task& task);
+    // Runs one task of any queue, false when there was none
+    bool runOne();
+    static void execute(Task& task);
+    void work(std::size_t index);
+    // The queue the calling thread forks into
+    Queue& ownQueue();
+
+    // One per thread started, then the one shared by the threads outside of the pool
+    std::vector<std::unique_ptr<Queue>> m_queues;
+    std::vector<std::jthread> m_threads;
+    std::atomic<std::size_t> m_queued = 0;
+    // Bumped on every push, idle threads sleep until it changes
+    std::atomic<std::uint32_t> m_pushes = 0;
+    std::atomic<bool> m_stopping = false;
+};
+
+template <typename Left, typename Right> void WorkStealingPool::join(Left&& left, Right&& right)
+{
+    Task task{ [](void* function) { (*static_cast<std::remove_reference_t<Right>*>(function))(); },
+               const_cast<void*>(static_cast<const void*>(std::addressof(right))),
+               nullptr };
+    push(task);
+    std::exception_ptr leftError{};
+    try
+    {
+        left();
+    }
+    catch (...)
+    {
+        leftError = std::current_exception();
+    }
+    if (reclaim(task))
+    {
+        if (leftError)
+        {
+            std::rethrow_exception(leftError); // Running in order, `right` would not have started
+        }
+        execute(task);
+    }
+    else
+    {
+        wait(task); // `right` lives on this frame
+    }
+    if (leftError)
+    {
+        std::rethrow_exception(leftError);
+    }
+    if (task.error)
+    {
+        std::rethrow_exception(task.error);
+    }
+}
+
+} // namespace lox
@@ -0,0 +1,112 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox Interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+#include "../src/allocStats.h"
+#include "../src/interpreter.h"
+#include "../src/lexer.h"
+#include "../src/parser.h"
+
+#include <gtest/gtest.h>
+#include <memory>
+#include <new>
+
+using namespace lox;
+
+class TestAllocStats : public testing::Test
+{
+public:
+    void SetUp() override { AllocStats::reset(); }
+
+    void TearDown() override {}
+};
+
+TEST_F(TestAllocStats, hooksAreLinked)
+{
+    EXPECT_TRUE(AllocStats::available());
+}
+
+TEST_F(TestAllocStats, attributesAllocationsToTheCurrentPhase)
+{
+    {
+        PhaseScope phase{ Phase::Parse };
+        auto value = std::make_unique<double>(1.0);
+        {
+            PhaseScope inner{ Phase::Print };
+            auto other = std::make_unique<double>(2.0);
+        }
+    }
+
+    EXPECT_EQ(AllocStats::phase(Phase::Parse).allocations, 1u);
+    EXPECT_EQ(AllocStats::phase(Phase::Parse).bytes, sizeof(double));
+    EXPECT_EQ(AllocStats::phase(Phase::Parse).deallocations, 1u);
+    EXPECT_EQ(AllocStats::phase(Phase::Print).allocations, 1u);
+    EXPECT_EQ(AllocStats::phase(Phase::Lex).allocations, 0u);
+}
+
+TEST_F(TestAllocStats, failingAllocationsRefuseTheHeap)
+{
+    bool threw = false;
+    void* nothrow = &threw;
+    std::uint64_t failed = 0;
+    {
+        FailingAllocations noHeap{};
+        try
+        {
+            auto value = std::make_unique<double>(1.0);
+        }
+        catch (std::bad_alloc&)
+        {
+            threw = true;
+        }
+        nothrow = new (std::nothrow) double{ 2.0 };
+        failed = noHeap.failed();
+    }
+
+    EXPECT_TRUE(threw);
+    EXPECT_EQ(nothrow, nullptr);
+    EXPECT_EQ(failed, 2u);
+    EXPECT_EQ(AllocStats::total().allocations, 0u);
+    EXPECT_NE(std::make_unique<double>(3.0), nullptr);
+}
+
+TEST_F(TestAllocStats, numericEvaluationDoesNotAllocate)
+{
+    auto expr = Parser{ Lexer{ "(1 + 2) * -3 >= 4 / 5 == !true" }.tokenize() }.parse();
+    ASSERT_TRUE(expr);
+    Interpreter interpreter{};
+
+    auto before = AllocStats::total();
+    auto value = interpreter.evaluateTree(*expr.value());
+    auto used = AllocStats::total() - before;
+
+    EXPECT_EQ(value, LiteralValues{ true });
+    EXPECT_EQ(used.allocations, 0u);
+}
+
+TEST_F(TestAllocStats, parserAllocatesOneNodePerExpression)
+{
+    Logger::setLevel(Logger::Error);
+    auto tokens = Lexer{ "1 + 2 * 3 - 4" }.tokenize();
+
+    auto before = AllocStats::total();
+    auto expr = Parser{ std::move(tokens) }.parse();
+    auto used = AllocStats::total() - before;
+    Logger::setLevel(Logger::Debug);
+
+    ASSERT_TRUE(expr);
+    // One per node. Kept tight, so that any new allocation in the parser shows up here.
+    EXPECT_LE(used.allocations, 7u);
+}
@@ -0,0 +1,196 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox Interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+#include "../src/AstPrinter.hpp"
+#include "../src/astCache.h"
+#include "../src/astSerializer.h"
+#include "../src/interpreter.h"
+#include "../src/logger.h"
+#include "../src/session.h"
+
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <initializer_list>
+#include <sstream>
+#include <string>
+
+using namespace lox;
+
+class TestAstCache : public testing::Test
+{
+public:
+    void SetUp() override
+    {
+        Logger::setLevel(Logger::Info);
+        // One per test, as ctest may run them concurrently
+        m_directory = std::filesystem::temp_directory_path() /
+                      ("lox_ast_cache_" + std::string{ testing::UnitTest::GetInstance()->current_test_info()->name() });
+        std::filesystem::remove_all(m_directory);
+    }
+
+    void TearDown() override
+    {
+        Logger::setLevel(Logger::Debug);
+        std::filesystem::remove_all(m_directory);
+    }
+
+protected:
+    static std::string printed(const Expression* tree)
+    {
+        std::ostringstream out{};
+        if (tree)
+        {
+            AstPrinter{ out }.print(*tree);
+        }
+        return out.str();
+    }
+
+    // What parsing `source` in a fresh session, which already knows `names`, prints
+    static std::string parsed(const std::string& source, std::initializer_list<std::string_view> names = {})
+    {
+        Session session{};
+        for (auto name : names)
+        {
+            session.symbols().intern(name);
+        }
+        session.lex(source);
+        return printed(session.parse());
+    }
+
+    static std::string serialized(const std::string& source)
+    {
+        Session session{};
+        session.lex(source);
+        auto* tree = session.parse();
+        EXPECT_NE(tree, nullptr) << source;
+        std::string bytes{};
+        serializeTree(*tree, source, session.symbols(), bytes);
+        return bytes;
+    }
+
+    std::filesystem::path m_directory{};
+};
+
+TEST_F(TestAstCache, roundTripsEveryNode)
+{
+    const std::string sources[] = {
+        "1 + 2 * 3",
+        "(1 + 2) * -3 - !true == nil",
+        "\"short\" + \"a string literal too long to be inline\"",
+        "x * (y - x) >= 2.5 != false",
+        "-(-(-1)) / 0.125 < 3 <= 4 > 5",
+        "x and y or nil ? x - 1 : y ? 2, 3 : 4",
+        "sum([1, x, -2.5] * [y ? 1 : 2, 3, []]) + max([])",
+    };
+    for (const auto& source : sources)
+    {
+        auto bytes = serialized(source);
+        Session session{};
+        session.symbols().intern("unrelated"); // Names get other ids than they had
+        auto* tree = session.restore(bytes, source);
+
+        ASSERT_NE(tree, nullptr) << source;
+        EXPECT_EQ(printed(tree), parsed(source, { "unrelated" }));
+        EXPECT_EQ(session.tokens().size(), 0u);
+    }
+}
+
+TEST_F(TestAstCache, rejectsDamagedBytes)
+{
+    const std::string source = "(1 + x) * -\"text\" == nil";
+    auto bytes = serialized(source);
+    Session session{};
+
+    for (std::size_t size = 0; size < bytes.size(); ++size)
+    {
+        EXPECT_EQ(session.restore(std::span{ bytes.data(), size }, source), nullptr) << size;
+    }
+    EXPECT_EQ(session.restore(bytes + '\0', source), nullptr);
+
+    auto badTag = bytes;
+    badTag[0] = '\x7f';
+    EXPECT_EQ(session.restore(badTag, source), nullptr);
+    EXPECT_NE(session.restore(bytes, source), nullptr);
+}
+
+TEST_F(TestAstCache, storesAndLoadsTrees)
+{
+    const std::string source = "(1 + x) * -2 == \"some string literal\"";
+    AstCache cache{ m_directory };
+    Session session{};
+    EXPECT_EQ(cache.load(source, session), nullptr);
+
+    session.lex(source);
+    auto* tree = session.parse();
+    ASSERT_NE(tree, nullptr);
+    ASSERT_TRUE(cache.store(source, *tree, session.symbols()));
+    EXPECT_TRUE(std::filesystem::exists(cache.pathOf(source)));
+
+    Session other{};
+    auto* loaded = cache.load(source, other);
+    ASSERT_NE(loaded, nullptr);
+    EXPECT_EQ(printed(loaded), parsed(source));
+    EXPECT_EQ(cache.stats().hits, 1u);
+    EXPECT_EQ(cache.stats().misses, 1u);
+    EXPECT_EQ(cache.stats().stores, 1u);
+}
+
+TEST_F(TestAstCache, ignoresStaleAndDamagedFiles)
+{
+    const std::string source = "1 + 2";
+    AstCache cache{ m_directory };
+    Session session{};
+    session.lex(source);
+    ASSERT_TRUE(cache.store(source, *session.parse(), session.symbols()));
+
+    EXPECT_NE(cache.pathOf("1 + 3"), cache.pathOf(source));
+    EXPECT_EQ(cache.load("1 + 3", session), nullptr);
+
+    // The same name holding the tree of another source, as if the hashes collided
+    std::filesystem::copy_file(cache.pathOf(source), cache.pathOf("1 - 2"));
+    EXPECT_EQ(cache.load("1 - 2", session), nullptr);
+
+    {
+        std::ofstream file{ cache.pathOf(source), std::ios::binary | std::ios::in | std::ios::out };
+        file.seekp(0);
+        file.put('X');
+    }
+    EXPECT_EQ(cache.load(source, session), nullptr);
+    EXPECT_EQ(cache.stats().hits, 0u);
+}
+
+TEST_F(TestAstCache, interpreterReusesTreesOfScripts)
+{
+    std::filesystem::create_directories(m_directory);
+    auto script = m_directory / "script.lox";
+    {
+        std::ofstream file{ script };
+        file << "(1 + 2) * 3 - -4 / 5 >= 6 == !nil";
+    }
+    AstCache cache{ m_directory / "trees" };
+
+    for (int run = 0; run < 3; ++run)
+    {
+        Interpreter interpreter{ script };
+        interpreter.setAstCache(&cache);
+        EXPECT_EQ(interpreter.run(), EXIT_SUCCESS);
+    }
+
+    EXPECT_EQ(cache.stats().misses, 1u);
+    EXPECT_EQ(cache.stats().stores, 1u);
+    EXPECT_EQ(cache.stats().hits, 2u);
+}
@@ -0,0 +1,206 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox Interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+#include "../src/constant.h"
+#include "../src/interpreter.h"
+#include "../src/lexer.h"
+#include "../src/logger.h"
+#include "../src/parser.h"
+
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <type_traits>
+
+using namespace lox;
+using namespace lox::literals;
+
+static_assert(constant<"1 + 2 * 3"> == 7.0);
+static_assert(constant<"(1 + 2) * 3 / 4"> == 2.25);
+static_assert(constant<"-(-(-(2)))"> == -2.0);
+static_assert(constant<"0.1 + 0.2"> == 0.1 + 0.2);
+static_assert(constant<"1 < 2 != (3 <= 4) == (5 > 6) == !false">);
+static_assert(!constant<"!0">);
+static_assert(std::is_same_v<decltype(constant<"nil">), const NullLiteral>);
+static_assert(constant<"1 == true"> == false);
+static_assert(constant<"1 // a comment\n /* and another */ + 1"> == 2.0);
+static_assert(constant<"0 or 1"> == 0.0);
+static_assert(constant<"true or 1 + nil">);
+static_assert(std::is_same_v<decltype(constant<"nil and -true">), const NullLiteral>);
+static_assert(constant<"1 > 2 ? -nil : 2 < 3 ? 2 * 3 : false + 1"> == 6.0);
+static_assert("2 * 21"_lox == 42.0);
+
+// 1e294 and 1e-294, too long for one literal to be exact, so they are worked out the way the interpreter does
+#define LOX_BIG \
+    "(100000000000000 * 100000000000000 * 100000000000000 * 100000000000000 * 100000000000000 * " \
+    "100000000000000 * 100000000000000 * 100000000000000 * 100000000000000 * 100000000000000 * " \
+    "100000000000000 * 100000000000000 * 100000000000000 * 100000000000000 * 100000000000000 * " \
+    "100000000000000 * 100000000000000 * 100000000000000 * 100000000000000 * 100000000000000 * " \
+    "100000000000000)"
+#define LOX_SMALL \
+    "(1 / 100000000000000 / 100000000000000 / 100000000000000 / 100000000000000 / 100000000000000 / " \
+    "100000000000000 / 100000000000000 / 100000000000000 / 100000000000000 / 100000000000000 / " \
+    "100000000000000 / 100000000000000 / 100000000000000 / 100000000000000 / 100000000000000 / " \
+    "100000000000000 / 100000000000000 / 100000000000000 / 100000000000000 / 100000000000000 / " \
+    "100000000000000)"
+
+constexpr double Infinity = std::numeric_limits<double>::infinity();
+static_assert(constant<LOX_BIG " * " LOX_BIG> == Infinity);
+static_assert(constant<"-" LOX_BIG " * " LOX_BIG> == -Infinity);
+static_assert(constant<LOX_BIG " / " LOX_SMALL> == Infinity);
+static_assert(constant<"-" LOX_SMALL " / " LOX_BIG> == 0.0);
+static_assert(constant<LOX_SMALL " * " LOX_SMALL> == 0.0);
+static_assert(constant<LOX_SMALL " / 100000000000000"> > 0.0);
+static_assert(constant<LOX_SMALL " / 100000000000000"> < std::numeric_limits<double>::min()); // Subnormal
+static_assert(constant<LOX_SMALL " * 0.000000000001 * 0.0001"> > 0.0);
+static_assert(constant<LOX_SMALL " * 0.000000000001 * 0.0001"> < std::numeric_limits<double>::min());
+static_assert(constant<"0.1 * 0.2 / 0.3"> == 0.1 * 0.2 / 0.3);
+static_assert(constant<"1 / 3 * 3 - 1"> == 1.0 / 3 * 3 - 1);
+static_assert("nil == nil"_lox);
+
+class TestConstant : public testing::Test
+{
+public:
+    void SetUp() override { Logger::setLevel(Logger::Info); }
+
+    void TearDown() override { Logger::setLevel(Logger::Debug); }
+
+protected:
+    // The constant is what the interpreter gets from the same source, to the bit
+    template <FixedString Source> static void expectSameAsInterpreter()
+    {
+        auto tree = Parser{ Lexer{ Source.view() }.tokenize() }.parse();
+        ASSERT_TRUE(tree.has_value()) << Source.view();
+        auto expected = Interpreter{}.evaluateTree(*tree.value());
+        auto actual = constant<Source>;
+        if constexpr (std::is_same_v<decltype(actual), double>)
+        {
+            ASSERT_TRUE(std::holds_alternative<double>(expected)) << Source.view();
+            auto number = std::get<double>(expected);
+            EXPECT_TRUE((std::isnan(number) && std::isnan(actual)) ||
+                        std::bit_cast<std::uint64_t>(number) == std::bit_cast<std::uint64_t>(actual))
+                << Source.view();
+        }
+        else
+        {
+            EXPECT_EQ(expected, LiteralValues{ actual }) << Source.view();
+        }
+    }
+
+    // Whether a file using `constant<"source">` compiles, and what the compiler said
+    static bool compiles(const std::string& source, std::string& diagnostics)
+    {
+        std::string test = testing::UnitTest::GetInstance()->current_test_info()->name();
+        auto directory = std::filesystem::temp_directory_path() / ("lox_constant_" + test);
+        std::filesystem::create_directories(directory);
+        std::ofstream{ directory / "constant.cpp" }
+            << std::format("#include \"{}/src/constant.h\"\nconstexpr auto value = lox::constant<\"{}\">;\n",
+                           LOX_SOURCE_DIR, source);
+        auto command = std::format("\"{}\" -std=c++20 -fsyntax-only \"{}/constant.cpp\" > \"{}/log.txt\" 2>&1",
+                                   LOX_CXX_COMPILER, directory.string(), directory.string());
+        bool compiled = std::system(command.c_str()) == 0;
+        std::ifstream log{ directory / "log.txt" };
+        std::stringstream content{};
+        content << log.rdbuf();
+        diagnostics = content.str();
+        std::filesystem::remove_all(directory);
+        return compiled;
+    }
+};
+
+TEST_F(TestConstant, matchesTheInterpreter)
+{
+    expectSameAsInterpreter<"(1 + 2.5) * -3 - 4 / (5 + 6) >= 7 == !nil">();
+    expectSameAsInterpreter<"123456789012345 / 0.001">();
+    expectSameAsInterpreter<"0.3 - 0.1 * 3">();
+    expectSameAsInterpreter<"1 / 0">();
+    expectSameAsInterpreter<"-1 / 0">();
+    expectSameAsInterpreter<"1 / -0">();
+    expectSameAsInterpreter<"0 / 0 == 0 / 0">();
+    expectSameAsInterpreter<"0 / 0 != 0 / 0">();
+    expectSameAsInterpreter<"!nil == !!true">();
+    expectSameAsInterpreter<"nil == false">();
+    expectSameAsInterpreter<"1, 2">();
+    expectSameAsInterpreter<"nil or false and 1 or 2 == 2">();
+    expectSameAsInterpreter<"!nil ? 1 / 0 < 2 ? 1 : 2 : -nil, 3">();
+}
+
+TEST_F(TestConstant, infinitiesAndNaNsMatchTheInterpreter)
+{
+    // Constant expressions refuse to make either, the evaluator works them out itself
+    expectSameAsInterpreter<"(1 / 0) * 0">();
+    expectSameAsInterpreter<"(1 / 0) - (1 / 0)">();
+    expectSameAsInterpreter<"(-1 / 0) / (1 / 0)">();
+    expectSameAsInterpreter<"(1 / 0) * -2 + 5">();
+    expectSameAsInterpreter<"100000000000000 * 100000000000000 * 100000000000000 * 100000000000000 * "
+                            "100000000000000 * 100000000000000 * 100000000000000 * 100000000000000 * "
+                            "100000000000000 * 100000000000000 * 100000000000000 * 100000000000000 * "
+                            "100000000000000 * 100000000000000 * 100000000000000 * 100000000000000 * "
+                            "100000000000000 * 100000000000000 * 100000000000000 * 100000000000000 * "
+                            "100000000000000 * 100000000000000 * -100000000000000">();
+    expectSameAsInterpreter<"179769313486231 * 1000000000 * 1000000000 * 1000000000 * 1000000000 * 1000000000 * "
+                            "1000000000 * 1000000000 * 1000000000 * 1000000000 * 1000000000 * 1000000000 * "
+                            "1000000000 * 1000000000 * 1000000000 * 1000000000 * 1000000000 * 1000000000 * "
+                            "1000000000 * 1000000000 * 1000000000 * 1000000000 * 1000000000 * 1000000000 * "
+                            "1000000000 * 1000000000 * 1000000000 * 1000000000 * 1000000000 * 1000000000 * "
+                            "1000000000 * 1000000000 * 1000000000 * 1000000000 * 10 * 0.1 * 10">();
+    expectSameAsInterpreter<"1 / 100000000000000 / 100000000000000 / 100000000000000 / 100000000000000 / "
+                            "100000000000000 / 100000000000000 / 100000000000000 / 100000000000000 / "
+                            "100000000000000 / 100000000000000 / 100000000000000 / 100000000000000 / "
+                            "100000000000000 / 100000000000000 / 100000000000000 / 100000000000000 / "
+                            "100000000000000 / 100000000000000 / 100000000000000 / 100000000000000 / "
+                            "100000000000000 / 100000000000000 / 100000000000000 / 100000000000000">();
+    expectSameAsInterpreter<LOX_BIG " * " LOX_BIG>();
+    expectSameAsInterpreter<"-" LOX_BIG " * " LOX_BIG>();
+    expectSameAsInterpreter<LOX_BIG " / " LOX_SMALL>();
+    expectSameAsInterpreter<"-" LOX_SMALL " / " LOX_BIG>();
+    expectSameAsInterpreter<LOX_SMALL " * " LOX_SMALL>();
+    expectSameAsInterpreter<LOX_SMALL " / 100000000000000">();
+    expectSameAsInterpreter<LOX_SMALL " * 0.000000000001 * 0.0001">();
+    expectSameAsInterpreter<LOX_SMALL " / 3 / 7 / 100000000000000 * 0.0001">();
+    expectSameAsInterpreter<LOX_BIG " * 17 / 3 * 0.00001 * 0.00003">();
+    expectSameAsInterpreter<"(" LOX_BIG ") / (" LOX_SMALL ") / (" LOX_BIG ") / (" LOX_BIG ")">();
+}
+
+TEST_F(TestConstant, errorsDoNotCompile)
+{
+    const std::pair<const char*, const char*> errors[] = {
+        { "1 +", "Expected expression." },
+        { "(1 + 2", "Expected ')' after expression." },
+        { "1 + true", "Operands must be numbers." },
+        { "x * 2", "Variables are not constants." },
+        { "true and 1 + nil", "Operands must be numbers." },
+        { "1 ? 2", "Expected ':' after the then branch of a conditional." },
+        { "\\\"text\\\"", "Strings are not constants." },
+        { "[1, 2]", "Arrays are not constants." },
+        { "sum(1)", "Arrays are not constants." },
+    };
+    std::string diagnostics{};
+    ASSERT_TRUE(compiles("1 + 2", diagnostics)) << diagnostics;
+    for (auto [source, reason] : errors)
+    {
+        EXPECT_FALSE(compiles(source, diagnostics)) << source;
+        EXPECT_NE(diagnostics.find(reason), std::string::npos) << source << ":\n" << diagnostics;
+    }
+}
@@ -0,0 +1,279 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox Interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+#include "../src/cppTranspiler.h"
+#include "../src/interpreter.h"
+#include "../src/lexer.h"
+#include "../src/logger.h"
+#include "../src/parser.h"
+#include "lox.h"
+
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace lox;
+
+class TestCppTranspiler : public testing::Test
+{
+public:
+    void SetUp() override
+    {
+        Logger::setLevel(Logger::Info);
+        // One per test, as ctest may run them concurrently
+        m_directory = std::filesystem::temp_directory_path() /
+                      ("lox_cpp_" + std::string{ testing::UnitTest::GetInstance()->current_test_info()->name() });
+        std::filesystem::remove_all(m_directory);
+        // Bound in the same order as they are interned, so the symbols of the parsed trees are the interpreter's
+        m_symbols.intern("x");
+        m_interpreter.setGlobal("x", 3.0);
+        m_symbols.intern("y");
+        m_interpreter.setGlobal("y", -0.5);
+        m_symbols.intern("s");
+        m_interpreter.setGlobal("s", LoxString{ "text" });
+        m_symbols.intern("t");
+        m_interpreter.setGlobal("t", true);
+    }
+
+    void TearDown() override
+    {
+        Logger::setLevel(Logger::Debug);
+        std::filesystem::remove_all(m_directory);
+    }
+
+protected:
+    ExpressionUPTR parse(const std::string& source)
+    {
+        auto tree = Parser{ Lexer{ source, &m_symbols }.tokenize() }.parse();
+        EXPECT_TRUE(tree.has_value()) << source;
+        return tree ? std::move(tree.value()) : nullptr;
+    }
+
+    // One line per result, written the same way by the generated driver, with any NaN as "nan"
+    std::string describe(const Expression& tree)
+    {
+        try
+        {
+            auto value = m_interpreter.evaluateTree(tree);
+            if (auto* number = std::get_if<double>(&value))
+            {
+                return std::isnan(*number) ? "number nan"
+                                           : std::format("number {:016x}", std::bit_cast<std::uint64_t>(*number));
+            }
+            if (auto* string = std::get_if<LoxString>(&value))
+            {
+                return std::format("string {}:{}", string->size(), string->view());
+            }
+            if (auto* boolean = std::get_if<bool>(&value))
+            {
+                return std::format("bool {}", *boolean ? 1 : 0);
+            }
+            return "nil";
+        }
+        catch (const Interpreter::InterpreterException& e)
+        {
+            return std::format("error {}", e.what());
+        }
+    }
+
+    // Builds `main.cpp`, which prints the result of every function of the unit, with the generated code and runs it
+    std::string compileAndRun(const CppTranspiler& transpiler, std::size_t functions)
+    {
+        EXPECT_TRUE(transpiler.write(m_directory));
+        std::ofstream driver{ m_directory / "main.cpp" };
+        driver << std::format(R"(#include "{0}.h"
+
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+
+using namespace {0};
+
+std::optional<Value> lookup(std::string_view name)
+{{
+    if (name == "x") return Value{{ 3.0 }};
+    if (name == "y") return Value{{ -0.5 }};
+    if (name == "s") return Value{{ std::string{{ "text" }} }};
+    if (name == "t") return Value{{ true }};
+    return std::nullopt;
+}}
+
+void describe(Value (*function)(const Lookup&))
+{{
+    try
+    {{
+        auto value = function(lookup);
+        if (auto* number = std::get_if<double>(&value))
+        {{
+            if (std::isnan(*number))
+                std::printf("number nan\n");
+            else
+                std::printf("number %016llx\n", static_cast<unsigned long long>(std::bit_cast<std::uint64_t>(*number)));
+        }}
+        else if (auto* string = std::get_if<std::string>(&value))
+            std::printf("string %zu:%s\n", string->size(), string->c_str());
+        else if (auto* boolean = std::get_if<bool>(&value))
+            std::printf("bool %d\n", *boolean ? 1 : 0);
+        else
+            std::printf("nil\n");
+    }}
+    catch (const RuntimeError& e)
+    {{
+        std::printf("error %s\n", e.what());
+    }}
+}}
+
+int main()
+{{
+)",
+                              transpiler.unit());
+        for (std::size_t i = 0; i < functions; ++i)
+        {
+            driver << std::format("    describe(&f{});\n", i);
+        }
+        driver << "}\n";
+        driver.close();
+
+        auto directory = m_directory.string();
+        auto build = std::format("\"{}\" -std=c++20 -Wall -Wextra -Werror -o \"{}/driver\" \"{}/main.cpp\" "
+                                 "\"{}/{}.cpp\" > \"{}/build.log\" 2>&1",
+                                 LOX_CXX_COMPILER, directory, directory, directory, transpiler.unit(), directory);
+        if (std::system(build.c_str()) != 0)
+        {
+            ADD_FAILURE() << read(m_directory / "build.log");
+            return {};
+        }
+        auto run = std::format("\"{}/driver\" > \"{}/output.txt\"", directory, directory);
+        EXPECT_EQ(std::system(run.c_str()), 0);
+        return read(m_directory / "output.txt");
+    }
+
+    static std::string read(const std::filesystem::path& path)
+    {
+        std::ifstream file{ path };
+        std::stringstream content{};
+        content << file.rdbuf();
+        return content.str();
+    }
+
+    std::filesystem::path m_directory;
+    SymbolTable m_symbols{};
+    Interpreter m_interpreter{};
+};
+
+TEST_F(TestCppTranspiler, compiledCodeMatchesTheInterpreter)
+{
+    const std::string sources[] = {
+        "(1 + 2.5) * -3 - 4 / (5 + 6) >= 7 == !nil",
+        "\"some string literal\" + \"other\" == \"some string literal\" + \"other\"",
+        "1 < 2 != (3 <= 4) == (5 > 6) == !true",
+        "-(-(-(2)))",
+        "x * x - y",
+        "s + \" and \" + s",
+        "\"what?\" + \"a\\\\b\"",
+        "t == true != (nil == nil)",
+        "1 / 0",
+        "0 / 0 == 0 / 0",
+        "123456789012345678901234567890 + 0.1",
+        "1 == \"1\"",
+        "!x",
+        "s - 1",        // Arithmetic on a string
+        "1 + true",     // Addition of mismatched operands
+        "x > s",        // Comparison with a string
+        "-y * (x + s)", // The error of the innermost node
+        "x > 1 and s or missing",
+        "nil or x ? s + s : missing",
+        "t ? (x < 0 ? 1 : y) : 2, false and 1 + true",
+        "x and s - 1", // The error of an operand that is not skipped
+    };
+    CppTranspiler transpiler{ "rules", m_symbols };
+    std::string expected{};
+    std::vector<ExpressionUPTR> trees{};
+    for (const auto& source : sources)
+    {
+        trees.push_back(parse(source));
+        transpiler.add(std::format("f{}", trees.size() - 1), *trees.back());
+        expected += describe(*trees.back()) + "\n";
+    }
+
+    EXPECT_EQ(compileAndRun(transpiler, trees.size()), expected);
+}
+
+TEST_F(TestCppTranspiler, undefinedVariablesAreRuntimeErrors)
+{
+    auto tree = parse("x + missing");
+    CppTranspiler transpiler{ "undefined", m_symbols };
+    transpiler.add("f0", *tree);
+
+    Token token{ TokenType::Identifier, m_symbols.intern("missing"), "missing", 1 };
+    Interpreter::InterpreterException expected{ token, "undefined variable missing" };
+    EXPECT_EQ(compileAndRun(transpiler, 1), std::format("error {}\n", expected.what()));
+}
+
+TEST_F(TestCppTranspiler, headerDeclaresEveryFunction)
+{
+    auto tree = parse("1 + 2");
+    CppTranspiler transpiler{ "rules", m_symbols };
+    transpiler.add("first", *tree);
+    transpiler.add("second", *tree);
+
+    auto header = transpiler.header();
+    EXPECT_NE(header.find("namespace rules"), std::string::npos);
+    EXPECT_NE(header.find("Value first(const Lookup& lookup);"), std::string::npos);
+    EXPECT_NE(header.find("Value second(const Lookup& lookup);"), std::string::npos);
+    EXPECT_NE(transpiler.source().find("#include \"rules.h\""), std::string::npos);
+}
+
+TEST_F(TestCppTranspiler, rejectsNamesThatAreNotIdentifiers)
+{
+    auto tree = parse("1");
+    EXPECT_THROW((CppTranspiler{ "9lives", m_symbols }), std::invalid_argument);
+    EXPECT_THROW((CppTranspiler{ "has space", m_symbols }), std::invalid_argument);
+
+    CppTranspiler transpiler{ "rules", m_symbols };
+    EXPECT_THROW(transpiler.add("class", *tree), std::invalid_argument);
+    EXPECT_THROW(transpiler.add("Value", *tree), std::invalid_argument);
+    EXPECT_THROW(transpiler.add("__reserved", *tree), std::invalid_argument);
+    transpiler.add("rule", *tree);
+    EXPECT_THROW(transpiler.add("rule", *tree), std::invalid_argument);
+    EXPECT_THROW(transpiler.add("array", *parse("sum([1, 2])")), std::invalid_argument);
+}
+
+TEST_F(TestCppTranspiler, emitsScriptsFromTheCommandLine)
+{
+    std::filesystem::create_directories(m_directory);
+    auto script = m_directory / "script.lox";
+    std::ofstream{ script } << "(1 + 2) * 3\n";
+    auto output = (m_directory / "generated").string();
+    auto flag = "--emit-cpp=" + output;
+    auto path = script.string();
+    char* argv[] = { const_cast<char*>("lox"), flag.data(), path.data() };
+
+    EXPECT_EQ(run(3, argv), EXIT_SUCCESS);
+    EXPECT_NE(read(m_directory / "generated" / "script.h").find("Value evaluate(const Lookup& lookup);"),
+              std::string::npos);
+    EXPECT_TRUE(std::filesystem::exists(m_directory / "generated" / "script.cpp"));
+}
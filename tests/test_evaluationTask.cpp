@@ -0,0 +1,178 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox Interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+#include "../src/evaluationTask.h"
+#include "../src/interpreter.h"
+#include "../src/lexer.h"
+#include "../src/logger.h"
+#include "../src/parser.h"
+
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <string>
+
+using namespace lox;
+
+class TestEvaluationTask : public testing::Test
+{
+public:
+    void SetUp() override { Logger::setLevel(Logger::Info); }
+
+    void TearDown() override { Logger::setLevel(Logger::Debug); }
+
+protected:
+    ExpressionUPTR parse(const std::string& source)
+    {
+        auto tree = Parser{ Lexer{ source, &m_symbols }.tokenize() }.parse();
+        EXPECT_TRUE(tree.has_value()) << source;
+        return tree ? std::move(tree.value()) : nullptr;
+    }
+
+    static LiteralValues runToEnd(EvaluationTask task)
+    {
+        while (!task.resume())
+        {
+        }
+        return task.result();
+    }
+
+    // "0 + 1 + ... + 1", with `terms` ones
+    static std::string sum(int terms)
+    {
+        std::string source = "0";
+        for (int i = 0; i < terms; ++i)
+        {
+            source += " + 1";
+        }
+        return source;
+    }
+
+    SymbolTable m_symbols{};
+};
+
+TEST_F(TestEvaluationTask, matchesRecursiveEvaluation)
+{
+    const std::string sources[] = {
+        "(1 + 2.5) * -3 - 4 / (5 + 6) >= 7 == !nil",
+        "\"some string literal\" + \"other\" == \"some string literal\" + \"other\"",
+        "1 < 2 != (3 <= 4) == (5 > 6) == !true",
+        "-(-(-(2)))",
+        "nil or 1 > 2 and missing or \"a\" + \"b\"",
+        "1 < 2 ? (false ? missing : 3) * 2 : -nil",
+        "sum([1, 2 * 3, -4] * [2, 1, 0] + 1) - max(![0, 1]), [5, 6]",
+    };
+    Interpreter interpreter{};
+    for (const auto& source : sources)
+    {
+        auto tree = parse(source);
+        EvaluationSlice slice{};
+        slice.nodes = 3;
+
+        EXPECT_EQ(runToEnd(interpreter.evaluateCooperatively(*tree, slice)), interpreter.evaluateTree(*tree)) << source;
+    }
+}
+
+TEST_F(TestEvaluationTask, suspendsEveryFewNodes)
+{
+    auto tree = parse(sum(50)); // 101 nodes
+    Interpreter interpreter{};
+    EvaluationSlice slice{};
+    slice.nodes = 10;
+    auto task = interpreter.evaluateCooperatively(*tree, slice);
+    EXPECT_FALSE(task.done()); // Nothing runs before the first resume
+
+    while (!task.resume())
+    {
+    }
+
+    EXPECT_EQ(task.slices(), 11u);
+    EXPECT_EQ(task.result(), LiteralValues{ 50.0 });
+}
+
+TEST_F(TestEvaluationTask, suspendsAfterBigStrings)
+{
+    auto tree = parse("\"0123456789\" + \"0123456789\" + \"0123456789\"");
+    Interpreter interpreter{};
+    EvaluationSlice slice{};
+    slice.stringBytes = 20;
+    auto task = interpreter.evaluateCooperatively(*tree, slice);
+
+    while (!task.resume())
+    {
+    }
+
+    EXPECT_EQ(task.slices(), 4u);
+    EXPECT_EQ(std::get<LoxString>(task.result()).size(), 30u);
+}
+
+TEST_F(TestEvaluationTask, deepTreesNeedNoNativeStack)
+{
+    constexpr int Depth = 200000; // Far deeper than the recursive evaluator could go
+    ExpressionUPTR tree = std::make_unique<LiteralExpression>(true);
+    for (int i = 0; i < Depth; ++i)
+    {
+        tree = std::make_unique<UnaryExpression>(Token{ TokenType::Bang, std::monostate{}, "!", 1 }, std::move(tree));
+    }
+    Interpreter interpreter{};
+
+    EXPECT_EQ(runToEnd(interpreter.evaluateCooperatively(*tree)), LiteralValues{ true });
+
+    // Taken apart from the top, as destroying it recursively would be as deep
+    while (auto* unary = dynamic_cast<UnaryExpression*>(tree.get()))
+    {
+        auto next = std::move(unary->right);
+        tree = std::move(next);
+    }
+}
+
+TEST_F(TestEvaluationTask, schedulerTakesTurns)
+{
+    auto longTree = parse(sum(1000));
+    auto shortTree = parse("1 + 2");
+    Interpreter interpreter{};
+    EvaluationScheduler scheduler{};
+    EvaluationSlice slice{};
+    slice.nodes = 100;
+    auto longTask = scheduler.add(interpreter.evaluateCooperatively(*longTree, slice));
+    auto shortTask = scheduler.add(interpreter.evaluateCooperatively(*shortTree, slice));
+
+    EXPECT_EQ(scheduler.step(), 1u);
+    EXPECT_TRUE(scheduler.task(shortTask).done());
+    EXPECT_FALSE(scheduler.task(longTask).done());
+
+    scheduler.run();
+    EXPECT_EQ(scheduler.pending(), 0u);
+    EXPECT_EQ(scheduler.task(longTask).result(), LiteralValues{ 1000.0 });
+    EXPECT_EQ(scheduler.task(shortTask).result(), LiteralValues{ 3.0 });
+    EXPECT_EQ(scheduler.task(shortTask).slices(), 1u);
+}
+
+TEST_F(TestEvaluationTask, errorsComeOutOfTheResult)
+{
+    auto badTree = parse("1 + \"text\"");
+    auto longTree = parse(sum(100));
+    Interpreter interpreter{};
+    EvaluationBudget budget{};
+    budget.maxNodes = 50;
+    interpreter.setBudget(budget);
+
+    auto task = interpreter.evaluateCooperatively(*badTree);
+    EXPECT_THROW(task.result(), std::logic_error);
+    EXPECT_TRUE(task.resume());
+    EXPECT_THROW(task.result(), Interpreter::InterpreterException);
+
+    EXPECT_THROW(runToEnd(interpreter.evaluateCooperatively(*longTree)), BudgetExceededException);
+}
@@ -0,0 +1,219 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox Interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+#include "../src/evaluator.h"
+#include "../src/interpreter.h"
+#include "../src/lexer.h"
+#include "../src/logger.h"
+#include "../src/parser.h"
+
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <variant>
+#include <vector>
+
+using namespace lox;
+
+static_assert(sizeof(NumericValue) <= 16);
+static_assert(std::variant_size_v<NumericValue> == 3);
+static_assert(std::is_same_v<Evaluator<>::Value, LiteralValues>);
+
+class TestEvaluator : public testing::Test
+{
+public:
+    void SetUp() override { Logger::setLevel(Logger::Info); }
+
+    void TearDown() override { Logger::setLevel(Logger::Debug); }
+
+protected:
+    // The trees read x, y and flag, bound in that order so their Symbols match the interpreter's
+    void bind(Interpreter& interpreter)
+    {
+        interpreter.setGlobal("x", 3.0);
+        interpreter.setGlobal("y", -0.5);
+        interpreter.setGlobal("flag", true);
+        m_symbols.intern("x");
+        m_symbols.intern("y");
+        m_symbols.intern("flag");
+    }
+
+    ExpressionUPTR parse(std::string_view source)
+    {
+        auto tree = Parser{ Lexer{ source, &m_symbols }.tokenize() }.parse();
+        EXPECT_TRUE(tree.has_value()) << source;
+        return std::move(tree.value());
+    }
+
+    // What evaluating `tree` gives, or the message of the error it throws
+    template <typename Evaluate> static std::variant<LiteralValues, std::string> outcome(Evaluate evaluate)
+    {
+        try
+        {
+            return evaluate();
+        }
+        catch (Interpreter::InterpreterException& e)
+        {
+            return std::string{ e.what() };
+        }
+    }
+
+    SymbolTable m_symbols;
+};
+
+TEST_F(TestEvaluator, numericOnlyMatchesTheDynamicPolicy)
+{
+    Interpreter interpreter{};
+    bind(interpreter);
+    const char* sources[] = {
+        "(x + 2.5) * -y - 4 / (x + 6) >= 7 == !nil",
+        "x / 0 == x / 0",
+        "(0 / 0) != (0 / 0)",
+        "flag == true != (nil == false)",
+        "!flag == !!nil",
+        "x + y * x - y / x",
+        "1, flag",
+        "nil",
+        "-x < y == (x <= 3)",
+        "flag + 1",
+        "x > nil",
+        "true == 1",
+    };
+    for (const char* source : sources)
+    {
+        auto tree = parse(source);
+        auto dynamic = outcome([&]() { return interpreter.evaluateTree(*tree); });
+        auto numeric = outcome([&]() { return interpreter.evaluateNumeric(*tree); });
+        EXPECT_EQ(dynamic, numeric) << source;
+    }
+}
+
+TEST_F(TestEvaluator, numericOnlyRejectsStringLiterals)
+{
+    Interpreter interpreter{};
+    bind(interpreter);
+    auto tree = parse("x == 1 == (\"text\" == nil)");
+    EXPECT_TRUE(hasStringLiterals(*tree));
+    EXPECT_FALSE(hasStringLiterals(*parse("-(x + 1) == !flag")));
+    EXPECT_THROW(interpreter.evaluateNumeric(*parse("(1 + \"a\") == nil")), std::invalid_argument);
+}
+
+TEST_F(TestEvaluator, numericOnlyRejectsStringVariables)
+{
+    Interpreter interpreter{};
+    bind(interpreter);
+    interpreter.setGlobal("name", LoxString{ "lox" });
+    m_symbols.intern("name");
+    auto tree = parse("x + name");
+    EXPECT_THROW(interpreter.evaluateTree(*tree), Interpreter::InterpreterException);
+    auto error = outcome([&]() { return interpreter.evaluateNumeric(*tree); });
+    ASSERT_TRUE(std::holds_alternative<std::string>(error));
+    EXPECT_NE(std::get<std::string>(error).find("variable name holds a string"), std::string::npos);
+}
+
+TEST_F(TestEvaluator, numericOnlyKeepsToTheBudget)
+{
+    Interpreter interpreter{};
+    bind(interpreter);
+    EvaluationBudget budget{};
+    budget.maxNodes = 4;
+    budget.checkInterval = 1;
+    interpreter.setBudget(budget);
+    EXPECT_THROW(interpreter.evaluateNumeric(*parse("x + y + x + y")), Interpreter::BudgetExceededException);
+    EXPECT_EQ(interpreter.evaluateNumeric(*parse("x + y")), LiteralValues{ 2.5 });
+}
+
+TEST_F(TestEvaluator, evaluatesWithoutAnInterpreter)
+{
+    auto tree = parse("x * 2 == 6");
+    Globals globals{ LiteralValues{ 3.0 } };
+    EvaluationBudget budget{};
+    BudgetMeter meter{};
+    meter.start(budget);
+    EXPECT_EQ(Evaluator<NumericOnly>(globals, m_symbols, budget, meter).evaluate(*tree), NumericValue{ true });
+    EXPECT_EQ(Evaluator<>(globals, m_symbols, budget, meter).evaluate(*tree), LiteralValues{ true });
+    EXPECT_EQ(meter.visits(), 10u);
+}
+
+TEST_F(TestEvaluator, arraysApplyOperatorsToEveryElement)
+{
+    Interpreter interpreter{};
+    bind(interpreter);
+    auto array = [](std::vector<double> elements) { return LiteralValues{ NumberArray{ elements } }; };
+    const std::pair<const char*, LiteralValues> cases[] = {
+        { "[1, 2, 3] + [10, 20, 30]", array({ 11, 22, 33 }) },
+        { "[1, 2, 3] * x - 1", array({ 2, 5, 8 }) },
+        { "12 / [1, 2, 4]", array({ 12, 6, 3 }) },
+        { "[1, x, 5] > 2", array({ 0, 1, 1 }) },
+        { "-[1, -y]", array({ -1, -0.5 }) },
+        { "![0, 1, 2]", array({ 1, 0, 0 }) },
+        { "[]", array({}) },
+        { "[1, 2] == [1, 2]", LiteralValues{ true } },
+        { "[1, 2] != [1, 2, 3]", LiteralValues{ true } },
+        { "[] ? 1 : 2", LiteralValues{ 1.0 } },
+        { "sum([1, 2, 3] * 2)", LiteralValues{ 12.0 } },
+        { "min([4, x, 8]) + max([4, x, 8])", LiteralValues{ 11.0 } },
+        { "sum([])", LiteralValues{ 0.0 } },
+    };
+    for (const auto& [source, expected] : cases)
+    {
+        auto tree = parse(source);
+        EXPECT_EQ(outcome([&]() { return interpreter.evaluateTree(*tree); }),
+                  (std::variant<LiteralValues, std::string>{ expected }))
+            << source;
+    }
+}
+
+TEST_F(TestEvaluator, arrayErrors)
+{
+    Interpreter interpreter{};
+    bind(interpreter);
+    const std::pair<const char*, const char*> errors[] = {
+        { "[1, 2] + [1, 2, 3]", "Arrays of different lengths, 2 and 3." },
+        { "[1, flag]", "Array elements must be numbers." },
+        { "[1] + \"a\"", "Addition on something" },
+        { "[1] * nil", "variables do not hold the same type" },
+        { "sum(x)", "sum() takes an array." },
+        { "min([])", "min() of an empty array." },
+    };
+    for (auto [source, reason] : errors)
+    {
+        auto tree = parse(source);
+        auto error = outcome([&]() { return interpreter.evaluateTree(*tree); });
+        ASSERT_TRUE(std::holds_alternative<std::string>(error)) << source;
+        EXPECT_NE(std::get<std::string>(error).find(reason), std::string::npos) << source << ": "
+                                                                                 << std::get<std::string>(error);
+    }
+}
+
+TEST_F(TestEvaluator, numericOnlyRejectsArrays)
+{
+    Interpreter interpreter{};
+    bind(interpreter);
+    interpreter.setGlobal("values", NumberArray{ std::vector<double>{ 1, 2 } });
+    m_symbols.intern("values");
+    EXPECT_TRUE(hasArrayLiterals(*parse("x + sum([1, 2])")));
+    EXPECT_FALSE(hasArrayLiterals(*parse("x + \"[1, 2]\"")));
+    EXPECT_FALSE(hasStringLiterals(*parse("[1, 2]")));
+    EXPECT_THROW(interpreter.evaluateNumeric(*parse("[x] == nil")), std::invalid_argument);
+    auto tree = parse("x + values");
+    LiteralValues expected{ NumberArray{ std::vector<double>{ 4, 5 } } };
+    EXPECT_EQ(interpreter.evaluateTree(*tree), expected);
+    auto error = outcome([&]() { return interpreter.evaluateNumeric(*tree); });
+    ASSERT_TRUE(std::holds_alternative<std::string>(error));
+    EXPECT_NE(std::get<std::string>(error).find("variable values holds an array"), std::string::npos);
+}
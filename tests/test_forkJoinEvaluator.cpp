@@ -0,0 +1,209 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox Interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+#include "../src/forkJoinEvaluator.h"
+#include "../src/interpreter.h"
+#include "../src/lexer.h"
+#include "../src/logger.h"
+#include "../src/parser.h"
+
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include <variant>
+
+using namespace lox;
+
+class TestForkJoinEvaluator : public testing::Test
+{
+public:
+    void SetUp() override
+    {
+        Logger::setLevel(Logger::Info);
+        // Bound in the same order as they are interned, so the symbols of the parsed trees are the interpreter's
+        bind("x", 3.0);
+        bind("y", -0.5);
+        bind("s", LoxString{ "a string long enough for the heap" });
+        bind("b", true);
+        bind("v", NumberArray{ std::vector<double>{ 1, 2, 3 } });
+    }
+
+    void TearDown() override { Logger::setLevel(Logger::Debug); }
+
+protected:
+    using Outcome = std::variant<LiteralValues, std::string>;
+
+    void bind(std::string_view name, LiteralValues value)
+    {
+        m_symbols.intern(name);
+        m_interpreter.setGlobal(name, value);
+        m_globals.push_back(std::move(value));
+    }
+
+    ExpressionUPTR parse(const std::string& source)
+    {
+        auto tree = Parser{ Lexer{ source, &m_symbols }.tokenize() }.parse();
+        EXPECT_TRUE(tree.has_value()) << source;
+        return tree ? std::move(tree.value()) : nullptr;
+    }
+
+    // The value of the evaluation, or the message of its error
+    template <typename Evaluate> static Outcome outcome(Evaluate evaluate)
+    {
+        try
+        {
+            return evaluate();
+        }
+        catch (InterpreterException& e)
+        {
+            return std::string{ e.what() };
+        }
+        catch (BudgetExceededException& e)
+        {
+            return std::string{ e.what() };
+        }
+    }
+
+    Outcome sequential(const Expression& tree)
+    {
+        return outcome([&]() { return m_interpreter.evaluateTree(tree); });
+    }
+
+    Outcome forked(const Expression& tree, std::uint32_t grain)
+    {
+        ForkJoinEvaluator<> evaluator{ m_pool, m_globals, m_symbols, m_budget, grain };
+        return outcome([&]() { return evaluator.evaluate(tree); });
+    }
+
+    // A random expression of any type, many of them with type errors somewhere
+    std::string any(int depth)
+    {
+        static const char* const leaves[] = { "0", "2.5", "x", "y", "s", "b", "nil", "true", "\"ab\"", "-7", "v" };
+        static const char* const operators[] = { " + ", " - ", " * ", " / ", " < ", " <= ", " > ",
+                                                 " >= ", " == ", " != ", " + ", " + ", " and ", " or " };
+        static const char* const builtins[] = { "sum(", "min(", "max(" };
+        switch (depth == 0 ? 0 : pick(8))
+        {
+        case 0:
+            return leaves[pick(10)];
+        case 1:
+            return "!" + any(depth - 1);
+        case 2:
+            return "(" + any(depth - 1) + " ? " + any(depth - 1) + " : " + any(depth - 1) + ")";
+        case 3:
+        {
+            std::string array = "[" + any(depth - 1);
+            for (int i = pick(3); i > 0; --i)
+            {
+                array += ", " + any(depth - 1);
+            }
+            return array + "]";
+        }
+        case 4:
+            return builtins[pick(2)] + any(depth - 1) + ")";
+        default:
+            return "(" + any(depth - 1) + operators[pick(13)] + any(depth - 1) + ")";
+        }
+    }
+
+    // Uniform in [0, max]
+    int pick(int max) { return std::uniform_int_distribution<int>{ 0, max }(m_random); }
+
+    SymbolTable m_symbols{};
+    Interpreter m_interpreter{};
+    Globals m_globals{};
+    EvaluationBudget m_budget{};
+    WorkStealingPool m_pool{ 4 };
+    std::mt19937 m_random{ 47 };
+};
+
+TEST_F(TestForkJoinEvaluator, parserCountsTheNodes)
+{
+    auto tree = parse("-(x + 1) * !b == (2)");
+    EXPECT_EQ(tree->treeSize(), 11u);
+    const auto& equality = static_cast<const BinaryExpression&>(*tree);
+    EXPECT_EQ(equality.left->treeSize(), 8u);
+    EXPECT_EQ(equality.right->treeSize(), 2u);
+}
+
+TEST_F(TestForkJoinEvaluator, matchesTheSequentialEvaluation)
+{
+    int failures = 0;
+    for (int i = 0; i < 500; ++i)
+    {
+        auto source = any(8);
+        auto tree = parse(source);
+        ASSERT_NE(tree, nullptr);
+        auto expected = sequential(*tree);
+        failures += std::holds_alternative<std::string>(expected);
+        for (std::uint32_t grain : { 1u, 3u, 16u })
+        {
+            EXPECT_EQ(forked(*tree, grain), expected) << source << " with a grain of " << grain;
+        }
+    }
+    // Both kinds of outcome are covered
+    EXPECT_GT(failures, 50);
+    EXPECT_LT(failures, 450);
+}
+
+TEST_F(TestForkJoinEvaluator, reportsTheFirstErrorInEvaluationOrder)
+{
+    // Both operands fail, the right one quickly and the left one after a long evaluation
+    std::string slow = "1";
+    for (int i = 0; i < 2000; ++i)
+    {
+        slow = "(" + slow + " + x)";
+    }
+    auto tree = parse("((" + slow + " - nil) * (true - 1)) + (s - 1)");
+    ASSERT_NE(tree, nullptr);
+    auto expected = sequential(*tree);
+    ASSERT_TRUE(std::holds_alternative<std::string>(expected));
+    for (int i = 0; i < 20; ++i)
+    {
+        EXPECT_EQ(forked(*tree, 1), expected);
+    }
+}
+
+TEST_F(TestForkJoinEvaluator, checksTheStringBudget)
+{
+    m_budget.maxStringSize = 40;
+    m_interpreter.setBudget(m_budget);
+    auto tree = parse("((s + s) == s) + (s + \"!\")");
+    ASSERT_NE(tree, nullptr);
+    auto expected = sequential(*tree);
+    ASSERT_TRUE(std::holds_alternative<std::string>(expected));
+    EXPECT_EQ(forked(*tree, 1), expected);
+}
+
+TEST_F(TestForkJoinEvaluator, interpreterFallsBackForLimitedBudgets)
+{
+    m_interpreter.setPool(&m_pool, 1);
+    auto tree = parse("(x + y) * (x - y) + (x / y) * (y - x)");
+    ASSERT_NE(tree, nullptr);
+    EXPECT_EQ(m_interpreter.evaluateForked(*tree), m_interpreter.evaluateTree(*tree));
+
+    EvaluationBudget budget{};
+    budget.maxNodes = 5;
+    budget.checkInterval = 1;
+    m_interpreter.setBudget(budget);
+    EXPECT_THROW(m_interpreter.evaluateForked(*tree), BudgetExceededException);
+
+    m_interpreter.setNumericOnly(true);
+    budget.maxNodes.reset();
+    m_interpreter.setBudget(budget);
+    EXPECT_EQ(m_interpreter.evaluateForked(*tree), m_interpreter.evaluateNumeric(*tree));
+    m_interpreter.setPool(nullptr);
+}
@@ -0,0 +1,364 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox Interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+#include "../src/incrementalParser.h"
+#include "../src/lexer.h"
+#include "../src/logger.h"
+#include "../src/parser.h"
+
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace lox;
+
+class TestIncrementalParser : public testing::Test
+{
+public:
+    // The parser logs at debug level as it goes, which for long sources takes longer than the parsing
+    void SetUp() override { Logger::setLevel(Logger::Info); }
+
+    void TearDown() override { Logger::setLevel(Logger::Debug); }
+
+protected:
+    static bool sameTree(const Expression* a, const Expression* b)
+    {
+        if (!a || !b)
+        {
+            return a == b;
+        }
+        if (auto* binA = dynamic_cast<const BinaryExpression*>(a))
+        {
+            auto* binB = dynamic_cast<const BinaryExpression*>(b);
+            return binB && binA->op == binB->op && sameTree(binA->left.get(), binB->left.get()) &&
+                   sameTree(binA->right.get(), binB->right.get());
+        }
+        if (auto* unA = dynamic_cast<const UnaryExpression*>(a))
+        {
+            auto* unB = dynamic_cast<const UnaryExpression*>(b);
+            return unB && unA->op == unB->op && sameTree(unA->right.get(), unB->right.get());
+        }
+        if (auto* groupA = dynamic_cast<const GroupingExpression*>(a))
+        {
+            auto* groupB = dynamic_cast<const GroupingExpression*>(b);
+            return groupB && sameTree(groupA->expression.get(), groupB->expression.get());
+        }
+        if (auto* logA = dynamic_cast<const LogicalExpression*>(a))
+        {
+            auto* logB = dynamic_cast<const LogicalExpression*>(b);
+            return logB && logA->op == logB->op && sameTree(logA->left.get(), logB->left.get()) &&
+                   sameTree(logA->right.get(), logB->right.get());
+        }
+        if (auto* condA = dynamic_cast<const ConditionalExpression*>(a))
+        {
+            auto* condB = dynamic_cast<const ConditionalExpression*>(b);
+            return condB && sameTree(condA->condition.get(), condB->condition.get()) &&
+                   sameTree(condA->thenBranch.get(), condB->thenBranch.get()) &&
+                   sameTree(condA->elseBranch.get(), condB->elseBranch.get());
+        }
+        if (auto* arrayA = dynamic_cast<const ArrayExpression*>(a))
+        {
+            auto* arrayB = dynamic_cast<const ArrayExpression*>(b);
+            if (!arrayB || arrayA->elements.size() != arrayB->elements.size() || arrayA->bracket != arrayB->bracket)
+            {
+                return false;
+            }
+            for (std::size_t i = 0; i < arrayA->elements.size(); ++i)
+            {
+                if (!sameTree(arrayA->elements[i].get(), arrayB->elements[i].get()))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+        if (auto* callA = dynamic_cast<const CallExpression*>(a))
+        {
+            auto* callB = dynamic_cast<const CallExpression*>(b);
+            return callB && callA->builtin == callB->builtin && callA->name == callB->name &&
+                   sameTree(callA->argument.get(), callB->argument.get());
+        }
+        if (auto* varA = dynamic_cast<const VariableExpression*>(a))
+        {
+            auto* varB = dynamic_cast<const VariableExpression*>(b);
+            return varB && varA->symbol == varB->symbol && varA->line == varB->line;
+        }
+        auto* litA = dynamic_cast<const LiteralExpression*>(a);
+        auto* litB = dynamic_cast<const LiteralExpression*>(b);
+        return litA && litB && litA->value == litB->value;
+    }
+
+    // The incremental state must match lexing and parsing the buffer from scratch
+    static void expectSameAsScratch(IncrementalParser& incremental)
+    {
+        // Symbols are numbered in the order names were first seen, which edits change, so compare them by name
+        SymbolTable symbols{};
+        auto source = incremental.source();
+        auto tokens = Lexer{ source, &symbols }.tokenize();
+        for (auto& tok : tokens)
+        {
+            if (auto* symbol = std::get_if<Symbol>(&tok.literal))
+            {
+                *symbol = incremental.symbols().find(symbols.name(*symbol)).value_or(Symbol{});
+            }
+        }
+        ASSERT_EQ(tokens, incremental.tokens()) << source;
+        auto tree = Parser{ tokens }.parse();
+        EXPECT_TRUE(sameTree(tree ? tree->get() : nullptr, incremental.tree())) << source;
+        if (tree && incremental.tree())
+        {
+            EXPECT_EQ(tree->get()->hash(), incremental.tree()->hash()) << source;
+            EXPECT_EQ(tree->get()->treeSize(), incremental.tree()->treeSize()) << source;
+        }
+    }
+
+    static std::string longSum(int terms)
+    {
+        std::string source = "0";
+        for (int i = 1; i < terms; ++i)
+        {
+            source += " + " + std::to_string(i % 10) + " * (" + std::to_string(i % 7) + " - 2)";
+        }
+        return source;
+    }
+};
+
+TEST_F(TestIncrementalParser, parsesInitialSource)
+{
+    IncrementalParser incremental{ "1 + 2 * 3" };
+
+    expectSameAsScratch(incremental);
+    ASSERT_NE(incremental.tree(), nullptr);
+}
+
+TEST_F(TestIncrementalParser, replacesLiteral)
+{
+    IncrementalParser incremental{ "1 + 2 * 3" };
+    auto* root = dynamic_cast<const BinaryExpression*>(incremental.tree());
+    ASSERT_NE(root, nullptr);
+    const auto* left = root->left.get();
+
+    incremental.edit({ 8, 1, "42" });
+
+    EXPECT_EQ(incremental.source(), "1 + 2 * 42");
+    expectSameAsScratch(incremental);
+    EXPECT_EQ(incremental.tree(), root);
+    EXPECT_EQ(root->left.get(), left);
+}
+
+TEST_F(TestIncrementalParser, editsChangingPrecedence)
+{
+    IncrementalParser incremental{ "1 * 2 + 3" };
+
+    incremental.edit({ 2, 1, "-" }); // 1 - 2 + 3
+    expectSameAsScratch(incremental);
+    incremental.edit({ 6, 1, "*" }); // 1 - 2 * 3
+    expectSameAsScratch(incremental);
+    incremental.edit({ 0, 0, "(" }); // (1 - 2 * 3
+    expectSameAsScratch(incremental);
+    EXPECT_EQ(incremental.tree(), nullptr);
+    incremental.edit({ 6, 0, ")" }); // (1 - 2) * 3
+    expectSameAsScratch(incremental);
+    ASSERT_NE(incremental.tree(), nullptr);
+}
+
+TEST_F(TestIncrementalParser, editsInsideStringsAndComments)
+{
+    IncrementalParser incremental{ "\"a\" + /* note */ \"b\" == \"ab\"" };
+
+    incremental.edit({ 10, 0, "*/ 1 + /*" });
+    expectSameAsScratch(incremental);
+    incremental.edit({ 1, 0, "\" + \"" });
+    expectSameAsScratch(incremental);
+    incremental.edit({ 0, 1, "" }); // Unbalances every string after it
+    expectSameAsScratch(incremental);
+}
+
+TEST_F(TestIncrementalParser, editsChangingLines)
+{
+    IncrementalParser incremental{ "1 +\n2 *\n3 - 4" };
+
+    incremental.edit({ 3, 0, "\n\n" });
+    expectSameAsScratch(incremental);
+    incremental.edit({ 0, 5, "" });
+    expectSameAsScratch(incremental);
+}
+
+TEST_F(TestIncrementalParser, identifiersKeepTheirSymbols)
+{
+    IncrementalParser incremental{ "alpha + beta * alpha" };
+    auto alpha = incremental.symbols().find("alpha").value();
+
+    incremental.edit({ 8, 4, "gamma" }); // alpha + gamma * alpha
+    expectSameAsScratch(incremental);
+    EXPECT_EQ(std::get<Symbol>(incremental.tokens().front().literal), alpha);
+    EXPECT_EQ(std::get<Symbol>(incremental.tokens().at(4).literal), alpha);
+
+    incremental.edit({ 0, 0, "\n" }); // Moves every variable a line down
+    expectSameAsScratch(incremental);
+}
+
+TEST_F(TestIncrementalParser, editsInsideBranches)
+{
+    IncrementalParser incremental{ "a or b ? 1 + 2 : c and d ? 3 : 4" };
+    auto* root = dynamic_cast<const ConditionalExpression*>(incremental.tree());
+    ASSERT_NE(root, nullptr);
+    const auto* condition = root->condition.get();
+
+    incremental.edit({ 13, 1, "5 * 6" }); // a or b ? 1 + 5 * 6 : c and d ? 3 : 4
+    expectSameAsScratch(incremental);
+    EXPECT_EQ(incremental.tree(), root);
+    EXPECT_EQ(root->condition.get(), condition);
+    EXPECT_LT(incremental.lastEditStats().reparsedTokens, 6u);
+
+    incremental.edit({ 23, 3, "or" }); // a or b ? 1 + 5 * 6 : c or d ? 3 : 4
+    expectSameAsScratch(incremental);
+    incremental.edit({ 7, 1, ":" }); // a or b : 1 + ...
+    expectSameAsScratch(incremental);
+    incremental.edit({ 7, 1, "?" });
+    expectSameAsScratch(incremental);
+    incremental.edit({ 4, 0, "\n" }); // Moves the rest a line down
+    expectSameAsScratch(incremental);
+}
+
+TEST_F(TestIncrementalParser, editsInsideArrays)
+{
+    IncrementalParser incremental{ "sum([1, 2 + 3, x]) * 2" };
+    ASSERT_NE(incremental.tree(), nullptr);
+
+    incremental.edit({ 12, 1, "4 * 5" }); // sum([1, 2 + 4 * 5, x]) * 2
+    expectSameAsScratch(incremental);
+    incremental.edit({ 20, 0, ", y" }); // sum([1, 2 + 4 * 5, x, y]) * 2
+    expectSameAsScratch(incremental);
+    incremental.edit({ 0, 3, "max" });
+    expectSameAsScratch(incremental);
+    incremental.edit({ 5, 18, "" }); // max([]) * 2
+    expectSameAsScratch(incremental);
+    incremental.edit({ 5, 0, "\n1" });
+    expectSameAsScratch(incremental);
+    incremental.edit({ 2, 1, "" }); // ma([ is no call
+    expectSameAsScratch(incremental);
+}
+
+TEST_F(TestIncrementalParser, editsDoNotKeepOldStrings)
+{
+    auto globalStrings = StringInterner::global().size();
+    IncrementalParser incremental{ "\"a string literal too long to be inline\" == nil" };
+    for (int i = 0; i < 50; ++i)
+    {
+        incremental.edit({ 1, 0, std::string(1, static_cast<char>('a' + i % 26)) });
+        EXPECT_LE(incremental.strings().size(), 1u);
+    }
+    EXPECT_EQ(StringInterner::global().size(), globalStrings);
+    expectSameAsScratch(incremental); // Parses with the global interner, so only once it was counted
+}
+
+TEST_F(TestIncrementalParser, singleCharacterEditIsLocal)
+{
+    IncrementalParser incremental{ longSum(5000) };
+    auto middle = incremental.source().find(" + ", incremental.source().size() / 2) + 3;
+
+    incremental.edit({ middle, 1, "7" });
+
+    expectSameAsScratch(incremental);
+    EXPECT_LT(incremental.lastEditStats().relexedTokens, 4u);
+    EXPECT_LT(incremental.lastEditStats().reparsedTokens, 4u);
+}
+
+TEST_F(TestIncrementalParser, randomEditsMatchScratch)
+{
+    const std::vector<std::string> snippets{ "1", "23", "+", "-", "*", "/", "==", "<=", "!", "(", ")", " ",
+                                             "\n", "\"", "\"s\"", "/*", "*/", "//", "true", "nil", ",", "x",
+                                             " and ", " or ", "?", ":", "[", "]", "sum(", "max" };
+    std::mt19937 rng{ 42 };
+    IncrementalParser incremental{ longSum(40) };
+    for (int i = 0; i < 400; ++i)
+    {
+        const auto& source = incremental.source();
+        auto offset = std::uniform_int_distribution<std::size_t>{ 0, source.size() }(rng);
+        auto removed =
+            std::uniform_int_distribution<std::size_t>{ 0, std::min<std::size_t>(3, source.size() - offset) }(rng);
+        const auto& inserted = snippets[std::uniform_int_distribution<std::size_t>{ 0, snippets.size() - 1 }(rng)];
+
+        incremental.edit({ offset, removed, inserted });
+        expectSameAsScratch(incremental);
+        if (HasFailure())
+        {
+            FAIL() << "edit " << i << " at " << offset << " removing " << removed << " inserting " << inserted;
+        }
+    }
+}
+
+TEST_F(TestIncrementalParser, editWorkDoesNotGrowWithBufferSize)
+{
+    auto editMiddle = [](int terms)
+    {
+        IncrementalParser incremental{ longSum(terms) };
+        auto middle = incremental.source().find(" + ", incremental.source().size() / 2) + 3;
+        incremental.edit({ middle, 1, "7" }); // Brings the gaps to the middle, as a first edit there would
+        const std::vector<Edit> edits{
+            { middle, 1, "8" },      // Literal replaced
+            { middle, 0, "1" },      // Literal grown
+            { middle, 1, "" },       // and shrunk back
+            { middle + 2, 1, "/" },  // Operator of the same precedence
+            { middle - 2, 1, "-" },  // Operator on the spine of the sum
+            { middle, 0, " " },      // Whitespace
+            { middle + 2, 0, "\n" }, // Line break
+        };
+        std::vector<IncrementalParser::Stats> stats;
+        for (const auto& edit : edits)
+        {
+            incremental.edit(edit);
+            stats.push_back(incremental.lastEditStats());
+        }
+        EXPECT_NE(incremental.tree(), nullptr);
+        return stats;
+    };
+
+    auto small = editMiddle(2000);
+    auto large = editMiddle(100000);
+    ASSERT_EQ(small.size(), large.size());
+    for (std::size_t i = 0; i < small.size(); ++i)
+    {
+        EXPECT_EQ(small[i].relexedTokens, large[i].relexedTokens) << "edit " << i;
+        EXPECT_EQ(small[i].reparsedTokens, large[i].reparsedTokens) << "edit " << i;
+        EXPECT_EQ(small[i].visitedNodes, large[i].visitedNodes) << "edit " << i;
+        EXPECT_EQ(small[i].movedTokens, large[i].movedTokens) << "edit " << i;
+    }
+}
+
+TEST_F(TestIncrementalParser, editsVeryLongSums)
+{
+    // Deep enough that recursing over the tree would overflow the stack
+    constexpr int terms = 200000;
+    IncrementalParser incremental{ longSum(terms) };
+    ASSERT_NE(incremental.tree(), nullptr);
+    auto size = incremental.tree()->treeSize();
+
+    incremental.edit({ incremental.source().size() / 2, 0, "\n" });
+    incremental.edit({ 0, 1, "(1 + 2)" });
+    ASSERT_NE(incremental.tree(), nullptr);
+    EXPECT_EQ(incremental.tree()->treeSize(), size + 3);
+
+    // Breaking the sum in the middle leaves no tree, fixing it brings it back
+    auto middle = incremental.source().find(" + ", incremental.source().size() / 2) + 3;
+    incremental.edit({ middle, 0, "* " });
+    EXPECT_EQ(incremental.tree(), nullptr);
+    incremental.edit({ middle, 2, "" });
+    ASSERT_NE(incremental.tree(), nullptr);
+    EXPECT_EQ(incremental.tree()->treeSize(), size + 3);
+}
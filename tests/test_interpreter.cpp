@@ -15,6 +15,8 @@
  ******************************************************************************/
 
 #include "../src/interpreter.h"
+#include "../src/lexer.h"
+#include "../src/parser.h"
 
 #include <experimental/source_location>
 #include <gtest/gtest.h>
@@ -41,6 +43,28 @@ protected:
         std::cin.rdbuf(inputRedirection->rdbuf());
     }
 
+    static lox::ExpressionUPTR parse(const std::string& source)
+    {
+        auto tree = lox::Parser{ lox::Lexer{ source }.tokenize() }.parse();
+        EXPECT_TRUE(tree.has_value()) << source;
+        return tree ? std::move(tree.value()) : nullptr;
+    }
+
+    // The limit an evaluation of `tree` went over, or nothing when it finished
+    static std::optional<lox::EvaluationBudget::Limit> exceededLimit(lox::Interpreter& interpreter,
+                                                                     const lox::Expression& tree)
+    {
+        try
+        {
+            interpreter.evaluateTree(tree);
+        }
+        catch (lox::Interpreter::BudgetExceededException& e)
+        {
+            return e.limit();
+        }
+        return std::nullopt;
+    }
+
     // Save original `cin` buffer
     std::streambuf* originalCin;
     const std::filesystem::path gtestFile{ std::experimental::source_location::current().file_name() };
@@ -63,10 +87,150 @@ TEST_F(TestInterpreter, localHelloWorldFile)
 
 TEST_F(TestInterpreter, stdinReading)
 {
-    std::string simulatedStdin = "Hello, World!\n";
+    std::string simulatedStdin = "\"Hello, World!\"\n";
     redirect_stdin(simulatedStdin);
 
     lox::Interpreter interpreter;
 
     EXPECT_EQ(interpreter.run(), EXIT_SUCCESS);
-}
\ No newline at end of file
+}
+TEST_F(TestInterpreter, globalsAreVisibleToEveryLine)
+{
+    redirect_stdin("answer * 2\n\"x\" == greeting\n");
+
+    lox::Interpreter interpreter;
+    interpreter.setGlobal("answer", 21.0);
+    interpreter.setGlobal("greeting", lox::LoxString{ "x" });
+
+    EXPECT_EQ(interpreter.run(), EXIT_SUCCESS);
+}
+
+TEST_F(TestInterpreter, undefinedVariableIsARuntimeError)
+{
+    redirect_stdin("1 + missing\n");
+
+    lox::Interpreter interpreter;
+    interpreter.setGlobal("defined", 1.0);
+
+    EXPECT_EQ(interpreter.run(), EXIT_FAILURE);
+}
+
+TEST_F(TestInterpreter, jitFallsBackToTheInterpreter)
+{
+    redirect_stdin("answer * 2 > 40\n\"a\" + \"b\"\nanswer + missing\n");
+
+    lox::Interpreter interpreter;
+    interpreter.setGlobal("answer", 21.0);
+    interpreter.setJit(true);
+
+    EXPECT_EQ(interpreter.run(), EXIT_FAILURE);
+}
+
+TEST_F(TestInterpreter, numericOnlyRejectsStrings)
+{
+    redirect_stdin("answer * 2 > 40 == !nil\n");
+    lox::Interpreter numeric;
+    numeric.setGlobal("answer", 21.0);
+    numeric.setNumericOnly(true);
+    EXPECT_EQ(numeric.run(), EXIT_SUCCESS);
+
+    redirect_stdin("answer * 2 > 40\n\"a\" == \"b\"\n");
+    lox::Interpreter strings;
+    strings.setGlobal("answer", 21.0);
+    strings.setNumericOnly(true);
+    EXPECT_EQ(strings.run(), EXIT_FAILURE);
+}
+
+TEST_F(TestInterpreter, logicalOperatorsReturnAnOperand)
+{
+    lox::Interpreter interpreter;
+    EXPECT_EQ(interpreter.evaluateTree(*parse("nil or \"some\"")), lox::LiteralValues{ lox::LoxString{ "some" } });
+    EXPECT_EQ(interpreter.evaluateTree(*parse("0 or 1")), lox::LiteralValues{ 0.0 });
+    EXPECT_EQ(interpreter.evaluateTree(*parse("false and 1")), lox::LiteralValues{ false });
+    EXPECT_EQ(interpreter.evaluateTree(*parse("1 and 2")), lox::LiteralValues{ 2.0 });
+    EXPECT_EQ(interpreter.evaluateTree(*parse("nil and 1 or 3")), lox::LiteralValues{ 3.0 });
+}
+
+TEST_F(TestInterpreter, skippedOperandsAreNotEvaluated)
+{
+    // Each of these would fail on the missing variable, or the operand types, if it was evaluated
+    lox::Interpreter interpreter;
+    interpreter.setGlobal("x", 4.0);
+    EXPECT_EQ(interpreter.evaluateTree(*parse("x > 3 or missing")), lox::LiteralValues{ true });
+    EXPECT_EQ(interpreter.evaluateTree(*parse("x < 3 and 1 + true")), lox::LiteralValues{ false });
+    EXPECT_EQ(interpreter.evaluateTree(*parse("x == 4 ? x * 2 : -\"a\"")), lox::LiteralValues{ 8.0 });
+    EXPECT_EQ(interpreter.evaluateTree(*parse("x != 4 ? missing : x - 1")), lox::LiteralValues{ 3.0 });
+
+    // Nor charged to the budget
+    auto tree = parse("x > 3 ? x : (1 + 2) * 3"); // Eleven nodes, five of them visited
+    lox::EvaluationBudget budget{};
+    budget.maxNodes = 5;
+    interpreter.setBudget(budget);
+    EXPECT_EQ(exceededLimit(interpreter, *tree), std::nullopt);
+}
+
+TEST_F(TestInterpreter, nodeBudgetCountsEveryVisit)
+{
+    auto tree = parse("(1 + 2) * -3"); // Seven nodes
+    lox::Interpreter interpreter;
+    lox::EvaluationBudget budget{};
+    budget.maxNodes = 7;
+    interpreter.setBudget(budget);
+
+    EXPECT_EQ(exceededLimit(interpreter, *tree), std::nullopt);
+    EXPECT_EQ(exceededLimit(interpreter, *tree), std::nullopt); // Every evaluation starts afresh
+
+    budget.maxNodes = 6;
+    interpreter.setBudget(budget);
+    EXPECT_EQ(exceededLimit(interpreter, *tree), lox::EvaluationBudget::Limit::Nodes);
+}
+
+TEST_F(TestInterpreter, stringBudgetStopsConcatenation)
+{
+    auto tree = parse("\"0123456789\" + \"0123456789\" + \"0123456789\"");
+    lox::Interpreter interpreter;
+    lox::EvaluationBudget budget{};
+    budget.maxStringSize = 30;
+    interpreter.setBudget(budget);
+
+    EXPECT_EQ(exceededLimit(interpreter, *tree), std::nullopt);
+
+    budget.maxStringSize = 29;
+    interpreter.setBudget(budget);
+    EXPECT_EQ(exceededLimit(interpreter, *tree), lox::EvaluationBudget::Limit::StringSize);
+}
+
+TEST_F(TestInterpreter, deadlineIsCheckedEveryFewVisits)
+{
+    std::string source = "0";
+    for (int i = 0; i < 100; ++i)
+    {
+        source += " + 1";
+    }
+    auto tree = parse(source);
+    lox::Interpreter interpreter;
+    lox::EvaluationBudget budget{};
+    budget.timeLimit = std::chrono::hours{ 1 };
+    budget.checkInterval = 8;
+    interpreter.setBudget(budget);
+
+    EXPECT_EQ(exceededLimit(interpreter, *tree), std::nullopt);
+
+    budget.timeLimit = std::chrono::nanoseconds{ 0 };
+    interpreter.setBudget(budget);
+    EXPECT_EQ(exceededLimit(interpreter, *tree), lox::EvaluationBudget::Limit::Time);
+}
+
+TEST_F(TestInterpreter, exceededBudgetFailsTheInputWithoutCachingIt)
+{
+    redirect_stdin("1 + 2 + 3\n");
+    lox::ResultCache cache{};
+    lox::Interpreter interpreter;
+    interpreter.setResultCache(&cache);
+    lox::EvaluationBudget budget{};
+    budget.maxNodes = 3;
+    interpreter.setBudget(budget);
+
+    EXPECT_EQ(interpreter.run(), EXIT_FAILURE);
+    EXPECT_EQ(cache.size(), 0u);
+}
@@ -0,0 +1,266 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox Interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+#include "../src/interpreter.h"
+#include "../src/jit.h"
+#include "../src/lexer.h"
+#include "../src/logger.h"
+#include "../src/parser.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+using namespace lox;
+
+class TestJit : public testing::Test
+{
+public:
+    void SetUp() override
+    {
+        Logger::setLevel(Logger::Info);
+        if (!JitFunction::supported())
+        {
+            GTEST_SKIP() << "The JIT does not support this machine.";
+        }
+        // Bound in the same order as they are interned, so the symbols of the parsed trees are the interpreter's
+        for (auto [name, value] : Globals)
+        {
+            m_symbols.intern(name);
+            m_interpreter.setGlobal(name, value);
+        }
+    }
+
+    void TearDown() override { Logger::setLevel(Logger::Debug); }
+
+protected:
+    using Global = std::pair<std::string_view, double>;
+    static constexpr Global Globals[] = { { "x", 3.0 }, { "y", -0.5 }, { "z", 0.0 } };
+
+    ExpressionUPTR parse(const std::string& source)
+    {
+        auto tree = Parser{ Lexer{ source, &m_symbols }.tokenize() }.parse();
+        EXPECT_TRUE(tree.has_value()) << source;
+        return tree ? std::move(tree.value()) : nullptr;
+    }
+
+    // Compiles `source` and runs it against the interpreter, which must agree to the bit, bar the payload of NaNs
+    void expectSameAsInterpreter(const std::string& source)
+    {
+        auto tree = parse(source);
+        ASSERT_NE(tree, nullptr);
+        auto function = JitFunction::compile(*tree);
+        ASSERT_TRUE(function.has_value()) << source;
+
+        std::vector<double> values{};
+        for (auto symbol : function->variables())
+        {
+            auto global = std::ranges::find(Globals, m_symbols.name(symbol), &Global::first);
+            values.push_back(global->second);
+        }
+        auto expected = m_interpreter.evaluateTree(*tree);
+        auto actual = function->call(values);
+        ASSERT_EQ(actual.index(), expected.index()) << source;
+        if (auto* number = std::get_if<double>(&expected))
+        {
+            auto compiled = std::get<double>(actual);
+            EXPECT_TRUE((std::isnan(*number) && std::isnan(compiled)) ||
+                        std::bit_cast<std::uint64_t>(*number) == std::bit_cast<std::uint64_t>(compiled))
+                << source << ": " << compiled << " instead of " << *number;
+        }
+        else
+        {
+            EXPECT_EQ(actual, expected) << source;
+        }
+    }
+
+    // A random expression whose value is a number, `depth` levels deep at most
+    std::string number(int depth)
+    {
+        static const char* const literals[] = { "0", "1", "2.5", "7", "0.1", "1000000" };
+        static const char* const variables[] = { "x", "y", "z" };
+        static const char* const operators[] = { " + ", " - ", " * ", " / " };
+        switch (pick(depth == 0 ? 1 : 4))
+        {
+        case 0:
+            return literals[pick(5)];
+        case 1:
+            return variables[pick(2)];
+        case 2:
+            return "-" + number(depth - 1);
+        default:
+            return "(" + number(depth - 1) + operators[pick(3)] + number(depth - 1) + ")";
+        }
+    }
+
+    // A random expression whose value is a boolean
+    std::string boolean(int depth)
+    {
+        static const char* const comparisons[] = { " < ", " <= ", " > ", " >= " };
+        static const char* const equalities[] = { " == ", " != " };
+        switch (pick(depth == 0 ? 0 : 3))
+        {
+        case 0:
+            return pick(1) ? "true" : "false";
+        case 1:
+            return "!" + any(depth - 1);
+        case 2:
+            return "(" + number(depth - 1) + comparisons[pick(3)] + number(depth - 1) + ")";
+        default:
+            return "(" + any(depth - 1) + equalities[pick(1)] + any(depth - 1) + ")";
+        }
+    }
+
+    std::string any(int depth) { return pick(1) ? number(depth) : boolean(depth); }
+
+    // Uniform in [0, max]
+    int pick(int max) { return std::uniform_int_distribution<int>{ 0, max }(m_random); }
+
+    SymbolTable m_symbols{};
+    Interpreter m_interpreter{};
+    std::mt19937 m_random{ 42 };
+};
+
+TEST_F(TestJit, matchesTheInterpreter)
+{
+    const std::string sources[] = {
+        "(1 + 2.5) * -3 - 4 / (5 + 6) >= 7 == !true",
+        "1 < 2 != (3 <= 4) == (5 > 6) == !false",
+        "-(-(-(2)))",
+        "x * x - y / z",           // Infinity
+        "z / z == z / z",          // NaN is not equal to itself
+        "z / z != z / z",          // But is different from it
+        "-z",                      // Negative zero
+        "1 == true",               // A number never equals a boolean
+        "!0",                      // Every number is truthy
+        "x - (y - (x - (y - x)))", // Right operands that need the stack
+    };
+    for (const auto& source : sources)
+    {
+        expectSameAsInterpreter(source);
+    }
+}
+
+TEST_F(TestJit, matchesTheInterpreterOnRandomTrees)
+{
+    for (int i = 0; i < 2000; ++i)
+    {
+        expectSameAsInterpreter(any(6));
+    }
+}
+
+TEST_F(TestJit, leavesOtherTreesToTheInterpreter)
+{
+    const std::string sources[] = {
+        "\"some\" + \"string\"",
+        "nil == 1",
+        "1 + true", // A runtime error
+        "-false",
+        "true < false",
+        "1 < 2 and 3", // Branches
+        "true ? 1 : 2",
+        "sum([1, 2])", // Arrays
+    };
+    for (const auto& source : sources)
+    {
+        auto tree = parse(source);
+        EXPECT_FALSE(JitFunction::compile(*tree).has_value()) << source;
+    }
+}
+
+TEST_F(TestJit, readsEveryVariableOnce)
+{
+    auto tree = parse("z + x * x + z");
+    auto function = JitFunction::compile(*tree);
+    ASSERT_TRUE(function.has_value());
+
+    ASSERT_EQ(function->variables().size(), 2u);
+    EXPECT_EQ(m_symbols.name(function->variables()[0]), "z");
+    EXPECT_EQ(m_symbols.name(function->variables()[1]), "x");
+    const double values[] = { 1.0, 4.0 };
+    EXPECT_EQ(function->call(values), LiteralValues{ 18.0 });
+    EXPECT_THROW(function->call({}), std::invalid_argument);
+}
+
+TEST_F(TestJit, runsOnTheGlobals)
+{
+    auto tree = parse("x * y - z");
+    auto function = JitFunction::compile(*tree);
+    ASSERT_TRUE(function.has_value());
+
+    EXPECT_EQ(m_interpreter.evaluateCompiled(*function, *tree), LiteralValues{ -1.5 });
+    m_interpreter.setGlobal("z", 1.5);
+    EXPECT_EQ(m_interpreter.evaluateCompiled(*function, *tree), LiteralValues{ -3.0 });
+}
+
+TEST_F(TestJit, fallsBackWhenAVariableIsNotANumber)
+{
+    auto tree = parse("x + 1");
+    auto function = JitFunction::compile(*tree);
+    ASSERT_TRUE(function.has_value());
+
+    m_interpreter.setGlobal("x", LoxString{ "text" });
+    EXPECT_THROW(m_interpreter.evaluateCompiled(*function, *tree), Interpreter::InterpreterException);
+}
+
+TEST_F(TestJit, fallsBackWhenTheTreeIsOverTheNodeBudget)
+{
+    auto tree = parse("(1 + 2) * -3"); // Seven nodes
+    auto function = JitFunction::compile(*tree);
+    ASSERT_TRUE(function.has_value());
+    EXPECT_EQ(function->nodes(), 7u);
+    EvaluationBudget budget{};
+    budget.maxNodes = 6;
+    m_interpreter.setBudget(budget);
+
+    EXPECT_THROW(m_interpreter.evaluateCompiled(*function, *tree), BudgetExceededException);
+
+    budget.maxNodes = 7;
+    m_interpreter.setBudget(budget);
+    EXPECT_EQ(m_interpreter.evaluateCompiled(*function, *tree), LiteralValues{ -9.0 });
+}
+
+TEST_F(TestJit, fallsBackToNumericOnlyEvaluation)
+{
+    auto tree = parse("x == x");
+    auto function = JitFunction::compile(*tree);
+    ASSERT_TRUE(function.has_value());
+    m_interpreter.setJit(true);
+    m_interpreter.setNumericOnly(true);
+
+    m_interpreter.setGlobal("x", LoxString{ "text" });
+    try
+    {
+        m_interpreter.evaluateCompiled(*function, *tree);
+        FAIL() << "A string variable must be rejected when numeric-only";
+    }
+    catch (Interpreter::InterpreterException& e)
+    {
+        EXPECT_NE(std::string{ e.what() }.find("variable x holds a string"), std::string::npos) << e.what();
+    }
+
+    // Over the node budget the tree is walked, with numeric-only values too, which reject x on the second node
+    EvaluationBudget budget{};
+    budget.maxNodes = 2;
+    m_interpreter.setBudget(budget);
+    EXPECT_THROW(m_interpreter.evaluateCompiled(*function, *tree), Interpreter::InterpreterException);
+}
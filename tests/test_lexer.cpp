@@ -16,8 +16,11 @@
 
 #include "../src/lexer.h"
 
+#include <charconv>
 #include <experimental/source_location>
 #include <gtest/gtest.h>
+#include <random>
+#include <string>
 #include <string_view>
 #include <vector>
 
@@ -117,3 +120,44 @@ TEST_F(TestLexer, tokenizeTwoStrings)
     ASSERT_EQ(output.at(0), expectedTokOne);
     ASSERT_EQ(output.at(2), expectedTokTwo);
 }
+
+TEST_F(TestLexer, tokenizeNumbersLikeFromChars)
+{
+    using enum lox::TokenType;
+    std::vector<std::string> literals{ "0",
+                                       "007",
+                                       "1.5",
+                                       "0.1",
+                                       "123456789012345",
+                                       "1234567890123456",
+                                       "9007199254740993",
+                                       "3.141592653589793238",
+                                       "0.000000000000000000001" };
+    std::mt19937_64 rng{ 7 };
+    for (int i = 0; i < 1000; ++i)
+    {
+        auto integer = std::to_string(rng() >> (rng() % 64));
+        literals.emplace_back(i % 2 ? integer : integer + "." + std::to_string(rng() % 1000000));
+    }
+
+    for (const auto& literal : literals)
+    {
+        double expected = 0;
+        std::from_chars(literal.data(), literal.data() + literal.size(), expected);
+        auto output = lox::Lexer{ literal }.tokenize();
+        ASSERT_EQ(output.size(), 2) << literal;
+        EXPECT_EQ(output.at(0), (lox::Token{ Number, expected, "", 1 })) << literal;
+    }
+}
+
+TEST_F(TestLexer, tokenizeNumberOutOfRange)
+{
+    using enum lox::TokenType;
+    auto huge = "1" + std::string(400, '0');
+
+    auto output = lox::Lexer{ huge + " + 1" }.tokenize();
+
+    ASSERT_EQ(output.size(), 4);
+    EXPECT_EQ(output.at(0).type, Error);
+    EXPECT_EQ(output.at(2), (lox::Token{ Number, 1.0, "", 1 }));
+}
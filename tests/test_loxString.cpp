@@ -0,0 +1,200 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox Interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+#include "../src/allocStats.h"
+#include "../src/interpreter.h"
+#include "../src/lexer.h"
+#include "../src/loxString.h"
+#include "../src/parser.h"
+
+#include <gtest/gtest.h>
+#include <string>
+
+using namespace lox;
+
+class TestLoxString : public testing::Test
+{
+public:
+    void SetUp() override {}
+
+    void TearDown() override {}
+
+protected:
+    const std::string m_long = "a string too long to be stored inline";
+};
+
+TEST_F(TestLoxString, shortStringsAreInline)
+{
+    auto before = AllocStats::total();
+    LoxString empty{};
+    LoxString text{ "fifteen chars!!" };
+    auto copy = text;
+    auto used = AllocStats::total() - before;
+
+    EXPECT_EQ(used.allocations, 0u);
+    EXPECT_TRUE(text.isInline());
+    EXPECT_EQ(copy.view(), "fifteen chars!!");
+    EXPECT_EQ(empty.view(), "");
+    EXPECT_EQ(sizeof(LoxString), 16u);
+}
+
+TEST_F(TestLoxString, copiesShareTheirBuffer)
+{
+    LoxString text{ m_long };
+    auto before = AllocStats::total();
+    auto copy = text;
+    auto moved = std::move(copy);
+    auto used = AllocStats::total() - before;
+
+    EXPECT_FALSE(text.isInline());
+    EXPECT_EQ(used.allocations, 0u);
+    EXPECT_EQ(moved.view().data(), text.view().data());
+    EXPECT_EQ(moved, text);
+}
+
+TEST_F(TestLoxString, equalityComparesContent)
+{
+    EXPECT_EQ(LoxString{ m_long }, LoxString{ m_long });
+    EXPECT_NE(LoxString{ m_long }, LoxString{ m_long + "!" });
+    EXPECT_EQ(LoxString{ "short" }, LoxString{ "short" });
+    EXPECT_NE(LoxString{ "short" }, LoxString{ "shorter" });
+    EXPECT_EQ(LoxString{ m_long }.hash(), std::hash<std::string_view>{}(m_long));
+}
+
+TEST_F(TestLoxString, internedStringsAreUnique)
+{
+    StringInterner interner{};
+    auto a = interner.intern(m_long);
+    auto b = interner.intern(std::string{ m_long });
+    auto c = interner.intern(m_long + "?");
+
+    EXPECT_TRUE(a.isInterned());
+    EXPECT_EQ(a.view().data(), b.view().data());
+    EXPECT_EQ(a, b);
+    EXPECT_NE(a, c);
+    EXPECT_EQ(interner.size(), 2u);
+    EXPECT_FALSE(interner.intern("tiny").isInterned());
+    EXPECT_EQ(interner.size(), 2u);
+}
+
+TEST_F(TestLoxString, interningSurvivesClear)
+{
+    StringInterner interner{};
+    auto before = interner.intern(m_long);
+    interner.clear();
+    auto after = interner.intern(m_long);
+
+    EXPECT_EQ(interner.size(), 1u);
+    EXPECT_NE(before.view().data(), after.view().data());
+    EXPECT_EQ(before, after);
+    EXPECT_EQ(before.view(), m_long);
+}
+
+TEST_F(TestLoxString, concatenates)
+{
+    auto shortPair = LoxString{ "abc" } + LoxString{ "def" };
+    auto longPair = LoxString{ m_long } + LoxString{ "def" };
+
+    EXPECT_TRUE(shortPair.isInline());
+    EXPECT_EQ(shortPair.view(), "abcdef");
+    EXPECT_EQ(longPair.view(), m_long + "def");
+    EXPECT_EQ(longPair, LoxString{ m_long + "def" });
+}
+
+TEST_F(TestLoxString, interpreterUsesInternedLiterals)
+{
+    auto expr = Parser{ Lexer{ "\"" + m_long + "\" == \"" + m_long + "\"" }.tokenize() }.parse();
+    ASSERT_TRUE(expr);
+    auto* binary = dynamic_cast<const BinaryExpression*>(expr.value().get());
+    ASSERT_NE(binary, nullptr);
+    auto& left = std::get<LoxString>(dynamic_cast<const LiteralExpression&>(*binary->left).value);
+    auto& right = std::get<LoxString>(dynamic_cast<const LiteralExpression&>(*binary->right).value);
+    EXPECT_EQ(left.view().data(), right.view().data());
+
+    Interpreter interpreter{};
+    auto before = AllocStats::total();
+    auto value = interpreter.evaluateTree(*expr.value());
+    auto used = AllocStats::total() - before;
+
+    EXPECT_EQ(value, LiteralValues{ true });
+    EXPECT_EQ(used.allocations, 0u);
+}
+
+TEST_F(TestLoxString, longConcatenationsAreRopes)
+{
+    LoxString a{ std::string(200, 'a') };
+    LoxString b{ std::string(200, 'b') };
+
+    auto before = AllocStats::total();
+    auto rope = a + b;
+    auto used = AllocStats::total() - before;
+
+    EXPECT_EQ(used.allocations, 1u); // The node, nothing is copied
+    EXPECT_TRUE(rope.isRope());
+    EXPECT_EQ(rope.size(), 400u);
+    EXPECT_EQ(rope, LoxString{ std::string(200, 'a') + std::string(200, 'b') });
+    EXPECT_FALSE(rope.isRope());
+    EXPECT_EQ(rope.hash(), std::hash<std::string_view>{}(std::string(200, 'a') + std::string(200, 'b')));
+}
+
+TEST_F(TestLoxString, ropesOfDifferentSizesAreUnequalWithoutFlattening)
+{
+    LoxString a{ std::string(300, 'a') };
+    auto longer = a + a;
+    auto shorter = a + LoxString{ "!" };
+
+    EXPECT_NE(longer, shorter);
+    EXPECT_TRUE(longer.isRope());
+    EXPECT_TRUE(shorter.isRope());
+}
+
+TEST_F(TestLoxString, deepRopesFlattenAndDieWithoutRecursion)
+{
+    const std::string piece = "0123456789abcdefghij";
+    std::string expected{};
+    LoxString chain{};
+    for (int i = 0; i < 200000; ++i)
+    {
+        chain = chain + LoxString{ piece };
+        expected += piece;
+    }
+    auto copy = chain;
+
+    EXPECT_EQ(chain.view(), expected);
+    EXPECT_EQ(copy.view().data(), chain.view().data());
+}
+
+TEST_F(TestLoxString, interpreterConcatenatesChainsAsRopes)
+{
+    Logger::setLevel(Logger::Error);
+    std::string source = "\"start\"";
+    std::string expected = "start";
+    for (int i = 0; i < 2000; ++i)
+    {
+        source += " + \"some text to add\"";
+        expected += "some text to add";
+    }
+    auto expr = Parser{ Lexer{ source }.tokenize() }.parse();
+    Logger::setLevel(Logger::Debug);
+    ASSERT_TRUE(expr);
+
+    Interpreter interpreter{};
+    auto value = interpreter.evaluateTree(*expr.value());
+
+    ASSERT_TRUE(std::holds_alternative<LoxString>(value));
+    EXPECT_TRUE(std::get<LoxString>(value).isRope());
+    EXPECT_EQ(print(value), expected);
+}
@@ -0,0 +1,188 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox Interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+
+#include "../src/allocStats.h"
+#include "../src/arrayKernels.h"
+#include "../src/logger.h"
+#include "../src/numberArray.h"
+
+#include <cmath>
+#include <gtest/gtest.h>
+#include <limits>
+#include <sstream>
+#include <vector>
+
+using namespace lox;
+
+static_assert(sizeof(NumberArray) == sizeof(void*));
+
+class TestNumberArray : public testing::Test
+{
+public:
+    void SetUp() override { Logger::setLevel(Logger::Info); }
+
+    void TearDown() override { Logger::setLevel(Logger::Debug); }
+
+protected:
+    // 0, 1, ... `size` - 1, shifted and scaled so both operands differ everywhere
+    static std::vector<double> sequence(std::size_t size, double scale, double shift)
+    {
+        std::vector<double> elements(size);
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            elements[i] = static_cast<double>(i) * scale + shift;
+        }
+        return elements;
+    }
+
+    // Sizes around the width of the lanes, so every kernel runs with and without a scalar tail
+    static constexpr std::size_t Sizes[] = { 0, 1, 3, 4, 5, 7, 8, 9, 16, 17, 33 };
+};
+
+TEST_F(TestNumberArray, copiesShareTheirElements)
+{
+    NumberArray array{ sequence(5, 1, 0) };
+    auto before = AllocStats::total();
+    auto copy = array;
+    auto moved = std::move(copy);
+    auto used = AllocStats::total() - before;
+
+    EXPECT_EQ(used.allocations, 0u);
+    EXPECT_EQ(moved.data(), array.data());
+    EXPECT_EQ(moved, array);
+}
+
+TEST_F(TestNumberArray, emptyArraysHaveNoBuffer)
+{
+    auto before = AllocStats::total();
+    NumberArray empty{ std::vector<double>{} };
+    auto used = AllocStats::total() - before;
+
+    EXPECT_EQ(used.allocations, 0u);
+    EXPECT_EQ(empty.size(), 0u);
+    EXPECT_EQ(empty, NumberArray{});
+    EXPECT_EQ(empty.sum(), 0.0);
+}
+
+TEST_F(TestNumberArray, equalityComparesElements)
+{
+    EXPECT_EQ(NumberArray{ sequence(9, 2, 1) }, NumberArray{ sequence(9, 2, 1) });
+    EXPECT_NE(NumberArray{ sequence(9, 2, 1) }, NumberArray{ sequence(8, 2, 1) });
+    EXPECT_NE(NumberArray{ sequence(9, 2, 1) }, NumberArray{ sequence(9, 2, 0) });
+    NumberArray nan{ std::vector<double>{ 1, std::nan("") } };
+    EXPECT_NE(nan, nan);
+    EXPECT_EQ(NumberArray{ sequence(9, 2, 1) }.hash(), NumberArray{ sequence(9, 2, 1) }.hash());
+}
+
+TEST_F(TestNumberArray, printsItsElements)
+{
+    std::ostringstream out{};
+    out << NumberArray{ std::vector<double>{ 1, 2.5, -3 } } << NumberArray{};
+    EXPECT_EQ(out.str(), "[1, 2.5, -3][]");
+}
+
+TEST_F(TestNumberArray, operatorsMatchTheScalarOnes)
+{
+    using enum TokenType;
+    const std::pair<TokenType, double (*)(double, double)> operators[] = {
+        { Plus, [](double a, double b) { return a + b; } },
+        { Minus, [](double a, double b) { return a - b; } },
+        { Star, [](double a, double b) { return a * b; } },
+        { Slash, [](double a, double b) { return a / b; } },
+        { Greater, [](double a, double b) { return a > b ? 1.0 : 0.0; } },
+        { GreaterEqual, [](double a, double b) { return a >= b ? 1.0 : 0.0; } },
+        { Less, [](double a, double b) { return a < b ? 1.0 : 0.0; } },
+        { LessEqual, [](double a, double b) { return a <= b ? 1.0 : 0.0; } },
+    };
+    for (auto size : Sizes)
+    {
+        NumberArray a{ sequence(size, 1.5, -4) };
+        NumberArray b{ sequence(size, -0.5, 3) };
+        for (auto [op, scalar] : operators)
+        {
+            auto both = elementWise(op, a, b);
+            auto right = elementWise(op, a, 2.0);
+            auto left = elementWise(op, 2.0, b);
+            ASSERT_EQ(both.size(), size);
+            ASSERT_EQ(right.size(), size);
+            ASSERT_EQ(left.size(), size);
+            for (std::size_t i = 0; i < size; ++i)
+            {
+                EXPECT_EQ(both[i], scalar(a[i], b[i])) << tokenTypeToString(op) << " at " << i << " of " << size;
+                EXPECT_EQ(right[i], scalar(a[i], 2.0)) << tokenTypeToString(op) << " at " << i << " of " << size;
+                EXPECT_EQ(left[i], scalar(2.0, b[i])) << tokenTypeToString(op) << " at " << i << " of " << size;
+            }
+        }
+    }
+}
+
+TEST_F(TestNumberArray, unaryOperatorsMatchTheScalarOnes)
+{
+    for (auto size : Sizes)
+    {
+        NumberArray a{ sequence(size, 1, -2) };
+        auto negated = elementWise(TokenType::Minus, a);
+        auto flipped = elementWise(TokenType::Bang, a);
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            EXPECT_EQ(negated[i], -a[i]) << i << " of " << size;
+            EXPECT_EQ(flipped[i], a[i] == 0 ? 1.0 : 0.0) << i << " of " << size;
+        }
+    }
+}
+
+TEST_F(TestNumberArray, reductionsMatchTheScalarOnes)
+{
+    for (auto size : Sizes)
+    {
+        if (!size)
+        {
+            continue;
+        }
+        // Whole numbers, so the sum is exact in any order
+        auto elements = sequence(size, 3, -7);
+        std::swap(elements.front(), elements[size / 2]);
+        NumberArray array{ elements };
+        double sum = 0;
+        double min = elements.front();
+        double max = elements.front();
+        for (auto element : elements)
+        {
+            sum += element;
+            min = std::min(min, element);
+            max = std::max(max, element);
+        }
+        EXPECT_EQ(array.sum(), sum) << size;
+        EXPECT_EQ(array.min(), min) << size;
+        EXPECT_EQ(array.max(), max) << size;
+    }
+}
+
+TEST_F(TestNumberArray, minAndMaxPropagateNaN)
+{
+    for (auto size : Sizes)
+    {
+        for (std::size_t at = 0; at < size; ++at)
+        {
+            auto elements = sequence(size, 1, 0);
+            elements[at] = std::numeric_limits<double>::quiet_NaN();
+            NumberArray array{ elements };
+            EXPECT_TRUE(std::isnan(array.min())) << at << " of " << size;
+            EXPECT_TRUE(std::isnan(array.max())) << at << " of " << size;
+        }
+    }
+}
@@ -0,0 +1,137 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox Interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+#include "../src/lexer.h"
+#include "../src/logger.h"
+#include "../src/parallelLexer.h"
+
+#include <gtest/gtest.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class TestParallelLexer : public testing::Test
+{
+public:
+    void SetUp() override {}
+
+    void TearDown() override {}
+
+protected:
+    // Lexes the source with every chunk size up to maxChunkSize, all of them must match the sequential lexer
+    void expectSameAsSequential(std::string_view source, std::size_t maxChunkSize)
+    {
+        auto expected = lox::Lexer{ source }.tokenize();
+        for (std::size_t chunkSize = 1; chunkSize <= maxChunkSize; ++chunkSize)
+        {
+            auto threads = static_cast<unsigned int>(source.size() / chunkSize + 1);
+            auto output = lox::ParallelLexer{ source, threads, chunkSize }.tokenize();
+            ASSERT_EQ(expected.size(), output.size()) << "chunk size " << chunkSize;
+            for (std::size_t i = 0; i < output.size(); ++i)
+            {
+                EXPECT_EQ(expected[i], output[i]) << "chunk size " << chunkSize << ", token " << i;
+            }
+        }
+    }
+};
+
+TEST_F(TestParallelLexer, smallSourceFallsBackToSequential)
+{
+    using enum lox::TokenType;
+    lox::ParallelLexer lex("1 + 2");
+
+    auto output = lex.tokenize();
+    ASSERT_EQ(output.size(), 4);
+    EXPECT_EQ(output.at(1).type, Plus);
+    EXPECT_EQ(output.at(3).type, Eof);
+}
+
+TEST_F(TestParallelLexer, emptySource)
+{
+    lox::ParallelLexer lex("", 4, 1);
+
+    auto output = lex.tokenize();
+    ASSERT_EQ(output.size(), 1);
+    EXPECT_EQ(output.at(0), lox::Lexer{ "" }.tokenize().at(0));
+}
+
+TEST_F(TestParallelLexer, plainExpressions)
+{
+    expectSameAsSequential("(1 + 2.5) * 3 >= 4 / 5 != !true == nil and foo or bar_2\nclass fun;\n\t42 - -1", 16);
+}
+
+TEST_F(TestParallelLexer, stringsAcrossChunks)
+{
+    expectSameAsSequential(
+        "\"a + b\" + \"multi\nline\nstring // not a comment /* nor this */\" + \"\" + \"x\"\n1 \"tail\"", 24);
+}
+
+TEST_F(TestParallelLexer, commentsAcrossChunks)
+{
+    expectSameAsSequential(
+        "1 // comment with a \"quote\n2 /* block \"with\" a\n quote and // slashes\n*/ 3 /**/ 4 /* a/b * c */ 5\n"
+        "// trailing \"",
+        24);
+}
+
+TEST_F(TestParallelLexer, unterminatedConstructs)
+{
+    expectSameAsSequential("1 + \"never closed\n 2 + 3", 12);
+    expectSameAsSequential("1 + /* never closed\n \" 2 + 3", 12);
+}
+
+TEST_F(TestParallelLexer, unexpectedCharacters)
+{
+    expectSameAsSequential("1 @ 2 # \"@\" $ 3", 8);
+}
+
+TEST_F(TestParallelLexer, logsTheSameErrorsAsSequential)
+{
+    const std::string source = "1 + " + std::string(400, '9') + "\n@ 2 + \"never closed\n";
+    lox::Logger::setLevel(lox::Logger::Error);
+    testing::internal::CaptureStdout();
+    auto expected = lox::Lexer{ source }.tokenize();
+    auto expectedLog = testing::internal::GetCapturedStdout();
+    ASSERT_NE(expectedLog.find("Number literal out of range"), std::string::npos);
+    ASSERT_NE(expectedLog.find("Unexpected character"), std::string::npos);
+
+    for (std::size_t chunkSize : { 1u, 3u, 64u, 200u })
+    {
+        auto threads = static_cast<unsigned int>(source.size() / chunkSize + 1);
+        testing::internal::CaptureStdout();
+        auto output = lox::ParallelLexer{ source, threads, chunkSize }.tokenize();
+        auto log = testing::internal::GetCapturedStdout();
+        EXPECT_EQ(expected, output) << "chunk size " << chunkSize;
+        EXPECT_EQ(expectedLog, log) << "chunk size " << chunkSize;
+    }
+    lox::Logger::setLevel(lox::Logger::Debug);
+}
+
+TEST_F(TestParallelLexer, largeSource)
+{
+    std::string source{};
+    for (int i = 0; i < 2000; ++i)
+    {
+        source += "(" + std::to_string(i) + " + \"str\ning " + std::to_string(i) + "\") /* c\n*/ * x" +
+                  std::to_string(i % 7) + " // tail \"\n";
+    }
+    auto expected = lox::Lexer{ source }.tokenize();
+    for (unsigned int threads : { 2u, 3u, 8u, 32u })
+    {
+        auto output = lox::ParallelLexer{ source, threads, 1024 }.tokenize();
+        EXPECT_EQ(expected, output) << threads << " threads";
+    }
+}
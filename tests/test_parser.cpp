@@ -15,6 +15,7 @@
  ******************************************************************************/
 
 #include "../src/AstPrinter.hpp"
+#include "../src/lexer.h"
 #include "../src/parser.h"
 
 #include <experimental/source_location>
@@ -48,3 +49,70 @@ TEST_F(TestParser, parseTokenExpression)
     // printer.print(expressionPtr);
     // FAIL();
 }
+
+TEST_F(TestParser, logicalOperatorsBindLooserThanEquality)
+{
+    auto tree = Parser{ Lexer{ "a == 1 or b and c != 2" }.tokenize() }.parse();
+    ASSERT_TRUE(tree.has_value());
+    ASSERT_EQ(tree.value()->kind(), Expression::Kind::Logical);
+    const auto& orExpr = static_cast<const LogicalExpression&>(*tree.value());
+    EXPECT_EQ(orExpr.op.type, TokenType::Or);
+    EXPECT_EQ(orExpr.left->kind(), Expression::Kind::Binary);
+    ASSERT_EQ(orExpr.right->kind(), Expression::Kind::Logical);
+    const auto& andExpr = static_cast<const LogicalExpression&>(*orExpr.right);
+    EXPECT_EQ(andExpr.op.type, TokenType::And);
+    EXPECT_EQ(andExpr.right->kind(), Expression::Kind::Binary);
+}
+
+TEST_F(TestParser, conditionalNestsToTheRight)
+{
+    auto tree = Parser{ Lexer{ "a ? b, 1 : c ? 2 : 3, 4" }.tokenize() }.parse();
+    ASSERT_TRUE(tree.has_value());
+    // The comma binds loosest, except between "?" and ":"
+    ASSERT_EQ(tree.value()->kind(), Expression::Kind::Binary);
+    const auto& comma = static_cast<const BinaryExpression&>(*tree.value());
+    ASSERT_EQ(comma.left->kind(), Expression::Kind::Conditional);
+    const auto& conditional = static_cast<const ConditionalExpression&>(*comma.left);
+    EXPECT_EQ(conditional.condition->kind(), Expression::Kind::Variable);
+    EXPECT_EQ(conditional.thenBranch->kind(), Expression::Kind::Binary);
+    EXPECT_EQ(conditional.elseBranch->kind(), Expression::Kind::Conditional);
+}
+
+TEST_F(TestParser, conditionalNeedsBothBranches)
+{
+    for (std::string_view source : { "a ? 1", "a ? : 2", "a ? 1 : ", "a : 1" })
+    {
+        Lexer lexer{ source };
+        Parser parser{ lexer.tokenize() };
+        EXPECT_FALSE(parser.parse(Parser::Rule::Expression).has_value()) << source;
+    }
+}
+
+TEST_F(TestParser, arraysAndCalls)
+{
+    auto tree = Parser{ Lexer{ "sum([1, a ? 2 : 3, []]) + b" }.tokenize() }.parse(Parser::Rule::Expression);
+    ASSERT_TRUE(tree.has_value());
+    ASSERT_EQ(tree.value()->kind(), Expression::Kind::Binary);
+    const auto& plus = static_cast<const BinaryExpression&>(*tree.value());
+    ASSERT_EQ(plus.left->kind(), Expression::Kind::Call);
+    const auto& call = static_cast<const CallExpression&>(*plus.left);
+    EXPECT_EQ(call.builtin, CallExpression::Builtin::Sum);
+    ASSERT_EQ(call.argument->kind(), Expression::Kind::Array);
+    const auto& array = static_cast<const ArrayExpression&>(*call.argument);
+    ASSERT_EQ(array.elements.size(), 3u);
+    EXPECT_EQ(array.elements[1]->kind(), Expression::Kind::Conditional);
+    ASSERT_EQ(array.elements[2]->kind(), Expression::Kind::Array);
+    EXPECT_TRUE(static_cast<const ArrayExpression&>(*array.elements[2]).elements.empty());
+    // Without parentheses, the names are only variables
+    EXPECT_EQ(Parser{ Lexer{ "min" }.tokenize() }.parse().value()->kind(), Expression::Kind::Variable);
+}
+
+TEST_F(TestParser, arraysAndCallsNeedTheirBrackets)
+{
+    for (std::string_view source : { "[1, 2", "[1 2]", "[1,]", "sum([1)", "sum(1, 2)", "sum()", "avg([1])", "sum[1]" })
+    {
+        Lexer lexer{ source };
+        Parser parser{ lexer.tokenize() };
+        EXPECT_FALSE(parser.parse(Parser::Rule::Expression).has_value()) << source;
+    }
+}
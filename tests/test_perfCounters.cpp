@@ -0,0 +1,79 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox Interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+#include "../src/lexer.h"
+#include "../src/perfCounters.h"
+#include "../src/tracer.h"
+
+#include <gtest/gtest.h>
+
+using namespace lox;
+
+class TestPerfCounters : public testing::Test
+{
+public:
+    void SetUp() override { PerfCounters::reset(); }
+
+    void TearDown() override
+    {
+        PerfCounters::disable();
+        PerfCounters::reset();
+    }
+};
+
+TEST_F(TestPerfCounters, enableMatchesAvailability)
+{
+    // Either way works, as long as the two agree
+    EXPECT_EQ(PerfCounters::enable(), PerfCounters::read().has_value());
+}
+
+TEST_F(TestPerfCounters, phasesAreNotCountedWhenDisabled)
+{
+    {
+        PhaseScope phase{ Phase::Lex };
+        Lexer{ "1 + 2" }.tokenize();
+    }
+
+    EXPECT_EQ(PerfCounters::phase(Phase::Lex).instructions, 0u);
+}
+
+TEST_F(TestPerfCounters, countsPhaseScopes)
+{
+    if (!PerfCounters::enable())
+    {
+        GTEST_SKIP() << "Hardware counters are not available";
+    }
+    {
+        PhaseScope phase{ Phase::Lex };
+        PhaseScope nested{ Phase::Lex }; // Counted once
+        Lexer{ "1 + 2 * (3 - \"four\")" }.tokenize();
+    }
+
+    auto counts = PerfCounters::phase(Phase::Lex);
+    EXPECT_GT(counts.instructions, 0u);
+    EXPECT_EQ(PerfCounters::phase(Phase::Parse).instructions, 0u);
+}
+
+TEST_F(TestPerfCounters, ratiosOfMissingCountersAreZero)
+{
+    PerfCounts counts{};
+    counts.instructions = 10;
+
+    EXPECT_EQ(counts.instructionsPerCycle(), 0.0);
+    EXPECT_EQ(counts.branchMissRate(), 0.0);
+    counts.cycles = 5;
+    EXPECT_EQ(counts.instructionsPerCycle(), 2.0);
+}
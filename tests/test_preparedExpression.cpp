@@ -0,0 +1,219 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox Interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+
+#include "../src/allocStats.h"
+#include "../src/interpreter.h"
+#include "../src/lexer.h"
+#include "../src/logger.h"
+#include "../src/parser.h"
+#include "../src/preparedExpression.h"
+
+#include <gtest/gtest.h>
+#include <new>
+#include <optional>
+#include <string>
+#include <variant>
+#include <vector>
+
+using namespace lox;
+
+class TestPreparedExpression : public testing::Test
+{
+public:
+    void SetUp() override { Logger::setLevel(Logger::Info); }
+
+    void TearDown() override { Logger::setLevel(Logger::Debug); }
+
+protected:
+    // The trees read x, y, flag, name and values, bound in that order so their Symbols match the interpreter's
+    void bind(Interpreter& interpreter)
+    {
+        interpreter.setGlobal("x", 3.0);
+        interpreter.setGlobal("y", -0.5);
+        interpreter.setGlobal("flag", true);
+        interpreter.setGlobal("name", LoxString{ "lox" });
+        interpreter.setGlobal("values", NumberArray{ std::vector<double>{ 1, 2 } });
+        for (auto name : { "x", "y", "flag", "name", "values" })
+        {
+            m_symbols.intern(name);
+        }
+    }
+
+    ExpressionUPTR parse(std::string_view source)
+    {
+        auto tree = Parser{ Lexer{ source, &m_symbols }.tokenize() }.parse();
+        EXPECT_TRUE(tree.has_value()) << source;
+        return std::move(tree.value());
+    }
+
+    // The value of the prepared tree, or the message of its error, evaluated where every allocation fails
+    std::variant<LiteralValues, std::string> outcome(PreparedExpression& prepared, const Globals& globals)
+    {
+        EvaluationError error{};
+        std::optional<NumericValue> value{};
+        std::uint64_t failed = 0;
+        {
+            FailingAllocations noHeap{};
+            value = prepared.evaluate(globals, error);
+            failed = noHeap.failed();
+        }
+        EXPECT_EQ(failed, 0u);
+        EXPECT_EQ(value.has_value(), !error);
+        if (!value)
+        {
+            return std::string{ error.exception(m_symbols).what() };
+        }
+        return NumericOnly::toLiteral(value.value());
+    }
+
+    SymbolTable m_symbols;
+};
+
+TEST_F(TestPreparedExpression, matchesNumericOnlyEvaluation)
+{
+    Interpreter interpreter{};
+    bind(interpreter);
+    Globals globals{ 3.0, -0.5, true, LoxString{ "lox" }, NumberArray{ std::vector<double>{ 1, 2 } } };
+    const char* sources[] = {
+        "(x + 2.5) * -y - 4 / (x + 6) >= 7 == !nil",
+        "x / 0 == x / 0",
+        "(0 / 0) != (0 / 0)",
+        "flag == true != (nil == false)",
+        "!flag == !!nil",
+        "x + y * x - y / x <= x",
+        "1, flag",
+        "nil",
+        "nil or x and y",
+        "flag and nil or 2",
+        "x < 2 ? missing : y > 0 ? 1 : x * 2",
+        "(x ? nil : 1) == (false or (true ? nil : 2))",
+        "flag + 1",
+        "x > nil",
+        "(x < 4 ? nil : 1) * 2",
+        "x + name",
+        "values == values",
+        "y or missing", // The interpreter does not know the name, so it must not be read
+    };
+    for (const char* source : sources)
+    {
+        auto tree = parse(source);
+        auto prepared = PreparedExpression::prepare(*tree);
+        ASSERT_TRUE(prepared.has_value()) << source;
+
+        std::variant<LiteralValues, std::string> expected{};
+        try
+        {
+            expected = interpreter.evaluateNumeric(*tree);
+        }
+        catch (Interpreter::InterpreterException& e)
+        {
+            expected = std::string{ e.what() };
+        }
+        EXPECT_EQ(outcome(*prepared, globals), expected) << source;
+    }
+}
+
+TEST_F(TestPreparedExpression, reportsErrorsInTheirSlot)
+{
+    Interpreter interpreter{};
+    bind(interpreter);
+    Globals globals{ 3.0, -0.5, true, LoxString{ "lox" }, NumberArray{ std::vector<double>{ 1, 2 } } };
+    const std::pair<const char*, EvaluationError::Kind> errors[] = {
+        { "x + nil", EvaluationError::Kind::Addition },
+        { "x * flag", EvaluationError::Kind::Operands },
+        { "-flag", EvaluationError::Kind::Negation },
+        { "x - name", EvaluationError::Kind::StringVariable },
+        { "values", EvaluationError::Kind::ArrayVariable },
+        { "\n\nundefined", EvaluationError::Kind::UndefinedVariable },
+    };
+    for (auto [source, kind] : errors)
+    {
+        auto prepared = PreparedExpression::prepare(*parse(source));
+        ASSERT_TRUE(prepared.has_value()) << source;
+        EvaluationError error{};
+        EXPECT_FALSE(prepared->evaluate(globals, error).has_value()) << source;
+        EXPECT_EQ(error.kind, kind) << source;
+    }
+
+    EvaluationError error{};
+    PreparedExpression::prepare(*parse("\n\nundefined"))->evaluate(globals, error);
+    EXPECT_EQ(error.line, 3u);
+    EXPECT_EQ(m_symbols.name(error.symbol), "undefined");
+    PreparedExpression::prepare(*parse("1 +\n-flag"))->evaluate(globals, error);
+    EXPECT_EQ(error.op, TokenType::Minus);
+    EXPECT_NE(std::string{ error.exception(m_symbols).what() }.find("Negation of something other than a double"),
+              std::string::npos);
+}
+
+TEST_F(TestPreparedExpression, throwingEvaluationNeedsTheHeap)
+{
+    // What the prepared expression saves: the message of the exception is built on the heap
+    Interpreter interpreter{};
+    bind(interpreter);
+    auto tree = parse("x + nil");
+    bool outOfMemory = false;
+    {
+        FailingAllocations noHeap{};
+        try
+        {
+            interpreter.evaluateNumeric(*tree);
+        }
+        catch (std::bad_alloc&)
+        {
+            outOfMemory = true;
+        }
+    }
+    EXPECT_TRUE(outOfMemory);
+}
+
+TEST_F(TestPreparedExpression, takesNothingOnTheHeap)
+{
+    for (const char* source : { "\"text\" == nil", "[1, 2] == nil", "sum(x) > 1", "x ? 1 : \"no\"" })
+    {
+        EXPECT_FALSE(PreparedExpression::prepare(*parse(source)).has_value()) << source;
+    }
+}
+
+TEST_F(TestPreparedExpression, stackIsAsDeepAsTheProgramNeeds)
+{
+    auto right = PreparedExpression::prepare(*parse("1 + (2 + (3 + (4 + 5)))"));
+    auto left = PreparedExpression::prepare(*parse("(((1 + 2) + 3) + 4) + 5"));
+    auto branches = PreparedExpression::prepare(*parse("x or y ? -1 : 2 and 3"));
+    EXPECT_EQ(right->stackDepth(), 5u);
+    EXPECT_EQ(left->stackDepth(), 2u);
+    EXPECT_EQ(right->size(), 9u);
+    EXPECT_EQ(branches->stackDepth(), 1u);
+    EXPECT_EQ(branches->size(), 10u);
+}
+
+TEST_F(TestPreparedExpression, interpreterPreparesSources)
+{
+    Interpreter interpreter{};
+    interpreter.setGlobal("x", 2.0);
+    auto prepared = interpreter.prepare("x * 21 + (x > 1 ? 0 : 100)");
+    ASSERT_TRUE(prepared.has_value());
+    EXPECT_FALSE(interpreter.prepare("1 +").has_value());
+    EXPECT_FALSE(interpreter.prepare("\"text\"").has_value());
+
+    EvaluationError error{};
+    EXPECT_EQ(interpreter.evaluatePrepared(*prepared, error), NumericValue{ 42.0 });
+    interpreter.setGlobal("x", 1.0); // Read on every evaluation
+    EXPECT_EQ(interpreter.evaluatePrepared(*prepared, error), NumericValue{ 121.0 });
+    interpreter.setGlobal("x", false);
+    EXPECT_FALSE(interpreter.evaluatePrepared(*prepared, error).has_value());
+    EXPECT_NE(interpreter.errorMessage(error).find("variables do not hold the same type"), std::string::npos);
+}
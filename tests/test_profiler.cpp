@@ -0,0 +1,134 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox Interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+#include "../src/interpreter.h"
+#include "../src/lexer.h"
+#include "../src/parser.h"
+#include "../src/profiler.h"
+
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+
+using namespace lox;
+
+class TestProfiler : public testing::Test
+{
+public:
+    void SetUp() override {}
+
+    void TearDown() override {}
+
+protected:
+    static ExpressionUPTR parse(const std::string& source)
+    {
+        auto expr = Parser{ Lexer{ source }.tokenize() }.parse();
+        return expr ? std::move(expr.value()) : nullptr;
+    }
+
+    static const Profiler::OperatorProfile* find(const std::vector<Profiler::OperatorProfile>& ops, std::string name)
+    {
+        for (const auto& op : ops)
+        {
+            if (op.name == name)
+            {
+                return &op;
+            }
+        }
+        return nullptr;
+    }
+};
+
+TEST_F(TestProfiler, countsEveryNodeAndOperator)
+{
+    auto expr = parse("1 + 2 * (3 - -4)");
+    ASSERT_NE(expr, nullptr);
+    Interpreter interpreter{};
+    Profiler profiler{};
+
+    EXPECT_EQ(interpreter.profile(*expr, profiler), LiteralValues{ 15.0 });
+
+    auto* root = profiler.node(*expr);
+    ASSERT_NE(root, nullptr);
+    EXPECT_EQ(root->visits, 1u);
+    EXPECT_EQ(root->samples, 1u);
+    EXPECT_GE(root->totalCycles(), root->selfCycles());
+
+    auto ops = profiler.operators();
+    ASSERT_NE(find(ops, "Literal"), nullptr);
+    EXPECT_EQ(find(ops, "Literal")->nodes, 4u);
+    ASSERT_NE(find(ops, "Plus"), nullptr);
+    EXPECT_EQ(find(ops, "Plus")->visits, 1u);
+    ASSERT_NE(find(ops, "UnaryMinus"), nullptr);
+    EXPECT_EQ(find(ops, "Minus")->visits, 1u);
+    EXPECT_EQ(find(ops, "Grouping")->visits, 1u);
+}
+
+TEST_F(TestProfiler, annotatesThePrinterOutput)
+{
+    auto expr = parse("1 + 2");
+    Interpreter interpreter{};
+    Profiler profiler{};
+    interpreter.profile(*expr, profiler);
+
+    std::ostringstream out{};
+    profiler.printAnnotated(*expr, out);
+
+    EXPECT_TRUE(out.str().starts_with("Binary(")) << out.str();
+    EXPECT_NE(out.str().find("Left: 1 {visits=1, self="), std::string::npos) << out.str();
+    EXPECT_NE(profiler.report().find("Plus"), std::string::npos);
+}
+
+TEST_F(TestProfiler, samplingKeepsVisitCountsExact)
+{
+    std::string source = "0";
+    for (int i = 1; i < 2000; ++i)
+    {
+        source += " + " + std::to_string(i % 10);
+    }
+    auto expr = parse(source);
+    Interpreter interpreter{};
+    Profiler profiler{ 16 };
+    interpreter.profile(*expr, profiler);
+
+    auto ops = profiler.operators();
+    ASSERT_NE(find(ops, "Plus"), nullptr);
+    EXPECT_EQ(find(ops, "Plus")->visits, 1999u);
+    EXPECT_EQ(find(ops, "Literal")->visits, 2000u);
+
+    std::uint64_t samples = 0;
+    for (const auto* node = dynamic_cast<const BinaryExpression*>(expr.get()); node;
+         node = dynamic_cast<const BinaryExpression*>(node->left.get()))
+    {
+        samples += profiler.node(*node)->samples;
+    }
+    EXPECT_GT(samples, 0u);
+    EXPECT_LT(samples, 1999u / 4);
+}
+
+TEST_F(TestProfiler, survivesRuntimeErrors)
+{
+    auto expr = parse("1 + (2 - \"three\")");
+    Interpreter interpreter{};
+    Profiler profiler{};
+
+    EXPECT_THROW(interpreter.profile(*expr, profiler), Interpreter::InterpreterException);
+
+    auto ok = parse("1 + 2");
+    profiler.reset();
+    EXPECT_EQ(interpreter.profile(*ok, profiler), LiteralValues{ 3.0 });
+    EXPECT_EQ(profiler.node(*ok)->visits, 1u);
+}
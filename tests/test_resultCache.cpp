@@ -0,0 +1,197 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox Interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+#include "../src/interpreter.h"
+#include "../src/lexer.h"
+#include "../src/logger.h"
+#include "../src/parser.h"
+#include "../src/resultCache.h"
+#include "../src/symbolTable.h"
+
+#include <gtest/gtest.h>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+using namespace lox;
+
+class TestResultCache : public testing::Test
+{
+public:
+    void SetUp() override { Logger::setLevel(Logger::Info); }
+
+    void TearDown() override
+    {
+        Logger::setLevel(Logger::Debug);
+        std::cin.rdbuf(m_originalCin);
+    }
+
+protected:
+    ExpressionUPTR parse(const std::string& source)
+    {
+        auto tree = Parser{ Lexer{ source, &m_symbols }.tokenize() }.parse();
+        EXPECT_TRUE(tree.has_value()) << source;
+        return tree ? std::move(tree.value()) : nullptr;
+    }
+
+    std::uint64_t hashOf(const std::string& source) { return parse(source)->hash(); }
+
+    // Feeds the lines to the interpreter as stdin, returning the exit code of the last one
+    int runLines(Interpreter& interpreter, const std::string& lines)
+    {
+        std::istringstream stream{ lines };
+        std::cin.rdbuf(stream.rdbuf());
+        auto exitCode = interpreter.run();
+        std::cin.rdbuf(m_originalCin);
+        return exitCode;
+    }
+
+    SymbolTable m_symbols{};
+    std::streambuf* m_originalCin = std::cin.rdbuf();
+};
+
+TEST_F(TestResultCache, hashIgnoresSpacingAndParentheses)
+{
+    EXPECT_EQ(hashOf("1+2"), hashOf("((1 + 2))"));
+    EXPECT_EQ(hashOf("x * -3"), hashOf("x*(-(3))"));
+    EXPECT_EQ(hashOf("\"text\""), hashOf(" \"text\" "));
+}
+
+TEST_F(TestResultCache, hashTellsTreesApart)
+{
+    EXPECT_NE(hashOf("1 + 2"), hashOf("2 + 1"));
+    EXPECT_NE(hashOf("1 + 2"), hashOf("1 - 2"));
+    EXPECT_NE(hashOf("(1 + 2) * 3"), hashOf("1 + 2 * 3"));
+    EXPECT_NE(hashOf("0"), hashOf("-0"));
+    EXPECT_NE(hashOf("0"), hashOf("\"0\""));
+    EXPECT_NE(hashOf("true"), hashOf("1"));
+    EXPECT_NE(hashOf("x"), hashOf("y"));
+    EXPECT_NE(hashOf("-1"), hashOf("!1"));
+}
+
+TEST_F(TestResultCache, findsBySourceAndByTree)
+{
+    ResultCache cache{};
+    auto tree = parse("1 + 2");
+    EXPECT_EQ(cache.find(*tree), nullptr);
+    cache.insert("1 + 2", *tree, ResultCache::Result{ 3.0, std::nullopt });
+
+    auto* bySource = cache.find("1 + 2");
+    ASSERT_NE(bySource, nullptr);
+    EXPECT_EQ(bySource->value, LiteralValues{ 3.0 });
+    EXPECT_EQ(cache.find("(1 + 2)"), nullptr);
+    auto* byTree = cache.find(*parse("(1 + 2)"));
+    ASSERT_NE(byTree, nullptr);
+    EXPECT_EQ(byTree->value, LiteralValues{ 3.0 });
+    EXPECT_EQ(cache.find(*parse("2 + 1")), nullptr);
+
+    EXPECT_EQ(cache.stats().sourceHits, 1u);
+    EXPECT_EQ(cache.stats().treeHits, 1u);
+    EXPECT_EQ(cache.stats().misses, 2u);
+    EXPECT_EQ(cache.size(), 2u);
+}
+
+TEST_F(TestResultCache, evictsLeastRecentlyUsed)
+{
+    ResultCache measure{};
+    measure.insert("0", *parse("0"), ResultCache::Result{ 0.0, std::nullopt });
+    // Room for the two entries of two inputs
+    ResultCache cache{ measure.bytes() * 2 };
+
+    cache.insert("1", *parse("1"), ResultCache::Result{ 1.0, std::nullopt });
+    cache.insert("2", *parse("2"), ResultCache::Result{ 2.0, std::nullopt });
+    ASSERT_NE(cache.find("1"), nullptr);
+    ASSERT_NE(cache.find(*parse("1")), nullptr);
+    cache.insert("3", *parse("3"), ResultCache::Result{ 3.0, std::nullopt });
+
+    EXPECT_NE(cache.find("1"), nullptr);
+    EXPECT_EQ(cache.find("2"), nullptr);
+    EXPECT_EQ(cache.find(*parse("2")), nullptr);
+    EXPECT_NE(cache.find("3"), nullptr);
+    EXPECT_EQ(cache.stats().evictions, 2u);
+    EXPECT_LE(cache.bytes(), cache.maxBytes());
+}
+
+TEST_F(TestResultCache, skipsResultsOverTheCap)
+{
+    ResultCache cache{ 1 };
+
+    cache.insert("1", *parse("1"), ResultCache::Result{ 1.0, std::nullopt });
+
+    EXPECT_EQ(cache.size(), 0u);
+    EXPECT_EQ(cache.bytes(), 0u);
+    EXPECT_EQ(cache.stats().evictions, 0u);
+}
+
+TEST_F(TestResultCache, interpreterAnswersRepeatedInputs)
+{
+    ResultCache cache{};
+    Interpreter interpreter{};
+    interpreter.setResultCache(&cache);
+
+    EXPECT_EQ(runLines(interpreter, "1 + 2 * 3\n1 + 2 * 3\n1 + (2 * 3)\n1 + 2 * 3\n"), EXIT_SUCCESS);
+
+    EXPECT_EQ(cache.stats().sourceHits, 2u);
+    EXPECT_EQ(cache.stats().treeHits, 1u);
+    EXPECT_EQ(cache.stats().misses, 1u);
+}
+
+TEST_F(TestResultCache, interpreterCachesRuntimeErrors)
+{
+    ResultCache cache{};
+    Interpreter interpreter{};
+    interpreter.setResultCache(&cache);
+
+    EXPECT_EQ(runLines(interpreter, "\"text\" + 1\n"), EXIT_FAILURE);
+    EXPECT_EQ(runLines(interpreter, "\"text\" + 1\n"), EXIT_FAILURE);
+
+    auto* cached = cache.find("\"text\" + 1");
+    ASSERT_NE(cached, nullptr);
+    EXPECT_TRUE(cached->error.has_value());
+    EXPECT_EQ(cache.stats().misses, 1u);
+}
+
+TEST_F(TestResultCache, errorsAreOnlySharedByTreesOnTheSameLines)
+{
+    ResultCache cache{};
+    cache.insert("1 + 2", *parse("1 + 2"), ResultCache::Result{ 3.0, std::nullopt });
+    cache.insert("\"text\" + 1", *parse("\"text\" + 1"), ResultCache::Result{ NullLiteral{}, "at line 1" });
+
+    // Values do not depend on lines, errors quote the line of the operator that raised them
+    EXPECT_NE(cache.find(*parse("1\n+ 2")), nullptr);
+    auto* sameLines = cache.find(*parse("(\"text\") + (1)"));
+    ASSERT_NE(sameLines, nullptr);
+    EXPECT_EQ(sameLines->error, "at line 1");
+    EXPECT_EQ(cache.find(*parse("\"text\"\n+ 1")), nullptr);
+
+    EXPECT_EQ(cache.stats().treeHits, 2u);
+    EXPECT_EQ(cache.stats().misses, 1u);
+}
+
+TEST_F(TestResultCache, settingGlobalsClearsTheCache)
+{
+    ResultCache cache{};
+    Interpreter interpreter{};
+    interpreter.setResultCache(&cache);
+    interpreter.setGlobal("x", 1.0);
+    EXPECT_EQ(runLines(interpreter, "x + 1\n"), EXIT_SUCCESS);
+    EXPECT_GT(cache.size(), 0u);
+
+    interpreter.setGlobal("x", LoxString{ "text" });
+
+    EXPECT_EQ(cache.size(), 0u);
+    EXPECT_EQ(runLines(interpreter, "x + 1\n"), EXIT_FAILURE);
+}
@@ -0,0 +1,154 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox Interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+#include "../src/AstPrinter.hpp"
+#include "../src/allocStats.h"
+#include "../src/arena.h"
+#include "../src/interpreter.h"
+#include "../src/logger.h"
+#include "../src/session.h"
+
+#include <gtest/gtest.h>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+
+using namespace lox;
+
+class TestSession : public testing::Test
+{
+public:
+    // Debug logging builds its messages on every token
+    void SetUp() override { Logger::setLevel(Logger::Info); }
+
+    void TearDown() override
+    {
+        Logger::setLevel(Logger::Debug);
+        std::cin.rdbuf(m_originalCin);
+    }
+
+protected:
+    // Runs the lines through a fresh interpreter, returning how many allocations that took
+    std::uint64_t allocationsToRun(const std::string& line, int times)
+    {
+        std::string input{};
+        for (int i = 0; i < times; ++i)
+        {
+            input += line + "\n";
+        }
+        std::istringstream stream{ input };
+        std::cin.rdbuf(stream.rdbuf());
+        auto before = AllocStats::total();
+        {
+            Interpreter interpreter{};
+            EXPECT_EQ(interpreter.run(), EXIT_SUCCESS);
+        }
+        std::cin.rdbuf(m_originalCin);
+        return (AllocStats::total() - before).allocations;
+    }
+
+    std::streambuf* m_originalCin = std::cin.rdbuf();
+};
+
+TEST_F(TestSession, nodesGoToTheArenaInScope)
+{
+    Arena arena{};
+    {
+        Arena::Scope scope{ arena };
+        std::make_unique<LiteralExpression>(0.0).reset(); // The first node makes the first block
+        auto before = AllocStats::total();
+        auto node = std::make_unique<BinaryExpression>(
+            std::make_unique<LiteralExpression>(1.0),
+            Token{ TokenType::Plus, std::monostate{}, "", 1 },
+            std::make_unique<LiteralExpression>(2.0));
+        EXPECT_EQ((AllocStats::total() - before).allocations, 0u);
+        EXPECT_GT(arena.used(), 0u);
+    }
+    EXPECT_EQ(Arena::current(), nullptr);
+    arena.rewind();
+    EXPECT_EQ(arena.used(), 0u);
+
+    auto before = AllocStats::total();
+    auto node = std::make_unique<LiteralExpression>(1.0);
+    node.reset();
+    EXPECT_EQ((AllocStats::total() - before).allocations, 1u);
+    EXPECT_EQ((AllocStats::total() - before).deallocations, 1u);
+}
+
+TEST_F(TestSession, keepsBuffersAcrossInputs)
+{
+    Session session{};
+    session.lex("(1 + 2) * \"long enough to be interned\" == x");
+    ASSERT_NE(session.parse(), nullptr);
+    auto tokenCapacity = session.tokens().capacity();
+    auto arenaCapacity = session.arena().capacity();
+
+    session.lex("3 - 4");
+    ASSERT_NE(session.parse(), nullptr);
+
+    EXPECT_EQ(session.tokens().size(), 4u);
+    EXPECT_EQ(session.tokens().capacity(), tokenCapacity);
+    EXPECT_EQ(session.arena().capacity(), arenaCapacity);
+    EXPECT_EQ(session.symbols().size(), 1u);
+    EXPECT_EQ(session.strings().size(), 1u);
+}
+
+TEST_F(TestSession, failedParseLeavesNoTree)
+{
+    Session session{};
+    session.lex("1 +");
+
+    EXPECT_EQ(session.parse(), nullptr);
+    EXPECT_EQ(session.tree(), nullptr);
+}
+
+TEST_F(TestSession, steadyStateDoesNotAllocate)
+{
+    Session session{};
+    Interpreter interpreter{};
+    std::ostream discard{ nullptr };
+    auto runOnce = [&](const std::string& source)
+    {
+        session.lex(source);
+        auto* tree = session.parse();
+        ASSERT_NE(tree, nullptr);
+        AstPrinter{ session.output() }.print(*tree);
+        session.flush(discard);
+        auto value = interpreter.evaluateTree(*tree);
+        EXPECT_TRUE(std::holds_alternative<bool>(value));
+    };
+    const std::string first = "(1 + 2.5) * -3 - 4 / (5 + 6) >= 7 == (\"some string literal\" == \"other\")";
+    const std::string second = "(8 + 9.5) * -1 - 2 / (3 + 4) >= 5 == (\"some string literal\" == \"more\")";
+    runOnce(first); // Grows the buffers
+    runOnce(second);
+
+    auto before = AllocStats::total();
+    for (int i = 0; i < 100; ++i)
+    {
+        runOnce(i % 2 ? first : second);
+    }
+    EXPECT_EQ((AllocStats::total() - before).allocations, 0u);
+}
+
+TEST_F(TestSession, interpreterAllocationsDoNotGrowWithInputs)
+{
+    const std::string line = "(1 + 2) * 3 - -4 / 5 >= 6";
+
+    allocationsToRun(line, 1); // Makes whatever is made once per process
+
+    EXPECT_EQ(allocationsToRun(line, 4), allocationsToRun(line, 64));
+}
@@ -0,0 +1,256 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox Interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+#include "../src/AstPrinter.hpp"
+#include "../src/interpreter.h"
+#include "../src/lexer.h"
+#include "../src/logger.h"
+#include "../src/parser.h"
+#include "../src/staticVisitor.h"
+
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+#include <type_traits>
+
+using namespace lox;
+
+namespace
+{
+
+// How many levels of nodes a tree has
+class Depth : public StaticVisitor<Depth, int>
+{
+public:
+    int visit(const BinaryExpression& expr) { return 1 + std::max(dispatch(*expr.left), dispatch(*expr.right)); }
+    int visit(const LiteralExpression& /*expr*/) { return 1; }
+    int visit(const UnaryExpression& expr) { return 1 + dispatch(*expr.right); }
+    int visit(const GroupingExpression& expr) { return 1 + dispatch(*expr.expression); }
+    int visit(const VariableExpression& /*expr*/) { return 1; }
+    int visit(const LogicalExpression& expr) { return 1 + std::max(dispatch(*expr.left), dispatch(*expr.right)); }
+    int visit(const ConditionalExpression& expr)
+    {
+        return 1 + std::max({ dispatch(*expr.condition), dispatch(*expr.thenBranch), dispatch(*expr.elseBranch) });
+    }
+    int visit(const ArrayExpression& expr)
+    {
+        int deepest = 0;
+        for (const auto& element : expr.elements)
+        {
+            deepest = std::max(deepest, dispatch(*element));
+        }
+        return 1 + deepest;
+    }
+    int visit(const CallExpression& expr) { return 1 + dispatch(*expr.argument); }
+};
+
+// The tree in prefix notation, with the kind of every node
+class Prefix : public StaticVisitor<Prefix, std::string>
+{
+public:
+    std::string visit(const BinaryExpression& expr)
+    {
+        return "(" + tokenTypeToString(expr.op.type) + " " + dispatch(*expr.left) + " " + dispatch(*expr.right) + ")";
+    }
+    std::string visit(const LiteralExpression& expr) { return print(expr.value); }
+    std::string visit(const UnaryExpression& expr)
+    {
+        return "(" + tokenTypeToString(expr.op.type) + " " + dispatch(*expr.right) + ")";
+    }
+    std::string visit(const GroupingExpression& expr) { return "(group " + dispatch(*expr.expression) + ")"; }
+    std::string visit(const VariableExpression& expr) { return "#" + std::to_string(expr.symbol.id); }
+    std::string visit(const LogicalExpression& expr)
+    {
+        return "(" + tokenTypeToString(expr.op.type) + " " + dispatch(*expr.left) + " " + dispatch(*expr.right) + ")";
+    }
+    std::string visit(const ConditionalExpression& expr)
+    {
+        return "(? " + dispatch(*expr.condition) + " " + dispatch(*expr.thenBranch) + " " +
+               dispatch(*expr.elseBranch) + ")";
+    }
+    std::string visit(const ArrayExpression& expr)
+    {
+        std::string prefix = "[";
+        for (const auto& element : expr.elements)
+        {
+            prefix += (prefix.size() > 1 ? " " : "") + dispatch(*element);
+        }
+        return prefix + "]";
+    }
+    std::string visit(const CallExpression& expr)
+    {
+        return "(" + std::string{ CallExpression::nameOf(expr.builtin) } + " " + dispatch(*expr.argument) + ")";
+    }
+};
+
+// Counts the nodes of every kind, returning nothing
+class KindCounter : public StaticVisitor<KindCounter>
+{
+public:
+    void visit(const BinaryExpression& expr)
+    {
+        binaries++;
+        dispatch(*expr.left);
+        dispatch(*expr.right);
+    }
+    void visit(const LiteralExpression& /*expr*/) { literals++; }
+    void visit(const UnaryExpression& expr)
+    {
+        unaries++;
+        dispatch(*expr.right);
+    }
+    void visit(const GroupingExpression& expr)
+    {
+        groupings++;
+        dispatch(*expr.expression);
+    }
+    void visit(const VariableExpression& /*expr*/) { variables++; }
+    void visit(const LogicalExpression& expr)
+    {
+        logicals++;
+        dispatch(*expr.left);
+        dispatch(*expr.right);
+    }
+    void visit(const ConditionalExpression& expr)
+    {
+        conditionals++;
+        dispatch(*expr.condition);
+        dispatch(*expr.thenBranch);
+        dispatch(*expr.elseBranch);
+    }
+    void visit(const ArrayExpression& expr)
+    {
+        arrays++;
+        for (const auto& element : expr.elements)
+        {
+            dispatch(*element);
+        }
+    }
+    void visit(const CallExpression& expr)
+    {
+        calls++;
+        dispatch(*expr.argument);
+    }
+
+    int binaries = 0;
+    int literals = 0;
+    int unaries = 0;
+    int groupings = 0;
+    int variables = 0;
+    int logicals = 0;
+    int conditionals = 0;
+    int arrays = 0;
+    int calls = 0;
+};
+
+static_assert(std::is_same_v<decltype(Depth{}.dispatch(std::declval<const Expression&>())), int>);
+static_assert(std::is_same_v<decltype(KindCounter{}.dispatch(std::declval<const Expression&>())), void>);
+
+} // namespace
+
+class TestStaticVisitor : public testing::Test
+{
+public:
+    void SetUp() override { Logger::setLevel(Logger::Info); }
+
+    void TearDown() override { Logger::setLevel(Logger::Debug); }
+
+protected:
+    static ExpressionUPTR parse(std::string_view source)
+    {
+        auto tree = Parser{ Lexer{ source }.tokenize() }.parse();
+        EXPECT_TRUE(tree.has_value()) << source;
+        return std::move(tree.value());
+    }
+};
+
+TEST_F(TestStaticVisitor, nodesKnowTheirKind)
+{
+    auto tree = parse("-(1) + x");
+    ASSERT_EQ(tree->kind(), Expression::Kind::Binary);
+    const auto& binary = static_cast<const BinaryExpression&>(*tree);
+    EXPECT_EQ(binary.right->kind(), Expression::Kind::Variable);
+    ASSERT_EQ(binary.left->kind(), Expression::Kind::Unary);
+    const auto& unary = static_cast<const UnaryExpression&>(*binary.left);
+    ASSERT_EQ(unary.right->kind(), Expression::Kind::Grouping);
+    EXPECT_EQ(static_cast<const GroupingExpression&>(*unary.right).expression->kind(), Expression::Kind::Literal);
+}
+
+TEST_F(TestStaticVisitor, returnsAnyType)
+{
+    auto tree = parse("1 + 2 * (3 - -x) == \"a\"");
+    EXPECT_EQ(Depth{}.dispatch(*tree), 7);
+    EXPECT_EQ(Prefix{}.dispatch(*tree),
+              "(EqualEqual (Plus 1.000000 (Star 2.000000 (group (Minus 3.000000 (Minus #0))))) a)");
+}
+
+TEST_F(TestStaticVisitor, returnsNothing)
+{
+    KindCounter counter{};
+    counter.dispatch(*parse("!(a == b) != (1 < 2) == !nil"));
+    EXPECT_EQ(counter.binaries, 4);
+    EXPECT_EQ(counter.literals, 3);
+    EXPECT_EQ(counter.unaries, 2);
+    EXPECT_EQ(counter.groupings, 2);
+    EXPECT_EQ(counter.variables, 2);
+}
+
+TEST_F(TestStaticVisitor, dispatchesBranchingNodes)
+{
+    auto tree = parse("a and b or c ? 1 : d ? 2 : 3");
+    EXPECT_EQ(tree->kind(), Expression::Kind::Conditional);
+    EXPECT_EQ(Prefix{}.dispatch(*tree), "(? (Or (And #0 #1) #2) 1.000000 (? #3 2.000000 3.000000))");
+    EXPECT_EQ(Depth{}.dispatch(*tree), 4);
+    KindCounter counter{};
+    counter.dispatch(*tree);
+    EXPECT_EQ(counter.logicals, 2);
+    EXPECT_EQ(counter.conditionals, 2);
+    EXPECT_EQ(tree->treeSize(), 11u);
+}
+
+TEST_F(TestStaticVisitor, dispatchesArraysAndCalls)
+{
+    auto tree = parse("sum([1, -x, [], 2 * 3]) + max(y)");
+    EXPECT_EQ(Prefix{}.dispatch(*tree), "(Plus (sum [1.000000 (Minus #1) [] (Star 2.000000 3.000000)]) (max #3))");
+    EXPECT_EQ(Depth{}.dispatch(*tree), 5);
+    KindCounter counter{};
+    counter.dispatch(*tree);
+    EXPECT_EQ(counter.arrays, 2);
+    EXPECT_EQ(counter.calls, 2);
+    EXPECT_EQ(counter.literals, 3);
+    EXPECT_EQ(tree->treeSize(), 12u);
+}
+
+TEST_F(TestStaticVisitor, astPrinterOutputIsUnchanged)
+{
+    std::ostringstream out{};
+    AstPrinter printer{ out, [](const Expression& expr) { return std::to_string(Depth{}.dispatch(expr)); } };
+    auto tree = parse("-(1.5) * x");
+    printer.print(*tree);
+    const auto& binary = static_cast<const BinaryExpression&>(*tree);
+    const auto& unary = static_cast<const UnaryExpression&>(*binary.left);
+    EXPECT_EQ(out.str(), "Binary(OP: " + binary.op.print() + ", Left: Unary( " + unary.op.print() +
+                             " Grouping(1.5 {1}) {2}) {3}, Right: Variable(#0) {1}) {4}\n");
+}
+
+TEST_F(TestStaticVisitor, interpreterEvaluatesEveryKind)
+{
+    Interpreter interpreter{};
+    interpreter.setGlobal("x", 4.0);
+    EXPECT_EQ(interpreter.evaluateTree(*parse("-(x - 1) * 2 + 7 == 1")), LiteralValues{ true });
+    EXPECT_EQ(interpreter.evaluateTree(*parse("!(\"a\" + \"b\" == \"ab\")")), LiteralValues{ false });
+}
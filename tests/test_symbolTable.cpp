@@ -0,0 +1,140 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox Interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+#include "../src/BaseExpression.h"
+#include "../src/lexer.h"
+#include "../src/parallelLexer.h"
+#include "../src/parser.h"
+#include "../src/symbolTable.h"
+
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+using namespace lox;
+
+class TestSymbolTable : public testing::Test
+{
+public:
+    void SetUp() override {}
+
+    void TearDown() override {}
+
+protected:
+    static std::vector<Symbol> symbolsOf(const std::vector<Token>& tokens)
+    {
+        std::vector<Symbol> symbols{};
+        for (const auto& tok : tokens)
+        {
+            if (auto* symbol = std::get_if<Symbol>(&tok.literal))
+            {
+                symbols.emplace_back(*symbol);
+            }
+        }
+        return symbols;
+    }
+};
+
+TEST_F(TestSymbolTable, idsAreDenseAndStable)
+{
+    SymbolTable table{};
+
+    auto foo = table.intern("foo");
+    auto bar = table.intern("bar");
+
+    EXPECT_EQ(foo.id, 0);
+    EXPECT_EQ(bar.id, 1);
+    EXPECT_EQ(table.intern(std::string{ "foo" }), foo);
+    EXPECT_EQ(table.size(), 2);
+    EXPECT_EQ(table.name(bar), "bar");
+    EXPECT_EQ(table.find("bar"), bar);
+    EXPECT_FALSE(table.find("baz").has_value());
+}
+
+TEST_F(TestSymbolTable, namesSurviveGrowth)
+{
+    SymbolTable table{};
+    for (int i = 0; i < 1000; ++i)
+    {
+        table.intern("name_" + std::to_string(i));
+    }
+
+    EXPECT_EQ(table.name(Symbol{ 0 }), "name_0");
+    EXPECT_EQ(table.name(Symbol{ 999 }), "name_999");
+}
+
+TEST_F(TestSymbolTable, lexerTagsIdentifiers)
+{
+    using enum TokenType;
+    SymbolTable table{};
+
+    auto tokens = Lexer{ "x + y * x and z", &table }.tokenize();
+
+    ASSERT_EQ(tokens.size(), 8);
+    EXPECT_EQ(tokens.at(0).type, Identifier);
+    EXPECT_EQ(tokens.at(0).location, "x");
+    EXPECT_EQ(std::get<Symbol>(tokens.at(0).literal), std::get<Symbol>(tokens.at(4).literal));
+    EXPECT_EQ(tokens.at(5).type, And); // Keywords are not interned
+    EXPECT_EQ(table.size(), 3);
+}
+
+TEST_F(TestSymbolTable, sessionKeepsIdsAcrossLines)
+{
+    SymbolTable table{};
+
+    auto first = Lexer{ "a + b", &table }.tokenize();
+    auto second = Lexer{ "b + a + c", &table }.tokenize();
+
+    EXPECT_EQ(symbolsOf(first), (std::vector<Symbol>{ Symbol{ 0 }, Symbol{ 1 } }));
+    EXPECT_EQ(symbolsOf(second), (std::vector<Symbol>{ Symbol{ 1 }, Symbol{ 0 }, Symbol{ 2 } }));
+}
+
+TEST_F(TestSymbolTable, parallelLexerNumbersLikeSequential)
+{
+    std::string source{};
+    for (int i = 0; i < 500; ++i)
+    {
+        source +=
+            "v" + std::to_string(i % 37) + " + \"s" + std::to_string(i) + "\" * w" + std::to_string(i % 11) + "\n";
+    }
+    SymbolTable sequential{};
+    sequential.intern("w3"); // Already known from an earlier line
+    SymbolTable parallel{};
+    parallel.intern("w3");
+
+    auto expected = Lexer{ source, &sequential }.tokenize();
+    auto output = ParallelLexer{ source, &parallel, 8, 64 }.tokenize();
+
+    EXPECT_EQ(expected, output);
+    ASSERT_EQ(sequential.size(), parallel.size());
+    for (std::uint32_t id = 0; id < sequential.size(); ++id)
+    {
+        EXPECT_EQ(sequential.name(Symbol{ id }), parallel.name(Symbol{ id }));
+    }
+}
+
+TEST_F(TestSymbolTable, parserBuildsVariables)
+{
+    SymbolTable table{};
+    auto expr = Parser{ Lexer{ "-answer", &table }.tokenize() }.parse();
+
+    ASSERT_TRUE(expr.has_value());
+    auto* unary = dynamic_cast<const UnaryExpression*>(expr->get());
+    ASSERT_NE(unary, nullptr);
+    auto* variable = dynamic_cast<const VariableExpression*>(unary->right.get());
+    ASSERT_NE(variable, nullptr);
+    EXPECT_EQ(variable->symbol, table.find("answer"));
+}
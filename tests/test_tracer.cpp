@@ -0,0 +1,108 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox Interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+#include "../src/interpreter.h"
+#include "../src/parallelLexer.h"
+#include "../src/tracer.h"
+
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+
+using namespace lox;
+
+class TestTracer : public testing::Test
+{
+public:
+    void SetUp() override { Tracer::clear(); }
+
+    void TearDown() override
+    {
+        Tracer::disable();
+        Tracer::clear();
+    }
+
+protected:
+    static std::size_t countOf(const std::string& text, const std::string& needle)
+    {
+        std::size_t found = 0;
+        for (auto pos = text.find(needle); pos != std::string::npos; pos = text.find(needle, pos + 1))
+        {
+            found++;
+        }
+        return found;
+    }
+};
+
+TEST_F(TestTracer, recordsNothingWhenDisabled)
+{
+    {
+        PhaseScope phase{ Phase::Lex };
+    }
+
+    EXPECT_EQ(countOf(Tracer::json(), "\"ph\":\"X\""), 0u);
+}
+
+TEST_F(TestTracer, recordsCompleteEvents)
+{
+    Tracer::enable();
+    {
+        PhaseScope outer{ Phase::Evaluate };
+        PhaseScope inner{ Phase::Print };
+    }
+    auto json = Tracer::json();
+
+    EXPECT_TRUE(json.starts_with("{\"traceEvents\":["));
+    EXPECT_EQ(countOf(json, "\"ph\":\"X\""), 2u);
+    EXPECT_EQ(countOf(json, "\"name\":\"Evaluate\""), 1u);
+    EXPECT_EQ(countOf(json, "\"name\":\"Print\""), 1u);
+}
+
+TEST_F(TestTracer, threadsRecordIntoTheirOwnBuffers)
+{
+    Tracer::enable();
+    {
+        PhaseScope phase{ Phase::Parse };
+    }
+    std::thread{ []() { PhaseScope phase{ Phase::Lex }; } }.join();
+    auto json = Tracer::json();
+
+    auto parse = json.find("\"name\":\"Parse\"");
+    auto lex = json.find("\"name\":\"Lex\"");
+    ASSERT_NE(parse, std::string::npos);
+    ASSERT_NE(lex, std::string::npos);
+    auto tidOf = [&json](std::size_t pos) { return json.substr(json.find("\"tid\":", pos), 8); };
+    EXPECT_NE(tidOf(parse), tidOf(lex));
+}
+
+TEST_F(TestTracer, interpreterTracesEveryPhase)
+{
+    auto path = std::filesystem::temp_directory_path() / "lox_trace_test.txt";
+    {
+        std::ofstream file(path);
+        file << "1 + 2 * 3";
+    }
+    Tracer::enable();
+    Interpreter interpreter{ path };
+    EXPECT_EQ(interpreter.run(), EXIT_SUCCESS);
+    auto json = Tracer::json();
+    std::filesystem::remove(path);
+
+    for (auto phase : { Phase::ReadInput, Phase::Lex, Phase::Parse, Phase::Print, Phase::Evaluate })
+    {
+        EXPECT_EQ(countOf(json, std::format("\"name\":\"{}\"", phaseName(phase))), 1u) << phaseName(phase);
+    }
+}
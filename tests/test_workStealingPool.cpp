@@ -0,0 +1,116 @@
+/******************************************************************************
+ * Project:  Lox
+ * Brief:    A C++ Lox Interpreter.
+ *
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and noninfringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages, or
+ * other liability, whether in an action of contract, tort, or otherwise,
+ * arising from, out of, or in connection with the software or the use or
+ * other dealings in the software.
+ *
+ * Author:   Dutesier
+ *
+ ******************************************************************************/
+
+#include "../src/workStealingPool.h"
+
+#include <atomic>
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace lox;
+
+namespace
+{
+
+// Sums [begin, end) by halving it down to single numbers, recording which threads did the work
+std::uint64_t sum(WorkStealingPool& pool, std::uint64_t begin, std::uint64_t end, std::set<std::thread::id>& threads,
+                  std::mutex& mutex)
+{
+    if (end - begin == 1)
+    {
+        std::lock_guard lock{ mutex };
+        threads.insert(std::this_thread::get_id());
+        return begin;
+    }
+    auto middle = begin + (end - begin) / 2;
+    std::uint64_t left = 0;
+    std::uint64_t right = 0;
+    pool.join([&]() { left = sum(pool, begin, middle, threads, mutex); },
+              [&]() { right = sum(pool, middle, end, threads, mutex); });
+    return left + right;
+}
+
+} // namespace
+
+TEST(TestWorkStealingPool, joinsNestedTasks)
+{
+    WorkStealingPool pool{ 4 };
+    EXPECT_EQ(pool.threadCount(), 4u);
+    std::set<std::thread::id> threads{};
+    std::mutex mutex{};
+    EXPECT_EQ(sum(pool, 0, 1 << 14, threads, mutex), (std::uint64_t{ 1 } << 13) * ((1 << 14) - 1));
+    EXPECT_GE(threads.size(), 1u);
+    EXPECT_LE(threads.size(), 4u);
+}
+
+TEST(TestWorkStealingPool, rethrowsTheLeftErrorFirst)
+{
+    WorkStealingPool pool{ 2 };
+    auto failLeft = []() { throw std::runtime_error("left"); };
+    auto failRight = []() { throw std::logic_error("right"); };
+    for (int i = 0; i < 100; ++i)
+    {
+        try
+        {
+            pool.join(failLeft, failRight);
+            FAIL() << "Nothing was thrown";
+        }
+        catch (std::runtime_error& e)
+        {
+            EXPECT_STREQ(e.what(), "left");
+        }
+        EXPECT_THROW(pool.join([]() {}, failRight), std::logic_error);
+    }
+}
+
+TEST(TestWorkStealingPool, runsTheRightTaskWhenTheLeftOneSucceeds)
+{
+    WorkStealingPool pool{ 3 };
+    std::atomic<int> runs = 0;
+    for (int i = 0; i < 1000; ++i)
+    {
+        pool.join([&runs]() { runs++; }, [&runs]() { runs++; });
+    }
+    EXPECT_EQ(runs.load(), 2000);
+}
+
+TEST(TestWorkStealingPool, sharedByOutsideThreads)
+{
+    WorkStealingPool pool{ 2 };
+    std::vector<std::uint64_t> sums(4);
+    {
+        std::vector<std::jthread> callers{};
+        for (auto& result : sums)
+        {
+            callers.emplace_back(
+                [&pool, &result]()
+                {
+                    std::set<std::thread::id> threads{};
+                    std::mutex mutex{};
+                    result = sum(pool, 0, 1 << 12, threads, mutex);
+                });
+        }
+    }
+    for (auto result : sums)
+    {
+        EXPECT_EQ(result, (std::uint64_t{ 1 } << 11) * ((1 << 12) - 1));
+    }
+}